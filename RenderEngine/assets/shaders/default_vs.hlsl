@@ -21,19 +21,26 @@ struct vs_output
 
 cbuffer object_cb : register(b0)
 {
-	float4x4 projection;
+	float4x3 world; // the last column is always (0, 0, 0, 1)
+	// compact vertices only
+	float4 position_scale;
+	float4 position_offset;
+};
+
+// Set once per frame, shared by every object
+cbuffer view_cb : register(b1)
+{
 	float4x4 view;
-	float4x4 world;
+	float4x4 projection;
+	float4x4 view_projection;
 };
 
 vs_output vs_main(vs_input input)
 {
 	vs_output output = (vs_output) 0;
     
-	output.position_local = mul(input.position, world);
-	output.position_world = output.position_local;
-	output.position_local = mul(output.position_local, view);
-	output.position_local = mul(output.position_local, projection);
+	output.position_world = float4(mul(input.position, world), 1.0f);
+	output.position_local = mul(output.position_world, view_projection);
 	output.tex_coord = input.tex_coord;
     
     // convert model space normals to world space
@@ -42,4 +49,32 @@ vs_output vs_main(vs_input input)
     output.normal = transform_vector_space(input.normal, (float3x3) world);
 	
 	return output;
-}
\ No newline at end of file
+}
+
+// s_mesh_file_compact_vertex, decoded the same way as decode_compact_vertex in vertex_compression.h
+struct vs_compact_input
+{
+	float4 position : POSITION; // unorm across the mesh bounds, w is always 1
+	int4 frame : NORMAL; // octahedral normal in xy & tangent in zw, the lowest bit of w flips the binormal
+	float2 tex_coord : TEXCOORD0; // half float
+};
+
+float3 decode_octahedral(int2 encoded)
+{
+	float2 xy = max(float2(encoded) / 32767.0f, -1.0f);
+	float z = 1.0f - abs(xy.x) - abs(xy.y);
+	float fold = max(-z, 0.0f);
+	xy += xy >= 0.0f ? -fold : fold;
+	return normalize(float3(xy, z));
+}
+
+vs_output vs_main_compact(vs_compact_input input)
+{
+	vs_input full_input = (vs_input) 0;
+	full_input.position = float4(position_offset.xyz + input.position.xyz * position_scale.xyz, 1.0f);
+	full_input.normal = decode_octahedral(input.frame.xy);
+	full_input.tangent = decode_octahedral(input.frame.zw);
+	full_input.binormal = cross(full_input.normal, full_input.tangent) * ((input.frame.w & 1) != 0 ? -1.0f : 1.0f);
+	full_input.tex_coord = input.tex_coord;
+	return vs_main(full_input);
+}
@@ -26,11 +26,29 @@ struct material_data
 							        //----------------------------------- (16 byte boundary)
 };
 
-cbuffer material_cb : register(b1)
+cbuffer material_cb : register(b2)
 {
 	material_data material;
 };
 
+// Material permutations define these as 0 or 1, so the branches & texture fetches they skip are compiled out
+// Without them the material flags are branched on per pixel
+#ifdef PERMUTATION_DIFFUSE_TEXTURE
+#define USE_DIFFUSE_TEXTURE PERMUTATION_DIFFUSE_TEXTURE
+#else
+#define USE_DIFFUSE_TEXTURE material.use_diffuse_texture
+#endif
+#ifdef PERMUTATION_SPECULAR_TEXTURE
+#define USE_SPECULAR_TEXTURE PERMUTATION_SPECULAR_TEXTURE
+#else
+#define USE_SPECULAR_TEXTURE material.use_specular_texture
+#endif
+#ifdef PERMUTATION_NORMAL_TEXTURE
+#define USE_NORMAL_TEXTURE PERMUTATION_NORMAL_TEXTURE
+#else
+#define USE_NORMAL_TEXTURE material.use_normal_texture
+#endif
+
 struct ps_deferred_gbuffers
 {
 	float4 albedo			: SV_Target0;
@@ -46,7 +64,7 @@ float4 ps_albedo(vs_output input)
 {
     // Retrieve colour from material/diffuse map
 	float4 albedo;
-	if (material.use_diffuse_texture)
+	if (USE_DIFFUSE_TEXTURE)
 	{
 		albedo = texture_diffuse.Sample(sampler_linear, input.tex_coord);
         
@@ -68,9 +86,10 @@ float4 ps_specular(vs_output input)
 {
     // Retrieve material specular/texture specular
 	float4 specular;
-	if (material.use_specular_texture)
+	if (USE_SPECULAR_TEXTURE)
 	{
-		specular = texture_specular.Sample(sampler_linear, input.tex_coord);
+		// Specular maps are greyscale, cooked ones are single channel BC4 which only fills red
+		specular = texture_specular.Sample(sampler_linear, input.tex_coord).rrra;
 	}
 	else
 	{
@@ -87,12 +106,13 @@ float4 ps_normal(vs_output input)
 {
     // Retrieve vertex normal/normal map
 	float4 normal;
-	if (material.use_normal_texture)
+	if (USE_NORMAL_TEXTURE)
 	{
         // retrieve normal in tangent space from normal map texture
-		normal = texture_normal.Sample(sampler_linear, input.tex_coord);
+		// cooked normal maps are two channel BC5, so only x & y are read and z is rebuilt from the unit length
 		// 'decompress' the range of the normal value from (0, +1) to (-1, +1)
-        normal = normal * 2.0 - 1.0f;
+		normal.xy = texture_normal.Sample(sampler_linear, input.tex_coord).rg * 2.0 - 1.0f;
+		normal.z = sqrt(saturate(1.0f - dot(normal.xy, normal.xy)));
 		// convert tangent space normal to world space
         float3x3 tangent_frame = float3x3(input.tangent, input.binormal, input.normal);
         normal = float4(transform_vector_space(normal.rgb, tangent_frame), 1);
@@ -0,0 +1,174 @@
+#include "archive.h"
+#include <reporting/report.h>
+#include <cstdio>
+
+c_asset_archive::c_asset_archive()
+	: m_file()
+	, m_entries(nullptr)
+	, m_entry_count(0)
+	, m_names(nullptr)
+{
+}
+
+bool c_asset_archive::open(const wchar_t* const file_path)
+{
+	this->close();
+
+	if (!m_file.open(file_path))
+	{
+		return K_FAILURE;
+	}
+
+	const ubyte* const data = m_file.get_data();
+	const qword file_size = m_file.get_size();
+	const s_archive_file_header* const header = reinterpret_cast<const s_archive_file_header*>(data);
+
+	const bool header_valid = file_size >= sizeof(s_archive_file_header) && header->signature == ARCHIVE_FILE_SIGNATURE;
+	if (!header_valid)
+	{
+		LOG_WARNING(L"%s is not an asset archive!", file_path);
+		this->close();
+		return K_FAILURE;
+	}
+	if (header->version != ARCHIVE_FILE_VERSION)
+	{
+		LOG_WARNING(L"archive %s is version %d, expected %d! recook assets", file_path, header->version, ARCHIVE_FILE_VERSION);
+		this->close();
+		return K_FAILURE;
+	}
+
+	// Validate the table of contents & every entry against the mapped size up front, so lookups never need to
+	const qword entries_size = static_cast<qword>(header->entry_count) * sizeof(s_archive_entry);
+	bool contents_valid =
+		header->entries_offset <= file_size && entries_size <= file_size - header->entries_offset &&
+		header->names_offset <= file_size && header->names_size <= file_size - header->names_offset &&
+		header->names_size > 0 && data[header->names_offset + header->names_size - 1] == '\0';
+	const s_archive_entry* const entries = reinterpret_cast<const s_archive_entry*>(data + header->entries_offset);
+	for (dword i = 0; contents_valid && i < header->entry_count; i++)
+	{
+		contents_valid =
+			entries[i].data_offset <= file_size && entries[i].data_size <= file_size - entries[i].data_offset &&
+			entries[i].name_offset < header->names_size &&
+			(i == 0 || entries[i - 1].name_hash < entries[i].name_hash);
+	}
+	if (!contents_valid)
+	{
+		LOG_WARNING(L"archive %s is truncated or has an invalid table of contents!", file_path);
+		this->close();
+		return K_FAILURE;
+	}
+
+	m_entries = entries;
+	m_entry_count = header->entry_count;
+	m_names = reinterpret_cast<const char*>(data + header->names_offset);
+
+	return K_SUCCESS;
+}
+
+void c_asset_archive::close()
+{
+	m_file.close();
+	m_entries = nullptr;
+	m_entry_count = 0;
+	m_names = nullptr;
+}
+
+const s_archive_entry* const c_asset_archive::find(const char* const name) const
+{
+	return this->find(hash_archive_name(name));
+}
+
+const s_archive_entry* const c_asset_archive::find(const qword name_hash) const
+{
+	// Entries are sorted by hash when packed
+	dword low = 0;
+	dword high = m_entry_count;
+	while (low < high)
+	{
+		const dword middle = low + (high - low) / 2;
+		if (m_entries[middle].name_hash < name_hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (low < m_entry_count && m_entries[low].name_hash == name_hash)
+	{
+		return &m_entries[low];
+	}
+	return nullptr;
+}
+
+bool c_asset_archive::validate_cook_manifests(const bool check_contents) const
+{
+	assert(this->is_open());
+
+	constexpr size_t manifest_name_length = sizeof(COOK_MANIFEST_NAME) - 1;
+	bool valid = true;
+	for (dword i = 0; i < m_entry_count; i++)
+	{
+		// Manifests sit in the root of each cooked directory, "models/cook.manifest" for instance
+		const char* const name = this->get_name(&m_entries[i]);
+		const size_t name_length = strlen(name);
+		const bool is_manifest =
+			name_length >= manifest_name_length && strcmp(name + name_length - manifest_name_length, COOK_MANIFEST_NAME) == 0 &&
+			(name_length == manifest_name_length || name[name_length - manifest_name_length - 1] == '/');
+		if (is_manifest && !this->validate_cook_manifest(&m_entries[i], check_contents))
+		{
+			valid = false;
+		}
+	}
+	return valid;
+}
+
+bool c_asset_archive::validate_cook_manifest(const s_archive_entry* const manifest_entry, const bool check_contents) const
+{
+	const char* const manifest_name = this->get_name(manifest_entry);
+	const ubyte* const data = this->get_data(manifest_entry);
+	const s_cook_manifest_header* const header = reinterpret_cast<const s_cook_manifest_header*>(data);
+	const bool header_valid = manifest_entry->data_size >= sizeof(s_cook_manifest_header) && header->signature == COOK_MANIFEST_SIGNATURE && header->version == COOK_MANIFEST_VERSION;
+	const qword entries_size = header_valid ? static_cast<qword>(header->entry_count) * sizeof(s_cook_manifest_entry) : 0;
+	if (!header_valid || sizeof(s_cook_manifest_header) + entries_size + header->names_size != manifest_entry->data_size || header->names_size == 0 || data[manifest_entry->data_size - 1] != '\0')
+	{
+		LOG_WARNING(L"%hs is invalid or from an older version! recook assets", manifest_name);
+		return K_FAILURE;
+	}
+
+	// Names in the manifest are relative to its directory
+	const size_t directory_length = strlen(manifest_name) - (sizeof(COOK_MANIFEST_NAME) - 1);
+	const s_cook_manifest_entry* const entries = reinterpret_cast<const s_cook_manifest_entry*>(data + sizeof(s_cook_manifest_header));
+	const char* const names = reinterpret_cast<const char*>(data + sizeof(s_cook_manifest_header) + entries_size);
+	bool valid = true;
+	for (dword i = 0; i < header->entry_count; i++)
+	{
+		const s_cook_manifest_entry& cooked_entry = entries[i];
+		char name[MAXIMUM_PATH];
+		if (cooked_entry.name_offset >= header->names_size || sprintf_s(name, MAXIMUM_PATH, "%.*s%s", static_cast<int>(directory_length), manifest_name, names + cooked_entry.name_offset) < 0)
+		{
+			LOG_WARNING(L"%hs has an invalid entry! recook assets", manifest_name);
+			return K_FAILURE;
+		}
+
+		const s_archive_entry* const entry = this->find(name);
+		if (entry == nullptr)
+		{
+			LOG_WARNING(L"%hs was cooked but not packed! recook assets", name);
+			valid = false;
+		}
+		else if (entry->data_size != cooked_entry.content_size)
+		{
+			LOG_WARNING(L"%hs is %llu bytes, cooked as %llu! recook assets", name, entry->data_size, cooked_entry.content_size);
+			valid = false;
+		}
+		else if (check_contents && hash_cooked_content(this->get_data(entry), entry->data_size) != cooked_entry.content_hash)
+		{
+			LOG_WARNING(L"%hs doesn't match what was cooked! recook assets", name);
+			valid = false;
+		}
+	}
+	return valid;
+}
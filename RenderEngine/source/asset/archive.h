@@ -0,0 +1,38 @@
+#pragma once
+#include <types.h>
+#include <asset/mapped_file.h>
+#include <asset/archive_format.h>
+#include <asset/cook_manifest_format.h>
+
+// Packed asset archive, the whole file is opened with a single mapping
+// Files are found by hashed name with a binary search over the sorted table of contents, and read in place
+class c_asset_archive
+{
+public:
+	c_asset_archive();
+
+	bool open(const wchar_t* const file_path);
+	void close();
+
+	inline const bool is_open() const { return m_entries != nullptr; };
+	inline const dword get_entry_count() const { return m_entry_count; };
+
+	// Returns nullptr if no file with this name was packed
+	const s_archive_entry* const find(const char* const name) const;
+	const s_archive_entry* const find(const qword name_hash) const;
+
+	inline const ubyte* const get_data(const s_archive_entry* const entry) const { return m_file.get_data() + entry->data_offset; };
+	inline const char* const get_name(const s_archive_entry* const entry) const { return m_names + entry->name_offset; };
+
+	// Check every file listed in the packed cook manifests is in the archive at the size it was cooked to, and with check_contents that its bytes hash the same
+	// Returns K_FAILURE if any are missing or differ, meaning the archive was packed from a partial or stale cook
+	bool validate_cook_manifests(const bool check_contents) const;
+
+private:
+	bool validate_cook_manifest(const s_archive_entry* const manifest_entry, const bool check_contents) const;
+
+	c_mapped_file m_file;
+	const s_archive_entry* m_entries;
+	dword m_entry_count;
+	const char* m_names;
+};
@@ -0,0 +1,58 @@
+#pragma once
+// Packed asset archive layout, shared between the engine and tools/asset_compiler
+// The asset compiler builds on platforms where the sizes asserted in types.h don't hold, so this header only uses cstdint types
+#include <cstdint>
+
+// 'PACK' read as a little endian uint32
+constexpr uint32_t ARCHIVE_FILE_SIGNATURE = 0x4B434150;
+constexpr uint32_t ARCHIVE_FILE_VERSION = 1;
+// Table of contents & every file blob start on this boundary from the start of the archive
+constexpr uint32_t ARCHIVE_DATA_ALIGNMENT = 256;
+
+enum e_archive_entry_type : uint32_t
+{
+	_archive_entry_raw,
+	_archive_entry_mesh, // cooked .mesh
+	_archive_entry_texture, // .dds
+
+	k_archive_entry_type_count
+};
+
+struct s_archive_file_header
+{
+	uint32_t signature; // ARCHIVE_FILE_SIGNATURE
+	uint32_t version; // ARCHIVE_FILE_VERSION
+	uint32_t entry_count;
+	uint32_t reserved;
+	uint64_t entries_offset; // s_archive_entry[entry_count], sorted by name_hash
+	uint64_t names_offset; // null terminated entry names, kept for debugging & collision checks
+	uint64_t names_size;
+	uint64_t reserved1;
+};
+static_assert(sizeof(s_archive_file_header) == 0x30);
+
+struct s_archive_entry
+{
+	uint64_t name_hash; // hash_archive_name of the entry name
+	uint64_t data_offset; // from the start of the archive, entries with identical contents share one blob so this also identifies the content
+	uint64_t data_size;
+	uint32_t type; // e_archive_entry_type
+	uint32_t name_offset; // from names_offset
+};
+static_assert(sizeof(s_archive_entry) == 0x20);
+
+// 64 bit FNV-1a over an ASCII entry name, case insensitive & treating '\' as '/' so "models\Cube.mesh" matches "models/cube.mesh"
+template<typename t_character>
+constexpr uint64_t hash_archive_name(const t_character* name)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (; *name != 0; name++)
+	{
+		uint32_t character = static_cast<uint32_t>(*name);
+		character = character == '\\' ? '/' : character;
+		character = (character >= 'A' && character <= 'Z') ? character - 'A' + 'a' : character;
+		hash = (hash ^ character) * 0x100000001B3ull;
+	}
+	return hash;
+}
+static_assert(hash_archive_name("models\\Cube.mesh") == hash_archive_name(L"models/cube.mesh"));
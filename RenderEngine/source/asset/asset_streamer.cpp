@@ -0,0 +1,374 @@
+#include "asset_streamer.h"
+#include <asset/archive.h>
+#include <asset/mapped_file.h>
+#include <render/render.h>
+#include <reporting/report.h>
+#include <algorithm>
+#ifdef API_DX12
+#include <render/api/directx12/helpers.h>
+#include <render/api/directx12/upload_batch.h>
+#include <d3d12.h>
+#endif
+
+// Uploads from every worker share the one command queue, so past a few workers they just wait on each other
+constexpr dword MAXIMUM_STREAMING_THREADS = 4;
+// Requests a worker takes at once to record into a single upload submit
+constexpr dword MAXIMUM_REQUESTS_PER_BATCH = 8;
+
+// Heap comparison, true if a should be streamed after b
+static bool stream_request_after(const s_stream_request& a, const s_stream_request& b)
+{
+	return a.priority != b.priority ? a.priority > b.priority : a.sequence > b.sequence;
+}
+
+// Loose file equivalent of an archive name, "models/cube.mesh" -> "assets\models\cube.mesh"
+static void get_loose_asset_path(const char* const asset_name, wchar_t (&out_path)[MAXIMUM_PATH])
+{
+	swprintf_s(out_path, MAXIMUM_PATH, L"assets\\%hs", asset_name);
+	for (wchar_t* character = out_path; *character != L'\0'; character++)
+	{
+		*character = *character == L'/' ? L'\\' : *character;
+	}
+}
+
+static dword get_streaming_thread_count()
+{
+	// Leave a hardware thread free for the render thread
+	const dword hardware_thread_count = std::thread::hardware_concurrency();
+	const dword thread_count = hardware_thread_count > 1 ? hardware_thread_count - 1 : 1;
+	return thread_count < MAXIMUM_STREAMING_THREADS ? thread_count : MAXIMUM_STREAMING_THREADS;
+}
+
+static void release_stream_result(s_stream_result* const result)
+{
+	delete[] result->geometry.meshlets;
+	result->geometry.meshlets = nullptr;
+#ifdef API_DX12
+	SAFE_RELEASE(result->geometry.vertex_buffer);
+	SAFE_RELEASE(result->geometry.index_buffer);
+	ID3D12Resource* texture_resource = (ID3D12Resource*)result->texture.resource;
+	SAFE_RELEASE(texture_resource);
+#endif
+}
+
+c_asset_streamer::c_asset_streamer(c_renderer* const renderer, const c_asset_archive* const archive)
+	: m_renderer(renderer)
+	, m_archive(archive)
+	, m_thread_count(get_streaming_thread_count())
+	, m_threads()
+	, m_mutex()
+	, m_request_condition()
+	, m_requests()
+	, m_results()
+	, m_next_sequence(0)
+	, m_outstanding_count(0)
+	, m_stopping(false)
+	, m_loose_names()
+	, m_batch_start_time()
+	, m_batch_count(0)
+	, m_batch_uploaded_bytes(0)
+	, m_batch_submit_count(0)
+	, m_batch_wait_milliseconds(0.0)
+{
+	for (dword i = 0; i < m_thread_count; i++)
+	{
+		m_threads.emplace_back(&c_asset_streamer::worker_main, this);
+	}
+}
+
+c_asset_streamer::~c_asset_streamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		for (const s_stream_request& request : m_requests)
+		{
+			if (request.type == _stream_request_texture)
+			{
+				request.texture->set_streaming(false);
+			}
+		}
+		m_requests.clear();
+	}
+	m_request_condition.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+
+	// Finished but never swapped in, nothing else owns these
+	for (s_stream_result& result : m_results)
+	{
+		if (result.request.type == _stream_request_texture)
+		{
+			result.request.texture->set_streaming(false);
+		}
+		release_stream_result(&result);
+	}
+}
+
+void c_asset_streamer::request_mesh(c_mesh* const mesh, const char* const name, const e_stream_priority priority)
+{
+	const bool arguments_valid = mesh != nullptr && name != nullptr;
+	assert(arguments_valid);
+	if (!arguments_valid)
+	{
+		LOG_WARNING(L"invalid arguments! ignoring request");
+		return;
+	}
+
+	s_stream_request request = {};
+	request.type = _stream_request_mesh;
+	request.priority = priority;
+	strcpy_s(request.name, MAXIMUM_PATH, name);
+	request.mesh = mesh;
+	this->request(request);
+}
+
+void c_asset_streamer::request_texture(c_render_texture* const texture, const char* const name, const e_stream_priority priority, const dword maximum_size)
+{
+	const bool arguments_valid = texture != nullptr && !texture->is_streaming() && name != nullptr;
+	assert(arguments_valid);
+	if (!arguments_valid)
+	{
+		LOG_WARNING(L"texture is already streaming! ignoring request");
+		return;
+	}
+
+	s_stream_request request = {};
+	request.type = _stream_request_texture;
+	request.priority = priority;
+	strcpy_s(request.name, MAXIMUM_PATH, name);
+	request.texture = texture;
+	request.texture_type = texture->get_type();
+	request.texture_maximum_size = maximum_size;
+	texture->set_streaming(true);
+	this->request(request);
+}
+
+void c_asset_streamer::request(const s_stream_request& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_outstanding_count == 0)
+		{
+			m_batch_start_time = std::chrono::steady_clock::now();
+			m_batch_count = 0;
+			m_batch_uploaded_bytes = 0;
+			m_batch_submit_count = 0;
+			m_batch_wait_milliseconds = 0.0;
+		}
+
+		m_requests.push_back(request);
+		m_requests.back().sequence = m_next_sequence++;
+		std::push_heap(m_requests.begin(), m_requests.end(), stream_request_after);
+		m_outstanding_count++;
+		m_batch_count++;
+	}
+	m_request_condition.notify_one();
+}
+
+dword c_asset_streamer::update()
+{
+	std::vector<s_stream_result> results;
+	bool batch_finished = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_results.empty())
+		{
+			return 0;
+		}
+		results.swap(m_results);
+		m_outstanding_count -= static_cast<dword>(results.size());
+		batch_finished = m_outstanding_count == 0;
+	}
+
+	// Safe to swap here as the command list for the next frame hasn't been recorded yet
+	dword loaded_count = 0;
+	for (const s_stream_result& result : results)
+	{
+		if (result.request.type == _stream_request_texture)
+		{
+			result.request.texture->set_streaming(false);
+		}
+		if (!result.loaded)
+		{
+			continue;
+		}
+
+		if (result.request.type == _stream_request_mesh)
+		{
+			// Meshlets are only read on this thread while culling, but frames in flight may still draw the buffers
+			s_geometry_resources replaced_resources;
+			if (result.request.mesh->set_streamed_resources(&result.geometry, &replaced_resources))
+			{
+				m_renderer->retire_geometry(&replaced_resources);
+				delete[] replaced_resources.meshlets;
+			}
+		}
+		else
+		{
+			// Frames still in flight may be sampling the texture being replaced
+			s_texture_resources replaced_resources;
+			if (result.request.texture->set_streamed_resources(&result.texture, &replaced_resources))
+			{
+				m_renderer->retire_texture(&replaced_resources);
+			}
+		}
+		loaded_count++;
+	}
+
+	if (batch_finished)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_batch_start_time).count();
+		LOG_MESSAGE(L"streamed %d assets in %.2fms on %d threads", m_batch_count, elapsed_ms, m_thread_count);
+		LOG_MESSAGE(L"uploaded %.2fMB in %d submits, %.2fms waiting on the GPU", m_batch_uploaded_bytes / (1024.0 * 1024.0), m_batch_submit_count, m_batch_wait_milliseconds);
+	}
+
+	return loaded_count;
+}
+
+dword c_asset_streamer::get_outstanding_count()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_outstanding_count;
+}
+
+void c_asset_streamer::override_archive(const char* const name)
+{
+	assert(name != nullptr);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_loose_names.insert(hash_archive_name(name));
+}
+
+void c_asset_streamer::worker_main()
+{
+	// Each worker records into its own staging memory & command list
+	c_upload_batch* const upload_batch = m_renderer->create_upload_batch();
+	if (upload_batch == nullptr)
+	{
+		LOG_ERROR(L"streaming thread has no upload batch! exiting");
+		return;
+	}
+
+	std::vector<s_stream_request> requests;
+	std::vector<s_stream_result> results;
+	std::vector<s_stream_result> failed_results;
+	while (true)
+	{
+		// Take a share of the queue, highest priority first, so idle workers still get requests of their own
+		requests.clear();
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_request_condition.wait(lock, [this] { return m_stopping || !m_requests.empty(); });
+			if (m_stopping)
+			{
+				break;
+			}
+
+			const dword queued_count = static_cast<dword>(m_requests.size());
+			dword take_count = queued_count / m_thread_count;
+			take_count = take_count < 1 ? 1 : take_count;
+			take_count = take_count < MAXIMUM_REQUESTS_PER_BATCH ? take_count : MAXIMUM_REQUESTS_PER_BATCH;
+			for (dword i = 0; i < take_count; i++)
+			{
+				std::pop_heap(m_requests.begin(), m_requests.end(), stream_request_after);
+				requests.push_back(m_requests.back());
+				m_requests.pop_back();
+			}
+		}
+
+		// Record every upload, then one submit & fence wait for all of them
+		results.clear();
+		failed_results.clear();
+		for (const s_stream_request& request : requests)
+		{
+			s_stream_result result = {};
+			result.request = request;
+			result.loaded = true;
+			if (this->load(request, &result, upload_batch))
+			{
+				results.push_back(result);
+			}
+			else
+			{
+				failed_results.push_back(result);
+			}
+		}
+		if (!upload_batch->flush())
+		{
+			LOG_WARNING(L"streaming upload failed! keeping placeholders");
+			failed_results.insert(failed_results.end(), results.begin(), results.end());
+			results.clear();
+		}
+
+		// Partially loaded resources can only be released once the batch is done with them
+		for (s_stream_result& result : failed_results)
+		{
+			release_stream_result(&result);
+			result.loaded = false;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const s_upload_batch_statistics* const upload_statistics = upload_batch->get_statistics();
+		m_batch_uploaded_bytes += upload_statistics->bytes_uploaded;
+		m_batch_submit_count += upload_statistics->submit_count;
+		m_batch_wait_milliseconds += upload_statistics->wait_milliseconds;
+		upload_batch->reset_statistics();
+
+		// Failed requests keep their placeholder, or the mips they already had
+		m_results.insert(m_results.end(), results.begin(), results.end());
+		m_results.insert(m_results.end(), failed_results.begin(), failed_results.end());
+	}
+
+	delete upload_batch;
+}
+
+bool c_asset_streamer::load(const s_stream_request& request, s_stream_result* const out_result, c_upload_batch* const upload_batch)
+{
+	wchar_t debug_name[MAXIMUM_PATH] = {};
+	swprintf_s(debug_name, MAXIMUM_PATH, L"%hs", request.name);
+
+	// Archive data is already mapped, loose files are mapped just until their upload is recorded
+	const ubyte* data = nullptr;
+	qword data_size = 0;
+	c_mapped_file loose_file;
+	bool from_archive = m_archive != nullptr && m_archive->is_open();
+	if (from_archive)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		from_archive = m_loose_names.count(hash_archive_name(request.name)) == 0;
+	}
+	if (from_archive)
+	{
+		const e_archive_entry_type entry_type = request.type == _stream_request_mesh ? _archive_entry_mesh : _archive_entry_texture;
+		const s_archive_entry* const entry = m_archive->find(request.name);
+		if (entry == nullptr || entry->type != entry_type)
+		{
+			LOG_WARNING(L"%s is not in the asset archive! keeping placeholder", debug_name);
+			return K_FAILURE;
+		}
+		data = m_archive->get_data(entry);
+		data_size = entry->data_size;
+	}
+	else
+	{
+		wchar_t file_path[MAXIMUM_PATH] = {};
+		get_loose_asset_path(request.name, file_path);
+		if (!loose_file.open(file_path))
+		{
+			LOG_WARNING(L"failed to open %s! keeping placeholder", file_path);
+			return K_FAILURE;
+		}
+		data = loose_file.get_data();
+		data_size = loose_file.get_size();
+	}
+
+	if (request.type == _stream_request_mesh)
+	{
+		return m_renderer->load_model_from_memory(data, data_size, debug_name, &out_result->geometry, upload_batch);
+	}
+	return m_renderer->load_texture_from_memory(request.texture_type, data, data_size, request.texture_maximum_size, debug_name, &out_result->texture, upload_batch);
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <types.h>
+#include <render/model.h>
+#include <render/texture.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+
+// Requests are streamed lowest priority value first, in request order within the same priority
+enum e_stream_priority
+{
+	_stream_priority_high,
+	_stream_priority_normal,
+	_stream_priority_low,
+
+	k_stream_priority_count
+};
+
+enum e_stream_request_type
+{
+	_stream_request_mesh,
+	_stream_request_texture,
+
+	k_stream_request_type_count
+};
+
+struct s_stream_request
+{
+	e_stream_request_type type;
+	e_stream_priority priority;
+	qword sequence; // request order
+	char name[MAXIMUM_PATH]; // archive name, e.g. "models/cube.mesh"
+	c_mesh* mesh;
+	c_render_texture* texture;
+	e_texture_type texture_type; // copied so workers never touch the texture itself
+	dword texture_maximum_size; // mips wider or taller than this are left out, 0 loads every mip
+};
+
+struct s_stream_result
+{
+	s_stream_request request;
+	bool loaded; // failed requests keep what they had, update() just marks them finished
+	s_geometry_resources geometry;
+	s_texture_resources texture;
+};
+
+class c_renderer;
+class c_asset_archive;
+class c_upload_batch;
+
+// Loads, decodes & uploads meshes and textures on worker threads
+// Callers create placeholder meshes & textures which render straight away, and update() swaps the real resources in between frames
+class c_asset_streamer
+{
+public:
+	// archive may be nullptr or closed, in which case requests are loaded from loose files under the assets directory
+	c_asset_streamer(c_renderer* const renderer, const c_asset_archive* const archive);
+	// Stops the workers after their current request, anything unfinished is dropped
+	// Must be destroyed before any mesh or texture it still has requests for
+	~c_asset_streamer();
+
+	// mesh may be a placeholder, created with only a renderer, or already streamed in
+	// Streamed meshes are loaded again & the geometry they replace is retired through the renderer
+	void request_mesh(c_mesh* const mesh, const char* const name, const e_stream_priority priority);
+	// texture must be a placeholder or already streamed in, and not still streaming
+	// Streamed textures are loaded again at the new maximum size & the texture they replace is retired through the renderer
+	void request_texture(c_render_texture* const texture, const char* const name, const e_stream_priority priority, const dword maximum_size);
+
+	// Swap every finished request into its mesh or texture, call from the render thread between frames
+	// Returns the number of assets swapped in
+	dword update();
+
+	// Number of requests not yet swapped in by update()
+	dword get_outstanding_count();
+
+	// Load name from its loose file from now on, even if the archive has it, for assets changed since the archive was packed
+	void override_archive(const char* const name);
+
+private:
+	void request(const s_stream_request& request);
+	void worker_main();
+	// Records the upload into upload_batch, the result can't be used until the batch is flushed
+	bool load(const s_stream_request& request, s_stream_result* const out_result, c_upload_batch* const upload_batch);
+
+	c_renderer* const m_renderer;
+	const c_asset_archive* const m_archive;
+	const dword m_thread_count;
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex; // guards everything below
+	std::condition_variable m_request_condition;
+	std::vector<s_stream_request> m_requests; // heap ordered by priority, then sequence
+	std::vector<s_stream_result> m_results;
+	qword m_next_sequence;
+	dword m_outstanding_count;
+	bool m_stopping;
+	std::unordered_set<qword> m_loose_names; // hash_archive_name of every overridden archive entry
+
+	// Reported when the queue drains, from the first request after it was last empty
+	std::chrono::steady_clock::time_point m_batch_start_time;
+	dword m_batch_count;
+	qword m_batch_uploaded_bytes; // summed from every worker's upload batch
+	dword m_batch_submit_count;
+	double m_batch_wait_milliseconds;
+};
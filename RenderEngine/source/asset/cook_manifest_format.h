@@ -0,0 +1,60 @@
+#pragma once
+// Cook manifest layout, shared between the engine and tools/asset_compiler
+// The asset compiler writes one into every directory it cooks, recording what each output was cooked from so unchanged assets are skipped
+// Manifests are packed into the archive alongside the files they describe, so the engine can check the cooked data it loads
+// The asset compiler builds on platforms where the sizes asserted in types.h don't hold, so this header only uses cstdint types
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// 'CMAN' read as a little endian uint32
+constexpr uint32_t COOK_MANIFEST_SIGNATURE = 0x4E414D43;
+constexpr uint32_t COOK_MANIFEST_VERSION = 1;
+// File name of the manifest in each cooked directory
+constexpr char COOK_MANIFEST_NAME[] = "cook.manifest";
+
+struct s_cook_manifest_header
+{
+	uint32_t signature; // COOK_MANIFEST_SIGNATURE
+	uint32_t version; // COOK_MANIFEST_VERSION
+	uint32_t entry_count; // s_cook_manifest_entry[entry_count] follow the header
+	uint32_t reserved;
+	uint64_t names_size; // null terminated names follow the entries
+	uint64_t reserved1;
+};
+static_assert(sizeof(s_cook_manifest_header) == 0x20);
+
+struct s_cook_manifest_entry
+{
+	uint64_t content_hash; // hash_cooked_content of the cooked file
+	uint64_t content_size;
+	uint64_t source_hash; // hash_cooked_content of the file it was cooked from
+	uint64_t source_size;
+	uint64_t source_write_time; // in the tool's file clock, a source with the same size & time isn't hashed again
+	uint64_t settings_hash; // cooker version & the options it was cooked with
+	uint32_t name_offset; // from the end of the entries, cooked file path relative to the manifest's directory using '/'
+	uint32_t source_name_offset; // from the end of the entries, source file path relative to the directory it was cooked from
+};
+static_assert(sizeof(s_cook_manifest_entry) == 0x38);
+
+constexpr uint64_t COOK_HASH_SEED = 0xCBF29CE484222325ull;
+
+// FNV-1a style hash taken a word at a time so whole textures hash quickly, pass the previous hash to continue one
+// Only used to notice changed files, not to protect against tampering
+inline uint64_t hash_cooked_content(const void* const data, const size_t size, uint64_t hash = COOK_HASH_SEED)
+{
+	const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+	size_t offset = 0;
+	for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + offset, sizeof(word));
+		hash = (hash ^ word) * 0x100000001B3ull;
+		hash ^= hash >> 29;
+	}
+	for (; offset < size; offset++)
+	{
+		hash = (hash ^ bytes[offset]) * 0x100000001B3ull;
+	}
+	return hash;
+}
@@ -0,0 +1,184 @@
+#include "file_watcher.h"
+#include <reporting/report.h>
+#include <cassert>
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#endif
+
+// Changes arriving faster than they're polled queue up here, if it fills they're dropped & a warning is logged
+constexpr dword FILE_WATCHER_BUFFER_SIZE = 64 * 1024;
+
+c_file_watcher::c_file_watcher()
+#ifdef PLATFORM_WINDOWS
+	: m_directory_handle(INVALID_HANDLE_VALUE)
+	, m_overlapped(nullptr)
+	, m_buffer(FILE_WATCHER_BUFFER_SIZE / sizeof(dword))
+	, m_open(false)
+#else
+	: m_open(false)
+#endif
+	, m_pending_files()
+{
+}
+
+c_file_watcher::~c_file_watcher()
+{
+	this->close();
+}
+
+bool c_file_watcher::open(const wchar_t* const directory_path)
+{
+	const bool valid_arguments = directory_path != nullptr;
+	assert(valid_arguments);
+	if (!valid_arguments)
+	{
+		LOG_WARNING(L"invalid arguments in call! aborting");
+		return K_FAILURE;
+	}
+
+	this->close();
+
+#ifdef PLATFORM_WINDOWS
+	m_directory_handle = CreateFileW(directory_path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (m_directory_handle == INVALID_HANDLE_VALUE)
+	{
+		LOG_WARNING(L"failed to open directory %s! (error %d)", directory_path, GetLastError());
+		return K_FAILURE;
+	}
+
+	m_overlapped = new OVERLAPPED();
+	m_overlapped->hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (m_overlapped->hEvent == nullptr)
+	{
+		LOG_WARNING(L"failed to create event for %s! (error %d)", directory_path, GetLastError());
+		this->close();
+		return K_FAILURE;
+	}
+
+	if (!this->read_changes())
+	{
+		LOG_WARNING(L"failed to watch directory %s! (error %d)", directory_path, GetLastError());
+		this->close();
+		return K_FAILURE;
+	}
+
+	m_open = true;
+	return K_SUCCESS;
+#else
+#error FILE WATCHING MISSING FROM CURRENT PLATFORM
+#endif
+}
+
+void c_file_watcher::close()
+{
+#ifdef PLATFORM_WINDOWS
+	if (m_overlapped != nullptr)
+	{
+		// The read has to finish cancelling before its buffer & OVERLAPPED can be freed
+		if (m_open)
+		{
+			DWORD transferred_bytes = 0;
+			CancelIoEx(m_directory_handle, m_overlapped);
+			GetOverlappedResult(m_directory_handle, m_overlapped, &transferred_bytes, TRUE);
+		}
+		if (m_overlapped->hEvent != nullptr)
+		{
+			CloseHandle(m_overlapped->hEvent);
+		}
+		delete m_overlapped;
+	}
+	if (m_directory_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_directory_handle);
+	}
+	m_directory_handle = INVALID_HANDLE_VALUE;
+	m_overlapped = nullptr;
+#endif
+	m_open = false;
+	m_pending_files.clear();
+}
+
+void c_file_watcher::poll(std::vector<std::string>* const out_changed_files)
+{
+	assert(out_changed_files != nullptr);
+	if (!m_open)
+	{
+		return;
+	}
+
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+#ifdef PLATFORM_WINDOWS
+	DWORD transferred_bytes = 0;
+	while (GetOverlappedResult(m_directory_handle, m_overlapped, &transferred_bytes, FALSE))
+	{
+		if (transferred_bytes == 0)
+		{
+			LOG_WARNING(L"too many file changes at once, some were missed!");
+		}
+		else
+		{
+			const ubyte* record = reinterpret_cast<const ubyte*>(m_buffer.data());
+			for (;;)
+			{
+				const FILE_NOTIFY_INFORMATION* const information = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+				// Removed & renamed away files have nothing left to reload
+				if (information->Action == FILE_ACTION_ADDED || information->Action == FILE_ACTION_MODIFIED || information->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					char file_name[MAXIMUM_PATH] = {};
+					const int32 name_length = WideCharToMultiByte(CP_UTF8, 0, information->FileName, information->FileNameLength / sizeof(WCHAR), file_name, MAXIMUM_PATH - 1, nullptr, nullptr);
+					if (name_length > 0)
+					{
+						for (int32 i = 0; i < name_length; i++)
+						{
+							file_name[i] = file_name[i] == '\\' ? '/' : file_name[i];
+						}
+						m_pending_files[file_name] = now;
+					}
+				}
+				if (information->NextEntryOffset == 0)
+				{
+					break;
+				}
+				record += information->NextEntryOffset;
+			}
+		}
+
+		ResetEvent(m_overlapped->hEvent);
+		if (!this->read_changes())
+		{
+			LOG_WARNING(L"failed to keep watching for file changes! (error %d)", GetLastError());
+			// No read is left to cancel
+			m_open = false;
+			this->close();
+			return;
+		}
+	}
+	if (GetLastError() != ERROR_IO_INCOMPLETE)
+	{
+		LOG_WARNING(L"failed to read file changes! (error %d)", GetLastError());
+		m_open = false;
+		this->close();
+		return;
+	}
+#endif
+
+	for (auto pending_file = m_pending_files.begin(); pending_file != m_pending_files.end();)
+	{
+		if (now - pending_file->second < std::chrono::milliseconds(FILE_WATCHER_SETTLE_MILLISECONDS))
+		{
+			pending_file++;
+			continue;
+		}
+		out_changed_files->push_back(pending_file->first);
+		pending_file = m_pending_files.erase(pending_file);
+	}
+}
+
+#ifdef PLATFORM_WINDOWS
+bool c_file_watcher::read_changes()
+{
+	const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+	const DWORD buffer_size = static_cast<DWORD>(m_buffer.size() * sizeof(dword));
+	return ReadDirectoryChangesW(m_directory_handle, m_buffer.data(), buffer_size, TRUE, filter, nullptr, m_overlapped, nullptr) ? K_SUCCESS : K_FAILURE;
+}
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#include <types.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+// Editors often save a file in several writes, so a change is only reported once the file has been left alone this long
+constexpr dword FILE_WATCHER_SETTLE_MILLISECONDS = 200;
+
+#ifdef PLATFORM_WINDOWS
+struct _OVERLAPPED;
+#endif
+
+// Reports files changed under a directory & its subdirectories, polled without blocking
+class c_file_watcher
+{
+public:
+	c_file_watcher();
+	~c_file_watcher();
+
+	c_file_watcher(const c_file_watcher&) = delete;
+	c_file_watcher& operator=(const c_file_watcher&) = delete;
+
+	// Start watching a directory, any previously watched directory is closed first
+	bool open(const wchar_t* const directory_path);
+	void close();
+
+	inline const bool is_open() const { return m_open; };
+
+	// Adds every file which changed & has since settled, relative to the directory using '/', e.g. "textures/crate/Crate_COLOR.tga"
+	void poll(std::vector<std::string>* const out_changed_files);
+
+private:
+#ifdef PLATFORM_WINDOWS
+	bool read_changes();
+
+	void* m_directory_handle; // HANDLE
+	_OVERLAPPED* m_overlapped;
+	std::vector<dword> m_buffer; // FILE_NOTIFY_INFORMATION records, which must be dword aligned
+#endif
+	bool m_open;
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_pending_files; // time of each file's last change
+};
@@ -0,0 +1,282 @@
+#include "hot_reload.h"
+#include <asset/asset_streamer.h>
+#include <render/render.h>
+#include <render/texture_cache.h>
+#include <scene/scene.h>
+#include <reporting/report.h>
+#include <algorithm>
+#include <cassert>
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#endif
+
+// Options matching tools\build_mesh.bat & tools\build_tex.bat, so reloaded assets cook the same as built ones
+constexpr wchar_t HOT_RELOAD_MESH_OPTIONS[] = L"-flipu";
+constexpr wchar_t HOT_RELOAD_TEXTURE_OPTIONS[] = L"-hflip -vflip";
+
+static bool has_extension(const std::string& file_name, const char* const extension)
+{
+	const size_t extension_offset = file_name.find_last_of('.');
+	return extension_offset != std::string::npos && _stricmp(file_name.c_str() + extension_offset, extension) == 0;
+}
+
+static std::string replace_extension(const std::string& file_name, const char* const extension)
+{
+	return file_name.substr(0, file_name.find_last_of('.')) + extension;
+}
+
+// Windows path from a root & a path relative to it using '/'
+static void get_path(const wchar_t* const root, const std::string& relative_path, wchar_t (&out_path)[MAXIMUM_PATH])
+{
+	swprintf_s(out_path, MAXIMUM_PATH, L"%s\\%hs", root, relative_path.c_str());
+	std::replace(out_path, out_path + wcslen(out_path), L'/', L'\\');
+}
+
+c_hot_reload::c_hot_reload(c_renderer* const renderer, c_asset_streamer* const streamer, c_texture_cache* const texture_cache, c_scene* const scene)
+	: m_renderer(renderer)
+	, m_streamer(streamer)
+	, m_texture_cache(texture_cache)
+	, m_scene(scene)
+	, m_watcher()
+	, m_source_directory()
+	, m_compiler_path()
+	, m_changed_files()
+	, m_jobs()
+	, m_pending_textures()
+	, m_meshes()
+{
+}
+
+c_hot_reload::~c_hot_reload()
+{
+#ifdef PLATFORM_WINDOWS
+	for (s_hot_reload_job& job : m_jobs)
+	{
+		WaitForSingleObject(job.process_handle, INFINITE);
+		CloseHandle(job.process_handle);
+	}
+#endif
+}
+
+bool c_hot_reload::open(const wchar_t* const source_directory, const wchar_t* const compiler_path)
+{
+	const bool valid_arguments = source_directory != nullptr && compiler_path != nullptr;
+	assert(valid_arguments);
+	if (!valid_arguments)
+	{
+		LOG_WARNING(L"invalid arguments in call! aborting");
+		return K_FAILURE;
+	}
+
+	wcscpy_s(m_source_directory, MAXIMUM_PATH, source_directory);
+	wcscpy_s(m_compiler_path, MAXIMUM_PATH, compiler_path);
+	if (!m_watcher.open(source_directory))
+	{
+		return K_FAILURE;
+	}
+#ifdef PLATFORM_WINDOWS
+	// Copied assets still reload without it, only those needing a cook fail
+	if (GetFileAttributesW(compiler_path) == INVALID_FILE_ATTRIBUTES)
+	{
+		LOG_WARNING(L"%s doesn't exist, build the project to compile it! changed meshes & textures won't be cooked", compiler_path);
+	}
+#endif
+	LOG_MESSAGE(L"hot reloading assets changed under %s", source_directory);
+	return K_SUCCESS;
+}
+
+void c_hot_reload::add_mesh(const char* const name, const s_mesh_handle handle)
+{
+	assert(name != nullptr);
+	m_meshes.emplace(name, handle);
+}
+
+void c_hot_reload::update()
+{
+	m_watcher.poll(&m_changed_files);
+
+	// A file saved again while it's cooking waits, two compilers writing the same output would race
+	std::vector<std::string> waiting_files;
+	for (const std::string& file_name : m_changed_files)
+	{
+		e_hot_reload_asset type = k_hot_reload_asset_count;
+		std::string name;
+		const wchar_t* options = nullptr;
+		if (has_extension(file_name, ".obj"))
+		{
+			type = _hot_reload_asset_mesh;
+			name = replace_extension(file_name, ".mesh");
+			options = HOT_RELOAD_MESH_OPTIONS;
+		}
+		else if (has_extension(file_name, ".tga"))
+		{
+			type = _hot_reload_asset_texture;
+			name = replace_extension(file_name, ".dds");
+			options = HOT_RELOAD_TEXTURE_OPTIONS;
+		}
+		else if (has_extension(file_name, ".mesh"))
+		{
+			type = _hot_reload_asset_mesh;
+			name = file_name;
+		}
+		else if (has_extension(file_name, ".dds"))
+		{
+			type = _hot_reload_asset_texture;
+			name = file_name;
+		}
+		else if (has_extension(file_name, ".hlsl"))
+		{
+			type = _hot_reload_asset_shader;
+			name = file_name;
+		}
+		else
+		{
+			// Directories, materials & anything else nothing is built from
+			continue;
+		}
+
+		const bool cooking = std::any_of(m_jobs.begin(), m_jobs.end(), [&name](const s_hot_reload_job& job) { return job.name == name; });
+		if (cooking)
+		{
+			waiting_files.push_back(file_name);
+			continue;
+		}
+
+		// Already cooked files are copied over as they are, the same as the build does
+		if (options != nullptr)
+		{
+			this->cook(file_name, name, type, options);
+		}
+		else if (this->copy(file_name, name, type))
+		{
+			this->reload(type, name);
+		}
+	}
+	m_changed_files.swap(waiting_files);
+
+#ifdef PLATFORM_WINDOWS
+	for (auto job = m_jobs.begin(); job != m_jobs.end();)
+	{
+		if (WaitForSingleObject(job->process_handle, 0) != WAIT_OBJECT_0)
+		{
+			job++;
+			continue;
+		}
+
+		DWORD exit_code = 0;
+		GetExitCodeProcess(job->process_handle, &exit_code);
+		CloseHandle(job->process_handle);
+		if (exit_code == 0)
+		{
+			this->reload(job->type, job->name);
+		}
+		else
+		{
+			// Whatever was loaded before stays, the next save tries again
+			LOG_WARNING(L"failed to cook %hs! (exit code %d)", job->name.c_str(), exit_code);
+		}
+		job = m_jobs.erase(job);
+	}
+#endif
+
+	// A texture can't be replaced mid stream, the reload would be overwritten by the request already in flight
+	std::vector<std::string> pending_textures;
+	pending_textures.swap(m_pending_textures);
+	for (const std::string& name : pending_textures)
+	{
+		this->reload(_hot_reload_asset_texture, name);
+	}
+}
+
+bool c_hot_reload::cook(const std::string& file_name, const std::string& name, const e_hot_reload_asset type, const wchar_t* const options)
+{
+#ifdef PLATFORM_WINDOWS
+	wchar_t source_path[MAXIMUM_PATH] = {};
+	wchar_t cooked_path[MAXIMUM_PATH] = {};
+	get_path(m_source_directory, file_name, source_path);
+	get_path(L"assets", name, cooked_path);
+
+	// CreateProcessW may write to the command line, so it can't be a literal
+	wchar_t command_line[MAXIMUM_PATH * 4] = {};
+	swprintf_s(command_line, MAXIMUM_PATH * 4, L"\"%s\" %s \"%s\" \"%s\"", m_compiler_path, options, source_path, cooked_path);
+
+	STARTUPINFOW startup_info = {};
+	startup_info.cb = sizeof(startup_info);
+	PROCESS_INFORMATION process_information = {};
+	if (!CreateProcessW(nullptr, command_line, nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr, &startup_info, &process_information))
+	{
+		LOG_WARNING(L"failed to run %s! (error %d)", m_compiler_path, GetLastError());
+		return K_FAILURE;
+	}
+	CloseHandle(process_information.hThread);
+
+	LOG_MESSAGE(L"cooking changed %hs", file_name.c_str());
+	m_jobs.push_back({ type, name, process_information.hProcess });
+	return K_SUCCESS;
+#else
+#error PROCESS CREATION MISSING FROM CURRENT PLATFORM
+#endif
+}
+
+bool c_hot_reload::copy(const std::string& file_name, const std::string& name, const e_hot_reload_asset type)
+{
+#ifdef PLATFORM_WINDOWS
+	wchar_t source_path[MAXIMUM_PATH] = {};
+	wchar_t cooked_path[MAXIMUM_PATH] = {};
+	get_path(m_source_directory, file_name, source_path);
+	get_path(L"assets", name, cooked_path);
+	if (!CopyFileW(source_path, cooked_path, FALSE))
+	{
+		LOG_WARNING(L"failed to copy %s to %s! (error %d)", source_path, cooked_path, GetLastError());
+		return K_FAILURE;
+	}
+	return K_SUCCESS;
+#else
+#error FILE COPYING MISSING FROM CURRENT PLATFORM
+#endif
+}
+
+void c_hot_reload::reload(const e_hot_reload_asset type, const std::string& name)
+{
+	// The archive was packed before this change, from now on the loose file is the current one
+	m_streamer->override_archive(name.c_str());
+
+	switch (type)
+	{
+		case _hot_reload_asset_mesh:
+		{
+			dword mesh_count = 0;
+			const auto meshes = m_meshes.equal_range(name);
+			for (auto registered_mesh = meshes.first; registered_mesh != meshes.second; registered_mesh++)
+			{
+				// Stale once the scene has released every reference, nothing is left to reload
+				c_mesh* const mesh = m_scene->m_meshes.get(registered_mesh->second);
+				if (mesh != nullptr)
+				{
+					m_streamer->request_mesh(mesh, name.c_str(), _stream_priority_high);
+					mesh_count++;
+				}
+			}
+			LOG_MESSAGE(L"reloading %hs into %d meshes", name.c_str(), mesh_count);
+			break;
+		}
+		case _hot_reload_asset_texture:
+		{
+			if (!m_texture_cache->reload(name.c_str()))
+			{
+				m_pending_textures.push_back(name);
+				break;
+			}
+			LOG_MESSAGE(L"reloading %hs", name.c_str());
+			break;
+		}
+		case _hot_reload_asset_shader:
+		{
+			wchar_t shader_path[MAXIMUM_PATH] = {};
+			get_path(L"assets", name, shader_path);
+			const dword shader_count = m_renderer->reload_shaders(shader_path);
+			LOG_MESSAGE(L"reloaded %d shaders using %hs", shader_count, name.c_str());
+			break;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <types.h>
+#include <asset/file_watcher.h>
+#include <scene/object.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+enum e_hot_reload_asset
+{
+	_hot_reload_asset_mesh,
+	_hot_reload_asset_texture,
+	_hot_reload_asset_shader,
+
+	k_hot_reload_asset_count
+};
+
+struct s_hot_reload_job
+{
+	e_hot_reload_asset type;
+	std::string name; // cooked asset name, e.g. "models/cube.mesh"
+	void* process_handle; // HANDLE of the asset compiler cooking it
+};
+
+class c_renderer;
+class c_asset_streamer;
+class c_texture_cache;
+class c_scene;
+
+// Watches the source assets while the game runs, cooks whatever changes into the build's assets directory & swaps it in between frames
+// Only the meshes, textures & shaders built from a changed file are replaced, everything else keeps its GPU resources
+class c_hot_reload
+{
+public:
+	c_hot_reload(c_renderer* const renderer, c_asset_streamer* const streamer, c_texture_cache* const texture_cache, c_scene* const scene);
+	// Waits for any cook still running, so no half written file is left behind
+	~c_hot_reload();
+
+	// source_directory is the uncooked assets directory, compiler_path the asset_compiler executable used to cook it, which compile_assets.bat builds
+	bool open(const wchar_t* const source_directory, const wchar_t* const compiler_path);
+
+	// Meshes aren't shared through a cache, so each one to reload has to be registered with the cooked name it was streamed from
+	void add_mesh(const char* const name, const s_mesh_handle handle);
+
+	// Start cooking changed files & swap in those finished, call from the render thread between frames
+	void update();
+
+private:
+	bool cook(const std::string& file_name, const std::string& name, const e_hot_reload_asset type, const wchar_t* const options);
+	bool copy(const std::string& file_name, const std::string& name, const e_hot_reload_asset type);
+	void reload(const e_hot_reload_asset type, const std::string& name);
+
+	c_renderer* const m_renderer;
+	c_asset_streamer* const m_streamer;
+	c_texture_cache* const m_texture_cache;
+	c_scene* const m_scene;
+
+	c_file_watcher m_watcher;
+	wchar_t m_source_directory[MAXIMUM_PATH];
+	wchar_t m_compiler_path[MAXIMUM_PATH];
+	std::vector<std::string> m_changed_files; // relative to the source directory, waiting on a cook of the same asset to finish
+	std::vector<s_hot_reload_job> m_jobs; // still cooking
+	std::vector<std::string> m_pending_textures; // cooked, but the textures they replace are still streaming
+	std::unordered_multimap<std::string, s_mesh_handle> m_meshes;
+};
@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+#include <reporting/report.h>
+#include <cassert>
+#ifdef PLATFORM_WINDOWS
+#include <windows.h>
+#endif
+
+c_mapped_file::c_mapped_file()
+	: m_data(nullptr)
+	, m_size(0)
+#ifdef PLATFORM_WINDOWS
+	, m_file_handle(INVALID_HANDLE_VALUE)
+	, m_mapping_handle(nullptr)
+#endif
+{
+}
+
+c_mapped_file::~c_mapped_file()
+{
+	this->close();
+}
+
+bool c_mapped_file::open(const wchar_t* const file_path)
+{
+	const bool valid_arguments = file_path != nullptr;
+	assert(valid_arguments);
+	if (!valid_arguments)
+	{
+		LOG_WARNING(L"invalid arguments in call! aborting");
+		return K_FAILURE;
+	}
+
+	this->close();
+
+#ifdef PLATFORM_WINDOWS
+	// Sequential scan hints the cache manager to read ahead aggressively, which suits how we consume mesh data
+	m_file_handle = CreateFileW(file_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file_handle == INVALID_HANDLE_VALUE)
+	{
+		LOG_WARNING(L"failed to open file %s!", file_path);
+		return K_FAILURE;
+	}
+
+	LARGE_INTEGER file_size = {};
+	if (!GetFileSizeEx(m_file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		// Empty files cannot be mapped
+		LOG_WARNING(L"file %s is empty or its size could not be read!", file_path);
+		this->close();
+		return K_FAILURE;
+	}
+	m_size = static_cast<qword>(file_size.QuadPart);
+
+	m_mapping_handle = CreateFileMappingW(m_file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping_handle == nullptr)
+	{
+		LOG_WARNING(L"failed to create file mapping for %s! (error %d)", file_path, GetLastError());
+		this->close();
+		return K_FAILURE;
+	}
+
+	m_data = static_cast<const ubyte*>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		LOG_WARNING(L"failed to map view of %s! (error %d)", file_path, GetLastError());
+		this->close();
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+#else
+#error FILE MAPPING MISSING FROM CURRENT PLATFORM
+#endif
+}
+
+void c_mapped_file::close()
+{
+#ifdef PLATFORM_WINDOWS
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping_handle != nullptr)
+	{
+		CloseHandle(m_mapping_handle);
+	}
+	if (m_file_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file_handle);
+	}
+	m_file_handle = INVALID_HANDLE_VALUE;
+	m_mapping_handle = nullptr;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <types.h>
+
+// Read only view of an entire file mapped into the process address space
+// Pages are faulted in by the OS on first access, no intermediate copies are made
+class c_mapped_file
+{
+public:
+	c_mapped_file();
+	~c_mapped_file();
+
+	c_mapped_file(const c_mapped_file&) = delete;
+	c_mapped_file& operator=(const c_mapped_file&) = delete;
+
+	// Map a file into memory, any previously mapped file is closed first
+	bool open(const wchar_t* const file_path);
+	void close();
+
+	inline const bool is_open() const { return m_data != nullptr; };
+	inline const ubyte* const get_data() const { return m_data; };
+	inline const qword get_size() const { return m_size; };
+
+private:
+	const ubyte* m_data;
+	qword m_size;
+#ifdef PLATFORM_WINDOWS
+	void* m_file_handle; // HANDLE
+	void* m_mapping_handle; // HANDLE
+#endif
+};
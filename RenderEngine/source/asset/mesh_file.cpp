@@ -0,0 +1,211 @@
+#include "mesh_file.h"
+#include <reporting/report.h>
+
+c_mesh_file::c_mesh_file()
+	: m_file()
+	, m_type(_mesh_file_none)
+	, m_vertex_data(nullptr)
+	, m_vertex_count(0)
+	, m_vertex_stride(0)
+	, m_vertex_format(_mesh_vertex_format_full)
+	, m_index_data(nullptr)
+	, m_index_count(0)
+	, m_index_format(_mesh_index_format_16)
+	, m_bounds(nullptr)
+	, m_lods(nullptr)
+	, m_lod_count(0)
+	, m_meshlets(nullptr)
+	, m_meshlet_count(0)
+{
+}
+
+bool c_mesh_file::open(const wchar_t* const file_path)
+{
+	this->close();
+
+	if (!m_file.open(file_path))
+	{
+		return K_FAILURE;
+	}
+
+	if (!this->parse(m_file.get_data(), m_file.get_size(), file_path))
+	{
+		this->close();
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+}
+
+bool c_mesh_file::open(const ubyte* const data, const qword data_size, const wchar_t* const debug_name)
+{
+	this->close();
+
+	if (!this->parse(data, data_size, debug_name))
+	{
+		this->close();
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+}
+
+bool c_mesh_file::parse(const ubyte* const data, const qword data_size, const wchar_t* const debug_name)
+{
+	// VBO files have no signature, but the leading vertex count can never match it as VBO vertex counts are limited to 16 bits
+	const bool is_cooked = data_size >= sizeof(uint32_t) && *reinterpret_cast<const uint32_t*>(data) == MESH_FILE_SIGNATURE;
+	return is_cooked ? this->parse_cooked(data, data_size, debug_name) : this->parse_vbo(data, data_size, debug_name);
+}
+
+bool c_mesh_file::parse_vbo(const ubyte* const data, const qword data_size, const wchar_t* const debug_name)
+{
+	if (data_size < sizeof(s_vbo_header))
+	{
+		LOG_WARNING(L"VBO %s is too small to contain a header! stopping load", debug_name);
+		return K_FAILURE;
+	}
+
+	const s_vbo_header* const header = reinterpret_cast<const s_vbo_header*>(data);
+	if (header->vertex_count == 0)
+	{
+		LOG_WARNING(L"vertex count for VBO %s was 0! stopping load", debug_name);
+		return K_FAILURE;
+	}
+	if (header->index_count == 0)
+	{
+		LOG_WARNING(L"index count for VBO %s was 0! stopping load", debug_name);
+		return K_FAILURE;
+	}
+
+	// Validate counts against the mapped size so we never read past the end of the view
+	const qword vertices_size = static_cast<qword>(header->vertex_count) * sizeof(vertex_part);
+	const qword indices_size = static_cast<qword>(header->index_count) * sizeof(uword);
+	if (sizeof(s_vbo_header) + vertices_size + indices_size > data_size)
+	{
+		LOG_WARNING(L"VBO %s is truncated! expected %llu bytes, got %llu. stopping load", debug_name, sizeof(s_vbo_header) + vertices_size + indices_size, data_size);
+		return K_FAILURE;
+	}
+
+	// header is 8 bytes and vertex_part is 32 bytes, so both ranges are naturally aligned within the view
+	m_type = _mesh_file_vbo;
+	m_vertex_count = header->vertex_count;
+	m_vertex_stride = sizeof(vertex_part);
+	m_vertex_format = _mesh_vertex_format_full;
+	m_vertex_data = data + sizeof(s_vbo_header);
+	m_index_count = header->index_count;
+	m_index_format = _mesh_index_format_16;
+	m_index_data = data + sizeof(s_vbo_header) + vertices_size;
+
+	return K_SUCCESS;
+}
+
+bool c_mesh_file::parse_cooked(const ubyte* const data, const qword data_size, const wchar_t* const debug_name)
+{
+	if (data_size < sizeof(s_mesh_file_header))
+	{
+		LOG_WARNING(L"mesh %s is too small to contain a header! stopping load", debug_name);
+		return K_FAILURE;
+	}
+
+	const s_mesh_file_header* const header = reinterpret_cast<const s_mesh_file_header*>(data);
+	if (header->version != MESH_FILE_VERSION)
+	{
+		LOG_WARNING(L"mesh %s is version %d, expected %d! recook assets", debug_name, header->version, MESH_FILE_VERSION);
+		return K_FAILURE;
+	}
+	if (header->vertex_count == 0 || header->index_count == 0)
+	{
+		LOG_WARNING(L"mesh %s has %d vertices and %d indices! stopping load", debug_name, header->vertex_count, header->index_count);
+		return K_FAILURE;
+	}
+	const dword expected_vertex_stride = header->vertex_format == _mesh_vertex_format_compact ? sizeof(s_mesh_file_compact_vertex) : sizeof(vertex);
+	if (header->vertex_format >= k_mesh_vertex_format_count || header->vertex_stride != expected_vertex_stride || header->index_format >= k_mesh_index_format_count)
+	{
+		LOG_WARNING(L"mesh %s has an unsupported vertex format (%d), vertex stride (%d) or index format (%d)! stopping load", debug_name, header->vertex_format, header->vertex_stride, header->index_format);
+		return K_FAILURE;
+	}
+
+	m_type = _mesh_file_cooked;
+	m_vertex_count = header->vertex_count;
+	m_vertex_stride = header->vertex_stride;
+	m_vertex_format = static_cast<e_mesh_vertex_format>(header->vertex_format);
+	m_index_count = header->index_count;
+	m_index_format = static_cast<e_mesh_index_format>(header->index_format);
+	m_bounds = &header->bounds;
+
+	// Validate data ranges against the mapped size so we never read past the end of the view
+	const qword vertices_size = static_cast<qword>(m_vertex_count) * m_vertex_stride;
+	const qword indices_size = static_cast<qword>(m_index_count) * this->get_index_stride();
+	const bool ranges_valid =
+		header->vertex_data_offset >= sizeof(s_mesh_file_header) && header->vertex_data_offset <= data_size && vertices_size <= data_size - header->vertex_data_offset &&
+		header->index_data_offset >= sizeof(s_mesh_file_header) && header->index_data_offset <= data_size && indices_size <= data_size - header->index_data_offset;
+	if (!ranges_valid)
+	{
+		LOG_WARNING(L"mesh %s is truncated or has invalid data offsets! stopping load", debug_name);
+		return K_FAILURE;
+	}
+
+	m_vertex_data = data + header->vertex_data_offset;
+	m_index_data = data + header->index_data_offset;
+
+	const qword lods_size = static_cast<qword>(header->lod_count) * sizeof(s_mesh_file_lod);
+	const bool lods_valid = IN_RANGE_INCLUSIVE(header->lod_count, 1, MESH_FILE_MAXIMUM_LODS) &&
+		header->lod_data_offset >= sizeof(s_mesh_file_header) && header->lod_data_offset <= data_size && lods_size <= data_size - header->lod_data_offset;
+	if (!lods_valid)
+	{
+		LOG_WARNING(L"mesh %s has %d levels of detail or an invalid level of detail offset! stopping load", debug_name, header->lod_count);
+		return K_FAILURE;
+	}
+	m_lods = reinterpret_cast<const s_mesh_file_lod*>(data + header->lod_data_offset);
+	m_lod_count = header->lod_count;
+	for (dword lod = 0; lod < m_lod_count; lod++)
+	{
+		const s_mesh_file_lod& level = m_lods[lod];
+		if (level.index_count == 0 || level.index_count % 3 != 0 || level.index_offset > m_index_count || level.index_count > m_index_count - level.index_offset)
+		{
+			LOG_WARNING(L"mesh %s level of detail %d has an invalid index range! stopping load", debug_name, lod);
+			return K_FAILURE;
+		}
+	}
+
+	const qword meshlets_size = static_cast<qword>(header->meshlet_count) * sizeof(s_mesh_file_meshlet);
+	const bool meshlets_valid = header->meshlet_count == 0 ||
+		(header->meshlet_data_offset >= sizeof(s_mesh_file_header) && header->meshlet_data_offset <= data_size && meshlets_size <= data_size - header->meshlet_data_offset);
+	if (!meshlets_valid)
+	{
+		LOG_WARNING(L"mesh %s has an invalid meshlet offset! stopping load", debug_name);
+		return K_FAILURE;
+	}
+	m_meshlets = header->meshlet_count > 0 ? reinterpret_cast<const s_mesh_file_meshlet*>(data + header->meshlet_data_offset) : nullptr;
+	m_meshlet_count = header->meshlet_count;
+	for (dword meshlet = 0; meshlet < m_meshlet_count; meshlet++)
+	{
+		// Drawn as ranges of the first level, so must stay inside it
+		const s_mesh_file_meshlet& cluster = m_meshlets[meshlet];
+		if (cluster.index_count % 3 != 0 || cluster.index_offset < m_lods[0].index_offset || cluster.index_offset - m_lods[0].index_offset > m_lods[0].index_count || cluster.index_count > m_lods[0].index_offset + m_lods[0].index_count - cluster.index_offset)
+		{
+			LOG_WARNING(L"mesh %s meshlet %d has an invalid index range! stopping load", debug_name, meshlet);
+			return K_FAILURE;
+		}
+	}
+
+	return K_SUCCESS;
+}
+
+void c_mesh_file::close()
+{
+	m_file.close();
+	m_type = _mesh_file_none;
+	m_vertex_data = nullptr;
+	m_vertex_count = 0;
+	m_vertex_stride = 0;
+	m_vertex_format = _mesh_vertex_format_full;
+	m_index_data = nullptr;
+	m_index_count = 0;
+	m_index_format = _mesh_index_format_16;
+	m_bounds = nullptr;
+	m_lods = nullptr;
+	m_lod_count = 0;
+	m_meshlets = nullptr;
+	m_meshlet_count = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <types.h>
+#include <asset/mapped_file.h>
+#include <asset/mesh_format.h>
+
+// Header at the start of a .VBO file as written by meshconvert
+// Followed by vertex_count * vertex_part, then index_count * uword
+struct s_vbo_header
+{
+	dword vertex_count;
+	dword index_count;
+};
+static_assert(sizeof(s_vbo_header) == 0x8);
+static_assert(sizeof(vertex_part) == 0x20);
+static_assert(sizeof(vertex) == sizeof(s_mesh_file_vertex));
+
+enum e_mesh_file_type
+{
+	_mesh_file_none,
+	_mesh_file_vbo, // positions, normals & texcoords only, tangent frame must be generated on load
+	_mesh_file_cooked, // final vertex layout & native index width, uploaded as is
+
+	k_mesh_file_type_count
+};
+
+// Memory mapped mesh file, either a cooked .MESH or a legacy .VBO, detected from the file header
+// Vertex & index ranges point directly into the mapped view and are valid until the file is closed
+class c_mesh_file
+{
+public:
+	c_mesh_file();
+
+	// Map a mesh file and validate its contents against the file size
+	bool open(const wchar_t* const file_path);
+	// Use mesh data that is already in memory (e.g. inside a mapped archive), data must outlive this object
+	bool open(const ubyte* const data, const qword data_size, const wchar_t* const debug_name);
+	void close();
+
+	inline const e_mesh_file_type get_type() const { return m_type; };
+	// vertex_part for VBO files, vertex or s_mesh_file_compact_vertex for cooked files
+	inline const void* const get_vertex_data() const { return m_vertex_data; };
+	inline const dword get_vertex_count() const { return m_vertex_count; };
+	inline const dword get_vertex_stride() const { return m_vertex_stride; };
+	// Only cooked files can be compact
+	inline const e_mesh_vertex_format get_vertex_format() const { return m_vertex_format; };
+	inline const void* const get_index_data() const { return m_index_data; };
+	inline const dword get_index_count() const { return m_index_count; };
+	inline const e_mesh_index_format get_index_format() const { return m_index_format; };
+	inline const dword get_index_stride() const { return m_index_format == _mesh_index_format_16 ? sizeof(uword) : sizeof(dword); };
+	// Only present in cooked files
+	inline const s_mesh_file_bounds* const get_bounds() const { return m_bounds; };
+	// Levels of detail as ranges of the index data, VBO files have none
+	inline const s_mesh_file_lod* const get_lods() const { return m_lods; };
+	inline const dword get_lod_count() const { return m_lod_count; };
+	// Clusters of the first level of detail's indices, only present in cooked files
+	inline const s_mesh_file_meshlet* const get_meshlets() const { return m_meshlets; };
+	inline const dword get_meshlet_count() const { return m_meshlet_count; };
+
+private:
+	bool parse(const ubyte* const data, const qword data_size, const wchar_t* const debug_name);
+	bool parse_vbo(const ubyte* const data, const qword data_size, const wchar_t* const debug_name);
+	bool parse_cooked(const ubyte* const data, const qword data_size, const wchar_t* const debug_name);
+
+	c_mapped_file m_file;
+	e_mesh_file_type m_type;
+	const void* m_vertex_data;
+	dword m_vertex_count;
+	dword m_vertex_stride;
+	e_mesh_vertex_format m_vertex_format;
+	const void* m_index_data;
+	dword m_index_count;
+	e_mesh_index_format m_index_format;
+	const s_mesh_file_bounds* m_bounds;
+	const s_mesh_file_lod* m_lods;
+	dword m_lod_count;
+	const s_mesh_file_meshlet* m_meshlets;
+	dword m_meshlet_count;
+};
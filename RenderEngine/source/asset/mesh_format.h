@@ -0,0 +1,106 @@
+#pragma once
+// Cooked mesh file layout, shared between the engine and tools/asset_compiler
+// The asset compiler builds on platforms where the sizes asserted in types.h don't hold, so this header only uses cstdint types
+#include <cstdint>
+
+// 'MESH' read as a little endian uint32
+constexpr uint32_t MESH_FILE_SIGNATURE = 0x4853454D;
+constexpr uint32_t MESH_FILE_VERSION = 4;
+// Vertex & index data offsets are aligned to this from the start of the file
+constexpr uint32_t MESH_FILE_DATA_ALIGNMENT = 16;
+// Full detail mesh included
+constexpr uint32_t MESH_FILE_MAXIMUM_LODS = 4;
+// Meshlet limits, small enough to cull finely while keeping each draw worth issuing
+constexpr uint32_t MESH_FILE_MESHLET_MAXIMUM_VERTICES = 64;
+constexpr uint32_t MESH_FILE_MESHLET_MAXIMUM_TRIANGLES = 124;
+
+enum e_mesh_index_format : uint32_t
+{
+	_mesh_index_format_16,
+	_mesh_index_format_32,
+
+	k_mesh_index_format_count
+};
+
+enum e_mesh_vertex_format : uint32_t
+{
+	_mesh_vertex_format_full, // s_mesh_file_vertex
+	_mesh_vertex_format_compact, // s_mesh_file_compact_vertex, encoded as in vertex_compression.h
+
+	k_mesh_vertex_format_count
+};
+
+// Final interleaved vertex, matches the engine's vertex struct & the full input layout exactly
+struct s_mesh_file_vertex
+{
+	float position[3];
+	float normal[3];
+	float tex_coord[2];
+	float tangent[3];
+	float bitangent[3];
+};
+static_assert(sizeof(s_mesh_file_vertex) == 0x38);
+
+// Quantized vertex, matches the compact input layout exactly
+struct s_mesh_file_compact_vertex
+{
+	uint16_t position[4]; // unorm across the mesh bounds, w is always 1.0
+	int16_t normal[2]; // octahedral
+	int16_t tangent[2]; // octahedral, the lowest bit of y is set when the bitangent is -cross(normal, tangent)
+	uint16_t tex_coord[2]; // half float
+};
+static_assert(sizeof(s_mesh_file_compact_vertex) == 0x14);
+
+// Model space axis aligned bounding box & bounding sphere
+struct s_mesh_file_bounds
+{
+	float minimum[3];
+	float maximum[3];
+	float center[3];
+	float radius;
+};
+static_assert(sizeof(s_mesh_file_bounds) == 0x28);
+
+// Range of the index data drawn for one level of detail, every level indexes the same vertices
+struct s_mesh_file_lod
+{
+	uint32_t index_offset; // in indices, from the start of the index data
+	uint32_t index_count;
+	float error; // model space distance from the full detail surface, 0 for the first level
+	uint32_t reserved;
+};
+static_assert(sizeof(s_mesh_file_lod) == 0x10);
+
+// Cluster of the full detail level's triangles, contiguous in the index data
+// Back facing when dot(center - eye, cone_axis) >= cone_cutoff * length(center - eye) + radius
+struct s_mesh_file_meshlet
+{
+	float center[3]; // bounding sphere, model space
+	float radius;
+	float cone_axis[3]; // average triangle normal
+	float cone_cutoff; // sine of the cone's half angle, 1 when the triangles face too many ways to cull
+	uint32_t index_offset; // in indices, from the start of the index data
+	uint32_t index_count;
+};
+static_assert(sizeof(s_mesh_file_meshlet) == 0x28);
+
+struct s_mesh_file_header
+{
+	uint32_t signature; // MESH_FILE_SIGNATURE
+	uint32_t version; // MESH_FILE_VERSION
+	uint32_t vertex_count;
+	uint32_t vertex_stride; // size of the vertex_format vertex
+	uint32_t index_count; // every level's indices
+	uint32_t index_format; // e_mesh_index_format
+	uint32_t vertex_format; // e_mesh_vertex_format
+	uint32_t lod_count; // at least 1, the first is full detail
+	uint64_t vertex_data_offset; // from the start of the file
+	uint64_t index_data_offset; // from the start of the file
+	s_mesh_file_bounds bounds; // compact positions are quantized across minimum to maximum
+	uint64_t lod_data_offset; // lod_count s_mesh_file_lod, from the start of the file
+	uint32_t meshlet_count; // covering the first level of detail exactly, 0 if none were built
+	uint32_t reserved;
+	uint64_t meshlet_data_offset; // meshlet_count s_mesh_file_meshlet, from the start of the file
+};
+static_assert(sizeof(s_mesh_file_header) == 0x70);
+static_assert(sizeof(s_mesh_file_header) % MESH_FILE_DATA_ALIGNMENT == 0);
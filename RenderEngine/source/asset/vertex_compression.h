@@ -0,0 +1,200 @@
+#pragma once
+// Compact vertex encoding, shared between the engine and tools/asset_compiler
+// The decode side is mirrored in default_vs.hlsl, keep the two in sync
+// The asset compiler builds on platforms where the sizes asserted in types.h don't hold, so this header only uses standard types
+#include <asset/mesh_format.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Largest decode error encode_compact_vertex may introduce, the asset compiler rejects meshes that exceed these
+// Positions are in units of the mesh extent on that axis, half a quantization step
+constexpr float COMPACT_POSITION_ERROR_BOUND = 0.5f / 65535.0f;
+// Distance between unit vectors, octahedral snorm16 stays well under this even with the tangent sign bit taken
+constexpr float COMPACT_DIRECTION_ERROR_BOUND = 1e-3f;
+// Relative to the larger of |uv| and 1, one half float ulp
+constexpr float COMPACT_TEX_COORD_ERROR_BOUND = 1.0f / 2048.0f;
+
+inline float compact_sign_not_zero(const float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline int16_t compact_float_to_snorm16(const float value)
+{
+	const float clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	return static_cast<int16_t>(lroundf(clamped * 32767.0f));
+}
+
+inline float compact_snorm16_to_float(const int16_t value)
+{
+	const float unpacked = static_cast<float>(value) / 32767.0f;
+	return unpacked < -1.0f ? -1.0f : unpacked;
+}
+
+// Unit vector to a point on the octahedron, unfolded into [-1, 1] squared
+inline void compact_encode_octahedral(const float direction[3], int16_t out_encoded[2])
+{
+	const float manhattan_length = fabsf(direction[0]) + fabsf(direction[1]) + fabsf(direction[2]);
+	if (manhattan_length == 0.0f)
+	{
+		out_encoded[0] = 0;
+		out_encoded[1] = 0;
+		return;
+	}
+
+	float x = direction[0] / manhattan_length;
+	float y = direction[1] / manhattan_length;
+	if (direction[2] < 0.0f)
+	{
+		const float folded_x = (1.0f - fabsf(y)) * compact_sign_not_zero(x);
+		const float folded_y = (1.0f - fabsf(x)) * compact_sign_not_zero(y);
+		x = folded_x;
+		y = folded_y;
+	}
+	out_encoded[0] = compact_float_to_snorm16(x);
+	out_encoded[1] = compact_float_to_snorm16(y);
+}
+
+inline void compact_decode_octahedral(const int16_t encoded[2], float out_direction[3])
+{
+	float x = compact_snorm16_to_float(encoded[0]);
+	float y = compact_snorm16_to_float(encoded[1]);
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+	const float fold = z < 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -fold : fold;
+	y += y >= 0.0f ? -fold : fold;
+
+	const float vector_length = sqrtf(x * x + y * y + z * z);
+	out_direction[0] = x / vector_length;
+	out_direction[1] = y / vector_length;
+	out_direction[2] = z / vector_length;
+}
+
+// IEEE half, rounding to nearest even, out of range values become infinity
+inline uint16_t compact_float_to_half(const float value)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t float_exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (float_exponent == 0xFF)
+	{
+		return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+	}
+
+	const int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+	if (exponent >= 31)
+	{
+		return static_cast<uint16_t>(sign | 0x7C00);
+	}
+	if (exponent <= 0)
+	{
+		// Subnormal half, or too small to represent at all
+		if (exponent < -10)
+		{
+			return static_cast<uint16_t>(sign);
+		}
+		mantissa |= 0x800000;
+		const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t half_mantissa = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half_mantissa & 1) != 0))
+		{
+			half_mantissa++;
+		}
+		return static_cast<uint16_t>(sign | half_mantissa);
+	}
+
+	// Rounding up may carry into the exponent, which is still the correctly rounded result
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0))
+	{
+		half++;
+	}
+	return static_cast<uint16_t>(half);
+}
+
+inline float compact_half_to_float(const uint16_t half)
+{
+	const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1F;
+	const uint32_t mantissa = half & 0x3FF;
+
+	if (exponent == 0)
+	{
+		const float value = ldexpf(static_cast<float>(mantissa), -24);
+		return sign != 0 ? -value : value;
+	}
+
+	uint32_t bits = exponent == 31 ? (sign | 0x7F800000 | (mantissa << 13)) : (sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+	float value = 0.0f;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+inline uint16_t compact_quantize_position(const float value, const float minimum, const float maximum)
+{
+	const float extent = maximum - minimum;
+	if (extent <= 0.0f)
+	{
+		return 0;
+	}
+	const float normalised = (value - minimum) / extent;
+	const float clamped = normalised < 0.0f ? 0.0f : (normalised > 1.0f ? 1.0f : normalised);
+	return static_cast<uint16_t>(lroundf(clamped * 65535.0f));
+}
+
+inline float compact_dequantize_position(const uint16_t value, const float minimum, const float maximum)
+{
+	return minimum + (maximum - minimum) * (static_cast<float>(value) / 65535.0f);
+}
+
+inline void encode_compact_vertex(const s_mesh_file_vertex& vertex, const s_mesh_file_bounds& bounds, s_mesh_file_compact_vertex* const out_vertex)
+{
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		out_vertex->position[axis] = compact_quantize_position(vertex.position[axis], bounds.minimum[axis], bounds.maximum[axis]);
+	}
+	out_vertex->position[3] = UINT16_MAX;
+
+	compact_encode_octahedral(vertex.normal, out_vertex->normal);
+	compact_encode_octahedral(vertex.tangent, out_vertex->tangent);
+
+	// Only the handedness of the bitangent is kept, the shader rebuilds it from the normal & tangent
+	const float* const n = vertex.normal;
+	const float* const t = vertex.tangent;
+	const float n_cross_t[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+	const float handedness = n_cross_t[0] * vertex.bitangent[0] + n_cross_t[1] * vertex.bitangent[1] + n_cross_t[2] * vertex.bitangent[2];
+	const uint16_t tangent_y = static_cast<uint16_t>(out_vertex->tangent[1]);
+	out_vertex->tangent[1] = static_cast<int16_t>((tangent_y & ~1u) | (handedness < 0.0f ? 1u : 0u));
+
+	out_vertex->tex_coord[0] = compact_float_to_half(vertex.tex_coord[0]);
+	out_vertex->tex_coord[1] = compact_float_to_half(vertex.tex_coord[1]);
+}
+
+// CPU reference for the vertex shader's decode
+inline void decode_compact_vertex(const s_mesh_file_compact_vertex& vertex, const s_mesh_file_bounds& bounds, s_mesh_file_vertex* const out_vertex)
+{
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		out_vertex->position[axis] = compact_dequantize_position(vertex.position[axis], bounds.minimum[axis], bounds.maximum[axis]);
+	}
+
+	compact_decode_octahedral(vertex.normal, out_vertex->normal);
+	compact_decode_octahedral(vertex.tangent, out_vertex->tangent);
+
+	const float* const n = out_vertex->normal;
+	const float* const t = out_vertex->tangent;
+	const float handedness = (static_cast<uint16_t>(vertex.tangent[1]) & 1) != 0 ? -1.0f : 1.0f;
+	out_vertex->bitangent[0] = (n[1] * t[2] - n[2] * t[1]) * handedness;
+	out_vertex->bitangent[1] = (n[2] * t[0] - n[0] * t[2]) * handedness;
+	out_vertex->bitangent[2] = (n[0] * t[1] - n[1] * t[0]) * handedness;
+
+	out_vertex->tex_coord[0] = compact_half_to_float(vertex.tex_coord[0]);
+	out_vertex->tex_coord[1] = compact_half_to_float(vertex.tex_coord[1]);
+}
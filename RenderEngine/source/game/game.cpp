@@ -4,6 +4,14 @@
 #include <scene/scene.h>
 #include <time/time.h>
 #include <render/texture.h>
+#include <asset/mesh_file.h>
+#include <asset/archive.h>
+#include <asset/asset_streamer.h>
+#include <render/texture_cache.h>
+#include <render/texture_residency.h>
+#include <asset/hot_reload.h>
+#include <fstream>
+#include <chrono>
 
 #if API_DIRECTX
 #include <render/api/directx12/renderer.h>
@@ -32,7 +40,6 @@ PROGRESS AND CRITICAL REFLECTION
 
 // WOULD BE NICE TODOs:
 // - Multiple cameras
-// - Smart pointers for assets and references to fix crashes on shutdown
 // - Limit camera up/down to prevent clipping
 // - reinit swapchain on window resize
 
@@ -43,6 +50,174 @@ static c_renderer_dx12* g_renderer;
 #error RENDER API MISSING FROM CURRENT PLATFORM
 #endif
 static c_scene* g_scene;
+// Every cooked asset packed into one mapped file, falls back to loose files under assets\ if it wasn't built
+static c_asset_archive* g_asset_archive;
+// Hashing every packed file at startup is only worth the time in debug, release still catches files missing or packed at the wrong size
+#ifdef _DEBUG
+constexpr bool VALIDATE_ARCHIVE_CONTENTS = true;
+#else
+constexpr bool VALIDATE_ARCHIVE_CONTENTS = false;
+#endif
+
+// Background loads & uploads every mesh and texture, so the first frame doesn't wait on scene assets
+static c_asset_streamer* g_asset_streamer;
+
+// Materials sharing a texture get the same one, rather than each streaming their own copy
+static c_texture_cache* g_texture_cache;
+
+// Video memory streamed textures may use, their least recently needed mips are dropped to stay within it
+constexpr qword TEXTURE_STREAMING_BUDGET = 256ull * 1024 * 1024;
+// Streams in the mips each texture needs on screen, starting from only the small ones
+static c_texture_residency* g_texture_residency;
+
+// Debug builds know where the uncooked assets are, and cook & swap in whatever changes there while running
+#ifdef PROJECT_DIRECTORY
+static c_hot_reload* g_hot_reload;
+#endif
+
+// Create a placeholder mesh & stream in a cooked asset name relative to the assets directory, e.g. "models/cube.mesh"
+static c_mesh* create_mesh(const char* const asset_name, const e_stream_priority priority)
+{
+    c_mesh* const mesh = new c_mesh(g_renderer);
+    g_asset_streamer->request_mesh(mesh, asset_name, priority);
+    return mesh;
+}
+
+// Get a shared texture for a cooked asset name relative to the assets directory, e.g. "textures/crate/Crate_COLOR.dds"
+// Renders as a placeholder until the first request for it has streamed in
+static c_render_texture* create_texture(const char* const asset_name, const e_texture_type type, const e_stream_priority priority)
+{
+    return g_texture_cache->acquire(asset_name, type, priority);
+}
+
+// Uncomment to time memory mapped mesh reads against the old ifstream path on startup
+//#define MESH_LOADING_BENCHMARK
+
+#ifdef MESH_LOADING_BENCHMARK
+// Reads a mesh the way load_model used to, ifstream into heap arrays before anything can be uploaded
+// GPU upload is identical for both paths so is left out of the timings
+static bool benchmark_read_mesh_stream(const wchar_t* const file_path, qword* const out_checksum)
+{
+    std::ifstream mesh_file(file_path, std::ifstream::in | std::ifstream::binary);
+    if (mesh_file.fail())
+    {
+        return K_FAILURE;
+    }
+
+    s_mesh_file_header header = {};
+    mesh_file.read(reinterpret_cast<char*>(&header), sizeof(s_mesh_file_header));
+    if (mesh_file.fail() || header.signature != MESH_FILE_SIGNATURE || header.vertex_count == 0 || header.index_count == 0)
+    {
+        return K_FAILURE;
+    }
+    const dword index_stride = header.index_format == _mesh_index_format_16 ? sizeof(uword) : sizeof(dword);
+
+    vertex* vertices = new vertex[header.vertex_count];
+    mesh_file.seekg(header.vertex_data_offset);
+    mesh_file.read(reinterpret_cast<char*>(vertices), sizeof(vertex) * header.vertex_count);
+    ubyte* indices = new ubyte[header.index_count * index_stride];
+    mesh_file.seekg(header.index_data_offset);
+    mesh_file.read(reinterpret_cast<char*>(indices), header.index_count * index_stride);
+
+    // touch the results so the reads can't be optimised away
+    *out_checksum += indices[0] + static_cast<qword>(vertices[header.vertex_count - 1].vertex.position.x);
+
+    delete[] vertices;
+    delete[] indices;
+    return K_SUCCESS;
+}
+
+// Reads a mesh the way load_model does now, mapped in place, touching the data so the pages are faulted in
+static bool benchmark_read_mesh_mapped(const wchar_t* const file_path, qword* const out_checksum)
+{
+    c_mesh_file mesh_file;
+    if (!mesh_file.open(file_path) || mesh_file.get_type() != _mesh_file_cooked)
+    {
+        return K_FAILURE;
+    }
+
+    const vertex* const vertices = static_cast<const vertex*>(mesh_file.get_vertex_data());
+    float position_sum = 0.0f;
+    for (dword i = 0; i < mesh_file.get_vertex_count(); i++)
+    {
+        position_sum += vertices[i].vertex.position.x;
+    }
+
+    *out_checksum += static_cast<const ubyte*>(mesh_file.get_index_data())[0] + static_cast<qword>(position_sum);
+    return K_SUCCESS;
+}
+
+static void benchmark_mesh_loading(const char* const mesh_names[], const dword mesh_count)
+{
+    // First pass of either path pays for cold OS file cache, so report best of several passes as well as the first
+    constexpr dword iteration_count = 5;
+    typedef bool (*read_mesh_function)(const wchar_t* const, qword* const);
+    const read_mesh_function read_functions[] = { benchmark_read_mesh_stream, benchmark_read_mesh_mapped };
+    const wchar_t* const read_function_names[] = { L"ifstream", L"mapped" };
+
+    for (dword function_index = 0; function_index < _countof(read_functions); function_index++)
+    {
+        double first_ms = 0.0;
+        double best_ms = 0.0;
+        qword checksum = 0;
+        for (dword iteration = 0; iteration < iteration_count; iteration++)
+        {
+            const auto start_time = std::chrono::steady_clock::now();
+            for (dword i = 0; i < mesh_count; i++)
+            {
+                wchar_t mesh_path[MAX_PATH] = {};
+                swprintf_s(mesh_path, MAX_PATH, L"assets\\models\\sponza\\%hs.mesh", mesh_names[i]);
+                if (!read_functions[function_index](mesh_path, &checksum))
+                {
+                    LOG_WARNING(L"benchmark failed to read %s! aborting", mesh_path);
+                    return;
+                }
+            }
+            const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+            first_ms = iteration == 0 ? elapsed_ms : first_ms;
+            best_ms = (iteration == 0 || elapsed_ms < best_ms) ? elapsed_ms : best_ms;
+        }
+        LOG_MESSAGE(L"%s: %d meshes, first pass %.3fms, best of %d %.3fms (checksum %llu)", read_function_names[function_index], mesh_count, first_ms, iteration_count, best_ms, checksum);
+    }
+}
+#endif
+
+// Uncomment to log how many triangles meshlet culling saves over object culling, once every asset has streamed in
+//#define CLUSTER_CULLING_BENCHMARK
+
+#ifdef CLUSTER_CULLING_BENCHMARK
+// Turns the camera through a full circle from where it starts, culling the scene from each view
+static void benchmark_cluster_culling()
+{
+    constexpr dword view_count = 64;
+    constexpr int32 view_step = 98; // mouse units, update_look turns 0.001 radians per unit so 64 steps is close to a full turn
+
+    s_culling_statistics totals = {};
+    double cull_ms = 0.0;
+    for (dword view = 0; view < view_count; view++)
+    {
+        g_scene->m_camera->update_look(view_step, 0);
+        g_scene->m_camera->update_view();
+        const auto start_time = std::chrono::steady_clock::now();
+        g_scene->cull_objects();
+        cull_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+        const s_culling_statistics* const statistics = g_scene->get_culling_statistics();
+        totals.meshlet_count += statistics->meshlet_count;
+        totals.visible_meshlet_count += statistics->visible_meshlet_count;
+        totals.triangle_count += statistics->triangle_count;
+        totals.visible_object_triangle_count += statistics->visible_object_triangle_count;
+        totals.drawn_triangle_count += statistics->drawn_triangle_count;
+    }
+    g_scene->m_camera->update_look(-view_step * static_cast<int32>(view_count), 0);
+
+    const double object_culled_percent = totals.triangle_count > 0 ? 100.0 * (totals.triangle_count - totals.visible_object_triangle_count) / totals.triangle_count : 0.0;
+    const double meshlet_culled_percent = totals.visible_object_triangle_count > 0 ? 100.0 * (totals.visible_object_triangle_count - totals.drawn_triangle_count) / totals.visible_object_triangle_count : 0.0;
+    LOG_MESSAGE(L"cluster culling: %d views, %llu triangles per view, object culling drew %llu (-%.1f%%), meshlet culling drew %llu (a further -%.1f%%), %u/%u meshlets visible, %.3fms per view",
+        view_count, totals.triangle_count / view_count, totals.visible_object_triangle_count / view_count, object_culled_percent, totals.drawn_triangle_count / view_count, meshlet_culled_percent,
+        totals.visible_meshlet_count, totals.meshlet_count, cull_ms / view_count);
+}
+#endif
 
 #ifdef PLATFORM_WINDOWS
 void main_win(qword hwnd)
@@ -78,15 +253,44 @@ void main_win(qword hwnd)
 		main_loop_body();
 	}
 
+#ifdef PROJECT_DIRECTORY
+    delete g_hot_reload;
+#endif
+    // Stop streaming before anything it could still be loading into is destroyed
+    delete g_asset_streamer;
+
 	// Wait for GPU to finish executing the command list before we close
 	g_renderer->wait_for_previous_frame(); // TODO: this does not seem to be waiting properly, we're getting crashes for GPU objects in use on scene destruction
-    delete g_scene;                        // Likely due to asset sharing between objects not being cleaned up properly
+    delete g_scene;
+    delete g_texture_cache;
+    delete g_texture_residency;
+    delete g_asset_archive;
 	delete g_renderer;
 }
 #endif
 
 void main_init()
 {
+    g_asset_archive = new c_asset_archive();
+    if (!g_asset_archive->open(L"assets\\assets.pack"))
+    {
+        LOG_WARNING(L"no asset archive, loading loose files instead");
+    }
+    else if (!g_asset_archive->validate_cook_manifests(VALIDATE_ARCHIVE_CONTENTS))
+    {
+        LOG_WARNING(L"asset archive doesn't match its cook manifests, assets may be stale");
+    }
+    g_asset_streamer = new c_asset_streamer(g_renderer, g_asset_archive);
+    g_texture_residency = new c_texture_residency(g_asset_streamer, TEXTURE_STREAMING_BUDGET);
+    g_texture_cache = new c_texture_cache(g_renderer, g_asset_streamer, g_texture_residency, g_asset_archive);
+#ifdef PROJECT_DIRECTORY
+    g_hot_reload = new c_hot_reload(g_renderer, g_asset_streamer, g_texture_cache, g_scene);
+    if (!g_hot_reload->open(L"" PROJECT_DIRECTORY "assets", L"" PROJECT_DIRECTORY "tools\\asset_compiler\\build\\asset_compiler.exe"))
+    {
+        LOG_WARNING(L"couldn't watch the source assets, changes won't be reloaded");
+    }
+#endif
+
     /*
 	// load cube model
     vertex cube_vertices[] =
@@ -194,9 +398,8 @@ void main_init()
     g_scene->m_ambient_light = colour_rgba{ 0.1f, 0.1f, 0.1f, 1.0f };
 
     // TODO: Move these to object initialisation! Load data from external files
-    // need to get asset manager working again to handle shared resources
 	//c_mesh* cube_model = new c_mesh(g_renderer, cube_vertices, sizeof(cube_vertices), cube_indices, sizeof(cube_indices));
-	c_mesh* cube_model = new c_mesh(g_renderer, L"assets\\models\\cube.vbo");
+	c_mesh* cube_model = create_mesh("models/cube.mesh", _stream_priority_high);
 
     c_material* cube_material = new c_material(g_renderer, 3);
     cube_material->m_properties.m_diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
@@ -209,16 +412,23 @@ void main_init()
     cube_material->m_properties.m_render_texture = true;
 
     // https://opengameart.org/content/free-materials-pack-34-redux
-    c_render_texture* cube_diffuse_texture = new c_render_texture(g_renderer, L"assets\\textures\\crate\\Crate_COLOR.dds", _texture_diffuse);
-    c_render_texture* cube_specular_texture = new c_render_texture(g_renderer, L"assets\\textures\\crate\\Crate_SPEC.dds", _texture_specular);
-    c_render_texture* cube_normal_texture = new c_render_texture(g_renderer, L"assets\\textures\\crate\\Crate_NRM.dds", _texture_normal);
+    c_render_texture* cube_diffuse_texture = create_texture("textures/crate/Crate_COLOR.dds", _texture_diffuse, _stream_priority_high);
+    c_render_texture* cube_specular_texture = create_texture("textures/crate/Crate_SPEC.dds", _texture_specular, _stream_priority_high);
+    c_render_texture* cube_normal_texture = create_texture("textures/crate/Crate_NRM.dds", _texture_normal, _stream_priority_high);
 
     cube_material->assign_texture(cube_diffuse_texture);
     cube_material->assign_texture(cube_specular_texture);
     cube_material->assign_texture(cube_normal_texture);
 
+    // The scene owns the mesh & material from here, every crate shares their one upload
+    const s_mesh_handle cube_model_handle = g_scene->m_meshes.add(cube_model);
+#ifdef PROJECT_DIRECTORY
+    g_hot_reload->add_mesh("models/cube.mesh", cube_model_handle);
+#endif
+    const s_material_handle cube_material_handle = g_scene->m_materials.add(cube_material);
+
     // scene objects - will be cleaned up by scene destruction
-    c_scene_object* cube_object = new c_scene_object("crate", cube_model, cube_material);
+    c_scene_object* cube_object = new c_scene_object("crate", g_scene, cube_model_handle, cube_material_handle);
     cube_object->add_update_function
     (
         [cube_object]
@@ -231,6 +441,20 @@ void main_init()
     );
     g_scene->add_object(cube_object);
 
+    // a stack of static crates by the entrance
+    constexpr point3d crate_stack_positions[] =
+    {
+        { -1.5f, -0.85f, 2.0f },
+        { -1.0f, -0.85f, 2.0f },
+        { -1.25f, -0.35f, 2.0f },
+    };
+    for (const point3d& crate_position : crate_stack_positions)
+    {
+        g_scene->add_object(new c_scene_object("crate_stack", g_scene, cube_model_handle, cube_material_handle, crate_position, {}, { 0.25f, 0.25f, 0.25f }));
+    }
+    g_scene->m_meshes.release(cube_model_handle);
+    g_scene->m_materials.release(cube_material_handle);
+
     // 25 diff, 19 norm
     constexpr const char* sponza_mesh_material_names[25] =
     {
@@ -290,13 +514,17 @@ void main_init()
     };
     constexpr dword sponza_mesh_material_count = _countof(sponza_mesh_material_names);
 
+#ifdef MESH_LOADING_BENCHMARK
+    benchmark_mesh_loading(sponza_mesh_material_names, sponza_mesh_material_count);
+#endif
+
     c_mesh* sponza_meshes[sponza_mesh_material_count];
     c_material* sponza_materials[sponza_mesh_material_count];
     for (dword i = 0; i < sponza_mesh_material_count; i++)
     {
-        wchar_t mesh_path[MAX_PATH] = {};
-        swprintf_s(mesh_path, MAX_PATH, L"assets\\models\\sponza\\%hs.vbo", sponza_mesh_material_names[i]);
-        sponza_meshes[i] = new c_mesh(g_renderer, mesh_path);
+        char mesh_name[MAX_PATH] = {};
+        sprintf_s(mesh_name, MAX_PATH, "models/sponza/%s.mesh", sponza_mesh_material_names[i]);
+        sponza_meshes[i] = create_mesh(mesh_name, _stream_priority_normal);
 
         dword texture_count = 0;
         c_render_texture* diffuse_texture = nullptr;
@@ -304,16 +532,17 @@ void main_init()
 
         if (sponza_material_texture_names[i][0] != "")
         {
-            wchar_t diff_texture_path[MAX_PATH] = {};
-            swprintf_s(diff_texture_path, MAX_PATH, L"assets\\textures\\sponza\\%hs.dds", sponza_material_texture_names[i][0]);
-            diffuse_texture = new c_render_texture(g_renderer, diff_texture_path, _texture_diffuse);
+            char diff_texture_name[MAX_PATH] = {};
+            sprintf_s(diff_texture_name, MAX_PATH, "textures/sponza/%s.dds", sponza_material_texture_names[i][0]);
+            diffuse_texture = create_texture(diff_texture_name, _texture_diffuse, _stream_priority_normal);
             texture_count++;
         }
         if (sponza_material_texture_names[i][1] != "")
         {
-            wchar_t norm_texture_path[MAX_PATH] = {};
-            swprintf_s(norm_texture_path, MAX_PATH, L"assets\\textures\\sponza\\%hs.dds", sponza_material_texture_names[i][1]);
-            normal_texture = new c_render_texture(g_renderer, norm_texture_path, _texture_normal);
+            char norm_texture_name[MAX_PATH] = {};
+            sprintf_s(norm_texture_name, MAX_PATH, "textures/sponza/%s.dds", sponza_material_texture_names[i][1]);
+            // normal maps last, the scene reads fine with flat normals until they arrive
+            normal_texture = create_texture(norm_texture_name, _texture_normal, _stream_priority_low);
             texture_count++;
         }
 
@@ -364,10 +593,21 @@ void main_init()
     // vase hanging
     sponza_materials[22]->m_properties.m_emissive = XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f);
 
+    LOG_MESSAGE(L"texture cache: %d requests for %d textures", g_texture_cache->get_request_count(), g_texture_cache->get_texture_count());
+
     for (dword i = 0; i < sponza_mesh_material_count; i++)
     {
-        c_scene_object* scene_object = new c_scene_object(sponza_mesh_material_names[i], sponza_meshes[i], sponza_materials[i], { 0.0f, -1.1f, 0.0f }, {}, { 0.01f, 0.01f, 0.01f });
+        const s_mesh_handle mesh_handle = g_scene->m_meshes.add(sponza_meshes[i]);
+#ifdef PROJECT_DIRECTORY
+        char mesh_name[MAX_PATH] = {};
+        sprintf_s(mesh_name, MAX_PATH, "models/sponza/%s.mesh", sponza_mesh_material_names[i]);
+        g_hot_reload->add_mesh(mesh_name, mesh_handle);
+#endif
+        const s_material_handle material_handle = g_scene->m_materials.add(sponza_materials[i]);
+        c_scene_object* scene_object = new c_scene_object(sponza_mesh_material_names[i], g_scene, mesh_handle, material_handle, { 0.0f, -1.1f, 0.0f }, {}, { 0.01f, 0.01f, 0.01f });
         g_scene->add_object(scene_object);
+        g_scene->m_meshes.release(mesh_handle);
+        g_scene->m_materials.release(material_handle);
     }
 }
 
@@ -383,12 +623,29 @@ void main_loop_body()
 	// input
 	update_input(delta_time);
 
+	// swap in any assets which finished streaming since the last frame
+	g_asset_streamer->update();
+#ifdef PROJECT_DIRECTORY
+    // cook changed source assets, their reloads are swapped in by the streamer's next update
+    g_hot_reload->update();
+#endif
+#ifdef CLUSTER_CULLING_BENCHMARK
+    static bool cluster_culling_benchmarked = false;
+    if (!cluster_culling_benchmarked && g_asset_streamer->get_outstanding_count() == 0)
+    {
+        benchmark_cluster_culling();
+        cluster_culling_benchmarked = true;
+    }
+#endif
+
 	// scene
 	g_scene->update(delta_time);
 
 	// render
     // TODO: can I better decouple the renderer and scene classes?
     g_scene->setup_for_render(g_renderer);
+    // stream mips for what's on screen now, they're swapped in on a later frame
+    g_texture_residency->update(g_scene);
 	g_renderer->render_frame(g_scene, time_manager.get_frames_per_second()); // execute the command queue (rendering the scene is the result of the gpu executing the command lists)
     time_manager.increment_frame_count();
 }
@@ -1,8 +1,9 @@
 #include "constant_buffer.h"
 #include <d3dx12.h>
-#include <BufferHelpers.h>
 #include <render/api/directx12/helpers.h>
+#include <render/api/directx12/upload_ring.h>
 #include <reporting/report.h>
+#include <cassert>
 
 // debug only function
 const wchar_t* const get_constant_buffer_name(const e_render_pass render_pass, const e_constant_buffers buffer_type)
@@ -22,6 +23,7 @@ const wchar_t* const get_constant_buffer_name(const e_render_pass render_pass, c
             constexpr const wchar_t* k_default_buffer_names[k_deferred_constant_buffer_count] =
             {
                 L"Object Constant Buffer",
+                L"View Constant Buffer",
                 L"Material Properties Constant Buffer"
             };
             static_assert(_countof(k_default_buffer_names) == k_deferred_constant_buffer_count);
@@ -66,12 +68,19 @@ const wchar_t* const get_constant_buffer_name(const e_render_pass render_pass, c
     return L"Unknown Constant Buffer";
 }
 
-c_constant_buffer::c_constant_buffer(ID3D12Device* const device, const e_render_pass render_pass,
+c_constant_buffer::c_constant_buffer(c_upload_ring* const upload_ring, const e_render_pass render_pass,
     const e_constant_buffers buffer_type, const dword buffer_struct_size, const D3D12_SHADER_VISIBILITY visibility)
-    : m_buffer_struct_size(buffer_struct_size)
-    , m_buffer_aligned_size((buffer_struct_size + 255) & ~255)
+    : m_upload_ring(upload_ring)
+    , m_render_pass(render_pass)
+    , m_buffer_type(buffer_type)
+    , m_buffer_struct_size(buffer_struct_size)
+    , m_buffer_aligned_size((buffer_struct_size + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1))
     , m_visibility(visibility)
+    , m_gpu_addresses()
+    , m_frame_serial(0)
 {
+    assert(upload_ring != nullptr);
+
     // ensure size doesn't exceed alignment (this should never happen)
     const bool buffer_aligned = m_buffer_struct_size <= m_buffer_aligned_size;
     assert(buffer_aligned);
@@ -80,61 +89,15 @@ c_constant_buffer::c_constant_buffer(ID3D12Device* const device, const e_render_
         LOG_ERROR(L"constant buffer was not aligned! [size: %d] [aligned: %d]", m_buffer_struct_size, m_buffer_aligned_size);
         return;
     }
-
-    // create the constant buffer resource heap
-    // We will update the constant buffer one or more times per frame, so we will use only an upload heap
-    // unlike previously we used an upload heap to upload the vertex and index data, and then copied over
-    // to a default heap. If you plan to use a resource for more than a couple frames, it is usually more
-    // efficient to copy to a default heap where it stays on the gpu. In this case, our constant buffer
-    // will be modified and uploaded at least once per frame, so we only use an upload heap
-
-    // first we will create a resource heap (upload heap) for each frame for the cubes constant buffers
-    // As you can see, we are allocating 64KB for each resource we create. Buffer resource heaps must be
-    // an alignment of 64KB. We are creating 3 resources, one for each frame. Each constant buffer is 
-    // only a 4x4 matrix of floats in this tutorial. So with a float being 4 bytes, we have 
-    // 16 floats in one constant buffer, and we will store 2 constant buffers in each
-    // heap, one for each cube, thats only 64x2 bits, or 128 bits we are using for each
-    // resource, and each resource must be at least 64KB (65536 bits)
-
-    HRESULT hr = S_OK;
-    CD3DX12_RANGE read_range(0, 0);
-    for (dword frame_index = 0; frame_index < FRAME_BUFFER_COUNT; frame_index++)
-    {
-        // 64KiB constant buffer - Must be a multiple of 64KiB for single-textures and constant buffers
-        hr = CreateUploadBuffer(device, nullptr, 64, 1024, &m_upload_buffers[frame_index]);
-        if (!HRESULT_VALID(hr))
-        {
-            LOG_WARNING(L"upload buffer creation failed! setting nullptr");
-            m_upload_buffers[frame_index] = nullptr;
-        }
-        hr = m_upload_buffers[frame_index]->Map(0, &read_range, reinterpret_cast<void**>(&m_gpu_address[frame_index]));
-        if (!HRESULT_VALID(hr))
-        {
-            m_gpu_address[frame_index] = nullptr;
-        }
-        m_upload_buffers[frame_index]->SetName(get_constant_buffer_name(render_pass, buffer_type));
-    }
 }
 
 c_constant_buffer::~c_constant_buffer()
 {
-    for (dword frame_index = 0; frame_index < FRAME_BUFFER_COUNT; frame_index++)
-    {
-        SAFE_RELEASE(m_upload_buffers[frame_index]);
-    };
 }
 
 void c_constant_buffer::set_data(const void* const buffer, const dword frame_index, const dword sub_index)
 {
-    const bool gpu_address_invalid = m_gpu_address == nullptr;
-    assert(!gpu_address_invalid);
-    if (gpu_address_invalid)
-    {
-        LOG_WARNING(L"failed to set constant buffer data! gpu address was invalid!");
-        return;
-    }
-
-    const bool invalid_arguments = buffer == nullptr || !IN_RANGE_COUNT(frame_index, 0, FRAME_BUFFER_COUNT);
+    const bool invalid_arguments = buffer == nullptr || frame_index != m_upload_ring->get_frame_index();
     assert(!invalid_arguments);
     if (invalid_arguments)
     {
@@ -142,31 +105,44 @@ void c_constant_buffer::set_data(const void* const buffer, const dword frame_ind
         return;
     }
 
-    // copy our ConstantBuffer instance to the mapped constant buffer resource
-    // Because of the constant read alignment requirements, constant buffer views must be 256 bit aligned. Our buffers are smaller than 256 bits,
-    // so we need to add spacing between the two buffers, so that the second buffer starts at 256 bits from the beginning of the resource heap.
-    memcpy(m_gpu_address[frame_index] + (m_buffer_aligned_size * sub_index), buffer, m_buffer_struct_size);
+    // Addresses from an earlier use of this frame index point at slices since handed out again
+    if (m_frame_serial != m_upload_ring->get_frame_serial())
+    {
+        m_gpu_addresses.assign(m_gpu_addresses.size(), NULL);
+        m_frame_serial = m_upload_ring->get_frame_serial();
+    }
+    if (sub_index >= m_gpu_addresses.size())
+    {
+        m_gpu_addresses.resize(sub_index + 1, NULL);
+    }
+
+    // Constant buffer views must be 256 byte aligned, the ring pads each slice out to that
+    void* data = nullptr;
+    if (!m_upload_ring->allocate(m_buffer_aligned_size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, &data, &m_gpu_addresses[sub_index]))
+    {
+        LOG_WARNING(L"failed to allocate %s data for sub index %d!", get_constant_buffer_name(m_render_pass, m_buffer_type), sub_index);
+        m_gpu_addresses[sub_index] = NULL;
+        return;
+    }
+    memcpy(data, buffer, m_buffer_struct_size);
 }
 
 D3D12_GPU_VIRTUAL_ADDRESS c_constant_buffer::get_gpu_address(const dword frame_index, const dword buffer_index)
 {
-    // TODO: validate buffer index - store max value in class?
-    const bool invalid_frame_index = !IN_RANGE_COUNT(frame_index, 0, FRAME_BUFFER_COUNT);
+    const bool invalid_frame_index = frame_index != m_upload_ring->get_frame_index();
     assert(!invalid_frame_index);
     if (invalid_frame_index)
     {
         LOG_WARNING(L"invalid frame index!");
         return NULL;
     }
-    ID3D12Resource* upload_buffer = m_upload_buffers[frame_index];
-    const bool invalid_upload_buffer = upload_buffer == nullptr;
-    assert(!invalid_upload_buffer);
-    if (invalid_upload_buffer)
+
+    const bool buffer_set = m_frame_serial == m_upload_ring->get_frame_serial() && buffer_index < m_gpu_addresses.size() && m_gpu_addresses[buffer_index] != NULL;
+    assert(buffer_set);
+    if (!buffer_set)
     {
-        LOG_WARNING(L"invalid upload buffer!");
+        LOG_WARNING(L"%s sub index %d wasn't set this frame!", get_constant_buffer_name(m_render_pass, m_buffer_type), buffer_index);
         return NULL;
     }
-
-    D3D12_GPU_VIRTUAL_ADDRESS gpu_address = upload_buffer->GetGPUVirtualAddress() + (m_buffer_aligned_size * buffer_index);
-    return gpu_address;
+    return m_gpu_addresses[buffer_index];
 }
@@ -2,18 +2,22 @@
 #include <types.h>
 #include <render/constants.h>
 #include <d3d12.h> // TODO: reduce reliance on this
+#include <vector>
 
 enum e_constant_buffers
 {
 	// deferred render pass
 	_deferred_constant_buffer_object,
+	_deferred_constant_buffer_view,
 	_deferred_constant_buffer_materials,
 	k_deferred_constant_buffer_count,
 
 	_lighting_constant_buffer_lights = 0,
 	k_lighting_constant_buffer_count,
 
+	// shares the deferred pass' object & view buffers, so these match its registers
 	_texcam_constant_buffer_object = 0,
+	_texcam_constant_buffer_view,
 	k_texcam_constant_buffer_count,
 
 	// post processing render pass
@@ -25,22 +29,29 @@ static const wchar_t* const get_constant_buffer_name(const e_render_pass render_
 //enum D3D12_SHADER_VISIBILITY;
 //struct ID3D12Device;
 //struct ID3D12Resource;
+class c_upload_ring;
+// Constants are written into a new slice of the upload ring each time they're set, so any number of sub indices can be set each frame
 class c_constant_buffer
 {
 public:
-	c_constant_buffer(ID3D12Device* const device, const e_render_pass render_pass,
+	c_constant_buffer(c_upload_ring* const upload_ring, const e_render_pass render_pass,
 		const e_constant_buffers buffer_type, const dword buffer_struct_size, const D3D12_SHADER_VISIBILITY visibility);
 	~c_constant_buffer();
 
+	// frame_index must be the frame the upload ring is allocating for
 	void set_data(const void* const buffer, const dword frame_index, const dword sub_index);
 
 	inline const D3D12_SHADER_VISIBILITY get_visibility() const { return m_visibility; };
+	// Only valid for sub indices set since the upload ring's frame began, otherwise NULL
 	D3D12_GPU_VIRTUAL_ADDRESS get_gpu_address(const dword frame_index, const dword buffer_index);
 
 private:
+	c_upload_ring* const m_upload_ring; // local reference, DO NOT clean this up!
+	const e_render_pass m_render_pass;
+	const e_constant_buffers m_buffer_type;
 	const dword m_buffer_struct_size;
 	const dword m_buffer_aligned_size;
 	const D3D12_SHADER_VISIBILITY m_visibility;
-	ID3D12Resource* m_upload_buffers[FRAME_BUFFER_COUNT];
-	ubyte* m_gpu_address[FRAME_BUFFER_COUNT];
+	std::vector<D3D12_GPU_VIRTUAL_ADDRESS> m_gpu_addresses; // by sub index, NULL for those not set this frame
+	qword m_frame_serial; // upload ring frame m_gpu_addresses were set in
 };
\ No newline at end of file
@@ -7,6 +7,7 @@ c_descriptor_heap::c_descriptor_heap(ID3D12Device* const device, const wchar_t*
     : m_maximum_allocations(heap_description.NumDescriptors)
     , m_allocated(0)
     , m_size(device->GetDescriptorHandleIncrementSize(heap_description.Type))
+    , m_descriptor_heap(nullptr)
 {
     HRESULT hr = S_OK;
     hr = device->CreateDescriptorHeap(&heap_description, IID_PPV_ARGS(&m_descriptor_heap));
@@ -0,0 +1,125 @@
+#include "material_table.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <render/api/directx12/upload_ring.h>
+#include <render/render.h>
+#include <render/material.h>
+#include <d3dx12.h>
+#include <algorithm>
+#include <cassert>
+
+// Root constant buffer views need their address aligned to this, so each entry takes up one placement
+constexpr qword MATERIAL_TABLE_STRIDE = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+static_assert(sizeof(s_material_properties_cb) <= MATERIAL_TABLE_STRIDE);
+
+// Copies have no placement requirement, this just keeps the staging writes aligned
+constexpr qword MATERIAL_UPLOAD_ALIGNMENT = 16;
+
+c_material_table::c_material_table(ID3D12Device* const device, const dword capacity)
+    : m_device(device)
+    , m_buffer(nullptr)
+    , m_state(D3D12_RESOURCE_STATE_COPY_DEST)
+    , m_entry_versions()
+    , m_pending_uploads()
+    , m_statistics()
+{
+    assert(device != nullptr && capacity > 0);
+    this->reserve(capacity);
+}
+
+c_material_table::~c_material_table()
+{
+    SAFE_RELEASE(m_buffer);
+}
+
+ID3D12Resource* c_material_table::reserve(const dword capacity)
+{
+    if (m_buffer != nullptr && capacity <= this->get_capacity())
+    {
+        return nullptr;
+    }
+
+    // Doubled so a scene adding materials one at a time only grows a few times
+    const dword new_capacity = std::max(capacity, this->get_capacity() * 2);
+    ID3D12Resource* buffer = nullptr;
+    const CD3DX12_HEAP_PROPERTIES default_heap_properties(D3D12_HEAP_TYPE_DEFAULT);
+    const CD3DX12_RESOURCE_DESC buffer_description = CD3DX12_RESOURCE_DESC::Buffer(new_capacity * MATERIAL_TABLE_STRIDE);
+    const HRESULT hr = m_device->CreateCommittedResource(&default_heap_properties, D3D12_HEAP_FLAG_NONE, &buffer_description, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&buffer));
+    if (!HRESULT_VALID(hr))
+    {
+        return nullptr;
+    }
+    buffer->SetName(L"Material Table");
+
+    // Staged uploads were for the old buffer, clearing every version uploads each material again as it's next updated
+    ID3D12Resource* const replaced_buffer = m_buffer;
+    m_buffer = buffer;
+    m_state = D3D12_RESOURCE_STATE_COPY_DEST;
+    m_entry_versions.assign(new_capacity, 0);
+    m_pending_uploads.clear();
+    return replaced_buffer;
+}
+
+bool c_material_table::update(const dword material_index, const c_material* const material, c_upload_ring* const upload_ring)
+{
+    const bool arguments_valid = this->is_valid() && material_index < this->get_capacity() && material != nullptr && upload_ring != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return K_FAILURE;
+    }
+
+    if (m_entry_versions[material_index] == material->get_properties_version())
+    {
+        return K_SUCCESS;
+    }
+
+    s_material_properties_cb* staged_properties = nullptr;
+    s_material_upload upload = { material_index, nullptr, 0 };
+    if (!upload_ring->allocate(sizeof(s_material_properties_cb), MATERIAL_UPLOAD_ALIGNMENT, reinterpret_cast<void**>(&staged_properties), &upload.source, &upload.source_offset))
+    {
+        return K_FAILURE;
+    }
+    staged_properties->m_material = material->m_properties;
+    m_pending_uploads.push_back(upload);
+    m_entry_versions[material_index] = material->get_properties_version();
+
+    m_statistics.upload_count++;
+    m_statistics.upload_bytes += sizeof(s_material_properties_cb);
+    return K_SUCCESS;
+}
+
+void c_material_table::record_uploads(ID3D12GraphicsCommandList* const command_list)
+{
+    if (m_pending_uploads.empty())
+    {
+        return;
+    }
+
+    if (m_state != D3D12_RESOURCE_STATE_COPY_DEST)
+    {
+        const CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_buffer, m_state, D3D12_RESOURCE_STATE_COPY_DEST);
+        command_list->ResourceBarrier(1, &barrier);
+    }
+    for (const s_material_upload& upload : m_pending_uploads)
+    {
+        command_list->CopyBufferRegion(m_buffer, upload.material_index * MATERIAL_TABLE_STRIDE, upload.source, upload.source_offset, sizeof(s_material_properties_cb));
+    }
+    const CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    command_list->ResourceBarrier(1, &barrier);
+    m_state = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+    m_pending_uploads.clear();
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS c_material_table::get_gpu_address(const dword material_index) const
+{
+    const bool material_index_valid = this->is_valid() && material_index < this->get_capacity();
+    assert(material_index_valid);
+    if (!material_index_valid)
+    {
+        LOG_WARNING(L"material index [%d] was out of range of capacity [%d]!", material_index, this->get_capacity());
+        return NULL;
+    }
+    return m_buffer->GetGPUVirtualAddress() + (material_index * MATERIAL_TABLE_STRIDE);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <types.h>
+#include <d3d12.h>
+#include <vector>
+
+struct s_material_table_statistics
+{
+	dword upload_count; // materials uploaded this frame
+	qword upload_bytes;
+};
+
+class c_material;
+class c_upload_ring;
+
+// Every material's properties in one buffer in GPU memory, indexed by material id
+// A material is only uploaded when its properties version changes, so frames without edits upload nothing
+// Entries are spaced for constant buffer placement, so draws bind their material as a root constant buffer view into the table
+// Not thread safe
+class c_material_table
+{
+public:
+	c_material_table(ID3D12Device* const device, const dword capacity);
+	~c_material_table();
+
+	inline const bool is_valid() const { return m_buffer != nullptr; };
+	inline const dword get_capacity() const { return static_cast<dword>(m_entry_versions.size()); };
+
+	// Make room for capacity entries, every entry is uploaded again after growing
+	// Returns the replaced buffer for the caller to release once no frame in flight can read it, or nullptr if nothing was replaced
+	ID3D12Resource* reserve(const dword capacity);
+	// Stage material's properties into the upload ring if they changed since material_index was last uploaded
+	bool update(const dword material_index, const c_material* const material, c_upload_ring* const upload_ring);
+	// Copy everything staged since the last call into the table, before any draw this frame reads it
+	void record_uploads(ID3D12GraphicsCommandList* const command_list);
+
+	D3D12_GPU_VIRTUAL_ADDRESS get_gpu_address(const dword material_index) const;
+
+	inline const s_material_table_statistics* const get_statistics() const { return &m_statistics; };
+	inline void reset_statistics() { m_statistics = {}; };
+
+private:
+	struct s_material_upload
+	{
+		dword material_index;
+		ID3D12Resource* source; // upload ring page, valid until this frame index begins again
+		qword source_offset;
+	};
+
+	ID3D12Device* const m_device; // local reference, DO NOT clean this up!
+	ID3D12Resource* m_buffer; // default heap
+	D3D12_RESOURCE_STATES m_state;
+	std::vector<qword> m_entry_versions; // properties version last uploaded to each entry, 0 if never
+	std::vector<s_material_upload> m_pending_uploads;
+
+	s_material_table_statistics m_statistics;
+};
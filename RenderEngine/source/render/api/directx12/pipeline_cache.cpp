@@ -0,0 +1,278 @@
+#include "pipeline_cache.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <asset/cook_manifest_format.h>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+// Bump whenever hash_description changes, so pipelines stored under older keys stop matching
+constexpr dword PIPELINE_CACHE_VERSION = 2;
+
+template <typename t_value>
+static qword hash_value(const t_value& value, const qword hash)
+{
+    return hash_cooked_content(&value, sizeof(value), hash);
+}
+
+c_pipeline_cache::c_pipeline_cache(ID3D12Device* const device, const wchar_t* const library_path)
+    : m_device(device)
+    , m_library_path()
+    , m_library(nullptr)
+    , m_library_data()
+    , m_library_changed(false)
+    , m_mutex()
+    , m_library_mutex()
+    , m_pipeline_states()
+    , m_statistics()
+{
+    assert(device != nullptr && library_path != nullptr);
+    wcscpy_s(m_library_path, MAXIMUM_PATH, library_path);
+    this->load_library();
+}
+
+c_pipeline_cache::~c_pipeline_cache()
+{
+    this->save();
+    for (auto& pipeline_state : m_pipeline_states)
+    {
+        SAFE_RELEASE(pipeline_state.second);
+    }
+    SAFE_RELEASE(m_library);
+}
+
+bool c_pipeline_cache::load_library()
+{
+    ID3D12Device1* device1 = nullptr;
+    if (FAILED(m_device->QueryInterface(IID_PPV_ARGS(&device1))))
+    {
+        LOG_WARNING(L"device doesn't support pipeline libraries, pipeline states won't be kept between runs");
+        return K_FAILURE;
+    }
+
+    std::ifstream library_file(m_library_path, std::ios::binary | std::ios::ate);
+    if (library_file.is_open())
+    {
+        m_library_data.resize(static_cast<qword>(library_file.tellg()));
+        library_file.seekg(0);
+        library_file.read(reinterpret_cast<char*>(m_library_data.data()), m_library_data.size());
+        if (!library_file.good())
+        {
+            m_library_data.clear();
+        }
+    }
+
+    HRESULT hr = E_FAIL;
+    if (!m_library_data.empty())
+    {
+        hr = device1->CreatePipelineLibrary(m_library_data.data(), m_library_data.size(), IID_PPV_ARGS(&m_library));
+        if (hr != S_OK)
+        {
+            // Expected after a driver update or on another GPU, every pipeline state is created again & saved in a new library
+            LOG_MESSAGE(L"pipeline library %s doesn't match this device, starting a new one (error %08x)", m_library_path, hr);
+            m_library_data.clear();
+        }
+    }
+    if (m_library_data.empty())
+    {
+        hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library));
+    }
+    SAFE_RELEASE(device1);
+    if (!HRESULT_VALID(hr))
+    {
+        m_library = nullptr;
+        return K_FAILURE;
+    }
+    return K_SUCCESS;
+}
+
+HRESULT c_pipeline_cache::create_graphics_pipeline_state(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* const desc, const qword root_signature_hash, ID3D12PipelineState** const out_pipeline_state)
+{
+    const bool arguments_valid = desc != nullptr && out_pipeline_state != nullptr && desc->StreamOutput.NumEntries == 0 && desc->CachedPSO.pCachedBlob == nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return E_INVALIDARG;
+    }
+    *out_pipeline_state = nullptr;
+
+    const qword key = this->hash_description(desc, root_signature_hash);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto cached_pipeline_state = m_pipeline_states.find(key);
+        if (cached_pipeline_state != m_pipeline_states.end())
+        {
+            m_statistics.shared_count++;
+            cached_pipeline_state->second->AddRef();
+            *out_pipeline_state = cached_pipeline_state->second;
+            return S_OK;
+        }
+    }
+
+    wchar_t pipeline_name[32] = {};
+    swprintf_s(pipeline_name, _countof(pipeline_name), L"%016llx", key);
+
+    ID3D12PipelineState* pipeline_state = nullptr;
+    bool loaded = false;
+    if (m_library != nullptr)
+    {
+        // Loads of the same pipeline aren't safe to overlap, so every load is taken in turn
+        std::lock_guard<std::mutex> lock(m_library_mutex);
+        loaded = m_library->LoadGraphicsPipeline(pipeline_name, desc, IID_PPV_ARGS(&pipeline_state)) == S_OK;
+    }
+
+    double create_milliseconds = 0.0;
+    if (!loaded)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        const HRESULT hr = m_device->CreateGraphicsPipelineState(desc, IID_PPV_ARGS(&pipeline_state));
+        create_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+
+        if (m_library != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(m_library_mutex);
+            const HRESULT store_hr = m_library->StorePipeline(pipeline_name, pipeline_state);
+            if (store_hr == S_OK)
+            {
+                m_library_changed = true;
+            }
+            else if (store_hr != E_INVALIDARG)
+            {
+                HRESULT_VALID(store_hr);
+            }
+            // E_INVALIDARG is another thread storing the same pipeline first, or a stored pipeline the description no longer matches
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (loaded)
+    {
+        m_statistics.library_hit_count++;
+    }
+    else
+    {
+        m_statistics.created_count++;
+        m_statistics.create_milliseconds += create_milliseconds;
+    }
+    const auto kept_pipeline_state = m_pipeline_states.emplace(key, pipeline_state);
+    if (!kept_pipeline_state.second)
+    {
+        SAFE_RELEASE(pipeline_state);
+        pipeline_state = kept_pipeline_state.first->second;
+    }
+    pipeline_state->AddRef();
+    *out_pipeline_state = pipeline_state;
+    return S_OK;
+}
+
+void c_pipeline_cache::save()
+{
+    std::lock_guard<std::mutex> lock(m_library_mutex);
+    if (m_library == nullptr || !m_library_changed)
+    {
+        return;
+    }
+
+    std::vector<ubyte> serialized_library(m_library->GetSerializedSize());
+    if (!HRESULT_VALID(m_library->Serialize(serialized_library.data(), serialized_library.size())))
+    {
+        return;
+    }
+
+    // Written aside & moved into place the same as the shader cache, a partly written library would fail to load
+    wchar_t temporary_path[MAXIMUM_PATH] = {};
+    swprintf_s(temporary_path, MAXIMUM_PATH, L"%s.tmp", m_library_path);
+    {
+        std::ofstream library_file(temporary_path, std::ios::binary | std::ios::trunc);
+        library_file.write(reinterpret_cast<const char*>(serialized_library.data()), serialized_library.size());
+        if (!library_file.good())
+        {
+            LOG_WARNING(L"failed to write pipeline library %s!", temporary_path);
+            return;
+        }
+    }
+    if (!MoveFileExW(temporary_path, m_library_path, MOVEFILE_REPLACE_EXISTING))
+    {
+        LOG_WARNING(L"failed to move %s into place! (error %d)", temporary_path, GetLastError());
+        DeleteFileW(temporary_path);
+        return;
+    }
+    m_library_changed = false;
+}
+
+qword c_pipeline_cache::hash_description(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* const desc, const qword root_signature_hash) const
+{
+    qword hash = hash_value(PIPELINE_CACHE_VERSION, COOK_HASH_SEED);
+    hash = hash_value(root_signature_hash, hash);
+
+    const D3D12_SHADER_BYTECODE* const shaders[] = { &desc->VS, &desc->PS, &desc->DS, &desc->HS, &desc->GS };
+    for (const D3D12_SHADER_BYTECODE* const shader : shaders)
+    {
+        hash = hash_value(static_cast<qword>(shader->BytecodeLength), hash);
+        if (shader->BytecodeLength > 0)
+        {
+            hash = hash_cooked_content(shader->pShaderBytecode, shader->BytecodeLength, hash);
+        }
+    }
+
+    // Each render target's write mask is a single byte followed by padding, so blend members are hashed one at a time
+    const D3D12_BLEND_DESC& blend = desc->BlendState;
+    hash = hash_value(blend.AlphaToCoverageEnable, hash);
+    hash = hash_value(blend.IndependentBlendEnable, hash);
+    for (const D3D12_RENDER_TARGET_BLEND_DESC& render_target : blend.RenderTarget)
+    {
+        hash = hash_value(render_target.BlendEnable, hash);
+        hash = hash_value(render_target.LogicOpEnable, hash);
+        hash = hash_value(render_target.SrcBlend, hash);
+        hash = hash_value(render_target.DestBlend, hash);
+        hash = hash_value(render_target.BlendOp, hash);
+        hash = hash_value(render_target.SrcBlendAlpha, hash);
+        hash = hash_value(render_target.DestBlendAlpha, hash);
+        hash = hash_value(render_target.BlendOpAlpha, hash);
+        hash = hash_value(render_target.LogicOp, hash);
+        hash = hash_value(render_target.RenderTargetWriteMask, hash);
+    }
+
+    // Every member of these is 4 bytes, so they have no padding to hash
+    hash = hash_value(desc->SampleMask, hash);
+    hash = hash_value(desc->RasterizerState, hash);
+
+    // The stencil masks leave padding before the stencil ops, so members are hashed one at a time
+    const D3D12_DEPTH_STENCIL_DESC& depth_stencil = desc->DepthStencilState;
+    hash = hash_value(depth_stencil.DepthEnable, hash);
+    hash = hash_value(depth_stencil.DepthWriteMask, hash);
+    hash = hash_value(depth_stencil.DepthFunc, hash);
+    hash = hash_value(depth_stencil.StencilEnable, hash);
+    hash = hash_value(depth_stencil.StencilReadMask, hash);
+    hash = hash_value(depth_stencil.StencilWriteMask, hash);
+    hash = hash_value(depth_stencil.FrontFace, hash);
+    hash = hash_value(depth_stencil.BackFace, hash);
+
+    hash = hash_value(desc->InputLayout.NumElements, hash);
+    for (dword element_index = 0; element_index < desc->InputLayout.NumElements; element_index++)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = desc->InputLayout.pInputElementDescs[element_index];
+        hash = hash_cooked_content(element.SemanticName, strlen(element.SemanticName) + 1, hash);
+        hash = hash_value(element.SemanticIndex, hash);
+        hash = hash_value(element.Format, hash);
+        hash = hash_value(element.InputSlot, hash);
+        hash = hash_value(element.AlignedByteOffset, hash);
+        hash = hash_value(element.InputSlotClass, hash);
+        hash = hash_value(element.InstanceDataStepRate, hash);
+    }
+
+    hash = hash_value(desc->IBStripCutValue, hash);
+    hash = hash_value(desc->PrimitiveTopologyType, hash);
+    hash = hash_value(desc->NumRenderTargets, hash);
+    hash = hash_value(desc->RTVFormats, hash);
+    hash = hash_value(desc->DSVFormat, hash);
+    hash = hash_value(desc->SampleDesc, hash);
+    hash = hash_value(desc->NodeMask, hash);
+    hash = hash_value(desc->Flags, hash);
+    return hash;
+}
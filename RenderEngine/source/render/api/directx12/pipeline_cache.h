@@ -0,0 +1,53 @@
+#pragma once
+#include <types.h>
+#include <d3d12.h>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+// Serialized pipeline library kept between runs, next to the shader cache
+constexpr wchar_t PIPELINE_LIBRARY_PATH[] = L"shader_cache\\pipeline_library.bin";
+
+struct s_pipeline_cache_statistics
+{
+	dword created_count;
+	dword library_hit_count; // loaded from the pipeline library an earlier run saved
+	dword shared_count; // identical to a pipeline state created earlier this run, e.g. by a reload that compiled the same bytecode
+	double create_milliseconds;
+};
+
+// Creates graphics pipeline states through an in memory cache & a pipeline library saved between runs
+// Keyed by a hash of the whole pipeline description, with shaders & input layouts hashed by content and the root signature by its serialized hash
+// Safe to create from several threads at once, pipeline creation happens outside the lock
+class c_pipeline_cache
+{
+public:
+	// Without ID3D12Device1 pipeline states are still shared within a run, just not saved
+	c_pipeline_cache(ID3D12Device* const device, const wchar_t* const library_path);
+	~c_pipeline_cache();
+
+	// Same as CreateGraphicsPipelineState, root_signature_hash identifies desc's root signature between runs
+	// Stream output & cached pipeline states aren't supported, the library does the caching
+	HRESULT create_graphics_pipeline_state(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* const desc, const qword root_signature_hash, ID3D12PipelineState** const out_pipeline_state);
+
+	// Write the library out if anything was added since it was loaded or last saved
+	void save();
+
+	// Only meaningful while nothing is being created
+	inline const s_pipeline_cache_statistics* const get_statistics() const { return &m_statistics; };
+
+private:
+	bool load_library();
+	qword hash_description(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* const desc, const qword root_signature_hash) const;
+
+	ID3D12Device* const m_device; // local reference, DO NOT clean this up!
+	wchar_t m_library_path[MAXIMUM_PATH];
+	ID3D12PipelineLibrary* m_library; // nullptr if the device can't create one
+	std::vector<ubyte> m_library_data; // the library reads from this until it's released
+	bool m_library_changed;
+
+	std::mutex m_mutex; // guards m_pipeline_states & m_statistics
+	std::mutex m_library_mutex; // guards loading, storing & saving through m_library, & m_library_changed
+	std::unordered_map<qword, ID3D12PipelineState*> m_pipeline_states; // holds a reference to everything created this run
+	s_pipeline_cache_statistics m_statistics;
+};
@@ -8,6 +8,7 @@
 #include <render/api/directx12/constant_buffer.h>
 #include <render/shader.h>
 #include <DirectXHelpers.h>
+#include <algorithm>
 
 const wchar_t* const get_render_target_name(const e_render_targets target_type)
 {
@@ -42,6 +43,8 @@ c_render_target::c_render_target(ID3D12Device* const device, c_shader_input* con
     , m_depth_stencil_buffers()
     , m_shader_input(shader_input)
     , m_shader_texture_heap(nullptr)
+    , m_texture_set_count(0)
+    , m_bound_pipeline_state(nullptr)
 {
     HRESULT hr = S_OK;
     const bool valid_arguments = device != nullptr && IN_RANGE_COUNT(target_type, 0, k_render_target_count);
@@ -165,17 +168,7 @@ c_render_target::c_render_target(ID3D12Device* const device, c_shader_input* con
     }
 
     // Create texture descriptor heap with shader resource views IN ORDER
-    m_shader_texture_heap = new c_descriptor_heap
-    (
-        m_device,
-        L"Render Target Shader Texture Heap",
-        {
-            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, // type
-            shader_input->m_texture_count * MAXIMUM_TEXTURE_SETS, // descriptor count
-            D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, // flags
-            0 // node mask
-        }
-    );
+    this->reserve_texture_sets(INITIAL_TEXTURE_SETS);
 }
 
 c_render_target::~c_render_target()
@@ -223,7 +216,49 @@ void c_render_target::begin_render(ID3D12GraphicsCommandList* const command_list
         command_list->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
     }
 
-    command_list->SetGraphicsRootSignature(m_shader_input->get_root_signature());
+    // The root signature is left to the renderer, which skips binding it again for targets sharing a shader input
+    // Other targets may have set a different pipeline state since this one last drew
+    m_bound_pipeline_state = nullptr;
+}
+
+ID3D12DescriptorHeap* c_render_target::reserve_texture_sets(const dword set_count)
+{
+    if (m_shader_texture_heap != nullptr && set_count <= m_texture_set_count)
+    {
+        return nullptr;
+    }
+
+    // Doubled so a scene adding materials one at a time only grows a few times
+    const dword new_set_count = std::max(set_count, m_texture_set_count * 2);
+    c_descriptor_heap* const shader_texture_heap = new c_descriptor_heap
+    (
+        m_device,
+        L"Render Target Shader Texture Heap",
+        {
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, // type
+            m_shader_input->m_texture_count * new_set_count, // descriptor count
+            D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, // flags
+            0 // node mask
+        }
+    );
+    if (shader_texture_heap->get_heap() == nullptr)
+    {
+        delete shader_texture_heap;
+        return nullptr;
+    }
+
+    // Sets are assigned before every draw, so nothing is copied over from the old heap
+    ID3D12DescriptorHeap* replaced_heap = nullptr;
+    if (m_shader_texture_heap != nullptr)
+    {
+        // Outlives its c_descriptor_heap until frames in flight are done with it
+        replaced_heap = m_shader_texture_heap->get_heap();
+        replaced_heap->AddRef();
+        delete m_shader_texture_heap;
+    }
+    m_shader_texture_heap = shader_texture_heap;
+    m_texture_set_count = new_set_count;
+    return replaced_heap;
 }
 
 void c_render_target::assign_texture(ID3D12Resource* const texture_resource, const e_texture_type texture_index, const dword set_index)
@@ -243,11 +278,11 @@ void c_render_target::assign_texture(ID3D12Resource* const texture_resource, con
         LOG_ERROR(L"out of bounds texture index [%d] supplied! max: [%d]", texture_index, texture_count);
         return;
     }
-    const bool set_index_invalid = !IN_RANGE_COUNT(set_index, 0, MAXIMUM_TEXTURE_SETS);
+    const bool set_index_invalid = !IN_RANGE_COUNT(set_index, 0, m_texture_set_count);
     assert(!set_index_invalid);
     if (set_index_invalid)
     {
-        LOG_ERROR(L"out of bounds texture set index [%d] supplied! max: [%d]", set_index, MAXIMUM_TEXTURE_SETS);
+        LOG_ERROR(L"out of bounds texture set index [%d] supplied! max: [%d]", set_index, m_texture_set_count);
         return;
     }
 
@@ -283,7 +318,12 @@ void c_render_target::assign_texture(ID3D12Resource* const texture_resource, con
 
 void c_render_target::begin_draw(ID3D12GraphicsCommandList* const command_list, const c_shader* const shader, const dword set_index)
 {
-    command_list->SetPipelineState((ID3D12PipelineState*)shader->get_resources()->pipeline_state);
+    ID3D12PipelineState* const pipeline_state = (ID3D12PipelineState*)shader->get_resources()->pipeline_state;
+    if (pipeline_state != m_bound_pipeline_state)
+    {
+        command_list->SetPipelineState(pipeline_state);
+        m_bound_pipeline_state = pipeline_state;
+    }
     ID3D12DescriptorHeap* const shader_texture_heap = m_shader_texture_heap->get_heap();
     command_list->SetDescriptorHeaps(1, &shader_texture_heap); // Only one heap type can be set at a time
 
@@ -303,8 +343,8 @@ ID3D12Resource* const c_render_target::get_frame_resource(const dword target_ind
 D3D12_GPU_DESCRIPTOR_HANDLE c_render_target::get_texture_handle(const dword texture_index, const dword set_index) const
 {
     assert(IN_RANGE_COUNT(texture_index, 0, m_shader_input->m_texture_count));
-    assert(IN_RANGE_COUNT(set_index, 0, MAXIMUM_TEXTURE_SETS));
+    assert(IN_RANGE_COUNT(set_index, 0, m_texture_set_count));
 
-    const dword resource_index = texture_index + (set_index * m_shader_input->m_render_target_count);
+    const dword resource_index = texture_index + (set_index * m_shader_input->m_texture_count);
     return m_shader_texture_heap->get_gpu_handle(resource_index);
 }
@@ -55,6 +55,10 @@ public:
 	void begin_render(ID3D12GraphicsCommandList* const command_list, const dword frame_index, const bool clear_buffers = true);
 	void assign_texture(ID3D12Resource* const texture_resource, const e_texture_type texture_index, const dword set_index);
 	void begin_draw(ID3D12GraphicsCommandList* const command_list, const c_shader* const shader, const dword set_index);
+	// Make room for set_count texture sets, every set must be assigned again after growing
+	// Returns the replaced heap for the caller to release once no frame in flight can read it, or nullptr if nothing was replaced
+	ID3D12DescriptorHeap* reserve_texture_sets(const dword set_count);
+	inline const dword get_texture_set_count() const { return m_texture_set_count; };
 
 	inline const c_shader_input* const get_shader_input() const { return m_shader_input; };
 	ID3D12Resource* const get_frame_resource(const dword target_index, const dword frame_index) const;
@@ -84,4 +88,8 @@ private:
 
 	// shader resource views for the render pass (in register order) live here
 	c_descriptor_heap* m_shader_texture_heap;
+	dword m_texture_set_count; // sets of m_shader_input->m_texture_count descriptors in m_shader_texture_heap
+
+	// Set by the last begin_draw since begin_render, so draws sorted by shader only set it once
+	ID3D12PipelineState* m_bound_pipeline_state;
 };
\ No newline at end of file
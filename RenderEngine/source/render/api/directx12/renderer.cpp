@@ -2,7 +2,6 @@
 #include <types.h>
 #include <reporting/report.h>
 #include <iostream>
-#include <fstream>
 #include <cassert>
 #include <render/api/directx12/helpers.h>
 #if _DEBUG
@@ -14,7 +13,6 @@
 #include <imgui.h>
 #include <backends/imgui_impl_win32.h>
 #include <backends/imgui_impl_dx12.h>
-#include <ResourceUploadBatch.h>
 //#include <DirectXMesh.h>
 #include <DirectXMeshTangentFrame.cpp> // TODO: this is stupid, but for some reason including DirectXMesh.h isn't finding the function header
 #include <BufferHelpers.h>
@@ -22,8 +20,42 @@
 #include <render/model.h>
 #include <render/shader.h>
 #include <scene/scene.h>
+#include <asset/mesh_file.h>
+#include <asset/vertex_compression.h>
 #include <render/imgui_overlay.h>
+#include <render/api/directx12/upload_batch.h>
+#include <render/api/directx12/upload_ring.h>
+#include <render/api/directx12/material_table.h>
+#include <render/api/directx12/shader_cache.h>
+#include <render/api/directx12/pipeline_cache.h>
+#include <render/api/directx12/root_signature_cache.h>
+#include <threading/job_graph.h>
 #include <ImGuizmo.h>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <chrono>
+
+// Staging for uploads made directly through the renderer, anything larger gets a temporary buffer
+constexpr qword RENDERER_UPLOAD_STAGING_SIZE = 16 * 1024 * 1024;
+// Staging per streaming thread, sized to fit several Sponza textures per submit
+constexpr qword STREAMING_UPLOAD_STAGING_SIZE = 64 * 1024 * 1024;
+// Constants for each frame in flight are allocated in pages this size, each holds about 2048 objects' object & material constants
+constexpr qword CONSTANT_RING_PAGE_SIZE = 1024 * 1024;
+// Material table entries to start with, it grows to fit the scene's materials
+constexpr dword MATERIAL_TABLE_CAPACITY = 64;
+#ifdef _DEBUG
+// Enable better shader debugging with the graphics debugging tools.
+constexpr dword SHADER_COMPILE_FLAGS = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+constexpr dword SHADER_COMPILE_FLAGS = 0;
+#endif
+
+// Threads shader compiles & pipeline state creation are spread over, including the calling thread
+static dword get_job_thread_count()
+{
+    return std::max(static_cast<dword>(std::thread::hardware_concurrency()), 1ul);
+}
 
 // https://github.com/microsoft/DirectX-Graphics-Samples/blob/master/Samples/Desktop/D3D12HelloWorld/src/HelloTriangle/D3D12HelloTriangle.cpp
 // https://github.com/microsoft/DirectX-Graphics-Samples/blob/master/Samples/Desktop/D3D12HelloWorld/src/HelloTriangle/DXSample.cpp
@@ -216,6 +248,34 @@ bool c_renderer_dx12::initialise_fences()
     return K_SUCCESS;
 }
 
+bool c_renderer_dx12::initialise_upload_batch()
+{
+    m_upload_batch = new c_upload_batch(m_device, m_command_queue, RENDERER_UPLOAD_STAGING_SIZE, L"Renderer Upload Batch");
+    m_constant_ring = new c_upload_ring(m_device, CONSTANT_RING_PAGE_SIZE, L"Constant Upload Ring");
+    m_material_table = new c_material_table(m_device, MATERIAL_TABLE_CAPACITY);
+    return m_upload_batch->is_valid() && m_material_table->is_valid();
+}
+
+bool c_renderer_dx12::initialise_shader_cache()
+{
+    m_shader_cache = new c_shader_cache(SHADER_CACHE_DIRECTORY);
+    m_pipeline_cache = new c_pipeline_cache(m_device, PIPELINE_LIBRARY_PATH);
+    m_root_signature_cache = new c_root_signature_cache(m_device, m_shader_cache);
+    return K_SUCCESS;
+}
+
+c_upload_batch* c_renderer_dx12::create_upload_batch()
+{
+    c_upload_batch* upload_batch = new c_upload_batch(m_device, m_command_queue, STREAMING_UPLOAD_STAGING_SIZE, L"Streaming Upload Batch");
+    if (!upload_batch->is_valid())
+    {
+        LOG_WARNING(L"failed to create upload batch!");
+        delete upload_batch;
+        return nullptr;
+    }
+    return upload_batch;
+}
+
 bool c_renderer_dx12::initialise_input_layouts()
 {
     HRESULT hr = S_OK;
@@ -223,7 +283,8 @@ bool c_renderer_dx12::initialise_input_layouts()
     // Vertex input layout
     // The input layout is used by the Input Assembler so that it knows how to read the vertex data bound to it.
     // Ensure 16-byte alignment
-    constexpr D3D12_INPUT_ELEMENT_DESC full_vertex_input_elements[5] =
+    // Static as c_shader_input keeps pointers to these, which are read again whenever a shader is reloaded
+    static constexpr D3D12_INPUT_ELEMENT_DESC full_vertex_input_elements[5] =
     {
         { "POSITION",   0, DXGI_FORMAT_R32G32B32_FLOAT,     0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "NORMAL",     0, DXGI_FORMAT_R32G32B32_FLOAT,     0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
@@ -231,18 +292,33 @@ bool c_renderer_dx12::initialise_input_layouts()
         { "TANGENT",    0, DXGI_FORMAT_R32G32B32_FLOAT,     0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "BINORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,     0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
-    constexpr D3D12_INPUT_ELEMENT_DESC simple_vertex_input_elements[2] =
+    // s_mesh_file_compact_vertex, decoded by vs_main_compact
+    static constexpr D3D12_INPUT_ELEMENT_DESC compact_vertex_input_elements[3] =
+    {
+        { "POSITION",   0, DXGI_FORMAT_R16G16B16A16_UNORM,  0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "NORMAL",     0, DXGI_FORMAT_R16G16B16A16_SINT,   0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }, // octahedral normal & tangent, read as integers to keep the handedness bit
+        { "TEXCOORD",   0, DXGI_FORMAT_R16G16_FLOAT,        0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+    static_assert(sizeof(s_mesh_file_compact_vertex) == sizeof(uword) * 10);
+    static constexpr D3D12_INPUT_ELEMENT_DESC simple_vertex_input_elements[2] =
     {
         { "POSITION",   0, DXGI_FORMAT_R32G32B32A32_FLOAT,  0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "TEXCOORD",   0, DXGI_FORMAT_R32G32_FLOAT,        0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
 
+    // Root signatures are created by jobs run alongside the shader compiles, each pipeline state only waits on its own shader input
+    // Everything the jobs reference stays in scope until create_shaders has run them
+    c_job_graph jobs;
+    dword input_jobs[k_shader_input_count] = {};
+
     // DEFERRED SHADER INPUTS
-    // Constant buffers - these pointers are the responsibility of c_shader_input to cleanup
+    // Constant buffers - these pointers are the responsibility of c_shader_input to cleanup, unless it's created as not owning them
     c_constant_buffer* constant_buffers_default[k_deferred_constant_buffer_count] =
     {
-        new c_constant_buffer(m_device, _render_pass_deferred, _deferred_constant_buffer_object, sizeof(s_object_cb), D3D12_SHADER_VISIBILITY_VERTEX),
-        new c_constant_buffer(m_device, _render_pass_deferred, _deferred_constant_buffer_materials, sizeof(s_material_properties_cb), D3D12_SHADER_VISIBILITY_PIXEL)
+        new c_constant_buffer(m_constant_ring, _render_pass_deferred, _deferred_constant_buffer_object, sizeof(s_object_cb), D3D12_SHADER_VISIBILITY_VERTEX),
+        new c_constant_buffer(m_constant_ring, _render_pass_deferred, _deferred_constant_buffer_view, sizeof(s_view_cb), D3D12_SHADER_VISIBILITY_VERTEX),
+        // Only describes the root parameter, draws bind their material's entry in the material table instead
+        new c_constant_buffer(m_constant_ring, _render_pass_deferred, _deferred_constant_buffer_materials, sizeof(s_material_properties_cb), D3D12_SHADER_VISIBILITY_PIXEL)
     };
     static_assert(_countof(constant_buffers_default) == k_deferred_constant_buffer_count);
     CD3DX12_DESCRIPTOR_RANGE default_texture_range[] = { { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, k_default_textures_count, 0 } };
@@ -258,20 +334,24 @@ bool c_renderer_dx12::initialise_input_layouts()
         DXGI_FORMAT_R8G8B8A8_UNORM // diffuse
     };
     static_assert(_countof(deferred_render_target_formats) == k_gbuffer_count);
-    m_shader_inputs[_input_deferred] = new c_shader_input
-    (
-        m_device, k_default_textures_count,
-        constant_buffers_default, _countof(constant_buffers_default),
-        full_vertex_input_elements, _countof(full_vertex_input_elements),
-        default_texture_range, _countof(default_texture_range),
-        deferred_render_target_formats, _countof(deferred_render_target_formats),
-        true, D3D12_COMPARISON_FUNC_LESS
-    );
+    input_jobs[_input_deferred] = jobs.add([&]()
+    {
+        m_shader_inputs[_input_deferred] = new c_shader_input
+        (
+            m_root_signature_cache, k_default_textures_count,
+            constant_buffers_default, _countof(constant_buffers_default), true,
+            full_vertex_input_elements, _countof(full_vertex_input_elements),
+            default_texture_range, _countof(default_texture_range),
+            deferred_render_target_formats, _countof(deferred_render_target_formats),
+            true, D3D12_COMPARISON_FUNC_LESS
+        );
+        m_shader_inputs[_input_deferred]->set_compact_input_layout(compact_vertex_input_elements, _countof(compact_vertex_input_elements));
+    });
 
     // LIGHTING SHADER INPUTS
     c_constant_buffer* constant_buffers_lighting[k_lighting_constant_buffer_count] =
     {
-        new c_constant_buffer(m_device, _render_pass_lighting, _lighting_constant_buffer_lights, sizeof(s_light_properties_cb), D3D12_SHADER_VISIBILITY_PIXEL)
+        new c_constant_buffer(m_constant_ring, _render_pass_lighting, _lighting_constant_buffer_lights, sizeof(s_light_properties_cb), D3D12_SHADER_VISIBILITY_PIXEL)
     };
     static_assert(_countof(constant_buffers_lighting) == k_lighting_constant_buffer_count);
     CD3DX12_DESCRIPTOR_RANGE lighting_texture_range[] = { { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, k_lighting_textures_count, 0 } };
@@ -281,138 +361,301 @@ bool c_renderer_dx12::initialise_input_layouts()
         DXGI_FORMAT_R8G8B8A8_UNORM,
         DXGI_FORMAT_R8G8B8A8_UNORM
     };
-    m_shader_inputs[_input_lighting] = new c_shader_input
-    (
-        m_device, k_lighting_textures_count,
-        constant_buffers_lighting, _countof(constant_buffers_lighting),
-        simple_vertex_input_elements, _countof(simple_vertex_input_elements),
-        lighting_texture_range, _countof(lighting_texture_range),
-        lighting_render_target_formats, _countof(lighting_render_target_formats),
-        false, D3D12_COMPARISON_FUNC_NONE
-    );
+    input_jobs[_input_lighting] = jobs.add([&]()
+    {
+        m_shader_inputs[_input_lighting] = new c_shader_input
+        (
+            m_root_signature_cache, k_lighting_textures_count,
+            constant_buffers_lighting, _countof(constant_buffers_lighting), true,
+            simple_vertex_input_elements, _countof(simple_vertex_input_elements),
+            lighting_texture_range, _countof(lighting_texture_range),
+            lighting_render_target_formats, _countof(lighting_render_target_formats),
+            false, D3D12_COMPARISON_FUNC_NONE
+        );
+    });
 
     // SHADING SHADER INPUTS
     CD3DX12_DESCRIPTOR_RANGE shading_texture_range[] = { { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, k_shading_textures_count, 0 } };
     DXGI_FORMAT shading_render_target_formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
-    m_shader_inputs[_input_shading] = new c_shader_input
-    (
-        m_device, k_shading_textures_count,
-        nullptr, 0,
-        simple_vertex_input_elements, _countof(simple_vertex_input_elements),
-        shading_texture_range, _countof(shading_texture_range),
-        shading_render_target_formats, _countof(shading_render_target_formats),
-        false, D3D12_COMPARISON_FUNC_NONE
-    );
+    input_jobs[_input_shading] = jobs.add([&]()
+    {
+        m_shader_inputs[_input_shading] = new c_shader_input
+        (
+            m_root_signature_cache, k_shading_textures_count,
+            nullptr, 0, true,
+            simple_vertex_input_elements, _countof(simple_vertex_input_elements),
+            shading_texture_range, _countof(shading_texture_range),
+            shading_render_target_formats, _countof(shading_render_target_formats),
+            false, D3D12_COMPARISON_FUNC_NONE
+        );
+    });
 
     // TEXCAM SHADER INPUTS
     // this is a range of descriptors inside a descriptor heap, allows use of resources from multiple heaps
     c_constant_buffer* constant_buffers_texcam[] =
     {
-        constant_buffers_default[_deferred_constant_buffer_object] // We can just share the object buffers between passes
-        //new c_constant_buffer(m_device, _render_pass_texcam, _texcam_constant_buffer_object, sizeof(s_object_cb), D3D12_SHADER_VISIBILITY_VERTEX)
+        constant_buffers_default[_deferred_constant_buffer_object], // We can just share the object buffers between passes
+        constant_buffers_default[_deferred_constant_buffer_view]
+        //new c_constant_buffer(m_constant_ring, _render_pass_texcam, _texcam_constant_buffer_object, sizeof(s_object_cb), D3D12_SHADER_VISIBILITY_VERTEX)
     };
     static_assert(_countof(constant_buffers_texcam) == k_texcam_constant_buffer_count);
     CD3DX12_DESCRIPTOR_RANGE texcam_texture_range[] = { { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, k_texcam_textures_count, 0 } };
     DXGI_FORMAT texcam_render_target_formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
-    m_shader_inputs[_input_texcam] = new c_shader_input
-    (
-        m_device, k_texcam_textures_count,
-        constant_buffers_texcam, _countof(constant_buffers_texcam),
-        full_vertex_input_elements, _countof(full_vertex_input_elements),
-        texcam_texture_range, _countof(texcam_texture_range),
-        texcam_render_target_formats, _countof(texcam_render_target_formats),
-        true, D3D12_COMPARISON_FUNC_LESS_EQUAL // Less equal allows the texcam objects to be redrawn where they are without drawing back over closer geometry
-    );
+    input_jobs[_input_texcam] = jobs.add([&]()
+    {
+        m_shader_inputs[_input_texcam] = new c_shader_input
+        (
+            m_root_signature_cache, k_texcam_textures_count,
+            constant_buffers_texcam, _countof(constant_buffers_texcam), false, // owned by the deferred input
+            full_vertex_input_elements, _countof(full_vertex_input_elements),
+            texcam_texture_range, _countof(texcam_texture_range),
+            texcam_render_target_formats, _countof(texcam_render_target_formats),
+            true, D3D12_COMPARISON_FUNC_LESS_EQUAL // Less equal allows the texcam objects to be redrawn where they are without drawing back over closer geometry
+        );
+        m_shader_inputs[_input_texcam]->set_compact_input_layout(compact_vertex_input_elements, _countof(compact_vertex_input_elements));
+    });
     
     // POST PROCESSING SHADER INPUTS
     c_constant_buffer* constant_buffers_post[] =
     {
-        new c_constant_buffer(m_device, _render_pass_post_processing, _post_constant_buffer, sizeof(s_post_parameters_cb), D3D12_SHADER_VISIBILITY_PIXEL)
+        new c_constant_buffer(m_constant_ring, _render_pass_post_processing, _post_constant_buffer, sizeof(s_post_parameters_cb), D3D12_SHADER_VISIBILITY_PIXEL)
     };
     static_assert(_countof(constant_buffers_post) == k_post_constant_buffer_count);
     CD3DX12_DESCRIPTOR_RANGE post_texture_range[] = { { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, k_post_textures_count, 0 } };
     DXGI_FORMAT post_render_target_formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM };
-    m_shader_inputs[_input_post_processing] = new c_shader_input
-    (
-        m_device, k_post_textures_count,
-        constant_buffers_post, _countof(constant_buffers_post),
-        simple_vertex_input_elements, _countof(simple_vertex_input_elements),
-        post_texture_range, _countof(post_texture_range),
-        post_render_target_formats, _countof(post_render_target_formats),
-        false, D3D12_COMPARISON_FUNC_NONE
-    );
-
-    m_deferred_shader = new c_shader(this, L"assets\\shaders\\default_vs.hlsl", "vs_main", L"assets\\shaders\\deferred.hlsl", "ps_deferred", _input_deferred);
-    m_lighting_shader = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\lighting.hlsl", "ps_deferred_lighting", _input_lighting);
-    m_shading_shader = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\shading.hlsl", "ps_deferred_shading", _input_shading);
-    m_texcam_shader = new c_shader(this, L"assets\\shaders\\default_vs.hlsl", "vs_main", L"assets\\shaders\\texcam.hlsl", "ps_sample_texture", _input_texcam);
+    input_jobs[_input_post_processing] = jobs.add([&]()
+    {
+        m_shader_inputs[_input_post_processing] = new c_shader_input
+        (
+            m_root_signature_cache, k_post_textures_count,
+            constant_buffers_post, _countof(constant_buffers_post), true,
+            simple_vertex_input_elements, _countof(simple_vertex_input_elements),
+            post_texture_range, _countof(post_texture_range),
+            post_render_target_formats, _countof(post_render_target_formats),
+            false, D3D12_COMPARISON_FUNC_NONE
+        );
+    });
+
+    m_lighting_shader = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\lighting.hlsl", "ps_deferred_lighting", _input_lighting);
+    m_shading_shader = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\shading.hlsl", "ps_deferred_shading", _input_shading);
+    m_texcam_shader = new c_shader(L"assets\\shaders\\default_vs.hlsl", "vs_main", L"assets\\shaders\\texcam.hlsl", "ps_sample_texture", _input_texcam);
+    m_texcam_compact_shader = new c_shader(L"assets\\shaders\\default_vs.hlsl", "vs_main_compact", L"assets\\shaders\\texcam.hlsl", "ps_sample_texture", _input_texcam, _mesh_vertex_format_compact);
     
-    m_post_shaders[_post_processing_default] = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\post_processing.hlsl", "ps_tex_to_screen", _input_post_processing);
-    m_post_shaders[_post_processing_blur_horizontal] = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\gaussian_blur.hlsl", "ps_gaussian_blur_horiz", _input_post_processing);
-    m_post_shaders[_post_processing_blur_vertical] = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\gaussian_blur.hlsl", "ps_gaussian_blur_vert", _input_post_processing);
-    m_post_shaders[_post_processing_depth_of_field] = new c_shader(this, L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\depth_of_field.hlsl", "ps_depth_of_field", _input_post_processing);
+    m_post_shaders[_post_processing_default] = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\post_processing.hlsl", "ps_tex_to_screen", _input_post_processing);
+    m_post_shaders[_post_processing_blur_horizontal] = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\gaussian_blur.hlsl", "ps_gaussian_blur_horiz", _input_post_processing);
+    m_post_shaders[_post_processing_blur_vertical] = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\gaussian_blur.hlsl", "ps_gaussian_blur_vert", _input_post_processing);
+    m_post_shaders[_post_processing_depth_of_field] = new c_shader(L"assets\\shaders\\screen_quad.hlsl", "vs_screen_quad", L"assets\\shaders\\depth_of_field.hlsl", "ps_depth_of_field", _input_post_processing);
+
+    // Deferred shaders are left until update_pipeline sees which material permutations are drawn
+    std::vector<c_shader*> shaders = this->get_shaders();
+    const dword thread_count = get_job_thread_count();
+    const auto start_time = std::chrono::steady_clock::now();
+    this->create_shaders(shaders.data(), static_cast<dword>(shaders.size()), &jobs, input_jobs, thread_count);
+    const double elapsed_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    // Compile time is summed across every thread, so it can be longer than the time taken
+    const s_shader_cache_statistics* const shader_cache_statistics = m_shader_cache->get_statistics();
+    LOG_MESSAGE(L"shaders: %d created in %.2fms on %d threads, %d compiled in %.2fms, %d loaded from the shader cache, %d shared", static_cast<dword>(shaders.size()), elapsed_milliseconds, thread_count, shader_cache_statistics->compiled_count, shader_cache_statistics->compile_milliseconds, shader_cache_statistics->disk_hit_count, shader_cache_statistics->memory_hit_count);
+    const s_pipeline_cache_statistics* const pipeline_cache_statistics = m_pipeline_cache->get_statistics();
+    LOG_MESSAGE(L"pipeline states: %d created in %.2fms, %d loaded from the pipeline library, %d shared", pipeline_cache_statistics->created_count, pipeline_cache_statistics->create_milliseconds, pipeline_cache_statistics->library_hit_count, pipeline_cache_statistics->shared_count);
+    const s_root_signature_cache_statistics* const root_signature_cache_statistics = m_root_signature_cache->get_statistics();
+    LOG_MESSAGE(L"root signatures: %d created, %d shared", root_signature_cache_statistics->created_count, root_signature_cache_statistics->shared_count);
+    m_pipeline_cache->save();
 
     // TODO: ensure input creation was successful before returning success
 
     return K_SUCCESS;
 }
 
-bool c_renderer_dx12::create_shader(const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type, s_shader_resources* out_resources)
+dword c_renderer_dx12::reload_shaders(const wchar_t* const file_path)
 {
-    HRESULT hr = S_OK;
+    const std::vector<c_shader*> shaders = this->get_shaders();
 
-    assert(vs_path != nullptr && vs_name != nullptr && ps_path != nullptr && ps_name != nullptr && out_resources != nullptr);
-    if (vs_path == nullptr || vs_name == nullptr || ps_path == nullptr || ps_name == nullptr || out_resources == nullptr)
+    // Anything not compiled directly is assumed to be included, and every shader could be including it
+    const bool included = std::none_of(shaders.begin(), shaders.end(), [file_path](const c_shader* const shader) { return shader->uses_file(file_path); });
+    dword reloaded_count = 0;
+    for (c_shader* const shader : shaders)
+    {
+        if ((included || shader->uses_file(file_path)) && shader->reload(this))
+        {
+            reloaded_count++;
+        }
+    }
+    return reloaded_count;
+}
+
+std::vector<c_shader*> c_renderer_dx12::get_shaders() const
+{
+    std::vector<c_shader*> shaders = { m_lighting_shader, m_shading_shader, m_texcam_shader, m_texcam_compact_shader };
+    shaders.insert(shaders.end(), std::begin(m_post_shaders), std::end(m_post_shaders));
+    for (dword vertex_format = 0; vertex_format < k_mesh_vertex_format_count; vertex_format++)
+    {
+        std::copy_if(std::begin(m_deferred_shaders[vertex_format]), std::end(m_deferred_shaders[vertex_format]), std::back_inserter(shaders), [](const c_shader* const shader) { return shader != nullptr; });
+    }
+    return shaders;
+}
+
+c_shader* c_renderer_dx12::new_deferred_shader(const e_mesh_vertex_format vertex_format, const dword permutation) const
+{
+    const char* const vs_name = vertex_format == _mesh_vertex_format_compact ? "vs_main_compact" : "vs_main";
+    c_shader* const shader = new c_shader(L"assets\\shaders\\default_vs.hlsl", vs_name, L"assets\\shaders\\deferred.hlsl", "ps_deferred", _input_deferred, vertex_format);
+    // deferred.hlsl drops the branches & texture fetches for whichever of these are 0
+    shader->add_ps_define("PERMUTATION_DIFFUSE_TEXTURE", (permutation & (1 << _material_permutation_diffuse_texture)) != 0 ? "1" : "0");
+    shader->add_ps_define("PERMUTATION_SPECULAR_TEXTURE", (permutation & (1 << _material_permutation_specular_texture)) != 0 ? "1" : "0");
+    shader->add_ps_define("PERMUTATION_NORMAL_TEXTURE", (permutation & (1 << _material_permutation_normal_texture)) != 0 ? "1" : "0");
+    return shader;
+}
+
+bool c_renderer_dx12::create_shader(const s_shader_description* const description, const bool reloading, s_shader_resources* const out_resources)
+{
+    assert(description != nullptr && out_resources != nullptr);
+    if (description == nullptr || out_resources == nullptr)
     {
         LOG_WARNING(L"invalid arguments in call! aborting");
-        *out_resources = {};
         return K_FAILURE;
     }
+    *out_resources = {};
+
+    ID3DBlob* vertex_shader = nullptr;
+    ID3DBlob* pixel_shader = nullptr;
+    if (!this->compile_shader(description->vs_path, nullptr, 0, description->vs_name, "vs_5_0", reloading, &vertex_shader))
+    {
+        return K_FAILURE;
+    }
+    if (!this->compile_shader(description->ps_path, description->ps_defines, description->ps_define_count, description->ps_name, "ps_5_0", reloading, &pixel_shader))
+    {
+        SAFE_RELEASE(vertex_shader);
+        return K_FAILURE;
+    }
+
+    const bool pipeline_state_created = this->create_pipeline_state(description, vertex_shader, pixel_shader, reloading, out_resources);
+    SAFE_RELEASE(vertex_shader);
+    SAFE_RELEASE(pixel_shader);
+    return pipeline_state_created;
+}
+
+void c_renderer_dx12::create_shaders(c_shader* const shaders[], const dword shader_count, c_job_graph* const jobs, const dword* const input_jobs, const dword thread_count)
+{
+    // Shaders sharing a vertex or pixel shader share its compile job, e.g. screen_quad.hlsl's vs_screen_quad
+    struct s_compile_job
+    {
+        const wchar_t* path;
+        const s_shader_define* defines;
+        dword define_count;
+        const char* name;
+        const char* profile;
+        ID3DBlob* bytecode; // nullptr if compilation failed
+        dword job_index;
+    };
+    std::vector<s_compile_job> compile_jobs;
+    const auto add_compile_job = [this, jobs, &compile_jobs](const wchar_t* const path, const s_shader_define* const defines, const dword define_count, const char* const name, const char* const profile) -> dword
+    {
+        for (dword compile_index = 0; compile_index < compile_jobs.size(); compile_index++)
+        {
+            const s_compile_job& compile_job = compile_jobs[compile_index];
+            const bool same_defines = compile_job.define_count == define_count && std::equal(defines, defines + define_count, compile_job.defines, [](const s_shader_define& a, const s_shader_define& b)
+            {
+                return strcmp(a.name, b.name) == 0 && strcmp(a.value, b.value) == 0;
+            });
+            if (_wcsicmp(compile_job.path, path) == 0 && same_defines && strcmp(compile_job.name, name) == 0 && strcmp(compile_job.profile, profile) == 0)
+            {
+                return compile_index;
+            }
+        }
+        // Jobs refer to their compile by index, as compile_jobs may move while it's still being filled
+        const dword compile_index = static_cast<dword>(compile_jobs.size());
+        const dword job_index = jobs->add([this, &compile_jobs, compile_index]()
+        {
+            s_compile_job& compile_job = compile_jobs[compile_index];
+            this->compile_shader(compile_job.path, compile_job.defines, compile_job.define_count, compile_job.name, compile_job.profile, false, &compile_job.bytecode);
+        });
+        compile_jobs.push_back({ path, defines, define_count, name, profile, nullptr, job_index });
+        return compile_index;
+    };
+
+    // Each pipeline state waits for both of its shaders & the root signature of its shader input
+    std::vector<s_shader_resources> resources(shader_count);
+    for (dword shader_index = 0; shader_index < shader_count; shader_index++)
+    {
+        const s_shader_description* const description = shaders[shader_index]->get_description();
+        const dword vs_compile = add_compile_job(description->vs_path, nullptr, 0, description->vs_name, "vs_5_0");
+        const dword ps_compile = add_compile_job(description->ps_path, description->ps_defines, description->ps_define_count, description->ps_name, "ps_5_0");
+        std::vector<dword> dependencies = { compile_jobs[vs_compile].job_index, compile_jobs[ps_compile].job_index };
+        if (input_jobs != nullptr)
+        {
+            dependencies.push_back(input_jobs[description->input_type]);
+        }
+        jobs->add([this, &compile_jobs, &resources, description, shader_index, vs_compile, ps_compile]()
+        {
+            ID3DBlob* const vertex_shader = compile_jobs[vs_compile].bytecode;
+            ID3DBlob* const pixel_shader = compile_jobs[ps_compile].bytecode;
+            if (vertex_shader != nullptr && pixel_shader != nullptr)
+            {
+                this->create_pipeline_state(description, vertex_shader, pixel_shader, false, &resources[shader_index]);
+            }
+        }, dependencies);
+    }
+
+    jobs->run(thread_count);
+
+    for (dword shader_index = 0; shader_index < shader_count; shader_index++)
+    {
+        shaders[shader_index]->set_resources(&resources[shader_index]);
+    }
+    // Each pipeline state holds its own references to the blobs it was created from
+    for (s_compile_job& compile_job : compile_jobs)
+    {
+        SAFE_RELEASE(compile_job.bytecode);
+    }
+}
+
+bool c_renderer_dx12::compile_shader(const wchar_t* const path, const s_shader_define* const defines, const dword define_count, const char* const name, const char* const profile, const bool reloading, ID3DBlob** const out_bytecode)
+{
+    assert(define_count <= MAXIMUM_SHADER_DEFINES);
+    D3D_SHADER_MACRO macros[MAXIMUM_SHADER_DEFINES + 1] = {}; // terminated by a nullptr name
+    for (dword define_index = 0; define_index < define_count; define_index++)
+    {
+        macros[define_index] = { defines[define_index].name, defines[define_index].value };
+    }
 
-    // create vertex and pixel shaders
-    // 
     // when debugging, we can compile the shader files at runtime.
     // but for release versions, we can compile the hlsl shaders
     // with fxc.exe to create .cso files, which contain the shader
     // bytecode. We can load the .cso files at runtime to get the
     // shader bytecode, which of course is faster than compiling
     // them at runtime
-#ifdef _DEBUG
-    // Enable better shader debugging with the graphics debugging tools.
-    constexpr dword compile_flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-    constexpr dword compile_flags = 0;
-#endif
-    ID3DBlob* vertex_shader = nullptr;
-    ID3DBlob* pixel_shader = nullptr;
-    ID3D12PipelineState* pipeline_state = nullptr;
+    // the shader cache does the same, keeping the bytecode of everything
+    // compiled & only compiling shaders again once their source changes
     ID3DBlob* error = nullptr;
-    hr = D3DCompileFromFile(vs_path, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, vs_name, "vs_5_0", compile_flags, 0, &vertex_shader, &error);
+    const HRESULT hr = m_shader_cache->compile(path, macros, name, profile, SHADER_COMPILE_FLAGS, out_bytecode, &error);
+    if (hr != S_OK && reloading)
+    {
+        // Mistakes in a reloaded shader leave the previous one running until they're fixed
+        LOG_WARNING(L"%s %hs failed to compile, keeping the previous shader\n%hs", path, name, error != nullptr ? (char*)error->GetBufferPointer() : "");
+        SAFE_RELEASE(error);
+        return K_FAILURE;
+    }
     if (hr != S_OK)
     {
         if (error != nullptr)
         {
             LOG_ERROR(L"%hs", (char*)error->GetBufferPointer());
         }
+        SAFE_RELEASE(error);
         HRESULT_VALID(hr);
         return K_FAILURE;
     }
+    return K_SUCCESS;
+}
+
+bool c_renderer_dx12::create_pipeline_state(const s_shader_description* const description, ID3DBlob* const vertex_shader, ID3DBlob* const pixel_shader, const bool reloading, s_shader_resources* const out_resources)
+{
     // fill out a shader bytecode structure, which is basically just a pointer
     // to the shader bytecode and the size of the shader bytecode
     D3D12_SHADER_BYTECODE vs_bytecode = {};
     vs_bytecode.BytecodeLength = vertex_shader->GetBufferSize();
     vs_bytecode.pShaderBytecode = vertex_shader->GetBufferPointer();
 
-    hr = D3DCompileFromFile(ps_path, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, ps_name, "ps_5_0", compile_flags, 0, &pixel_shader, &error);
-    if (hr != S_OK)
-    {
-        if (error != nullptr)
-        {
-            LOG_ERROR(L"%hs", (char*)error->GetBufferPointer());
-        }
-        HRESULT_VALID(hr);
-        return K_FAILURE;
-    }
     // fill out shader bytecode structure for pixel shader
     D3D12_SHADER_BYTECODE ps_bytecode = {};
     ps_bytecode.BytecodeLength = pixel_shader->GetBufferSize();
@@ -432,10 +675,10 @@ bool c_renderer_dx12::create_shader(const wchar_t* vs_path, const char* vs_name,
     DXGI_SAMPLE_DESC sample_desc = {};
     sample_desc.Count = 1; // multisample count (no multisampling, so we just put 1, since we still need 1 sample)
 
-    c_shader_input* shader_input = m_shader_inputs[input_type];
+    c_shader_input* shader_input = m_shader_inputs[description->input_type];
 
     D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {}; // a structure to define a pso
-    pso_desc.InputLayout = shader_input->get_input_layout(); // the structure describing our input layout
+    pso_desc.InputLayout = shader_input->get_input_layout(description->vertex_format); // the structure describing our input layout
     pso_desc.pRootSignature = shader_input->get_root_signature(); // the root signature that describes the input data this pso needs
     pso_desc.VS = vs_bytecode; // structure describing where to find the vertex shader bytecode and how large it is
     pso_desc.PS = ps_bytecode; // same as VS but for pixel shader
@@ -464,9 +707,19 @@ bool c_renderer_dx12::create_shader(const wchar_t* vs_path, const char* vs_name,
     }
 
     // create the pso
-    hr = m_device->CreateGraphicsPipelineState(&pso_desc, IID_PPV_ARGS(&pipeline_state));
+    // Identical pipelines are shared, e.g. shaders reloaded for a changed include they compile the same without
+    ID3D12PipelineState* pipeline_state = nullptr;
+    const HRESULT hr = m_pipeline_cache->create_graphics_pipeline_state(&pso_desc, shader_input->get_root_signature_hash(), &pipeline_state);
+    if (hr != S_OK && reloading)
+    {
+        // Most likely the shader's resources no longer match its root signature
+        LOG_WARNING(L"%s %hs doesn't fit its shader input, keeping the previous shader", description->ps_path, description->ps_name);
+        return K_FAILURE;
+    }
     if (!HRESULT_VALID(hr)) { return K_FAILURE; }
 
+    vertex_shader->AddRef();
+    pixel_shader->AddRef();
     out_resources->vertex_shader = vertex_shader;
     out_resources->pixel_shader = pixel_shader;
     out_resources->pipeline_state = pipeline_state;
@@ -479,10 +732,10 @@ qword c_renderer_dx12::get_gbuffer_textureid(e_gbuffers gbuffer_type) const
     return m_gbuffer_gpu_handles[gbuffer_type].ptr;
 }
 
-bool c_renderer_dx12::upload_geometry(const dword vertex_size, const void* const vertices, const dword vertices_size, const dword indices[], const dword indices_size, s_geometry_resources* const out_resources)
+bool c_renderer_dx12::upload_geometry(const dword vertex_size, const void* const vertices, const dword vertices_size, const void* const indices, const dword indices_size, const DXGI_FORMAT index_format, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch)
 {
-    const bool vertex_upload_result = this->upload_vertex_buffer(vertex_size, vertices, vertices_size, out_resources);
-    const bool index_upload_result = this->upload_index_buffer(indices, indices_size, out_resources);
+    const bool vertex_upload_result = this->upload_vertex_buffer(vertex_size, vertices, vertices_size, out_resources, upload_batch);
+    const bool index_upload_result = this->upload_index_buffer(indices, indices_size, index_format, out_resources, upload_batch);
 
     const bool upload_successful = vertex_upload_result && index_upload_result;
     assert(upload_successful);
@@ -490,64 +743,82 @@ bool c_renderer_dx12::upload_geometry(const dword vertex_size, const void* const
     return upload_successful;
 }
 
-bool c_renderer_dx12::create_geometry(vertex vertices[], dword vertices_size, dword indices[], dword indices_size, s_geometry_resources* const out_resources)
+bool c_renderer_dx12::compute_tangent_frame(vertex vertices[], const dword vertex_count, const void* const indices, const dword index_count, const DXGI_FORMAT index_format)
 {
     HRESULT hr = S_OK;
-    const dword face_count = indices_size / sizeof(dword) / 3; // IMPORTANT: ASSUMES ALL MODELS ARE TRIANGULATED TO GET ACCURATE FACE COUNT
-    const dword vertex_count = vertices_size / sizeof(vertex);
+    const dword face_count = index_count / 3; // IMPORTANT: ASSUMES ALL MODELS ARE TRIANGULATED TO GET ACCURATE FACE COUNT
+
+    // ComputeTangentFrame wants sequential arrays, carve them all out of a single scratch allocation
+    ubyte* scratch = new ubyte[vertex_count * (sizeof(vector3d) * 4 + sizeof(point2d))];
+    vector3d* positions = reinterpret_cast<vector3d*>(scratch);
+    vector3d* normals = positions + vertex_count;
+    vector3d* tangents = normals + vertex_count;
+    vector3d* binormals = tangents + vertex_count;
+    point2d* texcoords = reinterpret_cast<point2d*>(binormals + vertex_count);
 
-    // Retrieve positions, normals and texcoords and copy into sequential arrays for ComputeTangentFrame
-    vector3d* positions = new vector3d[vertex_count];
     for (dword i = 0; i < vertex_count; i++)
     {
         positions[i] = vertices[i].vertex.position;
+        normals[i] = vertices[i].vertex.normal;
+        texcoords[i] = vertices[i].vertex.tex_coord;
     }
 
-    vector3d* normals = new vector3d[vertex_count];
-    for (dword i = 0; i < vertex_count; i++)
+    // Index data is passed through in its native width, no widening copy needed
+    if (index_format == DXGI_FORMAT_R16_UINT)
     {
-        normals[i] = vertices[i].vertex.normal;
+        hr = ComputeTangentFrame((const uint16_t*)indices, face_count, (XMFLOAT3*)positions, (XMFLOAT3*)normals, (XMFLOAT2*)texcoords, vertex_count, (XMFLOAT3*)tangents, (XMFLOAT3*)binormals);
     }
-
-    point2d* texcoords = new point2d[vertex_count];
-    for (dword i = 0; i < vertex_count; i++)
+    else
     {
-        texcoords[i] = vertices[i].vertex.tex_coord;
+        hr = ComputeTangentFrame((const uint32_t*)indices, face_count, (XMFLOAT3*)positions, (XMFLOAT3*)normals, (XMFLOAT2*)texcoords, vertex_count, (XMFLOAT3*)tangents, (XMFLOAT3*)binormals);
+    }
+    if (!HRESULT_VALID(hr))
+    {
+        delete[] scratch;
+        return K_FAILURE;
     }
 
-    vector3d* tangents = new vector3d[vertex_count];
-    vector3d* binormals = new vector3d[vertex_count];
-    hr = ComputeTangentFrame((uint32_t*)indices, face_count, (XMFLOAT3*)positions, (XMFLOAT3*)normals, (XMFLOAT2*)texcoords, vertex_count, (XMFLOAT3*)tangents, (XMFLOAT3*)binormals);
-    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
-    delete[] positions;
-    delete[] normals;
-    delete[] texcoords;
     for (dword i = 0; i < vertex_count; i++)
     {
         vertices[i].tangent = tangents[i];
         vertices[i].bitangent = binormals[i];
     }
-    delete[] tangents;
-    delete[] binormals;
+    delete[] scratch;
+
+    return K_SUCCESS;
+}
+
+bool c_renderer_dx12::create_geometry(vertex vertices[], dword vertices_size, dword indices[], dword indices_size, s_geometry_resources* const out_resources)
+{
+    const dword vertex_count = vertices_size / sizeof(vertex);
+    const dword index_count = indices_size / sizeof(dword);
 
-    this->upload_geometry(sizeof(vertex), vertices, vertices_size, indices, indices_size, out_resources);
+    if (!this->compute_tangent_frame(vertices, vertex_count, indices, index_count, DXGI_FORMAT_R32_UINT))
+    {
+        return K_FAILURE;
+    }
+    compute_geometry_bounds(vertices, vertex_count, &out_resources->bounds);
+    out_resources->vertex_format = _mesh_vertex_format_full;
+    out_resources->tex_coord_density = compute_tex_coord_density(vertices, sizeof(vertex), indices, _mesh_index_format_32, index_count);
 
-    return true;
+    const bool geometry_uploaded = this->upload_geometry(sizeof(vertex), vertices, vertices_size, indices, indices_size, DXGI_FORMAT_R32_UINT, out_resources, m_upload_batch);
+    return geometry_uploaded && m_upload_batch->flush();
 }
 
 bool c_renderer_dx12::create_simple_geometry(simple_vertex vertices[], dword vertices_size, s_geometry_resources* const out_resources)
 {
-    const bool result = this->upload_vertex_buffer(sizeof(simple_vertex), vertices, vertices_size, out_resources);
+    const bool result = this->upload_vertex_buffer(sizeof(simple_vertex), vertices, vertices_size, out_resources, m_upload_batch);
 
-    return result;
+    return result && m_upload_batch->flush();
 }
 
 bool c_renderer_dx12::load_model(const wchar_t* const file_path, s_geometry_resources* const out_resources)
 {
     assert(out_resources != nullptr);
 
-    std::ifstream vbo_file(file_path, std::ifstream::in | std::ifstream::binary);
-    if (vbo_file.fail())
+    // Map the file rather than streaming it, vertex & index ranges are read in place from the mapped view
+    c_mesh_file mesh_file;
+    if (!mesh_file.open(file_path))
     {
         LOG_WARNING(L"failed to load file %s!", file_path);
         
@@ -557,52 +828,110 @@ bool c_renderer_dx12::load_model(const wchar_t* const file_path, s_geometry_reso
         return false;
     }
 
-    dword vertex_count = 0;
-    dword index_count = 0;
+    const bool geometry_loaded = this->create_geometry_from_mesh_file(mesh_file, out_resources, m_upload_batch);
+    return geometry_loaded && m_upload_batch->flush();
+}
+
+bool c_renderer_dx12::load_model_from_memory(const ubyte* const data, const qword data_size, const wchar_t* const debug_name, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch)
+{
+    assert(out_resources != nullptr);
 
-    vbo_file.read(reinterpret_cast<char*>(&vertex_count), sizeof(dword));
-    if (vertex_count == 0)
+    c_mesh_file mesh_file;
+    if (!mesh_file.open(data, data_size, debug_name))
     {
-        LOG_WARNING(L"vertex count for VBO %s was 0! stopping load", file_path);
+        LOG_WARNING(L"failed to load mesh %s!", debug_name);
+
+        // Initialise data to default, nullptrs and 0 counts so we can continue beyond this failure
         s_geometry_resources empty_resources = {};
         *out_resources = empty_resources;
         return false;
     }
 
-    vbo_file.read(reinterpret_cast<char*>(&index_count), sizeof(dword));
-    if (index_count == 0)
+    // Without a batch from the caller, upload immediately
+    if (upload_batch == nullptr)
     {
-        LOG_WARNING(L"index count for VBO %s was 0! stopping load", file_path);
-        s_geometry_resources empty_resources = {};
-        *out_resources = empty_resources;
-        return false;
+        const bool geometry_loaded = this->create_geometry_from_mesh_file(mesh_file, out_resources, m_upload_batch);
+        return geometry_loaded && m_upload_batch->flush();
     }
+    return this->create_geometry_from_mesh_file(mesh_file, out_resources, upload_batch);
+}
 
-    vertex_part* vertices = new vertex_part[vertex_count];
-    vbo_file.read(reinterpret_cast<char*>(vertices), sizeof(vertex_part) * vertex_count);
+bool c_renderer_dx12::create_geometry_from_mesh_file(const c_mesh_file& mesh_file, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch)
+{
+    const dword vertex_count = mesh_file.get_vertex_count();
+    const dword index_count = mesh_file.get_index_count();
+    const DXGI_FORMAT index_format = mesh_file.get_index_format() == _mesh_index_format_16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    const dword indices_size = index_count * mesh_file.get_index_stride();
+
+    // Cooked meshes are already in the final layout with tangents & bounds, upload straight from the mapped view
+    // Compact vertices are uploaded as they are too, the vertex shader decodes them
+    if (mesh_file.get_type() == _mesh_file_cooked)
+    {
+        static_assert(sizeof(s_geometry_bounds) == sizeof(s_mesh_file_bounds));
+        memcpy(&out_resources->bounds, mesh_file.get_bounds(), sizeof(s_geometry_bounds));
+
+        const dword vertex_stride = mesh_file.get_vertex_stride();
+        out_resources->vertex_format = mesh_file.get_vertex_format();
+        const bool geometry_loaded = this->upload_geometry(vertex_stride, mesh_file.get_vertex_data(), vertex_count * vertex_stride, mesh_file.get_index_data(), indices_size, index_format, out_resources, upload_batch);
+        assert(geometry_loaded);
+
+        // Every level is a range of the one index buffer
+        const s_mesh_file_lod* const lods = mesh_file.get_lods();
+        out_resources->lod_count = mesh_file.get_lod_count();
+        for (dword lod = 0; lod < out_resources->lod_count; lod++)
+        {
+            out_resources->lods[lod] = { lods[lod].index_offset, lods[lod].index_count, lods[lod].error };
+        }
 
-    uword* indices = new uword[index_count];
-    vbo_file.read(reinterpret_cast<char*>(indices), sizeof(uword) * index_count);
+        // Measured over the full detail level, compact vertices are decoded first
+        const dword lod_index_count = out_resources->lod_count > 0 ? out_resources->lods[0].index_count : index_count;
+        const ubyte* const lod_indices = static_cast<const ubyte*>(mesh_file.get_index_data()) + (out_resources->lod_count > 0 ? out_resources->lods[0].index_offset : 0) * mesh_file.get_index_stride();
+        if (out_resources->vertex_format == _mesh_vertex_format_compact)
+        {
+            const s_mesh_file_compact_vertex* const compact_vertices = static_cast<const s_mesh_file_compact_vertex*>(mesh_file.get_vertex_data());
+            std::vector<s_mesh_file_vertex> decoded_vertices(vertex_count);
+            for (dword i = 0; i < vertex_count; i++)
+            {
+                decode_compact_vertex(compact_vertices[i], *mesh_file.get_bounds(), &decoded_vertices[i]);
+            }
+            out_resources->tex_coord_density = compute_tex_coord_density(decoded_vertices.data(), sizeof(s_mesh_file_vertex), lod_indices, mesh_file.get_index_format(), lod_index_count);
+        }
+        else
+        {
+            out_resources->tex_coord_density = compute_tex_coord_density(mesh_file.get_vertex_data(), vertex_stride, lod_indices, mesh_file.get_index_format(), lod_index_count);
+        }
 
-    // conversion to full vertex type & 32 bit index buffer
-    dword* indices32 = new dword[index_count];
-    for (dword i = 0; i < index_count; i++)
-    {
-        indices32[i] = indices[i];
+        // Culled on the CPU every frame, so copied out of the file before it's unmapped
+        static_assert(sizeof(s_geometry_meshlet) == sizeof(s_mesh_file_meshlet));
+        if (geometry_loaded && mesh_file.get_meshlet_count() > 0)
+        {
+            out_resources->meshlet_count = mesh_file.get_meshlet_count();
+            out_resources->meshlets = new s_geometry_meshlet[out_resources->meshlet_count];
+            memcpy(out_resources->meshlets, mesh_file.get_meshlets(), out_resources->meshlet_count * sizeof(s_geometry_meshlet));
+        }
+        return geometry_loaded;
     }
+
+    // Legacy VBO, convert to full vertex type, the only copy we make as tangents need to be interleaved
+    const vertex_part* const vertices = static_cast<const vertex_part*>(mesh_file.get_vertex_data());
     vertex* full_vertices = new vertex[vertex_count];
     for (dword i = 0; i < vertex_count; i++)
     {
         full_vertices[i].vertex = vertices[i];
     }
+    compute_geometry_bounds(full_vertices, vertex_count, &out_resources->bounds);
+    out_resources->vertex_format = _mesh_vertex_format_full;
+    out_resources->tex_coord_density = compute_tex_coord_density(full_vertices, sizeof(vertex), mesh_file.get_index_data(), mesh_file.get_index_format(), index_count);
 
-    const bool geometry_loaded = this->create_geometry(full_vertices, vertex_count * sizeof(vertex), indices32, index_count * sizeof(dword), out_resources);
+    // VBO indices are 16 bit, these are fed directly from the mapped view to the upload with no widening
+    bool geometry_loaded = this->compute_tangent_frame(full_vertices, vertex_count, mesh_file.get_index_data(), index_count, index_format);
+    if (geometry_loaded)
+    {
+        geometry_loaded = this->upload_geometry(sizeof(vertex), full_vertices, vertex_count * sizeof(vertex), mesh_file.get_index_data(), indices_size, index_format, out_resources, upload_batch);
+    }
     assert(geometry_loaded);
 
-    // free memory
-    delete[] vertices;
-    delete[] indices;
-    delete[] indices32;
+    // free memory, the batch has already copied it to staging
     delete[] full_vertices;
 
     return geometry_loaded;
@@ -624,7 +953,101 @@ bool c_renderer_dx12::initialise_default_geometry()
     return creation_succeeded;
 }
 
-bool c_renderer_dx12::upload_vertex_buffer(const dword vertex_size, const void* const vertices, const dword vertices_size, s_geometry_resources* const out_resources)
+bool c_renderer_dx12::initialise_placeholder_resources()
+{
+    HRESULT hr = S_OK;
+
+    // Unit box, each face with its own 4 vertices so normals stay flat
+    // Faces are wound so cross(s, t) points out along the normal, matching the default clockwise front faces
+    constexpr float face_axes[6][3][3] =
+    {
+        // normal                s                     t
+        { {  1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+        { { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } },
+        { { 0.0f,  1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } },
+        { { 0.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+        { { 0.0f, 0.0f,  1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+        { { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f } },
+    };
+    constexpr float corner_signs[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+
+    vertex box_vertices[_countof(face_axes) * 4] = {};
+    dword box_indices[_countof(face_axes) * 6] = {};
+    for (dword face = 0; face < _countof(face_axes); face++)
+    {
+        const float* const normal = face_axes[face][0];
+        const float* const s = face_axes[face][1];
+        const float* const t = face_axes[face][2];
+        for (dword corner = 0; corner < 4; corner++)
+        {
+            vertex_part& box_vertex = box_vertices[face * 4 + corner].vertex;
+            box_vertex.position.x = normal[0] + s[0] * corner_signs[corner][0] + t[0] * corner_signs[corner][1];
+            box_vertex.position.y = normal[1] + s[1] * corner_signs[corner][0] + t[1] * corner_signs[corner][1];
+            box_vertex.position.z = normal[2] + s[2] * corner_signs[corner][0] + t[2] * corner_signs[corner][1];
+            box_vertex.normal = vector3d(normal[0], normal[1], normal[2]);
+            box_vertex.tex_coord = point2d(corner_signs[corner][0] * 0.5f + 0.5f, 0.5f - corner_signs[corner][1] * 0.5f);
+        }
+
+        const dword quad_indices[6] = { 0, 1, 2, 0, 2, 3 };
+        for (dword i = 0; i < _countof(quad_indices); i++)
+        {
+            box_indices[face * 6 + i] = face * 4 + quad_indices[i];
+        }
+    }
+
+    if (!this->create_geometry(box_vertices, sizeof(box_vertices), box_indices, sizeof(box_indices), &m_placeholder_geometry)) { return K_FAILURE; }
+    m_placeholder_geometry.vertex_buffer->SetName(L"Placeholder Vertex Buffer");
+    m_placeholder_geometry.index_buffer->SetName(L"Placeholder Index Buffer");
+
+    // White diffuse so the material colour shows through, no specular, and a flat tangent space normal
+    const dword placeholder_texels[k_default_textures_count] =
+    {
+        0xFFFFFFFF, // _texture_diffuse
+        0xFF000000, // _texture_specular
+        0xFFFF8080, // _texture_normal (0.5, 0.5, 1.0)
+    };
+    static_assert(_countof(placeholder_texels) == k_default_textures_count);
+
+    const CD3DX12_HEAP_PROPERTIES default_heap_properties(D3D12_HEAP_TYPE_DEFAULT);
+    const CD3DX12_RESOURCE_DESC texture_description = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1);
+    for (dword i = 0; i < k_default_textures_count; i++)
+    {
+        ID3D12Resource* texture_resource;
+        hr = m_device->CreateCommittedResource(&default_heap_properties, D3D12_HEAP_FLAG_NONE, &texture_description, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texture_resource));
+        if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+        texture_resource->SetName(L"Placeholder Texture");
+        m_placeholder_textures[i].resource = texture_resource;
+        m_placeholder_textures[i].width = 1;
+        m_placeholder_textures[i].height = 1;
+        m_placeholder_textures[i].mip_count = 1;
+        m_placeholder_textures[i].full_width = 1;
+        m_placeholder_textures[i].full_height = 1;
+
+        D3D12_SUBRESOURCE_DATA texel_data = {};
+        texel_data.pData = &placeholder_texels[i];
+        texel_data.RowPitch = sizeof(dword);
+        texel_data.SlicePitch = sizeof(dword);
+        if (!m_upload_batch->upload_texture(texture_resource, &texel_data, 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)) { return K_FAILURE; }
+    }
+    if (!m_upload_batch->flush()) { return K_FAILURE; }
+
+    return K_SUCCESS;
+}
+
+const s_texture_resources* const c_renderer_dx12::get_placeholder_texture(const e_texture_type texture_type) const
+{
+    const bool texture_type_valid = IN_RANGE_COUNT(texture_type, 0, k_default_textures_count);
+    assert(texture_type_valid);
+    if (!texture_type_valid)
+    {
+        LOG_WARNING(L"no placeholder for texture type [%d]! using diffuse", texture_type);
+        return &m_placeholder_textures[_texture_diffuse];
+    }
+
+    return &m_placeholder_textures[texture_type];
+}
+
+bool c_renderer_dx12::upload_vertex_buffer(const dword vertex_size, const void* const vertices, const dword vertices_size, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch)
 {
     HRESULT hr = S_OK;
 
@@ -645,20 +1068,8 @@ bool c_renderer_dx12::upload_vertex_buffer(const dword vertex_size, const void*
     if (!HRESULT_VALID(hr)) { return K_FAILURE; }
     out_resources->vertex_buffer->SetName(L"Vertex Buffer Resource Heap");
 
-    // setup vertex data subresource
-    D3D12_SUBRESOURCE_DATA vertex_data = {};
-    vertex_data.pData = vertices; // pointer to our vertex array
-    vertex_data.RowPitch = vertices_size; // size of all our triangle vertex data
-    vertex_data.SlicePitch = vertices_size; // also the size of our triangle vertex data
-
-    // Upload resources to the GPU
-    ResourceUploadBatch resource_upload(m_device);
-    resource_upload.Begin();
-    resource_upload.Upload(out_resources->vertex_buffer, 0, &vertex_data, 1);
-    resource_upload.Transition(out_resources->vertex_buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-    // wait for upload thread to terminate
-    std::future<void> upload_thread = resource_upload.End(m_command_queue);
-    upload_thread.wait();
+    // Record the upload, the buffer is usable once the batch has been flushed
+    if (!upload_batch->upload_buffer(out_resources->vertex_buffer, vertices, vertices_size, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)) { return K_FAILURE; }
 
     // Vertex buffer view
     out_resources->vertex_buffer_view.BufferLocation = out_resources->vertex_buffer->GetGPUVirtualAddress();
@@ -668,11 +1079,11 @@ bool c_renderer_dx12::upload_vertex_buffer(const dword vertex_size, const void*
     return K_SUCCESS;
 }
 
-bool c_renderer_dx12::upload_index_buffer(const dword indices[], const dword indices_size, s_geometry_resources* const out_resources)
+bool c_renderer_dx12::upload_index_buffer(const void* const indices, const dword indices_size, const DXGI_FORMAT index_format, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch)
 {
     HRESULT hr = S_OK;
 
-    const bool arguments_valid = indices != nullptr && indices_size > 0;
+    const bool arguments_valid = indices != nullptr && indices_size > 0 && (index_format == DXGI_FORMAT_R16_UINT || index_format == DXGI_FORMAT_R32_UINT);
     assert(arguments_valid);
     if (!arguments_valid)
     {
@@ -680,6 +1091,9 @@ bool c_renderer_dx12::upload_index_buffer(const dword indices[], const dword ind
         out_resources->index_buffer = nullptr;
         out_resources->index_buffer_view = {};
         out_resources->index_count = 0;
+        out_resources->lod_count = 0;
+        out_resources->meshlets = nullptr;
+        out_resources->meshlet_count = 0;
         return K_FAILURE;
     }
 
@@ -688,26 +1102,20 @@ bool c_renderer_dx12::upload_index_buffer(const dword indices[], const dword ind
     if (!HRESULT_VALID(hr)) { return K_FAILURE; }
     out_resources->index_buffer->SetName(L"Index Buffer Resource Heap");
 
-    // setup index data subresource
-    D3D12_SUBRESOURCE_DATA index_data = {};
-    index_data.pData = indices; // pointer to our index array
-    index_data.RowPitch = indices_size; // size of all our index buffer
-    index_data.SlicePitch = indices_size; // also the size of our index buffer
-
-    // Upload resources to the GPU
-    ResourceUploadBatch resource_upload(m_device);
-    resource_upload.Begin();
-    resource_upload.Upload(out_resources->index_buffer, 0, &index_data, 1);
-    resource_upload.Transition(out_resources->index_buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-    // wait for upload thread to terminate
-    std::future<void> upload_thread = resource_upload.End(m_command_queue);
-    upload_thread.wait();
+    // Record the upload, the buffer is usable once the batch has been flushed
+    if (!upload_batch->upload_buffer(out_resources->index_buffer, indices, indices_size, D3D12_RESOURCE_STATE_INDEX_BUFFER)) { return K_FAILURE; }
 
     // Init index buffer view
     out_resources->index_buffer_view.BufferLocation = out_resources->index_buffer->GetGPUVirtualAddress();
-    out_resources->index_buffer_view.Format = DXGI_FORMAT_R32_UINT;
+    out_resources->index_buffer_view.Format = index_format;
     out_resources->index_buffer_view.SizeInBytes = indices_size;
-    out_resources->index_count = indices_size / sizeof(dword);
+    out_resources->index_count = indices_size / (index_format == DXGI_FORMAT_R16_UINT ? sizeof(uword) : sizeof(dword));
+
+    // A single full detail level & no meshlets, cooked meshes replace these with the ones from their file
+    out_resources->lods[0] = { 0, out_resources->index_count, 0.0f };
+    out_resources->lod_count = 1;
+    out_resources->meshlets = nullptr;
+    out_resources->meshlet_count = 0;
 
     return K_SUCCESS;
 }
@@ -723,20 +1131,133 @@ bool c_renderer_dx12::load_texture(const e_texture_type texture_type, const wcha
         return K_FAILURE;
     }
 
-    // create DDS texture and upload to the GPU using helper class
+    // create DDS texture, subresources point into dds_data which the batch copies into staging
     ID3D12Resource* texture_resource;
-    ResourceUploadBatch resource_upload(m_device);
-    resource_upload.Begin();
-    hr = CreateDDSTextureFromFile(m_device, resource_upload, file_path, &texture_resource);
+    std::unique_ptr<uint8_t[]> dds_data;
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+    hr = LoadDDSTextureFromFile(m_device, file_path, &texture_resource, dds_data, subresources);
     if (!HRESULT_VALID(hr)) { return K_FAILURE; }
     texture_resource->SetName(L"Texture Buffer Resource Heap");
-    std::future<void> upload_thread = resource_upload.End(m_command_queue);
-    // wait for upload thread to terminate
-    upload_thread.wait();
+    out_resources->resource = texture_resource;
+    this->set_texture_info(texture_resource, static_cast<dword>(texture_resource->GetDesc().Width), texture_resource->GetDesc().Height, out_resources);
 
+    const bool texture_uploaded = m_upload_batch->upload_texture(texture_resource, subresources.data(), static_cast<dword>(subresources.size()), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    return texture_uploaded && m_upload_batch->flush();
+}
+
+bool c_renderer_dx12::load_texture_from_memory(const e_texture_type texture_type, const ubyte* const data, const qword data_size, const dword maximum_size, const wchar_t* const debug_name, s_texture_resources* const out_resources, c_upload_batch* const upload_batch)
+{
+    HRESULT hr = S_OK;
+    const bool valid_arguments = data != nullptr && data_size > 0 && out_resources != nullptr;
+    assert(valid_arguments);
+    if (!valid_arguments)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return K_FAILURE;
+    }
+
+    // create DDS texture from the in memory file, subresources point into data which the batch copies into staging
+    // Only the mips within maximum_size are created & uploaded
+    ID3D12Resource* texture_resource;
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+    hr = LoadDDSTextureFromMemory(m_device, data, static_cast<size_t>(data_size), &texture_resource, subresources, maximum_size);
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+    texture_resource->SetName(debug_name);
     out_resources->resource = texture_resource;
 
-    return K_SUCCESS;
+    // The loader has already validated the header, the height & width follow the magic number, header size & flags
+    constexpr qword DDS_HEIGHT_OFFSET = 12;
+    constexpr qword DDS_WIDTH_OFFSET = 16;
+    dword full_width = 0;
+    dword full_height = 0;
+    memcpy(&full_height, data + DDS_HEIGHT_OFFSET, sizeof(full_height));
+    memcpy(&full_width, data + DDS_WIDTH_OFFSET, sizeof(full_width));
+    this->set_texture_info(texture_resource, full_width, full_height, out_resources);
+
+    // Without a batch from the caller, upload immediately
+    c_upload_batch* const batch = upload_batch != nullptr ? upload_batch : m_upload_batch;
+    const bool texture_uploaded = batch->upload_texture(texture_resource, subresources.data(), static_cast<dword>(subresources.size()), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    if (upload_batch == nullptr)
+    {
+        return texture_uploaded && m_upload_batch->flush();
+    }
+    return texture_uploaded;
+}
+
+void c_renderer_dx12::retire_texture(const s_texture_resources* const resources)
+{
+    assert(resources != nullptr);
+    if (resources->resource == nullptr)
+    {
+        return;
+    }
+    this->retire((ID3D12Resource*)resources->resource);
+}
+
+void c_renderer_dx12::retire_geometry(const s_geometry_resources* const resources)
+{
+    assert(resources != nullptr);
+    if (resources->vertex_buffer != nullptr)
+    {
+        this->retire(resources->vertex_buffer);
+    }
+    if (resources->index_buffer != nullptr)
+    {
+        this->retire(resources->index_buffer);
+    }
+}
+
+void c_renderer_dx12::retire_shader(const s_shader_resources* const resources)
+{
+    assert(resources != nullptr);
+    ID3DBlob* vertex_shader = (ID3DBlob*)resources->vertex_shader;
+    ID3DBlob* pixel_shader = (ID3DBlob*)resources->pixel_shader;
+    SAFE_RELEASE(vertex_shader);
+    SAFE_RELEASE(pixel_shader);
+    if (resources->pipeline_state != nullptr)
+    {
+        this->retire((ID3D12PipelineState*)resources->pipeline_state);
+    }
+}
+
+void c_renderer_dx12::retire(ID3D12Pageable* const object)
+{
+    m_retired_objects.push_back({ object, m_frame_count });
+}
+
+void c_renderer_dx12::set_texture_info(ID3D12Resource* const texture_resource, const dword full_width, const dword full_height, s_texture_resources* const out_resources)
+{
+    const D3D12_RESOURCE_DESC description = texture_resource->GetDesc();
+    out_resources->width = static_cast<dword>(description.Width);
+    out_resources->height = description.Height;
+    out_resources->mip_count = description.MipLevels;
+    out_resources->full_width = full_width;
+    out_resources->full_height = full_height;
+    out_resources->skipped_mip_count = 0;
+    while ((full_width >> out_resources->skipped_mip_count) > out_resources->width)
+    {
+        out_resources->skipped_mip_count++;
+    }
+    out_resources->resident_size = m_device->GetResourceAllocationInfo(0, 1, &description).SizeInBytes;
+}
+
+void c_renderer_dx12::release_retired_objects(const bool release_all)
+{
+    // The frame being recorded reuses the oldest frame's resources, so by now every frame up to FRAME_BUFFER_COUNT ago has finished
+    // An object retired after m_frame_count frames were submitted was last used by the frame before that
+    for (size_t i = 0; i < m_retired_objects.size();)
+    {
+        if (release_all || m_frame_count >= m_retired_objects[i].second + FRAME_BUFFER_COUNT)
+        {
+            SAFE_RELEASE(m_retired_objects[i].first);
+            m_retired_objects[i] = m_retired_objects.back();
+            m_retired_objects.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
 }
 
 bool c_renderer_dx12::upload_assets()
@@ -803,6 +1324,7 @@ c_renderer_dx12::~c_renderer_dx12()
         m_frame_index = i;
         this->wait_for_previous_frame();
     }
+    this->release_retired_objects(true);
 
     if (m_fence_event != nullptr)
     {
@@ -820,6 +1342,12 @@ c_renderer_dx12::~c_renderer_dx12()
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
     delete m_imgui_descriptor_heap;
+    delete m_upload_batch;
+    delete m_material_table;
+    delete m_constant_ring;
+    delete m_root_signature_cache;
+    delete m_pipeline_cache;
+    delete m_shader_cache;
 
     SAFE_RELEASE(m_device);
     SAFE_RELEASE(m_swapchain);
@@ -827,6 +1355,13 @@ c_renderer_dx12::~c_renderer_dx12()
     SAFE_RELEASE(m_command_list);
     SAFE_RELEASE(m_screen_quad.vertex_buffer);
     SAFE_RELEASE(m_screen_quad.index_buffer);
+    SAFE_RELEASE(m_placeholder_geometry.vertex_buffer);
+    SAFE_RELEASE(m_placeholder_geometry.index_buffer);
+    for (dword i = 0; i < k_default_textures_count; i++)
+    {
+        ID3D12Resource* placeholder_texture = (ID3D12Resource*)m_placeholder_textures[i].resource;
+        SAFE_RELEASE(placeholder_texture);
+    }
 
     for (dword i = 0; i < k_render_target_count; i++)
     {
@@ -847,9 +1382,16 @@ c_renderer_dx12::~c_renderer_dx12()
         delete m_shader_inputs[i];
     }
 
-    delete m_deferred_shader;
+    for (dword vertex_format = 0; vertex_format < k_mesh_vertex_format_count; vertex_format++)
+    {
+        for (dword permutation = 0; permutation < MATERIAL_PERMUTATION_COUNT; permutation++)
+        {
+            delete m_deferred_shaders[vertex_format][permutation];
+        }
+    }
     delete m_lighting_shader;
     delete m_texcam_shader;
+    delete m_texcam_compact_shader;
     for (dword i = 0; i < k_post_processing_passes; i++)
     {
         delete m_post_shaders[i];
@@ -891,6 +1433,12 @@ bool c_renderer_dx12::initialise(const HWND hWnd)
     // Fence - The GPU object we notify when to do work, and the object we wait for the work to be done    
     if (!this->initialise_fences()) { return K_FAILURE; }
 
+    // Shared staging for uploads made through the renderer
+    if (!this->initialise_upload_batch()) { return K_FAILURE; }
+
+    // Compiled shaders from earlier runs
+    if (!this->initialise_shader_cache()) { return K_FAILURE; }
+
     // Define which resources are bound to the graphics pipeline
     if (!this->initialise_input_layouts()) { return K_FAILURE; }
 
@@ -900,6 +1448,9 @@ bool c_renderer_dx12::initialise(const HWND hWnd)
     // Default geometry
     if (!this->initialise_default_geometry()) { return K_FAILURE; }
 
+    // Stand in resources for assets which are still streaming
+    if (!this->initialise_placeholder_resources()) { return K_FAILURE; }
+
     // Execute the command list to upload the initial assets
     if (!this->upload_assets()) { return K_FAILURE; }
 
@@ -922,7 +1473,7 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     HRESULT hr = S_OK;
 
     // We have to wait for the gpu to finish with the command allocator before we reset it
-    const bool wait_succeeded = this->wait_for_previous_frame();
+    const bool wait_succeeded = this->begin_frame();
     assert(wait_succeeded);
     if (!wait_succeeded) { return; }
 
@@ -943,6 +1494,7 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     // the second parameter to NULL
     hr = m_command_list->Reset(m_command_allocators[m_frame_index], NULL);
     if (!HRESULT_VALID(hr)) { return; }
+    m_bound_root_signature = nullptr;
     // here we start recording commands into the commandList (which all the commands will be stored in the commandAllocator)
 
     m_command_list->RSSetViewports(1, &m_viewport); // set the viewports
@@ -950,15 +1502,34 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     m_command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); // set the primitive topology
 
     // Deferred pass
-    c_render_target* deferred_target = m_render_targets[_render_target_deferred];
-    deferred_target->begin_render(m_command_list, m_frame_index);
+    // Objects are drawn with ps_deferred specialised for their material, sorted so each permutation is drawn together
+    struct s_deferred_draw
+    {
+        c_scene_object* object;
+        dword object_index; // the object's constant buffers are set at its index in the scene
+        dword material_index; // entry in the material table & the deferred target's texture set, shared by every object using the material
+        dword shader_index; // vertex format & material permutation
+    };
+    std::vector<s_deferred_draw> deferred_draws;
+    ID3D12Resource* const replaced_material_table = m_material_table->reserve(scene->m_materials.get_slot_count());
+    if (replaced_material_table != nullptr)
+    {
+        this->retire(replaced_material_table);
+    }
+    ID3D12DescriptorHeap* const replaced_deferred_texture_heap = m_render_targets[_render_target_deferred]->reserve_texture_sets(scene->m_materials.get_slot_count());
+    if (replaced_deferred_texture_heap != nullptr)
+    {
+        this->retire(replaced_deferred_texture_heap);
+    }
+    std::vector<c_shader*> new_deferred_shaders;
     dword object_index = 0;
     std::vector<c_scene_object*> texcam_objects;
     std::vector<dword> texcam_object_scene_indices;
     for (c_scene_object* const object : *scene->get_objects())
     {
-        // Assign textures from material
         const c_material* const material = object->get_material();
+        // Only uploaded when the material has changed since it was last drawn
+        m_material_table->update(object->get_material_index(), material, m_constant_ring);
 
         // Render textures will eventually be overdrawn, but on the first pass they will use their material
         if (material->m_properties.m_render_texture)
@@ -967,31 +1538,66 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
             texcam_object_scene_indices.push_back(object_index);
         }
 
+        // Flags can be changed at any time, so the permutation is picked every frame
+        const e_mesh_vertex_format vertex_format = object->get_model()->get_resources()->vertex_format;
+        const dword permutation = material->get_permutation();
+        c_shader*& deferred_shader = m_deferred_shaders[vertex_format][permutation];
+        if (deferred_shader == nullptr)
+        {
+            deferred_shader = this->new_deferred_shader(vertex_format, permutation);
+            new_deferred_shaders.push_back(deferred_shader);
+        }
+        deferred_draws.push_back({ object, object_index, object->get_material_index(), (vertex_format * MATERIAL_PERMUTATION_COUNT) + permutation });
+        object_index++;
+    }
+    m_material_table->record_uploads(m_command_list);
+    if (!new_deferred_shaders.empty())
+    {
+        // Only the first frame drawing a permutation waits on it, & later runs mostly load it from the shader cache
+        c_job_graph jobs;
+        this->create_shaders(new_deferred_shaders.data(), static_cast<dword>(new_deferred_shaders.size()), &jobs, nullptr, get_job_thread_count());
+        LOG_MESSAGE(L"created %d deferred shader permutations", static_cast<dword>(new_deferred_shaders.size()));
+        m_pipeline_cache->save();
+    }
+    std::stable_sort(deferred_draws.begin(), deferred_draws.end(), [](const s_deferred_draw& a, const s_deferred_draw& b) { return a.shader_index < b.shader_index; });
+
+    c_render_target* deferred_target = m_render_targets[_render_target_deferred];
+    deferred_target->begin_render(m_command_list, m_frame_index);
+    this->set_root_signature(deferred_target);
+    // The view is the same for every object, so it's only bound once for the pass
+    this->set_constant_buffer_view(deferred_target, _deferred_constant_buffer_view, 0);
+    for (const s_deferred_draw& deferred_draw : deferred_draws)
+    {
+        // Assign textures from material
+        const c_material* const material = deferred_draw.object->get_material();
         for (dword i = 0; i < material->get_maximum_textures(); i++)
         {
             c_render_texture* const texture = material->get_texture(i);
             e_texture_type texture_type = texture->get_type();
             const s_texture_resources* const texture_resources = texture->get_resources();
-            deferred_target->assign_texture((ID3D12Resource*)texture_resources->resource, texture_type, object_index);
+            deferred_target->assign_texture((ID3D12Resource*)texture_resources->resource, texture_type, deferred_draw.material_index);
         }
-        deferred_target->begin_draw(m_command_list, m_deferred_shader, object_index);
+        const s_geometry_resources* const geometry_resources = deferred_draw.object->get_model()->get_resources();
+        const c_shader* const deferred_shader = m_deferred_shaders[deferred_draw.shader_index / MATERIAL_PERMUTATION_COUNT][deferred_draw.shader_index % MATERIAL_PERMUTATION_COUNT];
+        deferred_target->begin_draw(m_command_list, deferred_shader, deferred_draw.material_index);
 
         // Per-object constant buffers (materials & transforms)
-        this->set_constant_buffer_view(deferred_target, _deferred_constant_buffer_object, object_index);
-        this->set_constant_buffer_view(deferred_target, _deferred_constant_buffer_materials, object_index);
+        this->set_constant_buffer_view(deferred_target, _deferred_constant_buffer_object, deferred_draw.object_index);
+        m_command_list->SetGraphicsRootConstantBufferView(_deferred_constant_buffer_materials, m_material_table->get_gpu_address(deferred_draw.material_index));
 
         // Set geometry buffers & draw
-        const s_geometry_resources* const geometry_resources = object->get_model()->get_resources();
         m_command_list->IASetVertexBuffers(0, 1, &geometry_resources->vertex_buffer_view); // set the vertex buffer (using the vertex buffer view)
         m_command_list->IASetIndexBuffer(&geometry_resources->index_buffer_view);
-        m_command_list->DrawIndexedInstanced(geometry_resources->index_count, 1, 0, 0, 0);
-
-        object_index++;
+        for (const s_draw_range& draw_range : *deferred_draw.object->get_draw_ranges())
+        {
+            m_command_list->DrawIndexedInstanced(draw_range.index_count, 1, draw_range.index_offset, 0, 0);
+        }
     }
 
     // Lighting pass
     c_render_target* lighting_target = m_render_targets[_render_target_lighting];
     lighting_target->begin_render(m_command_list, m_frame_index);
+    this->set_root_signature(lighting_target);
     e_gbuffers lighting_gbuffers[k_lighting_textures_count] = { _gbuffer_position, _gbuffer_normal, _gbuffer_ambient, _gbuffer_diffuse, _gbuffer_specular };
     for (dword i = 0; i < k_lighting_textures_count; i++)
     {
@@ -1008,6 +1614,7 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     // Shading pass
     c_render_target* shading_target = m_render_targets[_render_target_shading];
     shading_target->begin_render(m_command_list, m_frame_index);
+    this->set_root_signature(shading_target);
     e_light_buffers shading_light_buffers[k_light_buffer_count] = { _light_buffer_ambient, _light_buffer_diffuse, _light_buffer_specular };
     for (dword i = 0; i < _texture_shading_albedo; i++)
     {
@@ -1044,18 +1651,25 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     TransitionResource(m_command_list, texcam_target->get_depth_resource(m_frame_index), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_DEPTH_WRITE);
     m_command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); // TODO: SET TOPOLOGY IN SHADER INPUT
     texcam_target->begin_render(m_command_list, m_frame_index, false);
+    this->set_root_signature(texcam_target);
+    this->set_constant_buffer_view(texcam_target, _texcam_constant_buffer_view, 0);
     // Re-draw all tex camera objects with rendered scene as the only input texture
+    // Every tex camera object samples the same texture, so they all share one texture set
+    texcam_target->assign_texture(shading_target->get_frame_resource(0, m_frame_index), _texture_cam_render_target, 0);
     dword texcam_index = 0;
     for (const c_scene_object* const object : texcam_objects)
     {
         dword object_scene_index = texcam_object_scene_indices[texcam_index];
-        texcam_target->assign_texture(shading_target->get_frame_resource(0, m_frame_index), _texture_cam_render_target, texcam_index);
-        texcam_target->begin_draw(m_command_list, m_texcam_shader, texcam_index);
-        this->set_constant_buffer_view(texcam_target, _texcam_constant_buffer_object, object_scene_index);
         const s_geometry_resources* const geometry_resources = object->get_model()->get_resources();
+        const bool compact_vertices = geometry_resources->vertex_format == _mesh_vertex_format_compact;
+        texcam_target->begin_draw(m_command_list, compact_vertices ? m_texcam_compact_shader : m_texcam_shader, 0);
+        this->set_constant_buffer_view(texcam_target, _texcam_constant_buffer_object, object_scene_index);
         m_command_list->IASetVertexBuffers(0, 1, &geometry_resources->vertex_buffer_view); // set the vertex buffer (using the vertex buffer view)
         m_command_list->IASetIndexBuffer(&geometry_resources->index_buffer_view);
-        m_command_list->DrawIndexedInstanced(geometry_resources->index_count, 1, 0, 0, 0);
+        for (const s_draw_range& draw_range : *object->get_draw_ranges())
+        {
+            m_command_list->DrawIndexedInstanced(draw_range.index_count, 1, draw_range.index_offset, 0, 0);
+        }
         texcam_index++;
     }
     TransitionResource(m_command_list, shading_target->get_frame_resource(0, m_frame_index), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -1146,6 +1760,7 @@ void c_renderer_dx12::update_pipeline(c_scene* const scene, dword fps_counter)
     m_command_list->SetDescriptorHeaps(_countof(imgui_descriptor_heaps), imgui_descriptor_heaps);
     ImGui::Render();
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), m_command_list);
+    m_bound_root_signature = nullptr; // ImGui binds its own
 
     // prepare final frame to copy into swapchain
     TransitionResource(m_command_list, final_target->get_frame_resource(0, m_frame_index), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
@@ -1166,6 +1781,18 @@ void c_renderer_dx12::set_constant_buffer_view(const c_render_target* const targ
     m_command_list->SetGraphicsRootConstantBufferView(buffer_type, gpu_address);
 }
 
+void c_renderer_dx12::set_root_signature(const c_render_target* const target)
+{
+    // Targets sharing a shader input, like each post processing pass, share its root signature
+    ID3D12RootSignature* const root_signature = target->get_shader_input()->get_root_signature();
+    if (root_signature == m_bound_root_signature)
+    {
+        return;
+    }
+    m_command_list->SetGraphicsRootSignature(root_signature);
+    m_bound_root_signature = root_signature;
+}
+
 void c_renderer_dx12::post_processing(const e_post_processing_passes pass, ID3D12Resource* const texture_resources[], const dword buffer_flags)
 {
     const bool arguments_valid = IN_RANGE_INCLUSIVE(pass, 0, k_post_processing_passes) && texture_resources != nullptr;
@@ -1180,6 +1807,7 @@ void c_renderer_dx12::post_processing(const e_post_processing_passes pass, ID3D1
     c_render_target* post_target = m_render_targets[k_default_render_target_count + pass];
 
     post_target->begin_render(m_command_list, m_frame_index);
+    this->set_root_signature(post_target);
 
     for (dword i = 0; i < k_post_textures_count; i++)
     {
@@ -1222,13 +1850,34 @@ void c_renderer_dx12::render_frame(c_scene* const scene, dword fps_counter)
     // has finished because the fence value will be set to "fenceValue" from the GPU since the command
     // queue is being executed on the GPU
     hr = m_command_queue->Signal(m_fences[m_frame_index], m_fence_values[m_frame_index]);
+    m_frame_begun = false;
     if (!HRESULT_VALID(hr)) { return; }
+    m_frame_count++;
 
     // present the current backbuffer
     hr = m_swapchain->Present(0, 0);
     if (!HRESULT_VALID(hr)) { return; }
 }
 
+bool c_renderer_dx12::begin_frame()
+{
+    if (m_frame_begun)
+    {
+        return K_SUCCESS;
+    }
+
+    if (!this->wait_for_previous_frame())
+    {
+        return K_FAILURE;
+    }
+    this->release_retired_objects(false);
+    // The frame that last allocated these constants has finished, so they can be handed out again
+    m_constant_ring->begin_frame(m_frame_index);
+    m_material_table->reset_statistics();
+    m_frame_begun = true;
+    return K_SUCCESS;
+}
+
 bool c_renderer_dx12::wait_for_previous_frame()
 {
     HRESULT hr = S_OK;
@@ -1263,20 +1912,25 @@ bool c_renderer_dx12::wait_for_previous_frame()
 }
 
 // TODO: store constant buffer class in c_renderer so we don't have to use a bunch of duplicate methods like this
+void c_renderer_dx12::set_view_constant_buffer(const s_view_cb& cbuffer)
+{
+    if (!this->begin_frame()) { return; }
+    // Shared with the texcam pass like the object cb
+    m_shader_inputs[_input_deferred]->get_constant_buffer(_deferred_constant_buffer_view)->set_data(&cbuffer, m_frame_index, 0);
+}
 void c_renderer_dx12::set_object_constant_buffer(const s_object_cb& cbuffer, const dword object_index)
 {
     // This sets the object cb for the texcam pass too as they are shared
+    if (!this->begin_frame()) { return; }
     m_shader_inputs[_input_deferred]->get_constant_buffer(_deferred_constant_buffer_object)->set_data(&cbuffer, m_frame_index, object_index);
 }
-void c_renderer_dx12::set_material_constant_buffer(const s_material_properties_cb& cbuffer, const dword object_index)
-{
-    m_shader_inputs[_input_deferred]->get_constant_buffer(_deferred_constant_buffer_materials)->set_data(&cbuffer, m_frame_index, object_index);
-}
 void c_renderer_dx12::set_lights_constant_buffer(const s_light_properties_cb& cbuffer)
 {
+    if (!this->begin_frame()) { return; }
     m_shader_inputs[_input_lighting]->get_constant_buffer(_lighting_constant_buffer_lights)->set_data(&cbuffer, m_frame_index, 0);
 }
 void c_renderer_dx12::set_post_constant_buffer(const s_post_parameters_cb& cbuffer)
 {
+    if (!this->begin_frame()) { return; }
     m_shader_inputs[_input_post_processing]->get_constant_buffer(_post_constant_buffer)->set_data(&cbuffer, m_frame_index, 0);
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <render/api/directx12/descriptor_heap.h>
 #include <render/api/directx12/shader_input.h>
 #include <render/model.h>
+#include <render/material.h>
+#include <vector>
 
 // TODO: root_parameters.h
 // TODO: post_processing.h
@@ -29,6 +31,15 @@ enum e_root_parameters_post_processing
 };
 
 class c_shader;
+class c_mesh_file;
+class c_upload_batch;
+class c_upload_ring;
+class c_material_table;
+class c_shader_cache;
+class c_pipeline_cache;
+class c_root_signature_cache;
+class c_job_graph;
+struct s_shader_define;
 class c_renderer_dx12 : public c_renderer
 {	
 public:
@@ -36,8 +47,8 @@ public:
 
 	bool initialise(const HWND hWnd) override;
 	void render_frame(c_scene* const scene, dword fps_counter) override;
+	void set_view_constant_buffer(const s_view_cb& cbuffer) override;
 	void set_object_constant_buffer(const s_object_cb& cbuffer, const dword object_index) override;
-	void set_material_constant_buffer(const s_material_properties_cb& cbuffer, const dword object_index) override;
 	void set_lights_constant_buffer(const s_light_properties_cb& cbuffer) override;
 	void set_post_constant_buffer(const s_post_parameters_cb& cbuffer) override;
 
@@ -49,12 +60,35 @@ public:
 	bool create_geometry(vertex vertices[], dword vertices_size, dword indices[], dword indices_size, s_geometry_resources* const out_resources) override;
 	// create a mesh from a simple mesh & index buffer
 	bool create_simple_geometry(simple_vertex vertices[], dword vertices_size, s_geometry_resources* const out_resources);
-	// Load a geometry data from a .VBO file
+	// Load a texture from .DDS data already in memory, e.g. a mapped asset archive
+	// Mips wider or taller than maximum_size are left out, 0 loads every mip
+	// If upload_batch isn't nullptr the upload is only recorded, and the texture can't be used until the batch is flushed
+	bool load_texture_from_memory(const e_texture_type texture_type, const ubyte* const data, const qword data_size, const dword maximum_size, const wchar_t* const debug_name, s_texture_resources* const out_resources, c_upload_batch* const upload_batch) override;
+	// Release a texture once every frame in flight which may still sample it has finished
+	void retire_texture(const s_texture_resources* const resources) override;
+	// Release vertex & index buffers once every frame in flight which may still draw them has finished, meshlets stay with the caller
+	void retire_geometry(const s_geometry_resources* const resources) override;
+	// Release a pipeline state once every frame in flight which may still use it has finished, the shader blobs are released straight away
+	void retire_shader(const s_shader_resources* const resources) override;
+	// Load geometry data from a cooked .MESH file, or a legacy .VBO file
 	bool load_model(const wchar_t* const file_path, s_geometry_resources* const out_resources) override;
+	// Load geometry data from .MESH or .VBO data already in memory, e.g. a mapped asset archive
+	// If upload_batch isn't nullptr the upload is only recorded, and the geometry can't be used until the batch is flushed
+	bool load_model_from_memory(const ubyte* const data, const qword data_size, const wchar_t* const debug_name, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch) override;
+	// Create a batch with its own staging memory for recording uploads from another thread, caller deletes it
+	c_upload_batch* create_upload_batch() override;
 	// Load a vertex & pixel shader from a .hlsl file
-	bool create_shader(const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type, s_shader_resources* out_resources) override;
+	// When reloading, compile errors are only warnings so a broken edit doesn't stop the engine
+	bool create_shader(const s_shader_description* const description, const bool reloading, s_shader_resources* const out_resources) override;
+	// Compile every shader using file_path again, or every shader if none use it directly as it may be included by them
+	// Returns the number of shaders swapped, those which fail to compile keep what they had
+	dword reload_shaders(const wchar_t* const file_path) override;
 	// Get the ImGUI gbuffer texture ID
 	qword get_gbuffer_textureid(e_gbuffers gbuffer_type) const override;
+	// Box drawn in place of meshes which haven't streamed in yet
+	const s_geometry_resources* const get_placeholder_geometry() const override { return &m_placeholder_geometry; };
+	// 1x1 texture bound in place of textures which haven't streamed in yet, neutral for its texture type
+	const s_texture_resources* const get_placeholder_texture(const e_texture_type texture_type) const override;
 
 private:
 	// Initialisation methods used by initialise()
@@ -66,21 +100,55 @@ private:
 	bool initialise_command_allocators();
 	bool initialise_command_list();
 	bool initialise_fences();
+	bool initialise_upload_batch();
+	bool initialise_shader_cache();
 	bool initialise_input_layouts();
 	bool initialise_default_geometry();
+	bool initialise_placeholder_resources();
 	bool initialise_imgui(const HWND hWnd);
 
+	// Create every shader's resources, compiling each distinct vertex & pixel shader once as a job in jobs
+	// Each pipeline state is created by a job waiting on its compiles & the input_jobs entry creating its shader input, then jobs is run on thread_count threads
+	// input_jobs is indexed by e_shader_input, or nullptr once every shader input exists
+	void create_shaders(c_shader* const shaders[], const dword shader_count, c_job_graph* const jobs, const dword* const input_jobs, const dword thread_count);
+	// Describe the deferred shader for a vertex format & material permutation, its resources are left for create_shaders
+	c_shader* new_deferred_shader(const e_mesh_vertex_format vertex_format, const dword permutation) const;
+	// Every shader created so far, for reloading
+	std::vector<c_shader*> get_shaders() const;
+	// Compile a shader through the shader cache, errors are only warnings when reloading
+	bool compile_shader(const wchar_t* const path, const s_shader_define* const defines, const dword define_count, const char* const name, const char* const profile, const bool reloading, ID3DBlob** const out_bytecode);
+	// Create the pipeline state for compiled shaders, out_resources takes its own references to them
+	bool create_pipeline_state(const s_shader_description* const description, ID3DBlob* const vertex_shader, ID3DBlob* const pixel_shader, const bool reloading, s_shader_resources* const out_resources);
+
 	// Upload pending assets on the command queue after initialisation
 	bool upload_assets();
 
-	// Upload vertex data to buffer stored in out_resources
-	bool upload_vertex_buffer(const dword vertex_size, const void* const vertices, const dword vertices_size, s_geometry_resources* const out_resources);
+	// Create a vertex buffer in out_resources & record its upload into upload_batch
+	bool upload_vertex_buffer(const dword vertex_size, const void* const vertices, const dword vertices_size, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch);
 	
-	// Upload index data to buffer stored in out_resources
-	bool upload_index_buffer(const dword indices[], const dword indices_size, s_geometry_resources* const out_resources);
+	// Create an index buffer in out_resources & record its upload into upload_batch, index_format must be R16_UINT or R32_UINT
+	bool upload_index_buffer(const void* const indices, const dword indices_size, const DXGI_FORMAT index_format, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch);
 	
-	// Upload vertex & index data to buffers in out_resources
-	bool upload_geometry(const dword vertex_size, const void* const vertices, const dword vertices_size, const dword indices[], const dword indices_size, s_geometry_resources* const out_resources);
+	// Create vertex & index buffers in out_resources & record their uploads into upload_batch
+	bool upload_geometry(const dword vertex_size, const void* const vertices, const dword vertices_size, const void* const indices, const dword indices_size, const DXGI_FORMAT index_format, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch);
+
+	// Record uploads for the contents of an opened mesh file, generating tangents if it isn't cooked
+	bool create_geometry_from_mesh_file(const c_mesh_file& mesh_file, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch);
+
+	// Fill in the size of texture_resource, full_width & full_height are the texture's size with every mip loaded
+	void set_texture_info(ID3D12Resource* const texture_resource, const dword full_width, const dword full_height, s_texture_resources* const out_resources);
+
+	// Wait for the GPU to finish with the current frame index & start reusing its memory, once per frame before anything is written for it
+	// Scenes set their constants before the frame is rendered, so whichever comes first begins the frame
+	bool begin_frame();
+
+	// Queue object for release once the frames in flight have finished with it
+	void retire(ID3D12Pageable* const object);
+	// Release retired objects no frame still in flight can be using
+	void release_retired_objects(const bool release_all);
+
+	// Fill in vertex tangents & bitangents from positions, normals and texcoords
+	bool compute_tangent_frame(vertex vertices[], const dword vertex_count, const void* const indices, const dword index_count, const DXGI_FORMAT index_format);
 
 	// Update pipeline prior to render
 	void update_pipeline(c_scene* const scene, dword fps_counter);
@@ -91,6 +159,9 @@ private:
 	// Set constant buffer view to use for render
 	void set_constant_buffer_view(const c_render_target* const target, const e_constant_buffers buffer_type, const dword buffer_index);
 
+	// Bind the root signature of target's shader input, unless it's already bound
+	void set_root_signature(const c_render_target* const target);
+
 	bool m_initialised;
 #ifdef _DEBUG
 	ID3D12Debug* m_dx12_debug;
@@ -109,11 +180,18 @@ private:
 
 	s_geometry_resources m_screen_quad; // Screen quad used to draw rendered scene texture to
 
+	// Shared by every mesh & texture still streaming, never released by them
+	s_geometry_resources m_placeholder_geometry;
+	s_texture_resources m_placeholder_textures[k_default_textures_count];
+
 	// TODO: TEMPORARY, MOVE THIS!!
-	c_shader* m_deferred_shader;
+	// ps_deferred specialised for each vertex format & material permutation, created the first time something is drawn with one
+	c_shader* m_deferred_shaders[k_mesh_vertex_format_count][MATERIAL_PERMUTATION_COUNT];
 	c_shader* m_lighting_shader;
 	c_shader* m_shading_shader;
 	c_shader* m_texcam_shader;
+	// Same pass for meshes cooked with compact vertices
+	c_shader* m_texcam_compact_shader;
 	c_shader* m_post_shaders[k_post_processing_passes];
 
 	ID3D12CommandAllocator* m_command_allocators[FRAME_BUFFER_COUNT]; // Allocations of storage for GPU commands (we want enough allocators for each buffer * number of threads (we only have one thread))
@@ -128,6 +206,19 @@ private:
 	c_descriptor_heap* m_imgui_descriptor_heap;
 	D3D12_GPU_DESCRIPTOR_HANDLE m_gbuffer_gpu_handles[k_gbuffer_count + k_light_buffer_count + 1]; // + depth
 
+	c_upload_batch* m_upload_batch; // Used by every upload not given a batch by the caller, flushed before returning
+	c_upload_ring* m_constant_ring; // Constant buffer data for each frame in flight
+	c_material_table* m_material_table; // Every material's properties, indexed by material index
+	bool m_frame_begun; // begin_frame has run since the last frame was submitted
+	c_shader_cache* m_shader_cache; // Compiled shader bytecode, kept between runs
+	c_pipeline_cache* m_pipeline_cache; // Pipeline states shared within a run & kept between runs
+	c_root_signature_cache* m_root_signature_cache; // Root signatures shared by shader inputs with the same layout
+	ID3D12RootSignature* m_bound_root_signature; // Set by set_root_signature since the command list was reset
+
+	// Resources & pipeline states replaced by streaming or reloading, with the frame count when they were retired
+	std::vector<std::pair<ID3D12Pageable*, qword>> m_retired_objects;
+	qword m_frame_count; // frames submitted
+
 	// Synchronisation objects
 	dword m_frame_index; // Current frame index on the swapchain
 	HANDLE m_fence_event; // Frame synchronisation event handle
@@ -0,0 +1,87 @@
+#include "root_signature_cache.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <render/api/directx12/shader_cache.h>
+#include <asset/cook_manifest_format.h>
+#include <cassert>
+
+c_root_signature_cache::c_root_signature_cache(ID3D12Device* const device, c_shader_cache* const shader_cache)
+    : m_device(device)
+    , m_shader_cache(shader_cache)
+    , m_mutex()
+    , m_root_signatures()
+    , m_statistics()
+{
+    assert(device != nullptr && shader_cache != nullptr);
+}
+
+c_root_signature_cache::~c_root_signature_cache()
+{
+    for (auto& root_signature : m_root_signatures)
+    {
+        SAFE_RELEASE(root_signature.second);
+    }
+}
+
+ID3D12RootSignature* c_root_signature_cache::create(const D3D12_ROOT_SIGNATURE_DESC* const desc, qword* const out_hash)
+{
+    const bool arguments_valid = desc != nullptr && out_hash != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return nullptr;
+    }
+
+    ID3DBlob* signature = nullptr;
+    ID3DBlob* error = nullptr; // a buffer holding the error data if any
+    HRESULT hr = m_shader_cache->serialize_root_signature(desc, &signature, &error);
+    if (hr != S_OK)
+    {
+        if (error != nullptr)
+        {
+            LOG_ERROR(L"%hs", (char*)error->GetBufferPointer());
+        }
+        SAFE_RELEASE(error);
+        HRESULT_VALID(hr);
+        return nullptr;
+    }
+    const qword signature_hash = hash_cooked_content(signature->GetBufferPointer(), signature->GetBufferSize());
+    *out_hash = signature_hash;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto cached_root_signature = m_root_signatures.find(signature_hash);
+        if (cached_root_signature != m_root_signatures.end())
+        {
+            SAFE_RELEASE(signature);
+            m_statistics.shared_count++;
+            cached_root_signature->second->AddRef();
+            return cached_root_signature->second;
+        }
+    }
+
+    ID3D12RootSignature* root_signature = nullptr;
+    hr = m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&root_signature));
+    SAFE_RELEASE(signature);
+    if (!HRESULT_VALID(hr))
+    {
+        return nullptr;
+    }
+
+    // Another thread may have created the same layout meanwhile, the first one kept wins
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto kept_root_signature = m_root_signatures.emplace(signature_hash, root_signature);
+    if (kept_root_signature.second)
+    {
+        m_statistics.created_count++;
+    }
+    else
+    {
+        SAFE_RELEASE(root_signature);
+        root_signature = kept_root_signature.first->second;
+        m_statistics.shared_count++;
+    }
+    root_signature->AddRef();
+    return root_signature;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <types.h>
+#include <d3d12.h>
+#include <unordered_map>
+#include <mutex>
+
+struct s_root_signature_cache_statistics
+{
+	dword created_count;
+	dword shared_count; // the same layout as a shader input created earlier
+};
+
+class c_shader_cache;
+
+// Root signatures shared by every shader input with the same layout
+// Serialized through the shader cache so blobs are kept between runs, then created once per distinct blob
+// Safe to create from several threads at once
+class c_root_signature_cache
+{
+public:
+	c_root_signature_cache(ID3D12Device* const device, c_shader_cache* const shader_cache);
+	~c_root_signature_cache();
+
+	// Returns a reference for the caller to release, or nullptr on failure
+	// out_hash is the serialized signature's hash, which identifies it between runs
+	ID3D12RootSignature* create(const D3D12_ROOT_SIGNATURE_DESC* const desc, qword* const out_hash);
+
+	// Only meaningful while nothing is being created
+	inline const s_root_signature_cache_statistics* const get_statistics() const { return &m_statistics; };
+
+private:
+	ID3D12Device* const m_device; // local reference, DO NOT clean this up!
+	c_shader_cache* const m_shader_cache; // local reference, DO NOT clean this up!
+
+	std::mutex m_mutex; // guards m_root_signatures & m_statistics
+	std::unordered_map<qword, ID3D12RootSignature*> m_root_signatures; // by hash of the serialized blob, holds a reference to each
+	s_root_signature_cache_statistics m_statistics;
+};
@@ -0,0 +1,390 @@
+#include "shader_cache.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <asset/mapped_file.h>
+#include <asset/cook_manifest_format.h>
+#include <D3Dcompiler.h>
+#include <fstream>
+#include <chrono>
+#include <cwchar>
+#include <cassert>
+
+// 'SHDC' read as a little endian dword
+constexpr dword SHADER_CACHE_SIGNATURE = 0x43444853;
+// Bump whenever the key or file layout changes, so older cache files stop matching
+constexpr dword SHADER_CACHE_VERSION = 2;
+
+struct s_shader_cache_header
+{
+    dword signature; // SHADER_CACHE_SIGNATURE
+    dword version; // SHADER_CACHE_VERSION
+    qword key; // the file is named after this too, checked in case it was renamed
+    qword bytecode_size; // bytecode follows the header
+    qword bytecode_hash; // hash_cooked_content of the bytecode, catches damaged files
+};
+static_assert(sizeof(s_shader_cache_header) == 0x20);
+
+static qword hash_string(const char* const string, const qword hash)
+{
+    // Including the terminator keeps "ab" + "c" apart from "a" + "bc"
+    return hash_cooked_content(string, strlen(string) + 1, hash);
+}
+
+template <typename t_value>
+static qword hash_value(const t_value& value, const qword hash)
+{
+    return hash_cooked_content(&value, sizeof(value), hash);
+}
+
+// Key for a root signature, hashed field by field so equivalent layouts match
+// Appended descriptor ranges are hashed at the offsets they resolve to, the same as a range placed there explicitly
+static qword hash_root_signature(const D3D12_ROOT_SIGNATURE_DESC* const desc)
+{
+    constexpr char root_signature_salt[] = "root signature"; // keeps root signatures & shaders from ever sharing a key
+    qword hash = hash_string(root_signature_salt, COOK_HASH_SEED);
+    hash = hash_value(SHADER_CACHE_VERSION, hash);
+    hash = hash_value(D3D_ROOT_SIGNATURE_VERSION_1, hash);
+    hash = hash_value(desc->Flags, hash);
+
+    hash = hash_value(desc->NumParameters, hash);
+    for (dword parameter_index = 0; parameter_index < desc->NumParameters; parameter_index++)
+    {
+        const D3D12_ROOT_PARAMETER& parameter = desc->pParameters[parameter_index];
+        hash = hash_value(parameter.ParameterType, hash);
+        hash = hash_value(parameter.ShaderVisibility, hash);
+        switch (parameter.ParameterType)
+        {
+            case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            {
+                hash = hash_value(parameter.DescriptorTable.NumDescriptorRanges, hash);
+                dword offset = 0;
+                for (dword range_index = 0; range_index < parameter.DescriptorTable.NumDescriptorRanges; range_index++)
+                {
+                    const D3D12_DESCRIPTOR_RANGE& range = parameter.DescriptorTable.pDescriptorRanges[range_index];
+                    offset = range.OffsetInDescriptorsFromTableStart != D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND ? range.OffsetInDescriptorsFromTableStart : offset;
+                    hash = hash_value(range.RangeType, hash);
+                    hash = hash_value(range.NumDescriptors, hash);
+                    hash = hash_value(range.BaseShaderRegister, hash);
+                    hash = hash_value(range.RegisterSpace, hash);
+                    hash = hash_value(offset, hash);
+                    offset += range.NumDescriptors;
+                }
+                break;
+            }
+            case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            {
+                hash = hash_value(parameter.Constants, hash);
+                break;
+            }
+            default:
+            {
+                hash = hash_value(parameter.Descriptor, hash);
+                break;
+            }
+        }
+    }
+
+    // Every member of a static sampler is 4 bytes, so it has no padding to hash
+    hash = hash_value(desc->NumStaticSamplers, hash);
+    for (dword sampler_index = 0; sampler_index < desc->NumStaticSamplers; sampler_index++)
+    {
+        hash = hash_value(desc->pStaticSamplers[sampler_index], hash);
+    }
+    return hash;
+}
+
+// Name of the file the #include directive at text includes, or false if text isn't an #include
+static bool parse_include(const char* text, const char* const end, std::string* const out_name)
+{
+    while (text < end && (*text == ' ' || *text == '\t'))
+    {
+        text++;
+    }
+    if (text == end || *text++ != '#')
+    {
+        return false;
+    }
+    while (text < end && (*text == ' ' || *text == '\t'))
+    {
+        text++;
+    }
+    constexpr char include_directive[] = "include";
+    constexpr qword include_directive_length = sizeof(include_directive) - 1;
+    if (static_cast<qword>(end - text) < include_directive_length || strncmp(text, include_directive, include_directive_length) != 0)
+    {
+        return false;
+    }
+    text += include_directive_length;
+    while (text < end && (*text == ' ' || *text == '\t'))
+    {
+        text++;
+    }
+    if (text == end || (*text != '"' && *text != '<'))
+    {
+        return false;
+    }
+
+    const char terminator = *text++ == '"' ? '"' : '>';
+    const char* const name_start = text;
+    while (text < end && *text != terminator && *text != '\n')
+    {
+        text++;
+    }
+    if (text == end || *text != terminator)
+    {
+        return false;
+    }
+    out_name->assign(name_start, text);
+    return true;
+}
+
+c_shader_cache::c_shader_cache(const wchar_t* const directory_path)
+    : m_directory_path()
+    , m_mutex()
+    , m_bytecode()
+    , m_statistics()
+{
+    assert(directory_path != nullptr);
+    wcscpy_s(m_directory_path, MAXIMUM_PATH, directory_path);
+    if (!CreateDirectoryW(m_directory_path, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        // Shaders still compile, they just aren't kept for the next run
+        LOG_WARNING(L"failed to create shader cache directory %s! (error %d)", m_directory_path, GetLastError());
+    }
+}
+
+c_shader_cache::~c_shader_cache()
+{
+    for (auto& bytecode : m_bytecode)
+    {
+        SAFE_RELEASE(bytecode.second);
+    }
+}
+
+HRESULT c_shader_cache::compile(const wchar_t* const file_path, const D3D_SHADER_MACRO* const defines, const char* const entry_point, const char* const profile, const dword flags, ID3DBlob** const out_bytecode, ID3DBlob** const out_errors)
+{
+    const bool arguments_valid = file_path != nullptr && entry_point != nullptr && profile != nullptr && out_bytecode != nullptr && out_errors != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return E_INVALIDARG;
+    }
+    *out_bytecode = nullptr;
+    *out_errors = nullptr;
+
+    qword key = COOK_HASH_SEED;
+    key = hash_string(entry_point, key);
+    key = hash_string(profile, key);
+    for (const D3D_SHADER_MACRO* define = defines; define != nullptr && define->Name != nullptr; define++)
+    {
+        key = hash_string(define->Name, key);
+        key = hash_string(define->Definition != nullptr ? define->Definition : "", key);
+    }
+    const dword key_values[] = { flags, D3D_COMPILER_VERSION, SHADER_CACHE_VERSION };
+    key = hash_cooked_content(key_values, sizeof(key_values), key);
+    std::vector<std::wstring> visited_files;
+    this->hash_source(file_path, &key, &visited_files);
+
+    return this->get_blob(key, [&](ID3DBlob** const out_blob)
+    {
+        return D3DCompileFromFile(file_path, defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, entry_point, profile, flags, 0, out_blob, out_errors);
+    }, out_bytecode);
+}
+
+HRESULT c_shader_cache::serialize_root_signature(const D3D12_ROOT_SIGNATURE_DESC* const desc, ID3DBlob** const out_blob, ID3DBlob** const out_errors)
+{
+    const bool arguments_valid = desc != nullptr && out_blob != nullptr && out_errors != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return E_INVALIDARG;
+    }
+    *out_blob = nullptr;
+    *out_errors = nullptr;
+
+    const qword key = hash_root_signature(desc);
+    return this->get_blob(key, [desc, out_errors](ID3DBlob** const out_serialized)
+    {
+        return D3D12SerializeRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1, out_serialized, out_errors);
+    }, out_blob);
+}
+
+HRESULT c_shader_cache::get_blob(const qword key, const std::function<HRESULT(ID3DBlob** const)>& create_blob, ID3DBlob** const out_blob)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto cached_blob = m_bytecode.find(key);
+        if (cached_blob != m_bytecode.end())
+        {
+            m_statistics.memory_hit_count++;
+            cached_blob->second->AddRef();
+            *out_blob = cached_blob->second;
+            return S_OK;
+        }
+    }
+
+    // Two threads missing on the same key both create it, each stores through its own temporary file so neither disturbs the other's write
+    ID3DBlob* blob = this->load(key);
+    const bool loaded = blob != nullptr;
+    double compile_milliseconds = 0.0;
+    if (!loaded)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        const HRESULT hr = create_blob(&blob);
+        compile_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        if (hr != S_OK)
+        {
+            // Failures aren't cached, the errors are only useful to whoever is fixing the shader now
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_statistics.compile_milliseconds += compile_milliseconds;
+            return hr;
+        }
+        this->store(key, blob);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (loaded)
+    {
+        m_statistics.disk_hit_count++;
+    }
+    else
+    {
+        m_statistics.compiled_count++;
+        m_statistics.compile_milliseconds += compile_milliseconds;
+    }
+    const auto kept_blob = m_bytecode.emplace(key, blob);
+    if (!kept_blob.second)
+    {
+        SAFE_RELEASE(blob);
+        blob = kept_blob.first->second;
+    }
+    blob->AddRef();
+    *out_blob = blob;
+    return S_OK;
+}
+
+void c_shader_cache::hash_source(const wchar_t* const file_path, qword* const hash, std::vector<std::wstring>* const visited_files) const
+{
+    for (const std::wstring& visited_file : *visited_files)
+    {
+        if (_wcsicmp(visited_file.c_str(), file_path) == 0)
+        {
+            return;
+        }
+    }
+    visited_files->push_back(file_path);
+
+    // A missing include still changes the key by name, the compile it causes reports the error
+    c_mapped_file source_file;
+    if (GetFileAttributesW(file_path) == INVALID_FILE_ATTRIBUTES || !source_file.open(file_path))
+    {
+        return;
+    }
+    const char* const source = reinterpret_cast<const char*>(source_file.get_data());
+    const char* const source_end = source + source_file.get_size();
+    *hash = hash_cooked_content(source, source_file.get_size(), *hash);
+
+    // The standard include handler looks next to the including file
+    std::wstring directory = file_path;
+    const size_t directory_end = directory.find_last_of(L"\\/");
+    directory = directory_end != std::wstring::npos ? directory.substr(0, directory_end + 1) : L"";
+
+    // Every #include is followed, even those inside a branch the compile won't take, which can only cause extra misses
+    for (const char* line = source; line < source_end;)
+    {
+        const char* line_end = static_cast<const char*>(memchr(line, '\n', source_end - line));
+        line_end = line_end != nullptr ? line_end : source_end;
+
+        std::string include_name;
+        if (parse_include(line, line_end, &include_name))
+        {
+            wchar_t include_path[MAXIMUM_PATH] = {};
+            swprintf_s(include_path, MAXIMUM_PATH, L"%s%hs", directory.c_str(), include_name.c_str());
+            *hash = hash_string(include_name.c_str(), *hash);
+            this->hash_source(include_path, hash, visited_files);
+        }
+        line = line_end + 1;
+    }
+}
+
+void c_shader_cache::get_cache_path(const qword key, wchar_t (&out_path)[MAXIMUM_PATH]) const
+{
+    swprintf_s(out_path, MAXIMUM_PATH, L"%s\\%016llx.cso", m_directory_path, key);
+}
+
+ID3DBlob* c_shader_cache::load(const qword key) const
+{
+    wchar_t cache_path[MAXIMUM_PATH] = {};
+    this->get_cache_path(key, cache_path);
+    if (GetFileAttributesW(cache_path) == INVALID_FILE_ATTRIBUTES)
+    {
+        return nullptr;
+    }
+
+    c_mapped_file cache_file;
+    if (!cache_file.open(cache_path))
+    {
+        return nullptr;
+    }
+    const s_shader_cache_header* const header = reinterpret_cast<const s_shader_cache_header*>(cache_file.get_data());
+    const ubyte* const bytecode_data = cache_file.get_data() + sizeof(s_shader_cache_header);
+    const bool header_valid = cache_file.get_size() >= sizeof(s_shader_cache_header)
+        && header->signature == SHADER_CACHE_SIGNATURE
+        && header->version == SHADER_CACHE_VERSION
+        && header->key == key
+        && header->bytecode_size == cache_file.get_size() - sizeof(s_shader_cache_header);
+    if (!header_valid || hash_cooked_content(bytecode_data, header->bytecode_size) != header->bytecode_hash)
+    {
+        // Compiled again & overwritten
+        LOG_WARNING(L"shader cache file %s is damaged! ignoring it", cache_path);
+        return nullptr;
+    }
+
+    ID3DBlob* bytecode = nullptr;
+    if (!HRESULT_VALID(D3DCreateBlob(header->bytecode_size, &bytecode)))
+    {
+        return nullptr;
+    }
+    memcpy(bytecode->GetBufferPointer(), bytecode_data, header->bytecode_size);
+    return bytecode;
+}
+
+void c_shader_cache::store(const qword key, ID3DBlob* const bytecode) const
+{
+    wchar_t cache_path[MAXIMUM_PATH] = {};
+    wchar_t temporary_path[MAXIMUM_PATH] = {};
+    this->get_cache_path(key, cache_path);
+    // Unique to this process & thread, so writers storing the same key at once never share a temporary file
+    swprintf_s(temporary_path, MAXIMUM_PATH, L"%s.%lu.%lu.tmp", cache_path, GetCurrentProcessId(), GetCurrentThreadId());
+
+    s_shader_cache_header header = {};
+    header.signature = SHADER_CACHE_SIGNATURE;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.bytecode_size = bytecode->GetBufferSize();
+    header.bytecode_hash = hash_cooked_content(bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+
+    // Written aside & moved into place, so a run that crashes part way never leaves a file that looks complete
+    {
+        std::ofstream cache_file(temporary_path, std::ios::binary | std::ios::trunc);
+        cache_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        cache_file.write(static_cast<const char*>(bytecode->GetBufferPointer()), bytecode->GetBufferSize());
+        if (!cache_file.good())
+        {
+            LOG_WARNING(L"failed to write shader cache file %s!", temporary_path);
+            return;
+        }
+    }
+    if (!MoveFileExW(temporary_path, cache_path, MOVEFILE_REPLACE_EXISTING))
+    {
+        // Another writer's file for the same key can be open while it's loaded, that copy has the same bytecode so nothing is lost
+        const DWORD error = GetLastError();
+        if (GetFileAttributesW(cache_path) == INVALID_FILE_ATTRIBUTES)
+        {
+            LOG_WARNING(L"failed to move %s into the shader cache! (error %d)", temporary_path, error);
+        }
+        DeleteFileW(temporary_path);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <types.h>
+#include <d3d12.h>
+#include <d3dcommon.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <functional>
+
+// Compiled bytecode is kept here between runs, relative to the working directory
+constexpr wchar_t SHADER_CACHE_DIRECTORY[] = L"shader_cache";
+
+struct s_shader_cache_statistics
+{
+	dword compiled_count;
+	dword disk_hit_count; // loaded from an earlier run
+	dword memory_hit_count; // compiled or loaded earlier this run, e.g. a vertex shader shared by several passes
+	double compile_milliseconds;
+};
+
+// Compiles shaders & serializes root signatures through an in memory & on disk cache of their blobs
+// Keyed by a hash of the source & every file it includes, the defines, entry point, profile, compile flags & compiler version, so any change to them compiles again
+// Safe to compile from several threads at once, compiles & file access happen outside the lock
+class c_shader_cache
+{
+public:
+	c_shader_cache(const wchar_t* const directory_path);
+	~c_shader_cache();
+
+	// Same as D3DCompileFromFile with the standard include handler, out_errors is only set when compilation fails
+	// defines is terminated by an entry with a nullptr name, or nullptr for none
+	HRESULT compile(const wchar_t* const file_path, const D3D_SHADER_MACRO* const defines, const char* const entry_point, const char* const profile, const dword flags, ID3DBlob** const out_bytecode, ID3DBlob** const out_errors);
+	// Same as D3D12SerializeRootSignature with version 1, keyed by the layout desc describes so equivalent layouts share a blob
+	HRESULT serialize_root_signature(const D3D12_ROOT_SIGNATURE_DESC* const desc, ID3DBlob** const out_blob, ID3DBlob** const out_errors);
+
+	// Only meaningful while nothing is compiling
+	inline const s_shader_cache_statistics* const get_statistics() const { return &m_statistics; };
+
+private:
+	// Find key's blob in memory or on disk, otherwise make it with create_blob & keep it
+	HRESULT get_blob(const qword key, const std::function<HRESULT(ID3DBlob** const)>& create_blob, ID3DBlob** const out_blob);
+	// Fold the file & everything it includes into hash, files already in visited_files are skipped so include cycles end
+	void hash_source(const wchar_t* const file_path, qword* const hash, std::vector<std::wstring>* const visited_files) const;
+	void get_cache_path(const qword key, wchar_t (&out_path)[MAXIMUM_PATH]) const;
+	// Returns nullptr on a miss or when the cached file is damaged
+	ID3DBlob* load(const qword key) const;
+	void store(const qword key, ID3DBlob* const bytecode) const;
+
+	wchar_t m_directory_path[MAXIMUM_PATH];
+	std::mutex m_mutex; // guards m_bytecode & m_statistics
+	std::unordered_map<qword, ID3DBlob*> m_bytecode; // holds a reference to everything compiled, serialized or loaded this run
+	s_shader_cache_statistics m_statistics;
+};
@@ -3,9 +3,32 @@
 #include <reporting/report.h>
 #include <render/api/directx12/helpers.h>
 #include <render/api/directx12/constant_buffer.h>
+#include <render/api/directx12/root_signature_cache.h>
 
-c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_count,
-    c_constant_buffer* const constant_buffers[], const dword constant_buffer_count,
+// Every shader input samples with the same static sampler
+// These are CD3DX12_STATIC_SAMPLER_DESC's defaults, which is what shader inputs have always been created with
+static const CD3DX12_STATIC_SAMPLER_DESC STATIC_SAMPLERS[1] =
+{
+    CD3DX12_STATIC_SAMPLER_DESC
+    (
+        0, // register
+        D3D12_FILTER_ANISOTROPIC,
+        D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        D3D12_TEXTURE_ADDRESS_MODE_WRAP,
+        0.0f, // mip LOD bias
+        16, // max anisotropy
+        D3D12_COMPARISON_FUNC_LESS_EQUAL,
+        D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE,
+        0.0f, // min LOD
+        D3D12_FLOAT32_MAX, // max LOD
+        D3D12_SHADER_VISIBILITY_ALL,
+        0 // register space
+    )
+};
+
+c_shader_input::c_shader_input(c_root_signature_cache* const root_signature_cache, const dword textures_count,
+    c_constant_buffer* const constant_buffers[], const dword constant_buffer_count, const bool owns_constant_buffers,
     const D3D12_INPUT_ELEMENT_DESC input_desc[], const dword input_element_count,
     const D3D12_DESCRIPTOR_RANGE texture_ranges[], const dword texture_range_count,
     const DXGI_FORMAT render_target_formats[], const dword render_target_count,
@@ -18,12 +41,14 @@ c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_
     , m_render_target_formats(new DXGI_FORMAT[m_render_target_count])
     , m_uses_depth_buffer(use_depth_buffer)
     , m_depth_comparison_func(use_depth_buffer ? depth_comparison_func : D3D12_COMPARISON_FUNC_NONE)
+    , m_root_signature_hash(0)
+    , m_owns_constant_buffers(owns_constant_buffers)
 {
     const bool valid_constant_buffers = constant_buffer_count > 0 ? constant_buffers != nullptr : true; // can provide no cbuffers
     const bool valid_input_desc = input_element_count > 0 && input_desc != nullptr; // must supply at least 1 input desc
     const bool valid_texture_ranges = texture_range_count > 0 ? texture_ranges != nullptr : true; // can provide no textures
     const bool valid_render_targets = IN_RANGE_INCLUSIVE(render_target_count, 1, 8) && render_target_formats != nullptr; // must supply at least 1 render target to a max of 8 in dx12
-    const bool valid_arguments = device != nullptr && valid_constant_buffers && valid_input_desc && valid_texture_ranges && valid_render_targets;
+    const bool valid_arguments = root_signature_cache != nullptr && valid_constant_buffers && valid_input_desc && valid_texture_ranges && valid_render_targets;
     assert(valid_arguments);
     if (!valid_arguments)
     {
@@ -31,8 +56,6 @@ c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_
         return;
     }
 
-    HRESULT hr = S_OK;
-
     m_constant_buffers = new c_constant_buffer*[m_constant_buffer_count];
     for (dword buffer_index = 0; buffer_index < m_constant_buffer_count; buffer_index++)
     {
@@ -51,6 +74,7 @@ c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_
     m_input_layout = {};
     m_input_layout.NumElements = input_element_count;
     m_input_layout.pInputElementDescs = input_desc;
+    m_compact_input_layout = {};
 
     // Root signature - Defines what types of resources are bound to the graphics pipeline
     // Resources eg. vertex/pixel shader, constant buffer
@@ -82,59 +106,25 @@ c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_
     root_parameters[m_textures_root_index].DescriptorTable = descriptor_table; // this is our descriptor table for this root parameter
     root_parameters[m_textures_root_index].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // our pixel shader will be the only shader accessing this parameter for now
 
-    // create a static sampler
-    CD3DX12_STATIC_SAMPLER_DESC samplers[1] =
-    {
-        (
-            0, // register
-            D3D12_FILTER_ANISOTROPIC,
-            D3D12_TEXTURE_ADDRESS_MODE_WRAP,
-            D3D12_TEXTURE_ADDRESS_MODE_WRAP,
-            D3D12_TEXTURE_ADDRESS_MODE_WRAP,
-            0.0f, // mip LOD bias
-            0, // max anisotropy
-            D3D12_COMPARISON_FUNC_NEVER,
-            D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK,
-            0.0f, // min LOD
-            D3D12_FLOAT32_MAX, // max LOD
-            D3D12_SHADER_VISIBILITY_PIXEL,
-            0 // register space
-        )
-    };
-
     CD3DX12_ROOT_SIGNATURE_DESC root_signature_desc;
     root_signature_desc.Init
     (
         m_root_parameter_count,
         root_parameters, // a pointer to the beginning of our root parameters array
-        _countof(samplers),
-        samplers, // a pointer to our static samplers (array)
+        _countof(STATIC_SAMPLERS),
+        STATIC_SAMPLERS, // a pointer to our static samplers (array)
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT | // we can deny shader stages here for better performance
         D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
         D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
         D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS
     );
-    ID3DBlob* signature;
-    ID3DBlob* error; // a buffer holding the error data if any
-    hr = D3D12SerializeRootSignature(&root_signature_desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
-    if (hr == S_OK)
-    {
-        hr = device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_root_signature));
-        if (!HRESULT_VALID(hr))
-        {
-            m_root_signature = nullptr;
-        }
-    }
-    else
+    // Shader inputs with the same layout share a root signature
+    m_root_signature = root_signature_cache->create(&root_signature_desc, &m_root_signature_hash);
+    delete[] root_parameters;
+    if (m_root_signature == nullptr)
     {
-        if (error != nullptr)
-        {
-            LOG_ERROR(L"%hs", (char*)error->GetBufferPointer());
-        }
-        HRESULT_VALID(hr);
         return;
     }
-    delete[] root_parameters;
 
     for (dword i = 0; i < m_render_target_count; i++)
     {
@@ -142,11 +132,25 @@ c_shader_input::c_shader_input(ID3D12Device* const device, const dword textures_
     }
 }
 
+void c_shader_input::set_compact_input_layout(const D3D12_INPUT_ELEMENT_DESC input_desc[], const dword input_element_count)
+{
+    const bool valid_input_desc = input_element_count > 0 && input_desc != nullptr;
+    assert(valid_input_desc);
+    if (!valid_input_desc)
+    {
+        LOG_WARNING(L"invalid compact input layout! ignoring");
+        return;
+    }
+
+    m_compact_input_layout.NumElements = input_element_count;
+    m_compact_input_layout.pInputElementDescs = input_desc;
+}
+
 c_shader_input::~c_shader_input()
 {
     for (dword buffer_index = 0; buffer_index < m_constant_buffer_count; buffer_index++)
     {
-        if (m_constant_buffers[buffer_index] != nullptr)
+        if (m_owns_constant_buffers && m_constant_buffers[buffer_index] != nullptr)
         {
             delete m_constant_buffers[buffer_index];
         }
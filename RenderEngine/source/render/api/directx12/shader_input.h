@@ -1,6 +1,7 @@
 #pragma once
 #include <types.h>
 #include <d3d12.h> // TODO: reduce reliance on this type
+#include <asset/mesh_format.h>
 
 enum e_shader_input
 {
@@ -15,12 +16,13 @@ enum e_shader_input
 };
 
 class c_constant_buffer;
+class c_root_signature_cache;
 enum e_constant_buffers;
 class c_shader_input
 {
 public:
-	c_shader_input(ID3D12Device* const device, const dword textures_count,
-		c_constant_buffer* const constant_buffers[], const dword constant_buffer_count,
+	c_shader_input(c_root_signature_cache* const root_signature_cache, const dword textures_count,
+		c_constant_buffer* const constant_buffers[], const dword constant_buffer_count, const bool owns_constant_buffers,
 		const D3D12_INPUT_ELEMENT_DESC input_desc[], const dword input_element_count,
 		const D3D12_DESCRIPTOR_RANGE texture_ranges[], const dword texture_range_count,
 		const DXGI_FORMAT render_target_formats[], const dword render_target_count,
@@ -28,7 +30,12 @@ public:
 	~c_shader_input();
 
 	inline ID3D12RootSignature* const get_root_signature() const { return m_root_signature; };
-	inline const D3D12_INPUT_LAYOUT_DESC get_input_layout() const { return m_input_layout; };
+	// Hash of the serialized root signature, the same between runs unlike the root signature itself
+	inline const qword get_root_signature_hash() const { return m_root_signature_hash; };
+	// Falls back to the full layout if no compact layout was set
+	inline const D3D12_INPUT_LAYOUT_DESC get_input_layout(const e_mesh_vertex_format vertex_format) const { return vertex_format == _mesh_vertex_format_compact && m_compact_input_layout.NumElements > 0 ? m_compact_input_layout : m_input_layout; };
+	// Layout for pipelines drawing compact vertices, sharing this input's root signature & constant buffers
+	void set_compact_input_layout(const D3D12_INPUT_ELEMENT_DESC input_desc[], const dword input_element_count);
 	inline c_constant_buffer* const get_constant_buffer(const e_constant_buffers buffer_index) const { return m_constant_buffers[buffer_index]; };
 	inline const DXGI_FORMAT get_render_target_format(const dword render_target_index) const
 	{ 
@@ -46,8 +53,11 @@ public:
 	const D3D12_COMPARISON_FUNC m_depth_comparison_func;
 
 private:
-	ID3D12RootSignature* m_root_signature; // Defines what resources are bound to the graphics pipeline
+	ID3D12RootSignature* m_root_signature; // Defines what resources are bound to the graphics pipeline, shared with inputs of the same layout
+	qword m_root_signature_hash;
 	D3D12_INPUT_LAYOUT_DESC m_input_layout; // TODO: INVESTIGATE WHETHER DANGLING POINTER LEFT IN HERE
+	D3D12_INPUT_LAYOUT_DESC m_compact_input_layout;
 	c_constant_buffer** m_constant_buffers; // array of pointers of count m_constant_buffer_count
+	const bool m_owns_constant_buffers; // false when sharing another input's constant buffers, which that input cleans up
 	DXGI_FORMAT* const m_render_target_formats; // array of formats
 };
\ No newline at end of file
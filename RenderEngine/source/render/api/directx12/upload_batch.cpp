@@ -0,0 +1,280 @@
+#include "upload_batch.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <d3dx12.h>
+#include <chrono>
+
+// Buffer copies have no placement requirement, this just keeps the staging writes aligned
+constexpr qword UPLOAD_BUFFER_ALIGNMENT = 16;
+
+static qword align_offset(const qword offset, const qword alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+c_upload_batch::c_upload_batch(ID3D12Device* const device, ID3D12CommandQueue* const command_queue, const qword staging_size, const wchar_t* const name)
+    : m_device(device)
+    , m_command_queue(command_queue)
+    , m_command_allocator(nullptr)
+    , m_command_list(nullptr)
+    , m_fence(nullptr)
+    , m_fence_event(nullptr)
+    , m_fence_value(0)
+    , m_staging_buffer(nullptr)
+    , m_staging_data(nullptr)
+    , m_staging_size(staging_size)
+    , m_staging_offset(0)
+    , m_dedicated_staging_buffers()
+    , m_barriers()
+    , m_recording(false)
+    , m_in_flight(false)
+    , m_pending_upload_count(0)
+    , m_statistics()
+{
+    HRESULT hr = S_OK;
+
+    hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_command_allocator));
+    if (!HRESULT_VALID(hr)) { return; }
+
+    // Command lists are created recording, close it until the first upload
+    hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_command_allocator, nullptr, IID_PPV_ARGS(&m_command_list));
+    if (!HRESULT_VALID(hr)) { return; }
+    m_command_list->SetName(name);
+    m_command_list->Close();
+
+    hr = m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
+    if (!HRESULT_VALID(hr)) { return; }
+    m_fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_fence_event == nullptr)
+    {
+        HRESULT_VALID(HRESULT_FROM_WIN32(GetLastError()));
+        return;
+    }
+
+    const CD3DX12_HEAP_PROPERTIES upload_heap_properties(D3D12_HEAP_TYPE_UPLOAD);
+    const CD3DX12_RESOURCE_DESC staging_description = CD3DX12_RESOURCE_DESC::Buffer(m_staging_size);
+    hr = m_device->CreateCommittedResource(&upload_heap_properties, D3D12_HEAP_FLAG_NONE, &staging_description, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_staging_buffer));
+    if (!HRESULT_VALID(hr)) { return; }
+    m_staging_buffer->SetName(name);
+
+    // Staging is write only from the CPU, mapped once for the lifetime of the batch
+    const CD3DX12_RANGE read_range(0, 0);
+    hr = m_staging_buffer->Map(0, &read_range, reinterpret_cast<void**>(&m_staging_data));
+    if (!HRESULT_VALID(hr))
+    {
+        m_staging_data = nullptr;
+        return;
+    }
+}
+
+c_upload_batch::~c_upload_batch()
+{
+    // Resources recorded into this batch may already be in use elsewhere, so finish them rather than dropping them
+    if (m_command_list != nullptr && m_fence_event != nullptr)
+    {
+        this->flush();
+    }
+
+    for (ID3D12Resource* dedicated_staging_buffer : m_dedicated_staging_buffers)
+    {
+        SAFE_RELEASE(dedicated_staging_buffer);
+    }
+    if (m_staging_data != nullptr)
+    {
+        m_staging_buffer->Unmap(0, nullptr);
+    }
+    SAFE_RELEASE(m_staging_buffer);
+    SAFE_RELEASE(m_fence);
+    SAFE_RELEASE(m_command_list);
+    SAFE_RELEASE(m_command_allocator);
+    if (m_fence_event != nullptr)
+    {
+        CloseHandle(m_fence_event);
+    }
+}
+
+bool c_upload_batch::upload_buffer(ID3D12Resource* const destination, const void* const data, const qword data_size, const D3D12_RESOURCE_STATES after_state)
+{
+    const bool arguments_valid = this->is_valid() && destination != nullptr && data != nullptr && data_size > 0;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid args! aborting");
+        return K_FAILURE;
+    }
+
+    ID3D12Resource* staging_buffer = nullptr;
+    qword staging_offset = 0;
+    if (!this->allocate_staging(data_size, UPLOAD_BUFFER_ALIGNMENT, &staging_buffer, &staging_offset)) { return K_FAILURE; }
+
+    if (staging_buffer == m_staging_buffer)
+    {
+        memcpy(m_staging_data + staging_offset, data, data_size);
+    }
+    else
+    {
+        void* dedicated_data = nullptr;
+        const CD3DX12_RANGE read_range(0, 0);
+        HRESULT hr = staging_buffer->Map(0, &read_range, &dedicated_data);
+        if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+        memcpy(dedicated_data, data, data_size);
+        staging_buffer->Unmap(0, nullptr);
+    }
+
+    m_command_list->CopyBufferRegion(destination, 0, staging_buffer, staging_offset, data_size);
+    m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(destination, D3D12_RESOURCE_STATE_COPY_DEST, after_state));
+
+    m_pending_upload_count++;
+    m_statistics.upload_count++;
+    m_statistics.bytes_uploaded += data_size;
+    return K_SUCCESS;
+}
+
+bool c_upload_batch::upload_texture(ID3D12Resource* const destination, const D3D12_SUBRESOURCE_DATA subresources[], const dword subresource_count, const D3D12_RESOURCE_STATES after_state)
+{
+    const bool arguments_valid = this->is_valid() && destination != nullptr && subresources != nullptr && subresource_count > 0;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid args! aborting");
+        return K_FAILURE;
+    }
+
+    // Includes the row pitch padding the copy footprints need
+    const qword required_size = GetRequiredIntermediateSize(destination, 0, subresource_count);
+    ID3D12Resource* staging_buffer = nullptr;
+    qword staging_offset = 0;
+    if (!this->allocate_staging(required_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &staging_buffer, &staging_offset)) { return K_FAILURE; }
+
+    // Writes every subresource's rows into staging & records a copy for each
+    const qword copied_size = UpdateSubresources(m_command_list, destination, staging_buffer, staging_offset, 0, subresource_count, subresources);
+    if (copied_size == 0)
+    {
+        LOG_WARNING(L"failed to record texture upload!");
+        return K_FAILURE;
+    }
+    m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(destination, D3D12_RESOURCE_STATE_COPY_DEST, after_state));
+
+    m_pending_upload_count++;
+    m_statistics.upload_count++;
+    for (dword i = 0; i < subresource_count; i++)
+    {
+        m_statistics.bytes_uploaded += subresources[i].SlicePitch;
+    }
+    return K_SUCCESS;
+}
+
+bool c_upload_batch::submit()
+{
+    if (!m_recording)
+    {
+        return K_SUCCESS;
+    }
+
+    HRESULT hr = S_OK;
+    if (!m_barriers.empty())
+    {
+        m_command_list->ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+        m_barriers.clear();
+    }
+    hr = m_command_list->Close();
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+
+    ID3D12CommandList* command_lists[] = { m_command_list };
+    m_command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+    m_fence_value++;
+    hr = m_command_queue->Signal(m_fence, m_fence_value);
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+
+    m_recording = false;
+    m_in_flight = true;
+    m_pending_upload_count = 0;
+    m_statistics.submit_count++;
+    return K_SUCCESS;
+}
+
+bool c_upload_batch::wait()
+{
+    if (!m_in_flight)
+    {
+        return K_SUCCESS;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    if (m_fence->GetCompletedValue() < m_fence_value)
+    {
+        HRESULT hr = m_fence->SetEventOnCompletion(m_fence_value, m_fence_event);
+        if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+        WaitForSingleObject(m_fence_event, INFINITE);
+    }
+    m_statistics.wait_milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    m_in_flight = false;
+
+    for (ID3D12Resource* dedicated_staging_buffer : m_dedicated_staging_buffers)
+    {
+        SAFE_RELEASE(dedicated_staging_buffer);
+    }
+    m_dedicated_staging_buffers.clear();
+
+    return K_SUCCESS;
+}
+
+bool c_upload_batch::flush()
+{
+    if (!this->submit()) { return K_FAILURE; }
+    return this->wait();
+}
+
+bool c_upload_batch::begin_recording()
+{
+    if (m_recording)
+    {
+        return K_SUCCESS;
+    }
+
+    // Staging & the allocator are still in use until the previous submit finishes
+    if (!this->wait()) { return K_FAILURE; }
+
+    HRESULT hr = S_OK;
+    hr = m_command_allocator->Reset();
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+    hr = m_command_list->Reset(m_command_allocator, nullptr);
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+
+    m_staging_offset = 0;
+    m_recording = true;
+    return K_SUCCESS;
+}
+
+bool c_upload_batch::allocate_staging(const qword size, const qword alignment, ID3D12Resource** const out_buffer, qword* const out_offset)
+{
+    if (!this->begin_recording()) { return K_FAILURE; }
+
+    if (size > m_staging_size)
+    {
+        ID3D12Resource* dedicated_staging_buffer = nullptr;
+        const CD3DX12_HEAP_PROPERTIES upload_heap_properties(D3D12_HEAP_TYPE_UPLOAD);
+        const CD3DX12_RESOURCE_DESC staging_description = CD3DX12_RESOURCE_DESC::Buffer(size);
+        HRESULT hr = m_device->CreateCommittedResource(&upload_heap_properties, D3D12_HEAP_FLAG_NONE, &staging_description, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&dedicated_staging_buffer));
+        if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+        dedicated_staging_buffer->SetName(L"Dedicated Upload Staging Buffer");
+        m_dedicated_staging_buffers.push_back(dedicated_staging_buffer);
+
+        *out_buffer = dedicated_staging_buffer;
+        *out_offset = 0;
+        return K_SUCCESS;
+    }
+
+    qword offset = align_offset(m_staging_offset, alignment);
+    if (offset + size > m_staging_size)
+    {
+        // Staging is full, make space by finishing everything recorded so far
+        if (!this->flush() || !this->begin_recording()) { return K_FAILURE; }
+        offset = 0;
+    }
+
+    m_staging_offset = offset + size;
+    *out_buffer = m_staging_buffer;
+    *out_offset = offset;
+    return K_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <types.h>
+#include <d3d12.h>
+#include <vector>
+
+struct s_upload_batch_statistics
+{
+	qword bytes_uploaded; // data copied through staging, not including row padding
+	dword upload_count; // buffers & textures recorded
+	dword submit_count; // command lists executed, each with a single fence signal
+	double wait_milliseconds; // CPU time blocked on the fence
+};
+
+// Records any number of buffer & texture uploads through one persistently mapped staging buffer,
+// then submits them as one command list with a single fence wait, instead of a queue round trip per resource
+// Not thread safe, use one batch per recording thread
+class c_upload_batch
+{
+public:
+	c_upload_batch(ID3D12Device* const device, ID3D12CommandQueue* const command_queue, const qword staging_size, const wchar_t* const name);
+	~c_upload_batch();
+
+	inline const bool is_valid() const { return m_staging_data != nullptr; };
+
+	// Copy data into staging & record a copy into destination, which must be in the COMMON or COPY_DEST state
+	// The source data can be freed once this returns, destination can't be used until the batch has been flushed
+	bool upload_buffer(ID3D12Resource* const destination, const void* const data, const qword data_size, const D3D12_RESOURCE_STATES after_state);
+	// As above for every subresource of a texture, destination must be in the COPY_DEST state
+	bool upload_texture(ID3D12Resource* const destination, const D3D12_SUBRESOURCE_DATA subresources[], const dword subresource_count, const D3D12_RESOURCE_STATES after_state);
+
+	// Execute everything recorded since the last submit, returns without waiting
+	bool submit();
+	// Block until the last submit has finished on the GPU, staging memory can only be reused after this
+	bool wait();
+	// Submit & wait
+	bool flush();
+
+	inline const bool has_pending_uploads() const { return m_pending_upload_count > 0; };
+	inline const s_upload_batch_statistics* const get_statistics() const { return &m_statistics; };
+	inline void reset_statistics() { m_statistics = {}; };
+
+private:
+	bool begin_recording();
+	// Sub allocate from staging, flushing to make space if needed
+	// Uploads bigger than the whole staging buffer get a dedicated buffer released after their submit finishes
+	bool allocate_staging(const qword size, const qword alignment, ID3D12Resource** const out_buffer, qword* const out_offset);
+
+	ID3D12Device* const m_device;
+	ID3D12CommandQueue* const m_command_queue;
+	ID3D12CommandAllocator* m_command_allocator;
+	ID3D12GraphicsCommandList* m_command_list;
+	ID3D12Fence* m_fence;
+	HANDLE m_fence_event;
+	qword m_fence_value; // value signalled by the last submit
+
+	ID3D12Resource* m_staging_buffer; // upload heap, mapped for the lifetime of the batch
+	ubyte* m_staging_data;
+	const qword m_staging_size;
+	qword m_staging_offset;
+	std::vector<ID3D12Resource*> m_dedicated_staging_buffers;
+	std::vector<D3D12_RESOURCE_BARRIER> m_barriers; // issued together at the end of the command list
+
+	bool m_recording;
+	bool m_in_flight; // submitted but not yet waited on
+	dword m_pending_upload_count;
+	s_upload_batch_statistics m_statistics;
+};
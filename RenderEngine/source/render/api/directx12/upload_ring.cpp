@@ -0,0 +1,141 @@
+#include "upload_ring.h"
+#include <reporting/report.h>
+#include <render/api/directx12/helpers.h>
+#include <d3dx12.h>
+#include <algorithm>
+#include <cassert>
+
+static qword align_offset(const qword offset, const qword alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+c_upload_ring::c_upload_ring(ID3D12Device* const device, const qword page_size, const wchar_t* const name)
+    : m_device(device)
+    , m_page_size(align_offset(page_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT))
+    , m_name()
+    , m_pages()
+    , m_frame_index(0)
+    , m_frame_serial(0)
+    , m_page_index(0)
+    , m_page_offset(0)
+    , m_statistics()
+{
+    assert(device != nullptr && page_size > 0 && name != nullptr);
+    wcscpy_s(m_name, _countof(m_name), name);
+}
+
+c_upload_ring::~c_upload_ring()
+{
+    for (std::vector<s_upload_page>& frame_pages : m_pages)
+    {
+        for (s_upload_page& page : frame_pages)
+        {
+            page.buffer->Unmap(0, nullptr);
+            SAFE_RELEASE(page.buffer);
+        }
+    }
+}
+
+void c_upload_ring::begin_frame(const dword frame_index)
+{
+    const bool arguments_valid = IN_RANGE_COUNT(frame_index, 0, FRAME_BUFFER_COUNT);
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return;
+    }
+
+    m_frame_index = frame_index;
+    m_frame_serial++;
+    m_page_index = 0;
+    m_page_offset = 0;
+    m_statistics.frame_size = 0;
+}
+
+bool c_upload_ring::allocate(const qword size, const qword alignment, void** const out_data, D3D12_GPU_VIRTUAL_ADDRESS* const out_gpu_address)
+{
+    const bool arguments_valid = out_gpu_address != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return K_FAILURE;
+    }
+
+    ID3D12Resource* buffer = nullptr;
+    qword offset = 0;
+    if (!this->allocate(size, alignment, out_data, &buffer, &offset)) { return K_FAILURE; }
+    *out_gpu_address = buffer->GetGPUVirtualAddress() + offset;
+    return K_SUCCESS;
+}
+
+bool c_upload_ring::allocate(const qword size, const qword alignment, void** const out_data, ID3D12Resource** const out_buffer, qword* const out_offset)
+{
+    const bool arguments_valid = size > 0 && alignment > 0 && (alignment & (alignment - 1)) == 0 && out_data != nullptr && out_buffer != nullptr && out_offset != nullptr;
+    assert(arguments_valid);
+    if (!arguments_valid)
+    {
+        LOG_WARNING(L"invalid arguments in call! aborting");
+        return K_FAILURE;
+    }
+
+    // Pages are only ever added, so a frame that needed more space once won't need to add it again
+    std::vector<s_upload_page>& frame_pages = m_pages[m_frame_index];
+    bool page_added = false;
+    qword offset = align_offset(m_page_offset, alignment);
+    while (m_page_index < frame_pages.size() && offset + size > frame_pages[m_page_index].size)
+    {
+        // The rest of a full page is left unused until this frame index begins again
+        m_page_index++;
+        offset = 0;
+    }
+    if (m_page_index == frame_pages.size())
+    {
+        if (!this->add_page(size)) { return K_FAILURE; }
+        page_added = true;
+        offset = 0;
+    }
+
+    const s_upload_page& page = frame_pages[m_page_index];
+    *out_data = page.data + offset;
+    *out_buffer = page.buffer;
+    *out_offset = offset;
+    m_page_offset = offset + size;
+
+    m_statistics.frame_size += align_offset(size, alignment);
+    m_statistics.peak_frame_size = std::max(m_statistics.peak_frame_size, m_statistics.frame_size);
+    if (page_added)
+    {
+        LOG_MESSAGE(L"%s grew to %d pages (%llu bytes), peak frame usage %llu bytes", m_name, m_statistics.page_count, m_statistics.capacity, m_statistics.peak_frame_size);
+    }
+    return K_SUCCESS;
+}
+
+bool c_upload_ring::add_page(const qword minimum_size)
+{
+    // Allocations bigger than a page get a page of their own size
+    const qword page_size = std::max(m_page_size, align_offset(minimum_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+
+    s_upload_page page = { nullptr, nullptr, page_size };
+    const CD3DX12_HEAP_PROPERTIES upload_heap_properties(D3D12_HEAP_TYPE_UPLOAD);
+    const CD3DX12_RESOURCE_DESC page_description = CD3DX12_RESOURCE_DESC::Buffer(page_size);
+    HRESULT hr = m_device->CreateCommittedResource(&upload_heap_properties, D3D12_HEAP_FLAG_NONE, &page_description, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&page.buffer));
+    if (!HRESULT_VALID(hr)) { return K_FAILURE; }
+    page.buffer->SetName(m_name);
+
+    // Only ever written by the CPU, so nothing is read back
+    const CD3DX12_RANGE read_range(0, 0);
+    hr = page.buffer->Map(0, &read_range, reinterpret_cast<void**>(&page.data));
+    if (!HRESULT_VALID(hr))
+    {
+        SAFE_RELEASE(page.buffer);
+        return K_FAILURE;
+    }
+
+    m_pages[m_frame_index].push_back(page);
+    m_statistics.capacity += page_size;
+    m_statistics.page_count++;
+    return K_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <types.h>
+#include <render/constants.h>
+#include <d3d12.h>
+#include <vector>
+
+struct s_upload_ring_statistics
+{
+	qword frame_size; // bytes allocated so far this frame, including alignment
+	qword peak_frame_size; // most bytes allocated in any one frame
+	qword capacity; // bytes in every page across all frames in flight
+	dword page_count;
+};
+
+// Per frame linear allocator for data the CPU writes & the GPU reads within the same frame, like constants
+// Each frame in flight sub allocates from its own pages of persistently mapped upload memory, reused once that frame comes around again
+// A frame running out of space adds another page rather than failing, so there's no cap besides memory
+// Not thread safe
+class c_upload_ring
+{
+public:
+	c_upload_ring(ID3D12Device* const device, const qword page_size, const wchar_t* const name);
+	~c_upload_ring();
+
+	// Start allocating from frame_index's pages again, only once the GPU has finished the last frame that used them
+	void begin_frame(const dword frame_index);
+	// Sub allocate size bytes at a power of two alignment, valid until this frame index begins again
+	bool allocate(const qword size, const qword alignment, void** const out_data, D3D12_GPU_VIRTUAL_ADDRESS* const out_gpu_address);
+	// As above, returning the page & offset within it for copying from rather than a GPU address
+	bool allocate(const qword size, const qword alignment, void** const out_data, ID3D12Resource** const out_buffer, qword* const out_offset);
+
+	inline const dword get_frame_index() const { return m_frame_index; };
+	// Changes every begin_frame, so callers can tell whether what they allocated is from this frame
+	inline const qword get_frame_serial() const { return m_frame_serial; };
+	inline const s_upload_ring_statistics* const get_statistics() const { return &m_statistics; };
+
+private:
+	struct s_upload_page
+	{
+		ID3D12Resource* buffer;
+		ubyte* data; // mapped for the lifetime of the ring
+		qword size;
+	};
+
+	// Append a page of at least minimum_size to the current frame's pages
+	bool add_page(const qword minimum_size);
+
+	ID3D12Device* const m_device; // local reference, DO NOT clean this up!
+	const qword m_page_size;
+	wchar_t m_name[64];
+
+	std::vector<s_upload_page> m_pages[FRAME_BUFFER_COUNT];
+	dword m_frame_index;
+	qword m_frame_serial;
+	dword m_page_index; // page in m_pages[m_frame_index] allocations are coming from
+	qword m_page_offset;
+
+	s_upload_ring_statistics m_statistics;
+};
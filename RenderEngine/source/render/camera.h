@@ -31,6 +31,8 @@ public:
 	const point3d get_position() const { return m_position; };
 	const point3d get_look_direction() const { return m_look_direction; };
 	const view_bounds2d get_resolution() const { return m_resolution; };
+	const float get_field_of_view() const { return m_field_of_view; }; // vertical, in degrees
+	const bounds2d get_clip_depth() const { return m_clip_depth; };
 
 	void move_forward(const float distance);
 	void strafe_left(const float distance);
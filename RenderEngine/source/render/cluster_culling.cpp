@@ -0,0 +1,147 @@
+#include "cluster_culling.h"
+#include <render/camera.h>
+#include <reporting/report.h>
+#include <cmath>
+
+#if API_DIRECTX
+enum e_frustum_plane
+{
+	_frustum_plane_left,
+	_frustum_plane_right,
+	_frustum_plane_bottom,
+	_frustum_plane_top,
+	_frustum_plane_near,
+	_frustum_plane_far,
+
+	k_frustum_plane_count
+};
+static_assert(k_frustum_plane_count == sizeof(s_view_frustum::planes) / sizeof(s_view_frustum::planes[0]));
+
+static bool sphere_in_frustum(const s_view_frustum& frustum, const XMVECTOR center, const float radius)
+{
+	for (dword i = 0; i < k_frustum_plane_count; i++)
+	{
+		const float distance = XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4((const XMFLOAT4*)&frustum.planes[i]), center));
+		if (distance < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+void build_view_frustum(const c_camera* const camera, s_view_frustum* const out_frustum)
+{
+	assert(camera != nullptr && out_frustum != nullptr);
+#if API_DIRECTX
+	// Planes come straight from the columns of the view projection matrix (Gribb & Hartmann), clip depth runs 0 to w in D3D
+	const matrix4x4 view = camera->get_view();
+	const matrix4x4 projection = camera->get_projection();
+	const XMMATRIX view_projection = XMMatrixMultiply(XMLoadFloat4x4((const XMFLOAT4X4*)&view), XMLoadFloat4x4((const XMFLOAT4X4*)&projection));
+	const XMMATRIX columns = XMMatrixTranspose(view_projection);
+
+	XMVECTOR planes[k_frustum_plane_count];
+	planes[_frustum_plane_left] = XMVectorAdd(columns.r[3], columns.r[0]);
+	planes[_frustum_plane_right] = XMVectorSubtract(columns.r[3], columns.r[0]);
+	planes[_frustum_plane_bottom] = XMVectorAdd(columns.r[3], columns.r[1]);
+	planes[_frustum_plane_top] = XMVectorSubtract(columns.r[3], columns.r[1]);
+	planes[_frustum_plane_near] = columns.r[2];
+	planes[_frustum_plane_far] = XMVectorSubtract(columns.r[3], columns.r[2]);
+	for (dword i = 0; i < k_frustum_plane_count; i++)
+	{
+		XMStoreFloat4((XMFLOAT4*)&out_frustum->planes[i], XMPlaneNormalize(planes[i]));
+	}
+#endif
+}
+
+void cull_mesh
+(
+	const c_mesh* const mesh,
+	const dword lod,
+	const matrix4x4& world,
+	const point3d scale,
+	const c_camera* const camera,
+	const s_view_frustum& frustum,
+	std::vector<s_draw_range>* const out_ranges,
+	s_culling_statistics* const statistics
+)
+{
+	assert(mesh != nullptr && camera != nullptr && out_ranges != nullptr && statistics != nullptr);
+	const s_geometry_lod* const geometry_lod = mesh->get_lod(lod);
+	const qword triangle_count = mesh->get_lod_count() > 0 ? geometry_lod->index_count / 3 : 0;
+	statistics->object_count++;
+	statistics->triangle_count += triangle_count;
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+#if API_DIRECTX
+	const XMMATRIX world_matrix = XMLoadFloat4x4((const XMFLOAT4X4*)&world);
+	const float maximum_scale = fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+	const s_geometry_bounds* const bounds = mesh->get_bounds();
+	const XMVECTOR world_center = XMVector3Transform(XMLoadFloat3((const XMFLOAT3*)&bounds->center), world_matrix);
+	if (!sphere_in_frustum(frustum, world_center, bounds->radius * maximum_scale))
+	{
+		return;
+	}
+	statistics->visible_object_count++;
+	statistics->visible_object_triangle_count += triangle_count;
+
+	const dword meshlet_count = mesh->get_meshlet_count();
+	if (lod != 0 || meshlet_count == 0)
+	{
+		out_ranges->push_back({ geometry_lod->index_offset, geometry_lod->index_count });
+		statistics->drawn_triangle_count += triangle_count;
+		return;
+	}
+
+	// Cones are only tested under a uniform positive scale, anything else skews the normals or flips the winding
+	const bool cone_culling = scale.x > 0.0f && scale.x == scale.y && scale.x == scale.z;
+	const point3d camera_position = camera->get_position();
+	const XMVECTOR eye = XMLoadFloat3((const XMFLOAT3*)&camera_position);
+	const s_geometry_meshlet* const meshlets = mesh->get_meshlets();
+	const size_t first_range = out_ranges->size();
+	for (dword i = 0; i < meshlet_count; i++)
+	{
+		const s_geometry_meshlet& meshlet = meshlets[i];
+		statistics->meshlet_count++;
+
+		const XMVECTOR center = XMVector3Transform(XMLoadFloat3((const XMFLOAT3*)&meshlet.center), world_matrix);
+		const float radius = meshlet.radius * maximum_scale;
+		if (!sphere_in_frustum(frustum, center, radius))
+		{
+			continue;
+		}
+
+		// Every triangle faces away when the eye is inside the cone's back facing region, widened by the bounding sphere
+		if (cone_culling && meshlet.cone_cutoff < 1.0f)
+		{
+			const XMVECTOR axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3((const XMFLOAT3*)&meshlet.cone_axis), world_matrix));
+			const XMVECTOR eye_to_center = XMVectorSubtract(center, eye);
+			const float distance = XMVectorGetX(XMVector3Length(eye_to_center));
+			if (XMVectorGetX(XMVector3Dot(eye_to_center, axis)) >= meshlet.cone_cutoff * distance + radius)
+			{
+				continue;
+			}
+		}
+
+		statistics->visible_meshlet_count++;
+		statistics->drawn_triangle_count += meshlet.index_count / 3;
+		if (out_ranges->size() > first_range && out_ranges->back().index_offset + out_ranges->back().index_count == meshlet.index_offset)
+		{
+			out_ranges->back().index_count += meshlet.index_count;
+		}
+		else
+		{
+			out_ranges->push_back({ meshlet.index_offset, meshlet.index_count });
+		}
+	}
+#else
+	out_ranges->push_back({ geometry_lod->index_offset, geometry_lod->index_count });
+	statistics->visible_object_count++;
+	statistics->visible_object_triangle_count += triangle_count;
+	statistics->drawn_triangle_count += triangle_count;
+#endif
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <types.h>
+#include <render/model.h>
+#include <vector>
+
+class c_camera;
+
+// World space planes bounding the camera's view, normals (i, j, k) point inwards & w is the plane distance
+struct s_view_frustum
+{
+	vector4d planes[6];
+};
+
+// Range of a mesh's index buffer to draw, neighbouring visible meshlets are merged into a single range
+struct s_draw_range
+{
+	dword index_offset;
+	dword index_count;
+};
+
+// Totals for one cull of every object in a scene
+struct s_culling_statistics
+{
+	dword object_count;
+	dword visible_object_count; // bounding sphere inside the frustum
+	dword meshlet_count; // tested
+	dword visible_meshlet_count;
+	qword triangle_count; // at each object's level of detail
+	qword visible_object_triangle_count; // drawn with object culling alone
+	qword drawn_triangle_count;
+};
+
+// The camera's view must already be up to date
+void build_view_frustum(const c_camera* const camera, s_view_frustum* const out_frustum);
+
+// Append the index ranges of mesh at lod that may be visible, world & scale are the object's transform
+// Meshlets are only tested at the full detail level, coarser levels are drawn whole once the mesh's bounds are in view
+// Back face culling by meshlet normal cones is skipped under non uniform or negative scale, which the cones don't survive
+void cull_mesh
+(
+	const c_mesh* const mesh,
+	const dword lod,
+	const matrix4x4& world,
+	const point3d scale,
+	const c_camera* const camera,
+	const s_view_frustum& frustum,
+	std::vector<s_draw_range>* const out_ranges,
+	s_culling_statistics* const statistics
+);
@@ -33,6 +33,8 @@ void imgui_overlay(c_scene* const scene, const c_renderer* const renderer, dword
         char debug_overlay_text[32];
         sprintf_s(debug_overlay_text, "DEBUG OVERLAY (%d/%dFPS)\n", fps_counter, TICK_RATE);
         ImGui::SeparatorText(debug_overlay_text);
+        const s_culling_statistics* const culling = scene->get_culling_statistics();
+        ImGui::Text("Objects %u/%u, meshlets %u/%u, triangles %llu/%llu", culling->visible_object_count, culling->object_count, culling->visible_meshlet_count, culling->meshlet_count, culling->drawn_triangle_count, culling->triangle_count);
         if (ImGui::BeginTabBar("Debug Overlay Tab Bar"))
         {
             if (ImGui::BeginTabItem("G-Buffers"))
@@ -56,15 +58,20 @@ void imgui_overlay(c_scene* const scene, const c_renderer* const renderer, dword
                     {
                         selected_object_index = object_index;
                         ImGui::SeparatorText("MATERIAL\n");
-                        ImGui::Checkbox("Use Diffuse Texture", (bool*)&object->get_material()->m_properties.m_use_diffuse_texture);
-                        ImGui::Checkbox("Use Specular Texture", (bool*)&object->get_material()->m_properties.m_use_specular_texture);
-                        ImGui::Checkbox("Use Normal Texture", (bool*)&object->get_material()->m_properties.m_use_normal_texture);
-                        ImGui::Checkbox("Render Target As Texture", (bool*)&object->get_material()->m_properties.m_render_texture);
-                        ImGui::SliderFloat3("Diffuse Material", object->get_material()->m_properties.m_diffuse.values, 0.0f, 1.0f);
-                        ImGui::SliderFloat3("Specular Material", object->get_material()->m_properties.m_specular.values, 0.0f, 1.0f);
-                        ImGui::SliderFloat3("Ambient Material", object->get_material()->m_properties.m_ambient.values, 0.0f, 1.0f);
-                        ImGui::SliderFloat3("Emissive Material", object->get_material()->m_properties.m_emissive.values, 0.0f, 1.0f);
-                        ImGui::SliderFloat("Specular Power", &object->get_material()->m_properties.m_specular_power, 0.0f, 128.0f);
+                        bool material_changed = false;
+                        material_changed |= ImGui::Checkbox("Use Diffuse Texture", (bool*)&object->get_material()->m_properties.m_use_diffuse_texture);
+                        material_changed |= ImGui::Checkbox("Use Specular Texture", (bool*)&object->get_material()->m_properties.m_use_specular_texture);
+                        material_changed |= ImGui::Checkbox("Use Normal Texture", (bool*)&object->get_material()->m_properties.m_use_normal_texture);
+                        material_changed |= ImGui::Checkbox("Render Target As Texture", (bool*)&object->get_material()->m_properties.m_render_texture);
+                        material_changed |= ImGui::SliderFloat3("Diffuse Material", object->get_material()->m_properties.m_diffuse.values, 0.0f, 1.0f);
+                        material_changed |= ImGui::SliderFloat3("Specular Material", object->get_material()->m_properties.m_specular.values, 0.0f, 1.0f);
+                        material_changed |= ImGui::SliderFloat3("Ambient Material", object->get_material()->m_properties.m_ambient.values, 0.0f, 1.0f);
+                        material_changed |= ImGui::SliderFloat3("Emissive Material", object->get_material()->m_properties.m_emissive.values, 0.0f, 1.0f);
+                        material_changed |= ImGui::SliderFloat("Specular Power", &object->get_material()->m_properties.m_specular_power, 0.0f, 128.0f);
+                        if (material_changed)
+                        {
+                            object->get_material()->properties_changed();
+                        }
 
                         ImGui::SeparatorText("TRANSFORM\n");
                         point3d position = object->m_transform.get_position();
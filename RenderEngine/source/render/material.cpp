@@ -6,22 +6,27 @@
 #endif
 #include <render/texture.h>
 
+// Last properties version handed out, materials are only created & changed on the main thread
+static qword g_material_properties_version = 0;
+
 c_material::c_material(c_renderer* const renderer, const dword maximum_textures)
 	: m_properties()
 	, m_textures()
 	, m_maximum_textures(maximum_textures)
 	, m_texture_count(0)
+	, m_properties_version(++g_material_properties_version)
 {
-	m_textures = new c_render_texture*[m_maximum_textures];
+	m_textures = new c_render_texture*[m_maximum_textures]();
 }
 
 c_material::~c_material()
 {
 	for (dword i = 0; i < m_maximum_textures; i++)
 	{
+		// Other materials may share this texture
 		if (m_textures[i] != nullptr)
 		{
-			delete m_textures[i];
+			m_textures[i]->release();
 		}
 	}
 	delete[] m_textures;
@@ -71,3 +76,17 @@ c_render_texture* const c_material::get_texture(const dword index) const
 
 	return texture;
 }
+
+const dword c_material::get_permutation() const
+{
+	dword permutation = 0;
+	permutation |= (m_properties.m_use_diffuse_texture ? 1 : 0) << _material_permutation_diffuse_texture;
+	permutation |= (m_properties.m_use_specular_texture ? 1 : 0) << _material_permutation_specular_texture;
+	permutation |= (m_properties.m_use_normal_texture ? 1 : 0) << _material_permutation_normal_texture;
+	return permutation;
+}
+
+void c_material::properties_changed()
+{
+	m_properties_version = ++g_material_properties_version;
+}
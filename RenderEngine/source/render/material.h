@@ -35,6 +35,17 @@ struct s_material
 	//--------------------------- (16 byte boundary)
 };
 
+// Material flags ps_deferred is specialised on, a permutation sets a bit for each flag enabled
+enum e_material_permutation_flags
+{
+	_material_permutation_diffuse_texture,
+	_material_permutation_specular_texture,
+	_material_permutation_normal_texture,
+
+	k_material_permutation_flags_count
+};
+constexpr dword MATERIAL_PERMUTATION_COUNT = 1 << k_material_permutation_flags_count;
+
 enum e_texture_type;
 class c_render_texture;
 class c_renderer;
@@ -45,10 +56,18 @@ public:
 	c_material(c_renderer* const renderer, const dword maximum_textures);
 	~c_material();
 
+	// Takes over the caller's reference to texture, released when the material is destroyed
 	void assign_texture(c_render_texture* const texture);
 
 	const dword get_maximum_textures() const { return m_maximum_textures; };
 	c_render_texture* const get_texture(const dword index) const;
+	// Permutation of ps_deferred matching the current flags, which can change at any time
+	const dword get_permutation() const;
+
+	// Call after changing m_properties once the material is being drawn, so the renderer uploads them again
+	void properties_changed();
+	// Unique across every material & every change, so a material reusing another's index never matches the old one's version
+	inline const qword get_properties_version() const { return m_properties_version; };
 
 	s_material m_properties;
 
@@ -57,5 +76,6 @@ private:
 	const dword m_maximum_textures;
 	dword m_texture_count;
 	c_render_texture** m_textures;
+	qword m_properties_version;
 	// TODO: c_shader
 };
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "model.h"
+#include <asset/archive.h>
+#include <reporting/report.h>
+#include <cmath>
 #ifdef API_DX12
 #include <render/api/directx12/helpers.h>
 #endif
 
 c_mesh::c_mesh(c_renderer* const renderer, vertex vertices[], dword vertices_size, dword indices[], dword indices_size)
+	: m_placeholder(false)
 {
 	// TODO: MOVE MOST OF THIS CODE BACK INTO C_MODEL
     const bool geometry_loaded = renderer->create_geometry(vertices, vertices_size, indices, indices_size, &m_resources);
@@ -11,15 +15,123 @@ c_mesh::c_mesh(c_renderer* const renderer, vertex vertices[], dword vertices_siz
 }
 
 c_mesh::c_mesh(c_renderer* const renderer, const wchar_t* const file_path)
+	: m_placeholder(false)
 {
 	const bool model_loaded = renderer->load_model(file_path, &m_resources);
 	assert(model_loaded);
 }
 
+c_mesh::c_mesh(c_renderer* const renderer, const c_asset_archive* const archive, const char* const name)
+	: m_placeholder(false)
+{
+	wchar_t debug_name[MAXIMUM_PATH] = {};
+	swprintf_s(debug_name, MAXIMUM_PATH, L"%hs", name);
+
+	const s_archive_entry* const entry = archive->find(name);
+	if (entry == nullptr || entry->type != _archive_entry_mesh)
+	{
+		LOG_WARNING(L"mesh %s is not in the asset archive!", debug_name);
+		m_resources = {};
+		return;
+	}
+
+	const bool model_loaded = renderer->load_model_from_memory(archive->get_data(entry), entry->data_size, debug_name, &m_resources, nullptr);
+	assert(model_loaded);
+}
+
+c_mesh::c_mesh(c_renderer* const renderer)
+	: m_resources(*renderer->get_placeholder_geometry())
+	, m_placeholder(true)
+{
+}
+
 c_mesh::~c_mesh()
 {
+	if (m_placeholder)
+	{
+		return;
+	}
+
+	delete[] m_resources.meshlets;
 #ifdef API_DX12
 	SAFE_RELEASE(m_resources.vertex_buffer);
 	SAFE_RELEASE(m_resources.index_buffer);
 #endif
-}
\ No newline at end of file
+}
+
+bool c_mesh::set_streamed_resources(const s_geometry_resources* const resources, s_geometry_resources* const out_replaced)
+{
+	assert(resources != nullptr && out_replaced != nullptr);
+
+	// Meshes are streamed again when their cooked file is reloaded
+	const bool replaced = !m_placeholder;
+	if (replaced)
+	{
+		*out_replaced = m_resources;
+	}
+
+	m_resources = *resources;
+	m_placeholder = false;
+	return replaced;
+}
+
+void compute_geometry_bounds(const vertex vertices[], const dword vertex_count, s_geometry_bounds* const out_bounds)
+{
+	assert(out_bounds != nullptr);
+	*out_bounds = {};
+	if (vertex_count == 0)
+	{
+		return;
+	}
+
+	out_bounds->minimum = vertices[0].vertex.position;
+	out_bounds->maximum = vertices[0].vertex.position;
+	for (dword i = 1; i < vertex_count; i++)
+	{
+		const vector3d& position = vertices[i].vertex.position;
+		out_bounds->minimum = { fminf(out_bounds->minimum.i, position.i), fminf(out_bounds->minimum.j, position.j), fminf(out_bounds->minimum.k, position.k) };
+		out_bounds->maximum = { fmaxf(out_bounds->maximum.i, position.i), fmaxf(out_bounds->maximum.j, position.j), fmaxf(out_bounds->maximum.k, position.k) };
+	}
+
+	out_bounds->center = (out_bounds->minimum + out_bounds->maximum) * 0.5f;
+	float radius_squared = 0.0f;
+	for (dword i = 0; i < vertex_count; i++)
+	{
+		const vector3d& position = vertices[i].vertex.position;
+		const float i_delta = position.i - out_bounds->center.i;
+		const float j_delta = position.j - out_bounds->center.j;
+		const float k_delta = position.k - out_bounds->center.k;
+		radius_squared = fmaxf(radius_squared, i_delta * i_delta + j_delta * j_delta + k_delta * k_delta);
+	}
+	out_bounds->radius = sqrtf(radius_squared);
+}
+
+float compute_tex_coord_density(const void* const vertices, const dword vertex_stride, const void* const indices, const e_mesh_index_format index_format, const dword index_count)
+{
+	const ubyte* const vertex_data = static_cast<const ubyte*>(vertices);
+	const auto get_vertex = [vertex_data, vertex_stride, indices, index_format](const dword index) -> const vertex_part&
+	{
+		const dword vertex_index = index_format == _mesh_index_format_16 ? static_cast<const uword*>(indices)[index] : static_cast<const dword*>(indices)[index];
+		return *reinterpret_cast<const vertex_part*>(vertex_data + static_cast<qword>(vertex_index) * vertex_stride);
+	};
+
+	double surface_area = 0.0;
+	double tex_coord_area = 0.0;
+	for (dword i = 0; i + 2 < index_count; i += 3)
+	{
+		const vertex_part& a = get_vertex(i);
+		const vertex_part& b = get_vertex(i + 1);
+		const vertex_part& c = get_vertex(i + 2);
+
+		const float ab[3] = { b.position.i - a.position.i, b.position.j - a.position.j, b.position.k - a.position.k };
+		const float ac[3] = { c.position.i - a.position.i, c.position.j - a.position.j, c.position.k - a.position.k };
+		const float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+		surface_area += 0.5 * sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+		const float uv_ab[2] = { b.tex_coord.x - a.tex_coord.x, b.tex_coord.y - a.tex_coord.y };
+		const float uv_ac[2] = { c.tex_coord.x - a.tex_coord.x, c.tex_coord.y - a.tex_coord.y };
+		tex_coord_area += 0.5 * fabs(uv_ab[0] * uv_ac[1] - uv_ab[1] * uv_ac[0]);
+	}
+
+	return surface_area > 0.0 ? static_cast<float>(sqrt(tex_coord_area / surface_area)) : 0.0f;
+}
@@ -1,12 +1,48 @@
 #pragma once
 #include <types.h>
 #include <render/render.h>
+#include <asset/mesh_format.h>
 #ifdef API_DX12
 #include <d3d12.h>
 #endif
 
+// Model space axis aligned bounding box & bounding sphere
+struct s_geometry_bounds
+{
+	vector3d minimum;
+	vector3d maximum;
+	vector3d center;
+	float radius;
+};
+
+// Range of the index buffer drawn for one level of detail
+struct s_geometry_lod
+{
+	dword index_offset;
+	dword index_count;
+	float error; // model space distance from the full detail surface
+};
+
+// Cluster of the first level of detail, drawn as its own index range when cull_mesh can't rule it out
+struct s_geometry_meshlet
+{
+	vector3d center; // bounding sphere, model space
+	float radius;
+	vector3d cone_axis;
+	float cone_cutoff; // sine of the cone's half angle, 1 if the meshlet can't be back face culled
+	dword index_offset;
+	dword index_count;
+};
+
 struct s_geometry_resources
 {
+	s_geometry_bounds bounds;
+	s_geometry_lod lods[MESH_FILE_MAXIMUM_LODS]; // most detailed first, all share the vertex & index buffers
+	dword lod_count;
+	s_geometry_meshlet* meshlets; // owned by the mesh, nullptr if the mesh has none
+	dword meshlet_count;
+	e_mesh_vertex_format vertex_format; // picks the input layout & vertex shader drawing this
+	float tex_coord_density; // UV units per model space unit across the full detail level, 0 if unknown
 #ifdef API_DX12
 	ID3D12Resource* vertex_buffer; // GPU memory
 	D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view;
@@ -16,15 +52,42 @@ struct s_geometry_resources
 #endif
 };
 
+class c_asset_archive;
+
+// UV units per model space unit, the square root of the triangles' total UV area over their total surface area
+// vertices may be any layout starting with a vertex_part, such as vertex. Returns 0 if the triangles have no area
+float compute_tex_coord_density(const void* const vertices, const dword vertex_stride, const void* const indices, const e_mesh_index_format index_format, const dword index_count);
+
+// Fit a box around the vertex positions, and a sphere around the box centre
+void compute_geometry_bounds(const vertex vertices[], const dword vertex_count, s_geometry_bounds* const out_bounds);
+
 class c_mesh
 {
 public:
 	c_mesh(c_renderer* const renderer, vertex vertices[], dword vertices_size, dword indices[], dword indices_size);
 	c_mesh(c_renderer* const renderer, const wchar_t* const file_path);
+	c_mesh(c_renderer* const renderer, const c_asset_archive* const archive, const char* const name);
+	// Draws the renderer's placeholder until set_streamed_resources is called
+	c_mesh(c_renderer* const renderer);
 	~c_mesh();
 
 	const s_geometry_resources* const get_resources() const { return &m_resources; };
+	const s_geometry_bounds* const get_bounds() const { return &m_resources.bounds; };
+	const float get_tex_coord_density() const { return m_resources.tex_coord_density; };
+	const dword get_lod_count() const { return m_resources.lod_count; };
+	const s_geometry_meshlet* const get_meshlets() const { return m_resources.meshlets; };
+	const dword get_meshlet_count() const { return m_resources.meshlet_count; };
+	// Clamped to the coarsest level, a placeholder may have fewer levels than the mesh streaming in
+	// Meshes that failed to load have no levels, their zeroed first level draws nothing
+	const s_geometry_lod* const get_lod(const dword lod) const { return &m_resources.lods[lod < m_resources.lod_count ? lod : (m_resources.lod_count > 0 ? m_resources.lod_count - 1 : 0)]; };
+
+	// Swap in streamed resources, which the mesh then owns. Only call between frames
+	// Returns true if resources this owned were replaced, they're copied to out_replaced for the caller to retire
+	// The placeholder is never released, so the previous frame may still draw it
+	bool set_streamed_resources(const s_geometry_resources* const resources, s_geometry_resources* const out_replaced);
+	const bool is_placeholder() const { return m_placeholder; };
 
 private:
 	s_geometry_resources m_resources;
+	bool m_placeholder; // m_resources belong to the renderer
 };
\ No newline at end of file
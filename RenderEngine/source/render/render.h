@@ -9,14 +9,25 @@
 #endif
 #include <render/constants.h>
 #include <render/material.h>
+#include <asset/mesh_format.h>
 
-// Root constant used for values which change frequently and require fast access
-// Float constants have a size limit of 4 bytes (1 double word)
-struct s_object_cb
+// Shared by every object drawn from the same view, set once per frame
+// Matrices are transposed for the gpu
+struct s_view_cb
 {
-	matrix4x4 m_projection;
 	matrix4x4 m_view;
-	matrix4x4 m_world;
+	matrix4x4 m_projection;
+	matrix4x4 m_view_projection;
+};
+
+// Set for each object, anything the same for every object belongs in s_view_cb
+struct s_object_cb
+{
+	// Transposed world matrix without its last column, which is always (0, 0, 0, 1), read as a float4x3 by the gpu
+	vector4d m_world[3];
+	// Compact vertices store positions normalised across the mesh bounds, model position = offset + position * scale
+	vector4d m_position_scale;
+	vector4d m_position_offset;
 };
 
 struct s_material_properties_cb
@@ -116,7 +127,9 @@ enum e_shader_input;
 struct s_texture_resources;
 struct s_geometry_resources;
 struct s_shader_resources;
+struct s_shader_description;
 class c_scene;
+class c_upload_batch;
 class c_renderer
 {
 public:
@@ -124,16 +137,25 @@ public:
 
 	virtual bool initialise(const HWND hWnd) = 0;
 	virtual void render_frame(c_scene* const scene, dword fps_counter) = 0;
+	virtual void set_view_constant_buffer(const s_view_cb& cbuffer) = 0;
 	virtual void set_object_constant_buffer(const s_object_cb& cbuffer, const dword object_index) = 0;
-	virtual void set_material_constant_buffer(const s_material_properties_cb& cbuffer, const dword object_index) = 0;
 	virtual void set_lights_constant_buffer(const s_light_properties_cb& cbuffer) = 0;
 	virtual void set_post_constant_buffer(const s_post_parameters_cb& cbuffer) = 0;
 	virtual bool wait_for_previous_frame() = 0;
 	virtual bool load_texture(const e_texture_type texture_type, const wchar_t* const file_path, s_texture_resources* const out_resources) = 0;
 	virtual bool create_geometry(vertex vertices[], dword vertices_size, dword indices[], dword indices_size, s_geometry_resources* const out_resources) = 0;
 	virtual bool load_model(const wchar_t* const file_path, s_geometry_resources* const out_resources) = 0;
-	virtual bool create_shader(const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type, s_shader_resources* out_resources) = 0;
+	virtual bool load_texture_from_memory(const e_texture_type texture_type, const ubyte* const data, const qword data_size, const dword maximum_size, const wchar_t* const debug_name, s_texture_resources* const out_resources, c_upload_batch* const upload_batch) = 0;
+	virtual void retire_texture(const s_texture_resources* const resources) = 0;
+	virtual void retire_geometry(const s_geometry_resources* const resources) = 0;
+	virtual void retire_shader(const s_shader_resources* const resources) = 0;
+	virtual bool load_model_from_memory(const ubyte* const data, const qword data_size, const wchar_t* const debug_name, s_geometry_resources* const out_resources, c_upload_batch* const upload_batch) = 0;
+	virtual c_upload_batch* create_upload_batch() = 0;
+	virtual bool create_shader(const s_shader_description* const description, const bool reloading, s_shader_resources* const out_resources) = 0;
+	virtual dword reload_shaders(const wchar_t* const file_path) = 0;
 	virtual qword get_gbuffer_textureid(e_gbuffers gbuffer_type) const = 0;
+	virtual const s_geometry_resources* const get_placeholder_geometry() const = 0;
+	virtual const s_texture_resources* const get_placeholder_texture(const e_texture_type texture_type) const = 0;
 
 protected:
 	s_object_cb m_object_cb; // cb per object
@@ -1,14 +1,22 @@
 #include "shader.h"
 #include <render/render.h>
+#include <reporting/report.h>
+#include <cassert>
 #ifdef API_DX12
 #include <render/api/directx12/helpers.h>
 #include <d3d12.h>
 #endif
 
-c_shader::c_shader(c_renderer* const renderer, const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type)
+c_shader::c_shader(const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type, const e_mesh_vertex_format vertex_format)
 	: m_resources()
+	, m_description()
 {
-	renderer->create_shader(vs_path, vs_name, ps_path, ps_name, input_type, &m_resources);
+	wcscpy_s(m_description.vs_path, MAXIMUM_PATH, vs_path);
+	strcpy_s(m_description.vs_name, MAXIMUM_SHADER_ENTRY_POINT, vs_name);
+	wcscpy_s(m_description.ps_path, MAXIMUM_PATH, ps_path);
+	strcpy_s(m_description.ps_name, MAXIMUM_SHADER_ENTRY_POINT, ps_name);
+	m_description.input_type = input_type;
+	m_description.vertex_format = vertex_format;
 }
 
 c_shader::~c_shader()
@@ -16,9 +24,57 @@ c_shader::~c_shader()
 #ifdef API_DX12
 	ID3DBlob* dx12_vertex_shader = (ID3DBlob*)m_resources.vertex_shader;
 	ID3DBlob* dx12_pixel_shader = (ID3DBlob*)m_resources.pixel_shader;
-	ID3D12PipelineState* dx12_pipeline_state = (ID3D12PipelineState*)m_resources.pixel_shader;
+	ID3D12PipelineState* dx12_pipeline_state = (ID3D12PipelineState*)m_resources.pipeline_state;
 	SAFE_RELEASE(dx12_vertex_shader);
 	SAFE_RELEASE(dx12_pixel_shader);
 	SAFE_RELEASE(dx12_pipeline_state);
 #endif
 }
+
+void c_shader::set_resources(const s_shader_resources* const resources)
+{
+	assert(resources != nullptr && m_resources.pipeline_state == nullptr);
+	m_resources = *resources;
+}
+
+void c_shader::add_ps_define(const char* const name, const char* const value)
+{
+	const bool valid_arguments = name != nullptr && value != nullptr && m_resources.pipeline_state == nullptr;
+	assert(valid_arguments);
+	if (!valid_arguments)
+	{
+		LOG_WARNING(L"invalid arguments in call! aborting");
+		return;
+	}
+	const bool defines_full = !IN_RANGE_COUNT(m_description.ps_define_count, 0, MAXIMUM_SHADER_DEFINES);
+	assert(!defines_full);
+	if (defines_full)
+	{
+		LOG_WARNING(L"could not define %hs, %s %hs already has the maximum defines!", name, m_description.ps_path, m_description.ps_name);
+		return;
+	}
+
+	s_shader_define& define = m_description.ps_defines[m_description.ps_define_count++];
+	strcpy_s(define.name, MAXIMUM_SHADER_DEFINE_LENGTH, name);
+	strcpy_s(define.value, MAXIMUM_SHADER_DEFINE_LENGTH, value);
+}
+
+const bool c_shader::uses_file(const wchar_t* const file_path) const
+{
+	return _wcsicmp(m_description.vs_path, file_path) == 0 || _wcsicmp(m_description.ps_path, file_path) == 0;
+}
+
+bool c_shader::reload(c_renderer* const renderer)
+{
+	s_shader_resources resources = {};
+	if (!renderer->create_shader(&m_description, true, &resources))
+	{
+		return K_FAILURE;
+	}
+
+	// The frame still in flight may be drawing with the previous pipeline state
+	renderer->retire_shader(&m_resources);
+	m_resources = resources;
+	LOG_MESSAGE(L"reloaded %s %hs & %s %hs", m_description.vs_path, m_description.vs_name, m_description.ps_path, m_description.ps_name);
+	return K_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <types.h>
+#include <asset/mesh_format.h>
 
 
 struct s_shader_resources
@@ -10,16 +11,55 @@ struct s_shader_resources
 	void* pipeline_state; // ID3D12PipelineState*
 };
 
+// Longest entry point name a shader keeps to reload with
+constexpr dword MAXIMUM_SHADER_ENTRY_POINT = 64;
+// Most preprocessor defines a shader can be specialised with, & the longest name or value of one
+constexpr dword MAXIMUM_SHADER_DEFINES = 8;
+constexpr dword MAXIMUM_SHADER_DEFINE_LENGTH = 32;
+
+struct s_shader_define
+{
+	char name[MAXIMUM_SHADER_DEFINE_LENGTH];
+	char value[MAXIMUM_SHADER_DEFINE_LENGTH];
+};
+
 class c_renderer;
 enum e_shader_input;
+
+// Everything needed to compile a shader's vertex & pixel shaders and create its pipeline state
+struct s_shader_description
+{
+	wchar_t vs_path[MAXIMUM_PATH];
+	char vs_name[MAXIMUM_SHADER_ENTRY_POINT];
+	wchar_t ps_path[MAXIMUM_PATH];
+	char ps_name[MAXIMUM_SHADER_ENTRY_POINT];
+	e_shader_input input_type;
+	e_mesh_vertex_format vertex_format; // picks the input layout the vertex shader reads
+	s_shader_define ps_defines[MAXIMUM_SHADER_DEFINES]; // specialise the pixel shader, e.g. for a material permutation
+	dword ps_define_count;
+};
+
 class c_shader
 {
 public:
-	c_shader(c_renderer* const renderer, const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type);
+	// Nothing is compiled here, the renderer creates every shader's resources together so they can compile in parallel
+	c_shader(const wchar_t* vs_path, const char* vs_name, const wchar_t* ps_path, const char* ps_name, const e_shader_input input_type, const e_mesh_vertex_format vertex_format = _mesh_vertex_format_full);
 	~c_shader();
 
 	const s_shader_resources* const get_resources() const { return &m_resources; };
+	const s_shader_description* const get_description() const { return &m_description; };
+	// Takes ownership of resources, only for the renderer creating this shader
+	void set_resources(const s_shader_resources* const resources);
+	// Define name as value when compiling the pixel shader, only before the shader's resources are created
+	void add_ps_define(const char* const name, const char* const value);
+
+	// Whether file_path is compiled as this shader's vertex or pixel shader, includes aren't tracked
+	const bool uses_file(const wchar_t* const file_path) const;
+	// Compile both files again & swap the new pipeline state in, only call between frames
+	// The previous pipeline state is retired through the renderer, and kept if compiling fails
+	bool reload(c_renderer* const renderer);
 
 private:
 	s_shader_resources m_resources;
-};
\ No newline at end of file
+	s_shader_description m_description;
+};
@@ -1,6 +1,9 @@
 #include "texture.h"
 #include <render/render.h>
 #include <render/material.h>
+#include <render/texture_cache.h>
+#include <asset/archive.h>
+#include <reporting/report.h>
 #ifdef API_DX12
 #include <render/api/directx12/helpers.h>
 #include <d3d12.h>
@@ -8,15 +11,91 @@
 
 c_render_texture::c_render_texture(c_renderer* const renderer, const wchar_t* const file_path, e_texture_type type = _texture_diffuse)
 	: m_type(type)
+	, m_placeholder(false)
+	, m_streaming(false)
+	, m_reference_count(1)
+	, m_cache(nullptr)
+	, m_cache_key(0)
 {
 	const bool texture_loaded = renderer->load_texture(m_type, file_path, &m_resources);
 	assert(texture_loaded);
 }
 
+c_render_texture::c_render_texture(c_renderer* const renderer, const c_asset_archive* const archive, const char* const name, e_texture_type type)
+	: m_type(type)
+	, m_resources()
+	, m_placeholder(false)
+	, m_streaming(false)
+	, m_reference_count(1)
+	, m_cache(nullptr)
+	, m_cache_key(0)
+{
+	wchar_t debug_name[MAXIMUM_PATH] = {};
+	swprintf_s(debug_name, MAXIMUM_PATH, L"%hs", name);
+
+	const s_archive_entry* const entry = archive->find(name);
+	if (entry == nullptr || entry->type != _archive_entry_texture)
+	{
+		LOG_WARNING(L"texture %s is not in the asset archive!", debug_name);
+		return;
+	}
+
+	const bool texture_loaded = renderer->load_texture_from_memory(m_type, archive->get_data(entry), entry->data_size, 0, debug_name, &m_resources, nullptr);
+	assert(texture_loaded);
+}
+
+c_render_texture::c_render_texture(c_renderer* const renderer, e_texture_type type)
+	: m_type(type)
+	, m_resources(*renderer->get_placeholder_texture(type))
+	, m_placeholder(true)
+	, m_streaming(false)
+	, m_reference_count(1)
+	, m_cache(nullptr)
+	, m_cache_key(0)
+{
+}
+
 c_render_texture::~c_render_texture()
 {
+	if (m_placeholder)
+	{
+		return;
+	}
+
 #ifdef API_DX12
 	ID3D12Resource* dx12_resource = (ID3D12Resource*)m_resources.resource;
 	SAFE_RELEASE(dx12_resource)
 #endif
 }
+
+void c_render_texture::release()
+{
+	assert(m_reference_count > 0);
+	m_reference_count--;
+	if (m_reference_count > 0)
+	{
+		return;
+	}
+
+	if (m_cache != nullptr)
+	{
+		m_cache->remove(this);
+	}
+	delete this;
+}
+
+bool c_render_texture::set_streamed_resources(const s_texture_resources* const resources, s_texture_resources* const out_replaced)
+{
+	assert(resources != nullptr && out_replaced != nullptr);
+
+	// Textures are streamed again at a different size as the mips they need change
+	const bool replaced = !m_placeholder;
+	if (replaced)
+	{
+		*out_replaced = m_resources;
+	}
+
+	m_resources = *resources;
+	m_placeholder = false;
+	return replaced;
+}
@@ -40,6 +40,13 @@ enum e_texture_type
 
 struct s_texture_resources
 {
+	dword width; // of the most detailed mip loaded
+	dword height;
+	dword mip_count; // loaded
+	dword skipped_mip_count; // most detailed mips left out of a texture streamed in at a maximum size
+	dword full_width; // with every mip loaded
+	dword full_height;
+	qword resident_size; // bytes of video memory, 0 for the renderer's shared placeholders
 #ifdef API_DX12
 	// TODO: forward declare
 	void* resource; // ID3D12Resource*
@@ -48,16 +55,44 @@ struct s_texture_resources
 
 class c_material;
 class c_renderer;
+class c_asset_archive;
+class c_texture_cache;
+// Reference counted, as materials share textures. Created with one reference owned by the creator
 class c_render_texture
 {
 public:
 	c_render_texture(c_renderer* const renderer, const wchar_t* const file_path, e_texture_type type);
-	~c_render_texture();
+	c_render_texture(c_renderer* const renderer, const c_asset_archive* const archive, const char* const name, e_texture_type type);
+	// Binds the renderer's placeholder for this type until set_streamed_resources is called
+	c_render_texture(c_renderer* const renderer, e_texture_type type);
+
+	// Not thread safe, references are only taken & dropped on the main thread
+	inline void add_reference() { m_reference_count++; };
+	// Deletes the texture once the last reference is dropped, removing it from its cache if it has one
+	void release();
+	inline const dword get_reference_count() const { return m_reference_count; };
 
 	const s_texture_resources* const get_resources() { return &m_resources; };
 	const e_texture_type get_type() { return m_type; };
 
+	// Swap in a streamed texture, which this then owns. Only call between frames
+	// Returns true if resources this owned were replaced, they're copied to out_replaced for the caller to retire
+	bool set_streamed_resources(const s_texture_resources* const resources, s_texture_resources* const out_replaced);
+	const bool is_placeholder() const { return m_placeholder; };
+	// Set by the asset streamer from the request until update() swaps the result in, or drops it if the load failed
+	inline void set_streaming(const bool streaming) { m_streaming = streaming; };
+	const bool is_streaming() const { return m_streaming; };
+
 private:
+	friend class c_texture_cache;
+	// Only release deletes textures, as something else may still hold a reference
+	~c_render_texture();
+
 	e_texture_type m_type;
 	s_texture_resources m_resources;
+	bool m_placeholder; // m_resources belong to the renderer
+	bool m_streaming;
+	dword m_reference_count;
+	c_texture_cache* m_cache; // nullptr if this wasn't created by a cache
+	qword m_cache_key;
 };
\ No newline at end of file
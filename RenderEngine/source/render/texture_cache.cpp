@@ -0,0 +1,130 @@
+#include "texture_cache.h"
+#include <render/texture_residency.h>
+#include <asset/archive.h>
+#include <reporting/report.h>
+
+c_texture_cache::c_texture_cache(c_renderer* const renderer, c_asset_streamer* const streamer, c_texture_residency* const residency, const c_asset_archive* const archive)
+	: m_renderer(renderer)
+	, m_streamer(streamer)
+	, m_residency(residency)
+	, m_archive(archive)
+	, m_textures()
+	, m_request_count(0)
+	, m_hit_count(0)
+{
+}
+
+c_texture_cache::~c_texture_cache()
+{
+	for (auto& cached_texture : m_textures)
+	{
+		cached_texture.second->m_cache = nullptr;
+	}
+}
+
+c_render_texture* c_texture_cache::acquire(const char* const name, const e_texture_type type, const e_stream_priority priority)
+{
+	const bool arguments_valid = name != nullptr && IN_RANGE_COUNT(type, 0, k_default_textures_count);
+	assert(arguments_valid);
+	if (!arguments_valid)
+	{
+		LOG_WARNING(L"invalid args! returning nullptr");
+		return nullptr;
+	}
+
+	m_request_count++;
+	const qword key = this->get_key(name, type);
+	const auto cached_texture = m_textures.find(key);
+	if (cached_texture != m_textures.end())
+	{
+		m_hit_count++;
+		cached_texture->second->add_reference();
+		return cached_texture->second;
+	}
+
+	// The cache holds no reference of its own, the one the texture starts with goes to the caller
+	c_render_texture* const texture = new c_render_texture(m_renderer, type);
+	texture->m_cache = this;
+	texture->m_cache_key = key;
+	m_textures.emplace(key, texture);
+	if (m_residency != nullptr)
+	{
+		m_residency->add(texture, name, priority);
+	}
+	else
+	{
+		m_streamer->request_texture(texture, name, priority, 0);
+	}
+	return texture;
+}
+
+bool c_texture_cache::reload(const char* const name)
+{
+	assert(name != nullptr);
+
+	// The file is a separate texture for each type it was acquired as
+	c_render_texture* textures[k_default_textures_count] = {};
+	for (dword type = 0; type < k_default_textures_count; type++)
+	{
+		const auto cached_texture = m_textures.find(this->get_key(name, static_cast<e_texture_type>(type)));
+		if (cached_texture == m_textures.end())
+		{
+			continue;
+		}
+		if (cached_texture->second->is_streaming())
+		{
+			return false;
+		}
+		textures[type] = cached_texture->second;
+	}
+
+	for (c_render_texture* const texture : textures)
+	{
+		if (texture == nullptr)
+		{
+			continue;
+		}
+		if (m_residency != nullptr)
+		{
+			m_residency->reload(texture);
+		}
+		else
+		{
+			m_streamer->request_texture(texture, name, _stream_priority_high, 0);
+		}
+	}
+	return true;
+}
+
+void c_texture_cache::remove(c_render_texture* const texture)
+{
+	const auto cached_texture = m_textures.find(texture->m_cache_key);
+	assert(cached_texture != m_textures.end() && cached_texture->second == texture);
+	if (cached_texture == m_textures.end() || cached_texture->second != texture)
+	{
+		LOG_WARNING(L"texture is not in this cache!");
+		return;
+	}
+	m_textures.erase(cached_texture);
+	if (m_residency != nullptr)
+	{
+		m_residency->remove(texture);
+	}
+}
+
+qword c_texture_cache::get_key(const char* const name, const e_texture_type type) const
+{
+	// The packer stores identical files once, so within an archive the data offset identifies the content
+	qword content_key = hash_archive_name(name);
+	if (m_archive != nullptr && m_archive->is_open())
+	{
+		const s_archive_entry* const entry = m_archive->find(content_key);
+		if (entry != nullptr)
+		{
+			content_key = entry->data_offset;
+		}
+	}
+
+	// Same FNV-1a step as the name hash, folding in the type
+	return (content_key ^ static_cast<qword>(type)) * 0x100000001B3ull;
+}
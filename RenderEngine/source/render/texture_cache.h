@@ -0,0 +1,47 @@
+#pragma once
+#include <types.h>
+#include <render/texture.h>
+#include <asset/asset_streamer.h>
+#include <unordered_map>
+
+class c_renderer;
+class c_asset_archive;
+class c_texture_residency;
+
+// Hands out shared textures, so an asset used by several materials is decoded & uploaded once
+// Archive entries are keyed by their content, names packed from identical files share one texture. Loose files are keyed by name
+class c_texture_cache
+{
+public:
+	// archive may be nullptr or closed, matching the streamer
+	// New textures are handed to residency to stream their mips as they're needed, without one every mip is streamed up front
+	c_texture_cache(c_renderer* const renderer, c_asset_streamer* const streamer, c_texture_residency* const residency, const c_asset_archive* const archive);
+	// Textures still referenced are left to their owners, they just stop being shared
+	~c_texture_cache();
+
+	// Returns a new reference the caller must release, streaming the texture in the first time it's requested
+	// The same file requested as a different type is a separate texture, as the type picks its shader register
+	c_render_texture* acquire(const char* const name, const e_texture_type type, const e_stream_priority priority);
+	// Stream every texture acquired from name again, for a file changed on disk. Textures sharing its archive data change with it
+	// Returns false without requesting anything if one is still streaming, call again on a later frame
+	bool reload(const char* const name);
+
+	inline const dword get_texture_count() const { return static_cast<dword>(m_textures.size()); };
+	inline const dword get_request_count() const { return m_request_count; };
+	// Requests served by a texture which was already loaded or streaming
+	inline const dword get_hit_count() const { return m_hit_count; };
+
+private:
+	friend class c_render_texture;
+	// Called by c_render_texture::release when the last reference is dropped
+	void remove(c_render_texture* const texture);
+	qword get_key(const char* const name, const e_texture_type type) const;
+
+	c_renderer* const m_renderer;
+	c_asset_streamer* const m_streamer;
+	c_texture_residency* const m_residency;
+	const c_asset_archive* const m_archive;
+	std::unordered_map<qword, c_render_texture*> m_textures;
+	dword m_request_count;
+	dword m_hit_count;
+};
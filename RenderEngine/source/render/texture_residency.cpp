@@ -0,0 +1,274 @@
+#include "texture_residency.h"
+#include <render/texture.h>
+#include <render/material.h>
+#include <scene/scene.h>
+#include <reporting/report.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// Block compressed textures can only be created from a mip which is a whole number of blocks across
+constexpr dword TEXTURE_BLOCK_SIZE = 4;
+
+static dword get_mip_size(const dword size, const dword mip)
+{
+	const dword mip_size = mip < 32 ? size >> mip : 0;
+	return mip_size > 1 ? mip_size : 1;
+}
+
+static dword get_full_mip_count(const s_texture_resources* const resources)
+{
+	return resources->skipped_mip_count + resources->mip_count;
+}
+
+// Largest side of a mip, the renderer loads every mip no wider or taller than this
+static dword get_maximum_size(const s_texture_resources* const resources, const dword mip)
+{
+	return std::max(get_mip_size(resources->full_width, mip), get_mip_size(resources->full_height, mip));
+}
+
+// Eviction never goes past the mip textures are first streamed at, or past a mip the renderer can't create on its own
+static dword get_coarsest_mip(const s_texture_resources* const resources)
+{
+	const dword last_mip = get_full_mip_count(resources) - 1;
+	dword mip = 0;
+	while (mip < last_mip && get_maximum_size(resources, mip) > TEXTURE_STREAMING_INITIAL_SIZE)
+	{
+		const dword next_width = resources->full_width >> (mip + 1);
+		const dword next_height = resources->full_height >> (mip + 1);
+		if (next_width < TEXTURE_BLOCK_SIZE || next_height < TEXTURE_BLOCK_SIZE || next_width % TEXTURE_BLOCK_SIZE != 0 || next_height % TEXTURE_BLOCK_SIZE != 0)
+		{
+			break;
+		}
+		mip++;
+	}
+	return mip;
+}
+
+// Each mip is a quarter the size of the one before, so this is close to what the renderer allocates
+static qword estimate_size(const s_texture_resources* const resources, const dword mip)
+{
+	const int32 mip_delta = static_cast<int32>(resources->skipped_mip_count) - static_cast<int32>(mip);
+	return static_cast<qword>(ldexp(static_cast<double>(resources->resident_size), 2 * mip_delta));
+}
+
+c_texture_residency::c_texture_residency(c_asset_streamer* const streamer, const qword budget)
+	: m_streamer(streamer)
+	, m_budget(budget)
+	, m_frame(0)
+	, m_textures()
+	, m_statistics()
+{
+}
+
+void c_texture_residency::add(c_render_texture* const texture, const char* const name, const e_stream_priority priority)
+{
+	const bool arguments_valid = texture != nullptr && texture->is_placeholder() && name != nullptr;
+	assert(arguments_valid);
+	if (!arguments_valid)
+	{
+		LOG_WARNING(L"texture must be a placeholder! ignoring");
+		return;
+	}
+
+	s_resident_texture resident_texture = {};
+	strcpy_s(resident_texture.name, MAXIMUM_PATH, name);
+	resident_texture.priority = priority;
+	resident_texture.needed_mip = UINT_MAX;
+	resident_texture.last_needed_frame = m_frame;
+	s_resident_texture* const added_texture = &m_textures.emplace(texture, resident_texture).first->second;
+
+	m_streamer->request_texture(texture, added_texture->name, priority, TEXTURE_STREAMING_INITIAL_SIZE);
+}
+
+void c_texture_residency::remove(c_render_texture* const texture)
+{
+	assert(texture != nullptr && !texture->is_streaming());
+	m_textures.erase(texture);
+}
+
+void c_texture_residency::reload(c_render_texture* const texture)
+{
+	assert(texture != nullptr && !texture->is_streaming());
+	const auto resident_texture = m_textures.find(texture);
+	if (resident_texture == m_textures.end())
+	{
+		LOG_WARNING(L"texture isn't managed here! ignoring");
+		return;
+	}
+
+	// A texture which never loaded starts over from its small mips, the file may have been broken until now
+	if (texture->is_placeholder())
+	{
+		resident_texture->second.every_mip_requested = false;
+		m_streamer->request_texture(texture, resident_texture->second.name, _stream_priority_high, TEXTURE_STREAMING_INITIAL_SIZE);
+		return;
+	}
+	this->request(texture, &resident_texture->second, texture->get_resources()->skipped_mip_count, _stream_priority_high);
+}
+
+void c_texture_residency::request(c_render_texture* const texture, s_resident_texture* const resident_texture, const dword mip, const e_stream_priority priority)
+{
+	resident_texture->requested_mip = mip;
+	m_streamer->request_texture(texture, resident_texture->name, priority, get_maximum_size(texture->get_resources(), mip));
+}
+
+void c_texture_residency::update(c_scene* const scene)
+{
+	m_frame++;
+
+	// Most detailed mip each texture needs, from every visible object using it
+	for (c_scene_object* const object : *scene->get_objects())
+	{
+		const c_mesh* const model = object->get_model();
+		const c_material* const material = object->get_material();
+		if (model == nullptr || material == nullptr || object->get_draw_ranges()->empty())
+		{
+			continue;
+		}
+
+		// Texels across the whole texture which keep one to each pixel, meshes with no measured density are assumed to map a unit of UV to each unit of surface
+		const float tex_coord_density = model->get_tex_coord_density() > 0.0f ? model->get_tex_coord_density() : 1.0f;
+		const float needed_size = object->get_pixels_per_unit() / tex_coord_density;
+		for (dword i = 0; i < material->get_maximum_textures(); i++)
+		{
+			c_render_texture* const texture = material->get_texture(i);
+			const auto resident_texture = m_textures.find(texture);
+			if (resident_texture == m_textures.end())
+			{
+				continue;
+			}
+			resident_texture->second.last_needed_frame = m_frame;
+			if (texture->is_placeholder())
+			{
+				continue;
+			}
+
+			// Coarsest mip still at least as big as the screen needs
+			const s_texture_resources* const resources = texture->get_resources();
+			const dword full_mip_count = get_full_mip_count(resources);
+			dword mip = 0;
+			while (mip + 1 < full_mip_count && static_cast<float>(get_maximum_size(resources, mip + 1)) >= needed_size)
+			{
+				mip++;
+			}
+			resident_texture->second.needed_mip = std::min(resident_texture->second.needed_mip, mip);
+		}
+	}
+
+	// Size of every texture, counting the larger of the old & new mips for those still streaming
+	m_statistics = {};
+	m_statistics.budget = m_budget;
+	m_statistics.texture_count = static_cast<dword>(m_textures.size());
+	qword resident_size = 0;
+	std::vector<std::pair<c_render_texture*, s_resident_texture*>> upgrades;
+	std::vector<std::pair<c_render_texture*, s_resident_texture*>> evictions;
+	for (auto& managed_texture : m_textures)
+	{
+		c_render_texture* const texture = managed_texture.first;
+		s_resident_texture* const resident_texture = &managed_texture.second;
+		const s_texture_resources* const resources = texture->get_resources();
+		const bool needed = resident_texture->last_needed_frame == m_frame;
+		const dword needed_mip = resident_texture->needed_mip;
+		resident_texture->needed_mip = UINT_MAX;
+
+		if (texture->is_streaming())
+		{
+			m_statistics.streaming_count++;
+			resident_size += texture->is_placeholder() ? 0 : std::max(resources->resident_size, estimate_size(resources, resident_texture->requested_mip));
+			continue;
+		}
+		if (texture->is_placeholder())
+		{
+			// The small mips of a texture that isn't a whole number of blocks across at that size can't be created alone
+			if (!resident_texture->every_mip_requested)
+			{
+				resident_texture->every_mip_requested = true;
+				m_statistics.streaming_count++;
+				m_streamer->request_texture(texture, resident_texture->name, resident_texture->priority, 0);
+			}
+			continue;
+		}
+
+		resident_size += resources->resident_size;
+		const dword resident_mip = resources->skipped_mip_count;
+		const dword coarsest_mip = get_coarsest_mip(resources);
+		if (needed && needed_mip < resident_mip)
+		{
+			resident_texture->requested_mip = needed_mip;
+			upgrades.push_back({ texture, resident_texture });
+		}
+		else if (resident_mip < coarsest_mip && (!needed || needed_mip > resident_mip))
+		{
+			// Detail nothing on screen is using, kept until the budget needs it back
+			resident_texture->requested_mip = needed ? std::min(needed_mip, coarsest_mip) : coarsest_mip;
+			evictions.push_back({ texture, resident_texture });
+		}
+	}
+
+	// Textures missing the most mips first, they look the worst
+	std::sort(upgrades.begin(), upgrades.end(), [](const auto& a, const auto& b)
+	{
+		const dword a_missing_mips = a.first->get_resources()->skipped_mip_count - a.second->requested_mip;
+		const dword b_missing_mips = b.first->get_resources()->skipped_mip_count - b.second->requested_mip;
+		return a_missing_mips > b_missing_mips;
+	});
+	// Needed longest ago first, then the most detail going unused
+	std::sort(evictions.begin(), evictions.end(), [](const auto& a, const auto& b)
+	{
+		if (a.second->last_needed_frame != b.second->last_needed_frame)
+		{
+			return a.second->last_needed_frame < b.second->last_needed_frame;
+		}
+		return a.second->requested_mip - a.first->get_resources()->skipped_mip_count > b.second->requested_mip - b.first->get_resources()->skipped_mip_count;
+	});
+
+	// Evictions only free memory once they're swapped in, so a texture waiting on one is upgraded on a later frame
+	qword shortfall = resident_size > m_budget ? resident_size - m_budget : 0;
+	for (auto& upgrade : upgrades)
+	{
+		if (m_statistics.streaming_count >= MAXIMUM_STREAMING_TEXTURES)
+		{
+			break;
+		}
+
+		// Settle for the most detail that fits
+		c_render_texture* const texture = upgrade.first;
+		const s_texture_resources* const resources = texture->get_resources();
+		const dword needed_mip = upgrade.second->requested_mip;
+		dword mip = needed_mip;
+		while (mip < resources->skipped_mip_count && resident_size - resources->resident_size + estimate_size(resources, mip) > m_budget)
+		{
+			mip++;
+		}
+		if (mip > needed_mip)
+		{
+			m_statistics.starved_count++;
+			shortfall += resident_size - resources->resident_size + estimate_size(resources, needed_mip) - m_budget;
+		}
+		if (mip < resources->skipped_mip_count)
+		{
+			resident_size += estimate_size(resources, mip) - resources->resident_size;
+			m_statistics.streaming_count++;
+			this->request(texture, upgrade.second, mip, upgrade.second->priority);
+		}
+	}
+
+	for (auto& eviction : evictions)
+	{
+		if (shortfall == 0 || m_statistics.streaming_count >= MAXIMUM_STREAMING_TEXTURES)
+		{
+			break;
+		}
+
+		c_render_texture* const texture = eviction.first;
+		const s_texture_resources* const resources = texture->get_resources();
+		const qword freed_size = resources->resident_size - estimate_size(resources, eviction.second->requested_mip);
+		shortfall = freed_size < shortfall ? shortfall - freed_size : 0;
+		m_statistics.streaming_count++;
+		m_statistics.evicted_count++;
+		this->request(texture, eviction.second, eviction.second->requested_mip, _stream_priority_low);
+	}
+
+	m_statistics.resident_size = resident_size;
+}
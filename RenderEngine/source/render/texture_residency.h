@@ -0,0 +1,68 @@
+#pragma once
+#include <types.h>
+#include <asset/asset_streamer.h>
+#include <unordered_map>
+
+class c_render_texture;
+class c_scene;
+
+// Textures are first streamed with only the mips this wide & tall, so every texture in a scene shows something before any detail is needed
+constexpr dword TEXTURE_STREAMING_INITIAL_SIZE = 64;
+// Textures loading at once, each one holds its old & new mips in video memory until it's swapped in
+constexpr dword MAXIMUM_STREAMING_TEXTURES = 8;
+
+struct s_resident_texture
+{
+	char name[MAXIMUM_PATH]; // archive name, e.g. "textures/sponza/vase_dif.dds"
+	e_stream_priority priority;
+	dword needed_mip; // most detailed mip a visible object needed this frame
+	qword last_needed_frame; // eviction takes the textures needed longest ago first
+	dword requested_mip; // valid while the texture is streaming
+	bool every_mip_requested; // the small mips couldn't be created alone, so the whole texture was requested instead
+};
+
+struct s_texture_residency_statistics
+{
+	qword resident_size; // video memory held by managed textures, including mips still loading
+	qword budget;
+	dword texture_count;
+	dword streaming_count;
+	dword starved_count; // needed at a more detailed mip than the budget left room for
+	dword evicted_count; // textures which gave up mips this frame
+};
+
+// Keeps streamed textures at the mips the scene needs within a video memory budget
+// Each frame every visible object works out the mip its material's textures need, from how many pixels its nearest point covers
+// & how much of the texture its mesh spreads over each unit of surface. Missing mips are streamed in the background,
+// and when the budget runs out the textures needed least recently give up their detailed mips first
+// Changing a texture's mips loads it again at the new size through the asset streamer, which retires the old one
+class c_texture_residency
+{
+public:
+	// budget is in bytes of video memory, only the textures added here count towards it
+	c_texture_residency(c_asset_streamer* const streamer, const qword budget);
+
+	// Start streaming a placeholder texture's small mips, name is its archive name
+	void add(c_render_texture* const texture, const char* const name, const e_stream_priority priority);
+	// Stop managing texture before it's deleted, it must not still be streaming
+	void remove(c_render_texture* const texture);
+	// Stream texture again at the mips it has now, for a file changed on disk. It must not still be streaming
+	void reload(c_render_texture* const texture);
+
+	// Request mips for the objects visible in the scene's last cull, call after setup_for_render
+	void update(c_scene* const scene);
+
+	inline void set_budget(const qword budget) { m_budget = budget; };
+	inline const qword get_budget() const { return m_budget; };
+	// From the last update
+	inline const s_texture_residency_statistics* const get_statistics() const { return &m_statistics; };
+
+private:
+	void request(c_render_texture* const texture, s_resident_texture* const resident_texture, const dword mip, const e_stream_priority priority);
+
+	c_asset_streamer* const m_streamer;
+	qword m_budget;
+	qword m_frame;
+	std::unordered_map<c_render_texture*, s_resident_texture> m_textures;
+	s_texture_residency_statistics m_statistics;
+};
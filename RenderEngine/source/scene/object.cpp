@@ -1,27 +1,36 @@
 #include "object.h"
 #include <reporting/report.h>
+#include <scene/scene.h>
+#include <cmath>
+
+// Largest on screen error allowed from a simplified level of detail
+constexpr float LOD_PIXEL_ERROR = 1.0f;
+// Levels are only coarsened once their error falls this far under LOD_PIXEL_ERROR, so objects near a switch distance don't flicker between levels
+constexpr float LOD_HYSTERESIS = 0.75f;
 
 // default constructor
 c_scene_object::c_scene_object()
 	: m_transform()
-	, m_model(nullptr)
+	, m_scene(nullptr)
+	, m_model()
 	, m_material()
+	, m_lod(0)
+	, m_pixels_per_unit(0.0f)
 	, m_has_update_function(false)
 {
 }
 
-c_scene_object::c_scene_object(const char* name, c_mesh* model, c_material* material, const point3d position, const point3d rotation, const point3d scale)
+c_scene_object::c_scene_object(const char* name, c_scene* const scene, const s_mesh_handle model, const s_material_handle material, const point3d position, const point3d rotation, const point3d scale)
 	: m_name(name)
 	, m_transform()
-	, m_model(model)
-	, m_material(material)
+	, m_scene(scene)
+	, m_model(scene->m_meshes.add_reference(model))
+	, m_material(scene->m_materials.add_reference(material))
+	, m_lod(0)
+	, m_pixels_per_unit(0.0f)
 	, m_has_update_function(false)
 {
-	//if (!c_asset_manager::get()->retrieve_render_model(&m_render_model, rm_dir))
-	//{
-	//	LOG_WARNING(L"failed to retrieve render model %ls", rm_dir);
-	//	m_render_model = nullptr;
-	//}
+	assert(scene->m_meshes.get(model) != nullptr && scene->m_materials.get(material) != nullptr);
 	m_transform.set_position(position);
 	m_transform.set_rotation_euler(rotation);
 	m_transform.set_scale(scale);
@@ -29,13 +38,27 @@ c_scene_object::c_scene_object(const char* name, c_mesh* model, c_material* mate
 
 c_scene_object::~c_scene_object()
 {
-	//if (m_render_model != nullptr)
-	//	m_render_model->unreference();
-	// TODO: UNREFERENCE RATHER THAN DELETE IN CASE BEING USED ELSEWHERE
-	if (m_model != nullptr)
-		delete m_model;
-	if (m_material != nullptr)
-		delete m_material;
+	// Other objects may still be using these, the registry deletes them with the last reference
+	if (m_scene != nullptr)
+	{
+		m_scene->m_meshes.release(m_model);
+		m_scene->m_materials.release(m_material);
+	}
+}
+
+const c_mesh* const c_scene_object::get_model() const
+{
+	return m_scene != nullptr ? m_scene->m_meshes.get(m_model) : nullptr;
+}
+
+c_material* const c_scene_object::get_material()
+{
+	return m_scene != nullptr ? m_scene->m_materials.get(m_material) : nullptr;
+}
+
+const c_material* const c_scene_object::get_material() const
+{
+	return m_scene != nullptr ? m_scene->m_materials.get(m_material) : nullptr;
 }
 
 void c_scene_object::update(const float delta_time)
@@ -47,32 +70,95 @@ void c_scene_object::update(const float delta_time)
 	}
 }
 
-void c_scene_object::setup_for_render(c_camera* const camera, c_renderer* const renderer, const dword index)
+void c_scene_object::update_visibility(const c_camera* const camera, const s_view_frustum& frustum, s_culling_statistics* const statistics)
+{
+	m_draw_ranges.clear();
+	m_pixels_per_unit = 0.0f;
+	const c_mesh* const model = this->get_model();
+	if (model == nullptr)
+	{
+		return;
+	}
+
+	const matrix4x4 world = m_transform.build_matrix();
+	m_pixels_per_unit = this->measure_pixels_per_unit(camera, world);
+	this->select_lod();
+	cull_mesh(model, m_lod, world, m_transform.get_scale(), camera, frustum, &m_draw_ranges, statistics);
+}
+
+void c_scene_object::setup_for_render(c_renderer* const renderer, const dword index)
 {
 #if API_DIRECTX
+	// The view & projection are the same for every object, so they're set once by the scene
 	s_object_cb cbuffer;
-	cbuffer.m_view = camera->get_view();
-	cbuffer.m_projection = camera->get_projection();
-	cbuffer.m_world = m_transform.build_matrix();
-
-	// must transpose wvp matrix for the gpu
-	XMMATRIX transposed = XMLoadFloat4x4((XMFLOAT4X4*)&cbuffer.m_view);
-	transposed = XMMatrixTranspose(transposed);
-	XMStoreFloat4x4((XMFLOAT4X4*)&cbuffer.m_view, transposed);
-	transposed = XMLoadFloat4x4((XMFLOAT4X4*)&cbuffer.m_projection);
-	transposed = XMMatrixTranspose(transposed);
-	XMStoreFloat4x4((XMFLOAT4X4*)&cbuffer.m_projection, transposed);
-	transposed = XMLoadFloat4x4((XMFLOAT4X4*)&cbuffer.m_world);
-	transposed = XMMatrixTranspose(transposed);
-	XMStoreFloat4x4((XMFLOAT4X4*)&cbuffer.m_world, transposed);
+	const matrix4x4 world = m_transform.build_matrix();
+	// XMStoreFloat3x4 transposes for the gpu as it stores, dropping the world matrix's constant last column
+	XMStoreFloat3x4((XMFLOAT3X4*)cbuffer.m_world, XMLoadFloat4x4((const XMFLOAT4X4*)&world));
+
+	// Only read by the compact vertex shader
+	const s_geometry_bounds* const bounds = this->get_model()->get_bounds();
+	cbuffer.m_position_scale = vector4d(bounds->maximum.x - bounds->minimum.x, bounds->maximum.y - bounds->minimum.y, bounds->maximum.z - bounds->minimum.z, 0.0f);
+	cbuffer.m_position_offset = vector4d(bounds->minimum.x, bounds->minimum.y, bounds->minimum.z, 0.0f);
 
 	// copy our ConstantBuffer instance to the mapped constant buffer resource
+	// Materials aren't set here, the renderer keeps its own copy of each & only uploads it when it changes
 	renderer->set_object_constant_buffer(cbuffer, index);
+#endif
+}
+
+float c_scene_object::measure_pixels_per_unit(const c_camera* const camera, const matrix4x4& world)
+{
+	float pixels_per_unit = 0.0f;
+#if API_DIRECTX
+	// Measured at the nearest point of the bounding sphere
+	const s_geometry_bounds* const bounds = this->get_model()->get_bounds();
+	const point3d scale = m_transform.get_scale();
+	const float maximum_scale = fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+	const XMVECTOR world_center = XMVector3Transform(XMLoadFloat3((const XMFLOAT3*)&bounds->center), XMLoadFloat4x4((const XMFLOAT4X4*)&world));
+	const point3d camera_position = camera->get_position();
+	const float center_distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(world_center, XMLoadFloat3((const XMFLOAT3*)&camera_position))));
+	const float distance = fmaxf(center_distance - bounds->radius * maximum_scale, camera->get_clip_depth().min);
+	const float pixels_per_radian = camera->get_resolution().height / (2.0f * tanf(XMConvertToRadians(camera->get_field_of_view()) * 0.5f));
+	pixels_per_unit = pixels_per_radian * maximum_scale / distance;
+#endif
+	return pixels_per_unit;
+}
 
-	// copy material data to constant buffer
-	s_material_properties_cb material_cb;
-	material_cb.m_material = m_material->m_properties;
-	renderer->set_material_constant_buffer(material_cb, index);
+void c_scene_object::select_lod()
+{
+	const c_mesh* const model = this->get_model();
+	const dword lod_count = model != nullptr ? model->get_lod_count() : 0;
+	if (lod_count <= 1)
+	{
+		m_lod = 0;
+		return;
+	}
+	m_lod = m_lod < lod_count ? m_lod : lod_count - 1;
+
+#if API_DIRECTX
+	const float pixels_per_unit = m_pixels_per_unit;
+
+	// Coarsest level within the error limit, errors only grow with each level
+	const auto get_coarsest_lod = [model, lod_count, pixels_per_unit](const float pixel_error)
+	{
+		dword lod = lod_count - 1;
+		while (lod > 0 && model->get_lod(lod)->error * pixels_per_unit > pixel_error)
+		{
+			lod--;
+		}
+		return lod;
+	};
+
+	const dword lod = get_coarsest_lod(LOD_PIXEL_ERROR);
+	if (lod < m_lod)
+	{
+		m_lod = lod;
+	}
+	else if (lod > m_lod)
+	{
+		const dword hysteresis_lod = get_coarsest_lod(LOD_PIXEL_ERROR * LOD_HYSTERESIS);
+		m_lod = hysteresis_lod > m_lod ? hysteresis_lod : m_lod;
+	}
 #endif
 }
 
@@ -3,20 +3,28 @@
 #include <render/camera.h>
 #include <render/render.h>
 #include <render/model.h>
+#include <render/cluster_culling.h>
 #include <functional>
 #include <render/material.h>
+#include <scene/resource_registry.h>
 
+typedef s_resource_handle<c_mesh> s_mesh_handle;
+typedef s_resource_handle<c_material> s_material_handle;
+
+class c_scene;
 // An instance of a loaded render model with a matrix
 // Can have a single render model used by multiple scene objects
 class c_scene_object
 {
 public:
 	c_scene_object();
+	// Takes its own reference to model & material from the scene's registries, the caller keeps theirs
 	c_scene_object
 	(
 		const char* name,
-		c_mesh* model,
-		c_material* material,
+		c_scene* const scene,
+		const s_mesh_handle model,
+		const s_material_handle material,
 		const point3d position = WORLD_ORIGIN,
 		const point3d rotation = DEFAULT_EULER_ROTATION,
 		const point3d scale = DEFAULT_SCALE
@@ -24,21 +32,40 @@ public:
 	~c_scene_object();
 
 	void update(const float delta_time);
-	void setup_for_render(c_camera* const camera, c_renderer* const renderer, const dword index);
+	// Picks the level of detail & the index ranges to draw this frame, call before setup_for_render
+	void update_visibility(const c_camera* const camera, const s_view_frustum& frustum, s_culling_statistics* const statistics);
+	void setup_for_render(c_renderer* const renderer, const dword index);
 	void add_update_function(std::function<void()> func);
 
-	const c_mesh* const get_model() const { return m_model; };
-	c_material* const get_material() { return m_material; };
-	const c_material* const get_material() const { return m_material; };
+	// Level of detail picked by the last update_visibility
+	inline const dword get_lod() const { return m_lod; };
+	// Screen pixels covered by one model space unit at the object's nearest point, from the last update_visibility
+	inline const float get_pixels_per_unit() const { return m_pixels_per_unit; };
+	// Empty when the object is entirely out of view
+	inline const std::vector<s_draw_range>* const get_draw_ranges() const { return &m_draw_ranges; };
+
+	// nullptr if the object has no scene
+	const c_mesh* const get_model() const;
+	c_material* const get_material();
+	const c_material* const get_material() const;
+	// Unique among the scene's materials while the object holds it, for tables indexed by material
+	inline const dword get_material_index() const { return m_material.index; };
 
 	const char* m_name;
 	c_transform m_transform;
 
 private:
-	// TODO: USE SMART POINTERS FOR THESE SO MULTIPLE OBJECTS CAN SHARE AND TRACK REFERENCES W/O DELETING IN USE RESOURCES
+	float measure_pixels_per_unit(const c_camera* const camera, const matrix4x4& world);
+	// From the pixels per unit, which must already be measured
+	void select_lod();
+
 	// TODO: multiple meshes w/ their own material in c_model?
-	c_mesh* m_model;
-	c_material* m_material;
+	c_scene* const m_scene; // owns the registries model & material are held in
+	s_mesh_handle m_model;
+	s_material_handle m_material;
+	dword m_lod;
+	float m_pixels_per_unit;
+	std::vector<s_draw_range> m_draw_ranges;
 	bool m_has_update_function;
 	std::function<void()> m_update_function; // Allows you to attach code to control the object
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <types.h>
+#include <reporting/report.h>
+#include <vector>
+
+// Reference to a registered resource, stays safe to hold after the resource is freed
+// A freed slot's generation is bumped, so stale handles stop resolving rather than reaching whatever reuses the slot
+template<typename t_resource>
+struct s_resource_handle
+{
+	dword index;
+	dword generation; // 0 is never handed out, a zeroed handle is invalid
+
+	inline const bool is_valid() const { return generation != 0; };
+	inline bool operator==(const s_resource_handle& other) const { return index == other.index && generation == other.generation; };
+	inline bool operator!=(const s_resource_handle& other) const { return !(*this == other); };
+};
+
+// Owns heap allocated resources shared through reference counted handles
+// Not thread safe, references are only taken & dropped on the main thread
+template<typename t_resource>
+class c_resource_registry
+{
+public:
+	typedef s_resource_handle<t_resource> t_handle;
+
+	c_resource_registry()
+		: m_slots()
+		, m_free_slots()
+		, m_count(0)
+	{
+	}
+
+	// Anything still referenced is leaked by its owners, delete it rather than leaving the GPU memory behind
+	~c_resource_registry()
+	{
+		if (m_count > 0)
+		{
+			LOG_WARNING(L"%d resources were still referenced on shutdown! deleting them", m_count);
+		}
+		for (s_slot& slot : m_slots)
+		{
+			delete slot.resource;
+		}
+	}
+
+	// Takes ownership of resource, the returned handle holds its first reference
+	t_handle add(t_resource* const resource)
+	{
+		const bool resource_valid = resource != nullptr;
+		assert(resource_valid);
+		if (!resource_valid)
+		{
+			LOG_WARNING(L"resource was nullptr! returning invalid handle");
+			return t_handle();
+		}
+
+		dword index = 0;
+		if (m_free_slots.empty())
+		{
+			index = static_cast<dword>(m_slots.size());
+			m_slots.push_back(s_slot{ nullptr, 1, 0 });
+		}
+		else
+		{
+			index = m_free_slots.back();
+			m_free_slots.pop_back();
+		}
+
+		s_slot& slot = m_slots[index];
+		slot.resource = resource;
+		slot.reference_count = 1;
+		m_count++;
+		return t_handle{ index, slot.generation };
+	}
+
+	// Returns handle so a copy can be taken inline
+	t_handle add_reference(const t_handle handle)
+	{
+		s_slot* const slot = this->get_slot(handle);
+		if (slot != nullptr)
+		{
+			slot->reference_count++;
+		}
+		return handle;
+	}
+
+	// Deletes the resource once its last reference is released
+	void release(const t_handle handle)
+	{
+		s_slot* const slot = this->get_slot(handle);
+		if (slot == nullptr)
+		{
+			return;
+		}
+
+		assert(slot->reference_count > 0);
+		slot->reference_count--;
+		if (slot->reference_count > 0)
+		{
+			return;
+		}
+
+		delete slot->resource;
+		slot->resource = nullptr;
+		// Skip 0 on wrap around, it marks invalid handles
+		slot->generation = slot->generation + 1 == 0 ? 1 : slot->generation + 1;
+		m_free_slots.push_back(handle.index);
+		m_count--;
+	}
+
+	// Returns nullptr for invalid or stale handles
+	t_resource* const get(const t_handle handle) const
+	{
+		const s_slot* const slot = this->get_slot(handle);
+		return slot != nullptr ? slot->resource : nullptr;
+	}
+
+	inline const dword get_count() const { return m_count; };
+	// Every handle's index is below this, for sizing tables indexed by handle
+	inline const dword get_slot_count() const { return static_cast<dword>(m_slots.size()); };
+	inline const dword get_reference_count(const t_handle handle) const
+	{
+		const s_slot* const slot = this->get_slot(handle);
+		return slot != nullptr ? slot->reference_count : 0;
+	}
+
+private:
+	struct s_slot
+	{
+		t_resource* resource;
+		dword generation;
+		dword reference_count;
+	};
+
+	s_slot* const get_slot(const t_handle handle)
+	{
+		return const_cast<s_slot*>(static_cast<const c_resource_registry*>(this)->get_slot(handle));
+	}
+	const s_slot* const get_slot(const t_handle handle) const
+	{
+		if (!handle.is_valid() || !IN_RANGE_COUNT(handle.index, 0, static_cast<dword>(m_slots.size())))
+		{
+			return nullptr;
+		}
+		const s_slot* const slot = &m_slots[handle.index];
+		return slot->generation == handle.generation && slot->resource != nullptr ? slot : nullptr;
+	}
+
+	std::vector<s_slot> m_slots;
+	std::vector<dword> m_free_slots;
+	dword m_count; // live resources
+};
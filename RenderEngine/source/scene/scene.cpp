@@ -4,6 +4,9 @@ c_scene::c_scene()
 	: m_lights()
 	, m_ambient_light(0.0f, 0.0f, 0.0f, 1.0f)
 	, m_post_parameters()
+	, m_meshes()
+	, m_materials()
+	, m_culling_statistics()
 {
 	m_objects.reserve(MAXIMUM_SCENE_OBJECTS);
 	m_camera = new c_camera({ 0.0f, -0.0f, -4.0f }, { 0.0f, 0.0f, 1.0f });
@@ -11,6 +14,7 @@ c_scene::c_scene()
 
 c_scene::~c_scene()
 {
+	// Objects release their meshes & materials, anything unreferenced after this is deleted with the registries
 	for (c_scene_object* object : m_objects)
 	{
 		delete object;
@@ -30,6 +34,7 @@ void c_scene::setup_for_render(c_renderer* const renderer)
 {
 	// camera
 	m_camera->update_view();
+	this->cull_objects();
 
 	s_light_properties_cb light_constant_buffer;
 	point3d camera_pos = m_camera->get_position();
@@ -41,17 +46,40 @@ void c_scene::setup_for_render(c_renderer* const renderer)
 	}
 	renderer->set_lights_constant_buffer(light_constant_buffer);
 
+	// view, shared by every object so it's only transposed & uploaded once
+	s_view_cb view_constant_buffer;
+	const matrix4x4 camera_view = m_camera->get_view();
+	const matrix4x4 camera_projection = m_camera->get_projection();
+	const XMMATRIX view = XMLoadFloat4x4((const XMFLOAT4X4*)&camera_view);
+	const XMMATRIX projection = XMLoadFloat4x4((const XMFLOAT4X4*)&camera_projection);
+	// must transpose matrices for the gpu
+	XMStoreFloat4x4((XMFLOAT4X4*)&view_constant_buffer.m_view, XMMatrixTranspose(view));
+	XMStoreFloat4x4((XMFLOAT4X4*)&view_constant_buffer.m_projection, XMMatrixTranspose(projection));
+	XMStoreFloat4x4((XMFLOAT4X4*)&view_constant_buffer.m_view_projection, XMMatrixTranspose(XMMatrixMultiply(view, projection)));
+	renderer->set_view_constant_buffer(view_constant_buffer);
+
 	// objects
 	dword index = 0;
 	for (c_scene_object* object : m_objects)
 	{
-		object->setup_for_render(m_camera, renderer, index++);
+		object->setup_for_render(renderer, index++);
 	}
 
 	// Setup blur parameters for its post processing pass
     renderer->set_post_constant_buffer(m_post_parameters);
 }
 
+void c_scene::cull_objects()
+{
+	s_view_frustum frustum;
+	build_view_frustum(m_camera, &frustum);
+	m_culling_statistics = {};
+	for (c_scene_object* object : m_objects)
+	{
+		object->update_visibility(m_camera, frustum, &m_culling_statistics);
+	}
+}
+
 void c_scene::add_object(c_scene_object* const object)
 {
 	m_objects.push_back(object);
@@ -3,6 +3,7 @@
 #include <render/camera.h>
 #include <render/render.h>
 #include <scene/object.h>
+#include <scene/resource_registry.h>
 #include <vector>
 
 constexpr dword MAXIMUM_SCENE_OBJECTS = 10;
@@ -18,8 +19,11 @@ public:
 
 	void update(const float delta_time);
 	void setup_for_render(c_renderer* const renderer);
+	// Updates every object's level of detail & visible meshlets from the camera's current view
+	void cull_objects();
 	void add_object(c_scene_object* const object);
 	std::vector<c_scene_object*>* const get_objects() { return &m_objects; };
+	const s_culling_statistics* const get_culling_statistics() const { return &m_culling_statistics; };
 
 	s_light m_lights[MAXIMUM_SCENE_LIGHTS];
 	colour_rgba m_ambient_light;
@@ -28,8 +32,13 @@ public:
 
 	c_camera* m_camera;
 
+	// Shared between objects, each object holds a reference to its mesh & material
+	c_resource_registry<c_mesh> m_meshes;
+	c_resource_registry<c_material> m_materials;
+
 private:
 	std::vector<c_scene_object*> m_objects;
+	s_culling_statistics m_culling_statistics; // from the last cull_objects
 	//dword m_active_camera;
 	//dword m_camera_count;
 	//c_camera* m_cameras[MAXIMUM_SCENE_CAMERAS];
@@ -0,0 +1,87 @@
+#include "job_graph.h"
+#include <reporting/report.h>
+#include <cassert>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+
+c_job_graph::c_job_graph()
+	: m_jobs()
+{
+}
+
+dword c_job_graph::add(const std::function<void()>& job, const std::vector<dword>& dependencies)
+{
+	const dword job_index = static_cast<dword>(m_jobs.size());
+	for (const dword dependency : dependencies)
+	{
+		// Jobs can only wait on those added before them, so the graph can never cycle
+		assert(dependency < job_index);
+		m_jobs[dependency].dependents.push_back(job_index);
+	}
+	m_jobs.push_back({ job, {}, static_cast<dword>(dependencies.size()) });
+	return job_index;
+}
+
+void c_job_graph::run(const dword thread_count)
+{
+	const dword job_count = static_cast<dword>(m_jobs.size());
+	std::mutex mutex;
+	std::condition_variable job_condition;
+	std::deque<dword> ready_jobs; // run in the order they were added, once ready
+	dword finished_count = 0;
+	for (dword job = 0; job < job_count; job++)
+	{
+		if (m_jobs[job].dependency_count == 0)
+		{
+			ready_jobs.push_back(job);
+		}
+	}
+
+	const auto worker_main = [this, job_count, &mutex, &job_condition, &ready_jobs, &finished_count]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			job_condition.wait(lock, [job_count, &ready_jobs, &finished_count]() { return !ready_jobs.empty() || finished_count == job_count; });
+			if (ready_jobs.empty())
+			{
+				return;
+			}
+			const dword job = ready_jobs.front();
+			ready_jobs.pop_front();
+
+			lock.unlock();
+			m_jobs[job].function();
+			lock.lock();
+
+			finished_count++;
+			for (const dword dependent : m_jobs[job].dependents)
+			{
+				if (--m_jobs[dependent].dependency_count == 0)
+				{
+					ready_jobs.push_back(dependent);
+				}
+			}
+			job_condition.notify_all();
+		}
+	};
+
+	// No more threads than jobs, most graphs are small
+	const dword helper_count = std::min(std::max(thread_count, 1ul), std::max(job_count, 1ul)) - 1;
+	std::vector<std::thread> helpers;
+	helpers.reserve(helper_count);
+	for (dword i = 0; i < helper_count; i++)
+	{
+		helpers.emplace_back(worker_main);
+	}
+	worker_main();
+	for (std::thread& helper : helpers)
+	{
+		helper.join();
+	}
+
+	m_jobs.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <types.h>
+#include <functional>
+#include <vector>
+
+// Jobs with dependencies between them, run across several threads once everything has been added
+// Each job only starts once every job it depends on has finished
+class c_job_graph
+{
+public:
+	c_job_graph();
+
+	// Returns the job's index for later jobs to depend on, dependencies must have been added already
+	dword add(const std::function<void()>& job, const std::vector<dword>& dependencies = {});
+
+	// Run every job on up to thread_count threads including the calling one, returns once all have finished
+	// Jobs are removed afterwards, so the graph can be filled & run again
+	void run(const dword thread_count);
+
+	inline const dword get_job_count() const { return static_cast<dword>(m_jobs.size()); };
+
+private:
+	struct s_job
+	{
+		std::function<void()> function;
+		std::vector<dword> dependents; // jobs waiting on this one
+		dword dependency_count;
+	};
+
+	std::vector<s_job> m_jobs;
+};
@@ -0,0 +1,284 @@
+#include "archive_writer.h"
+#include <common/report.h>
+#include <asset/archive_format.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+struct s_pending_entry
+{
+	fs::path file_path;
+	std::string name;
+	s_archive_entry entry;
+	uint64_t content_hash;
+	bool duplicate; // shares the blob of an identical file packed before it
+};
+
+static uint64_t align_offset(const uint64_t offset, const uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static bool read_file(const fs::path& file_path, const uint64_t file_size, std::vector<char>* const out_data)
+{
+	std::ifstream input_file(file_path, std::ios::in | std::ios::binary);
+	out_data->resize(file_size);
+	input_file.read(out_data->data(), static_cast<std::streamsize>(out_data->size()));
+	if (input_file.fail())
+	{
+		LOG_WARNING("failed to read %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	return K_SUCCESS;
+}
+
+// 64 bit FNV-1a, only used to find candidates for deduplication so speed matters more than distribution
+static uint64_t hash_content(const std::vector<char>& data)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const char byte : data)
+	{
+		hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+static e_archive_entry_type get_entry_type(const fs::path& file_path)
+{
+	std::string extension = file_path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const char character) { return static_cast<char>(tolower(character)); });
+
+	if (extension == ".mesh")
+	{
+		return _archive_entry_mesh;
+	}
+	if (extension == ".dds")
+	{
+		return _archive_entry_texture;
+	}
+	return _archive_entry_raw;
+}
+
+static void gather_entries(const fs::path& input_directory, std::vector<s_pending_entry>* const out_pending_entries)
+{
+	out_pending_entries->clear();
+	for (const fs::directory_entry& directory_entry : fs::recursive_directory_iterator(input_directory))
+	{
+		if (!directory_entry.is_regular_file() || directory_entry.path().extension() == ".pack" || directory_entry.path().extension() == ".tmp")
+		{
+			continue;
+		}
+
+		s_pending_entry pending_entry = {};
+		pending_entry.file_path = directory_entry.path();
+		pending_entry.name = fs::relative(directory_entry.path(), input_directory).generic_string();
+		pending_entry.entry.name_hash = hash_archive_name(pending_entry.name.c_str());
+		pending_entry.entry.data_size = directory_entry.file_size();
+		pending_entry.entry.type = get_entry_type(directory_entry.path());
+		out_pending_entries->push_back(std::move(pending_entry));
+	}
+}
+
+bool is_archive_up_to_date(const fs::path& input_directory, const fs::path& output_path)
+{
+	std::error_code error;
+	const fs::file_time_type archive_write_time = fs::last_write_time(output_path, error);
+	if (error)
+	{
+		return false;
+	}
+
+	std::ifstream archive_file(output_path, std::ios::in | std::ios::binary);
+	s_archive_file_header header = {};
+	archive_file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (archive_file.fail() || header.signature != ARCHIVE_FILE_SIGNATURE || header.version != ARCHIVE_FILE_VERSION)
+	{
+		return false;
+	}
+	std::vector<s_archive_entry> entries(header.entry_count);
+	archive_file.seekg(static_cast<std::streamoff>(header.entries_offset));
+	archive_file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(s_archive_entry)));
+	if (archive_file.fail())
+	{
+		return false;
+	}
+
+	// Same files at the same sizes, none written since the archive was
+	std::vector<s_pending_entry> pending_entries;
+	gather_entries(input_directory, &pending_entries);
+	if (pending_entries.size() != entries.size())
+	{
+		return false;
+	}
+	std::unordered_map<uint64_t, uint64_t> data_size_by_name;
+	for (const s_archive_entry& entry : entries)
+	{
+		data_size_by_name.emplace(entry.name_hash, entry.data_size);
+	}
+	for (const s_pending_entry& pending_entry : pending_entries)
+	{
+		const auto data_size = data_size_by_name.find(pending_entry.entry.name_hash);
+		if (data_size == data_size_by_name.end() || data_size->second != pending_entry.entry.data_size || fs::last_write_time(pending_entry.file_path, error) > archive_write_time || error)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool write_archive(const fs::path& input_directory, const fs::path& output_path, s_archive_statistics* const out_statistics)
+{
+	*out_statistics = {};
+
+	std::vector<s_pending_entry> pending_entries;
+	gather_entries(input_directory, &pending_entries);
+
+	if (pending_entries.empty())
+	{
+		LOG_WARNING("no files to pack in %s!", input_directory.string().c_str());
+		return K_FAILURE;
+	}
+
+	// The runtime binary searches on hash, so entries are sorted by it & any collision has to be fixed by renaming a file
+	std::sort(pending_entries.begin(), pending_entries.end(), [](const s_pending_entry& a, const s_pending_entry& b) { return a.entry.name_hash < b.entry.name_hash; });
+	for (size_t i = 1; i < pending_entries.size(); i++)
+	{
+		if (pending_entries[i - 1].entry.name_hash == pending_entries[i].entry.name_hash)
+		{
+			LOG_WARNING("%s and %s have the same name hash! rename one of them", pending_entries[i - 1].name.c_str(), pending_entries[i].name.c_str());
+			return K_FAILURE;
+		}
+	}
+
+	// Files with identical contents (the same texture exported under two names, say) are packed once & share a blob
+	// The runtime relies on this, a shared data_offset is how it tells two names refer to the same content
+	std::vector<char> file_data;
+	std::vector<char> other_file_data;
+	std::unordered_map<uint64_t, size_t> first_entry_by_content;
+	for (size_t i = 0; i < pending_entries.size(); i++)
+	{
+		s_pending_entry& pending_entry = pending_entries[i];
+		if (!read_file(pending_entry.file_path, pending_entry.entry.data_size, &file_data))
+		{
+			return K_FAILURE;
+		}
+		pending_entry.content_hash = hash_content(file_data);
+
+		const auto first_entry = first_entry_by_content.find(pending_entry.content_hash);
+		if (first_entry == first_entry_by_content.end())
+		{
+			first_entry_by_content.emplace(pending_entry.content_hash, i);
+			continue;
+		}
+
+		// Hashes only nominate a match, the bytes have to agree before any blob is shared
+		const s_pending_entry& original_entry = pending_entries[first_entry->second];
+		if (original_entry.entry.data_size != pending_entry.entry.data_size || !read_file(original_entry.file_path, original_entry.entry.data_size, &other_file_data))
+		{
+			continue;
+		}
+		pending_entry.duplicate = other_file_data == file_data;
+	}
+
+	// Layout: header, table of contents, names, then each unique file blob, all aligned
+	std::string names;
+	for (s_pending_entry& pending_entry : pending_entries)
+	{
+		pending_entry.entry.name_offset = static_cast<uint32_t>(names.size());
+		names.append(pending_entry.name);
+		names.push_back('\0');
+	}
+
+	s_archive_file_header header = {};
+	header.signature = ARCHIVE_FILE_SIGNATURE;
+	header.version = ARCHIVE_FILE_VERSION;
+	header.entry_count = static_cast<uint32_t>(pending_entries.size());
+	header.entries_offset = align_offset(sizeof(s_archive_file_header), ARCHIVE_DATA_ALIGNMENT);
+	header.names_offset = header.entries_offset + static_cast<uint64_t>(header.entry_count) * sizeof(s_archive_entry);
+	header.names_size = names.size();
+
+	uint64_t data_offset = align_offset(header.names_offset + header.names_size, ARCHIVE_DATA_ALIGNMENT);
+	for (s_pending_entry& pending_entry : pending_entries)
+	{
+		out_statistics->data_size += pending_entry.entry.data_size;
+		if (pending_entry.duplicate)
+		{
+			continue;
+		}
+		pending_entry.entry.data_offset = data_offset;
+		data_offset = align_offset(data_offset + pending_entry.entry.data_size, ARCHIVE_DATA_ALIGNMENT);
+	}
+	for (s_pending_entry& pending_entry : pending_entries)
+	{
+		if (pending_entry.duplicate)
+		{
+			pending_entry.entry.data_offset = pending_entries[first_entry_by_content[pending_entry.content_hash]].entry.data_offset;
+			out_statistics->duplicate_count++;
+			out_statistics->duplicate_size += pending_entry.entry.data_size;
+		}
+	}
+	out_statistics->entry_count = header.entry_count;
+	out_statistics->archive_size = data_offset;
+
+	// Write to a temporary file & swap it in, so a failed pack never leaves a truncated archive behind
+	fs::path temporary_path = output_path;
+	temporary_path += ".tmp";
+	std::error_code error;
+	fs::create_directories(output_path.parent_path(), error);
+	std::ofstream archive_file(temporary_path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	std::vector<char> padding(ARCHIVE_DATA_ALIGNMENT, 0);
+	auto pad_to = [&archive_file, &padding](const uint64_t offset)
+	{
+		const uint64_t position = static_cast<uint64_t>(archive_file.tellp());
+		archive_file.write(padding.data(), static_cast<std::streamsize>(offset - position));
+	};
+
+	archive_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	pad_to(header.entries_offset);
+	for (const s_pending_entry& pending_entry : pending_entries)
+	{
+		archive_file.write(reinterpret_cast<const char*>(&pending_entry.entry), sizeof(s_archive_entry));
+	}
+	archive_file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+	for (const s_pending_entry& pending_entry : pending_entries)
+	{
+		if (pending_entry.duplicate)
+		{
+			continue;
+		}
+		if (!read_file(pending_entry.file_path, pending_entry.entry.data_size, &file_data))
+		{
+			archive_file.close();
+			fs::remove(temporary_path, error);
+			return K_FAILURE;
+		}
+
+		pad_to(pending_entry.entry.data_offset);
+		archive_file.write(file_data.data(), static_cast<std::streamsize>(file_data.size()));
+	}
+	pad_to(out_statistics->archive_size);
+	archive_file.close();
+
+	if (archive_file.fail())
+	{
+		LOG_WARNING("failed to write %s!", temporary_path.string().c_str());
+		fs::remove(temporary_path, error);
+		return K_FAILURE;
+	}
+
+	fs::rename(temporary_path, output_path, error);
+	if (error)
+	{
+		LOG_WARNING("failed to replace %s! (%s)", output_path.string().c_str(), error.message().c_str());
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <common/types.h>
+#include <filesystem>
+
+struct s_archive_statistics
+{
+	uint32_t entry_count;
+	uint64_t data_size; // total of every packed file
+	uint32_t duplicate_count; // files sharing another file's blob
+	uint64_t duplicate_size; // bytes not written thanks to them
+	uint64_t archive_size;
+};
+
+// Pack every cooked file under input_directory into one archive, named by their path relative to input_directory
+// Existing archives in the directory are skipped, so packing can be rerun in place
+// Cook manifests in the directory are packed like any other file, so the engine can check the archive against them
+// Files with identical contents are stored once, with each of their entries pointing at the same data
+bool write_archive(const std::filesystem::path& input_directory, const std::filesystem::path& output_path, s_archive_statistics* const out_statistics);
+
+// Whether the archive at output_path already holds every file under input_directory at its current size, with none written since it was packed
+bool is_archive_up_to_date(const std::filesystem::path& input_directory, const std::filesystem::path& output_path);
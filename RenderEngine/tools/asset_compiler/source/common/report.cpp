@@ -0,0 +1,49 @@
+#include "report.h"
+#include <cstdio>
+#include <cstdarg>
+#include <mutex>
+#include <atomic>
+
+constexpr uint32_t REPORT_STRING_SIZE = 2048;
+
+constexpr const char* g_log_level_titles[k_log_level_count] =
+{
+	"INVALID",
+	"MESSAGE",
+	"WARNING",
+	"-ERROR-"
+};
+
+static std::mutex g_report_mutex;
+static std::atomic<uint32_t> g_report_counts[k_log_level_count];
+
+void generate_report(e_log_level log_level, const char* function_name, const char* message_format, ...)
+{
+	if (log_level <= _log_none || log_level >= k_log_level_count)
+	{
+		return;
+	}
+	g_report_counts[log_level]++;
+
+	char message_buffer[REPORT_STRING_SIZE] = {};
+	va_list list;
+	va_start(list, message_format);
+	vsnprintf(message_buffer, REPORT_STRING_SIZE, message_format, list);
+	va_end(list);
+
+	// Format first, then lock only around the write so lines from worker threads don't interleave
+	std::lock_guard<std::mutex> lock(g_report_mutex);
+	if (log_level == _log_message)
+	{
+		fprintf(stdout, "%s\n", message_buffer);
+	}
+	else
+	{
+		fprintf(stderr, "%s %s(): %s\n", g_log_level_titles[log_level], function_name, message_buffer);
+	}
+}
+
+uint32_t get_report_count(e_log_level log_level)
+{
+	return (log_level > _log_none && log_level < k_log_level_count) ? g_report_counts[log_level].load() : 0;
+}
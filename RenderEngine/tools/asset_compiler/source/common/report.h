@@ -0,0 +1,22 @@
+#pragma once
+#include <common/types.h>
+
+enum e_log_level
+{
+	_log_none,
+
+	_log_message, // printed to stdout
+	_log_warning, // printed to stderr
+	_log_error, // printed to stderr, the tool will exit with a failure code
+
+	k_log_level_count
+};
+
+// Narrow counterparts to the engine's reporting macros, safe to call from worker threads
+#define LOG_MESSAGE(message_format, ...) generate_report(_log_message, __FUNCTION__, message_format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARNING(message_format, ...) generate_report(_log_warning, __FUNCTION__, message_format __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(message_format, ...) generate_report(_log_error, __FUNCTION__, message_format __VA_OPT__(,) __VA_ARGS__)
+void generate_report(e_log_level log_level, const char* function_name, const char* message_format, ...);
+
+// Number of warnings & errors reported so far
+uint32_t get_report_count(e_log_level log_level);
@@ -0,0 +1,130 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+c_thread_pool::c_thread_pool(uint32_t thread_count)
+	: m_threads()
+	, m_jobs()
+	, m_mutex()
+	, m_job_available()
+	, m_stopping(false)
+{
+	if (thread_count == 0)
+	{
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	m_threads.reserve(thread_count);
+	for (uint32_t i = 0; i < thread_count; i++)
+	{
+		m_threads.emplace_back(&c_thread_pool::worker_main, this);
+	}
+}
+
+c_thread_pool::~c_thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_job_available.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void c_thread_pool::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_job_available.notify_one();
+}
+
+void c_thread_pool::worker_main()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_job_available.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+
+			// Drain the queue before stopping so no submitted job is dropped
+			if (m_jobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
+
+c_job_group::c_job_group(c_thread_pool* const thread_pool)
+	: m_thread_pool(thread_pool)
+	, m_state(std::make_shared<s_state>())
+{
+	m_state->pending_count = 0;
+}
+
+c_job_group::~c_job_group()
+{
+	this->wait();
+}
+
+void c_job_group::run(std::function<void()> job)
+{
+	m_state->pending_count++;
+	{
+		std::lock_guard<std::mutex> lock(m_state->mutex);
+		m_state->jobs.push_back(std::move(job));
+	}
+
+	// The pool runs whichever of our jobs is next, it may already have been taken by a waiting thread
+	m_thread_pool->submit([state = m_state] { run_next_job(state.get()); });
+}
+
+bool c_job_group::run_next_job(s_state* const state)
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		if (state->jobs.empty())
+		{
+			return false;
+		}
+		job = std::move(state->jobs.front());
+		state->jobs.pop_front();
+	}
+
+	job();
+	state->pending_count--;
+	return true;
+}
+
+void c_job_group::wait()
+{
+	while (m_state->pending_count > 0)
+	{
+		// Help out rather than block, only with our own jobs so unrelated work can't delay the return
+		if (!run_next_job(m_state.get()))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void parallel_for(c_thread_pool* const thread_pool, const size_t count, const std::function<void(size_t)>& function)
+{
+	c_job_group job_group(thread_pool);
+	for (size_t i = 0; i < count; i++)
+	{
+		job_group.run([&function, i] { function(i); });
+	}
+	job_group.wait();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <common/types.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+// Fixed set of worker threads pulling jobs from a shared FIFO queue
+class c_thread_pool
+{
+public:
+	// thread_count of 0 uses one worker per hardware thread
+	explicit c_thread_pool(uint32_t thread_count = 0);
+	~c_thread_pool();
+
+	c_thread_pool(const c_thread_pool&) = delete;
+	c_thread_pool& operator=(const c_thread_pool&) = delete;
+
+	inline uint32_t get_thread_count() const { return static_cast<uint32_t>(m_threads.size()); };
+
+	void submit(std::function<void()> job);
+
+private:
+	void worker_main();
+
+	std::vector<std::thread> m_threads;
+	std::deque<std::function<void()>> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_job_available;
+	bool m_stopping;
+};
+
+// Tracks a set of jobs submitted to a pool
+// Waiting runs the group's own unstarted jobs on the waiting thread, so jobs can wait on nested groups without starving the pool
+class c_job_group
+{
+public:
+	explicit c_job_group(c_thread_pool* const thread_pool);
+	~c_job_group();
+
+	c_job_group(const c_job_group&) = delete;
+	c_job_group& operator=(const c_job_group&) = delete;
+
+	void run(std::function<void()> job);
+	void wait();
+
+private:
+	// Shared with the pool so queued pool jobs stay valid after the group is gone
+	struct s_state
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+		std::atomic<uint32_t> pending_count;
+	};
+	static bool run_next_job(s_state* const state);
+
+	c_thread_pool* const m_thread_pool;
+	std::shared_ptr<s_state> m_state;
+};
+
+// Call function(index) for every index in [0, count) across the pool & wait for them all
+void parallel_for(c_thread_pool* const thread_pool, const size_t count, const std::function<void(size_t)>& function);
@@ -0,0 +1,8 @@
+#pragma once
+// The engine's types.h assumes MSVC's type sizes (32 bit long) and anonymous structs with constructors, neither of which hold under GCC/Clang
+// so the tool sticks to fixed width types from cstdint
+#include <cstdint>
+#include <cstddef>
+
+constexpr bool K_SUCCESS = true;
+constexpr bool K_FAILURE = false;
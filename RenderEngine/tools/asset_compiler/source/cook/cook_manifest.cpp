@@ -0,0 +1,189 @@
+#include "cook_manifest.h"
+#include <common/report.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// A multiple of the hash's word size, so hashing in chunks gives the same result as hashing the whole file at once
+constexpr size_t HASH_CHUNK_SIZE = 1024 * 1024;
+static_assert(HASH_CHUNK_SIZE % sizeof(uint64_t) == 0);
+
+c_cook_manifest::c_cook_manifest()
+	: m_records()
+{
+}
+
+void c_cook_manifest::read(const fs::path& file_path)
+{
+	m_records.clear();
+
+	std::error_code error;
+	const uintmax_t file_size = fs::file_size(file_path, error);
+	if (error)
+	{
+		return;
+	}
+
+	std::vector<char> data(file_size);
+	std::ifstream input_file(file_path, std::ios::in | std::ios::binary);
+	input_file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+	const s_cook_manifest_header* const header = reinterpret_cast<const s_cook_manifest_header*>(data.data());
+	const bool header_valid = !input_file.fail() && data.size() >= sizeof(s_cook_manifest_header) && header->signature == COOK_MANIFEST_SIGNATURE && header->version == COOK_MANIFEST_VERSION;
+	const uint64_t entries_size = header_valid ? static_cast<uint64_t>(header->entry_count) * sizeof(s_cook_manifest_entry) : 0;
+	const bool contents_valid = header_valid &&
+		sizeof(s_cook_manifest_header) + entries_size + header->names_size == data.size() &&
+		header->names_size > 0 && data.back() == '\0';
+	if (!contents_valid)
+	{
+		LOG_WARNING("%s is invalid or from an older version, cooking everything again", file_path.string().c_str());
+		return;
+	}
+
+	const s_cook_manifest_entry* const entries = reinterpret_cast<const s_cook_manifest_entry*>(data.data() + sizeof(s_cook_manifest_header));
+	const char* const names = data.data() + sizeof(s_cook_manifest_header) + entries_size;
+	for (uint32_t i = 0; i < header->entry_count; i++)
+	{
+		const s_cook_manifest_entry& entry = entries[i];
+		if (entry.name_offset >= header->names_size || entry.source_name_offset >= header->names_size)
+		{
+			LOG_WARNING("%s has an invalid entry, cooking everything again", file_path.string().c_str());
+			m_records.clear();
+			return;
+		}
+
+		s_cook_record record = {};
+		record.name = names + entry.name_offset;
+		record.source_name = names + entry.source_name_offset;
+		record.content_hash = entry.content_hash;
+		record.content_size = entry.content_size;
+		record.source_hash = entry.source_hash;
+		record.source_size = entry.source_size;
+		record.source_write_time = entry.source_write_time;
+		record.settings_hash = entry.settings_hash;
+		m_records.emplace(record.name, std::move(record));
+	}
+}
+
+bool c_cook_manifest::write(const fs::path& file_path) const
+{
+	// Sorted by name so an unchanged cook writes an identical manifest
+	std::vector<const s_cook_record*> records;
+	for (const auto& record : m_records)
+	{
+		records.push_back(&record.second);
+	}
+	std::sort(records.begin(), records.end(), [](const s_cook_record* const a, const s_cook_record* const b) { return a->name < b->name; });
+
+	std::vector<s_cook_manifest_entry> entries;
+	std::string names;
+	for (const s_cook_record* const record : records)
+	{
+		s_cook_manifest_entry entry = {};
+		entry.content_hash = record->content_hash;
+		entry.content_size = record->content_size;
+		entry.source_hash = record->source_hash;
+		entry.source_size = record->source_size;
+		entry.source_write_time = record->source_write_time;
+		entry.settings_hash = record->settings_hash;
+		entry.name_offset = static_cast<uint32_t>(names.size());
+		names.append(record->name);
+		names.push_back('\0');
+		entry.source_name_offset = static_cast<uint32_t>(names.size());
+		names.append(record->source_name);
+		names.push_back('\0');
+		entries.push_back(entry);
+	}
+	if (names.empty())
+	{
+		names.push_back('\0');
+	}
+
+	s_cook_manifest_header header = {};
+	header.signature = COOK_MANIFEST_SIGNATURE;
+	header.version = COOK_MANIFEST_VERSION;
+	header.entry_count = static_cast<uint32_t>(entries.size());
+	header.names_size = names.size();
+
+	// Write to a temporary file & swap it in, so an interrupted cook never leaves a manifest claiming files it didn't finish
+	fs::path temporary_path = file_path;
+	temporary_path += ".tmp";
+	std::error_code error;
+	fs::create_directories(file_path.parent_path(), error);
+	std::ofstream manifest_file(temporary_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	manifest_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	manifest_file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(s_cook_manifest_entry)));
+	manifest_file.write(names.data(), static_cast<std::streamsize>(names.size()));
+	manifest_file.close();
+
+	if (manifest_file.fail())
+	{
+		LOG_WARNING("failed to write %s!", temporary_path.string().c_str());
+		fs::remove(temporary_path, error);
+		return K_FAILURE;
+	}
+
+	fs::rename(temporary_path, file_path, error);
+	if (error)
+	{
+		LOG_WARNING("failed to replace %s! (%s)", file_path.string().c_str(), error.message().c_str());
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+}
+
+const s_cook_record* c_cook_manifest::find(const std::string& name) const
+{
+	const auto record = m_records.find(name);
+	return record != m_records.end() ? &record->second : nullptr;
+}
+
+void c_cook_manifest::set(const s_cook_record& record)
+{
+	m_records[record.name] = record;
+}
+
+void c_cook_manifest::remove(const std::string& name)
+{
+	m_records.erase(name);
+}
+
+bool hash_file(const fs::path& file_path, uint64_t* const out_hash, uint64_t* const out_size)
+{
+	std::ifstream input_file(file_path, std::ios::in | std::ios::binary);
+	if (!input_file.is_open())
+	{
+		LOG_WARNING("failed to open %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	std::vector<char> chunk(HASH_CHUNK_SIZE);
+	uint64_t hash = COOK_HASH_SEED;
+	uint64_t size = 0;
+	while (input_file)
+	{
+		input_file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		const size_t read_size = static_cast<size_t>(input_file.gcount());
+		hash = hash_cooked_content(chunk.data(), read_size, hash);
+		size += read_size;
+	}
+	if (input_file.bad())
+	{
+		LOG_WARNING("failed to read %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	*out_hash = hash;
+	*out_size = size;
+	return K_SUCCESS;
+}
+
+uint64_t get_file_write_time(const fs::path& file_path)
+{
+	std::error_code error;
+	const fs::file_time_type write_time = fs::last_write_time(file_path, error);
+	return error ? 0 : static_cast<uint64_t>(write_time.time_since_epoch().count());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <common/types.h>
+#include <asset/cook_manifest_format.h>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+// What one cooked file was cooked from, an entry of the manifest as the tool uses it
+struct s_cook_record
+{
+	std::string name; // cooked file path relative to the manifest's directory, using '/'
+	std::string source_name; // source file path relative to the directory it was cooked from, using '/'
+	uint64_t content_hash;
+	uint64_t content_size;
+	uint64_t source_hash;
+	uint64_t source_size;
+	uint64_t source_write_time;
+	uint64_t settings_hash;
+};
+
+// Records of every file cooked into a directory, read before cooking & written back after so only changed assets are cooked again
+class c_cook_manifest
+{
+public:
+	c_cook_manifest();
+
+	// A missing manifest reads as empty, an invalid one is ignored with a warning & everything is cooked again
+	void read(const std::filesystem::path& file_path);
+	bool write(const std::filesystem::path& file_path) const;
+
+	// Returns nullptr if nothing was cooked to this name
+	const s_cook_record* find(const std::string& name) const;
+	void set(const s_cook_record& record);
+	void remove(const std::string& name);
+
+	inline const std::unordered_map<std::string, s_cook_record>& get_records() const { return m_records; };
+
+private:
+	std::unordered_map<std::string, s_cook_record> m_records;
+};
+
+// Hash of a whole file's contents, in chunks so large sources aren't read into memory at once
+bool hash_file(const std::filesystem::path& file_path, uint64_t* const out_hash, uint64_t* const out_size);
+
+// File time as stored in the manifest
+uint64_t get_file_write_time(const std::filesystem::path& file_path);
@@ -0,0 +1,414 @@
+#include <common/report.h>
+#include <common/thread_pool.h>
+#include <mesh/mesh_cooker.h>
+#include <texture/texture_cooker.h>
+#include <archive/archive_writer.h>
+#include <cook/cook_manifest.h>
+#include <bit>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <unordered_set>
+
+// Offline asset compiler
+// Cooks meshes into the engine's .MESH format so load_model can upload them without any per vertex work,
+// block compresses textures into .DDS files by their usage
+// and packs cooked assets into a single archive the engine maps once at startup
+// Cooking a directory is incremental, a manifest in the output directory records the source & settings of every cooked file
+// so only assets whose source, options or cooker version changed are cooked again
+
+namespace fs = std::filesystem;
+
+struct s_command_line
+{
+	s_mesh_cook_options mesh_options;
+	s_texture_cook_options texture_options;
+	uint32_t thread_count;
+	bool pack;
+	bool force; // ignore the manifest & cook or pack everything
+	fs::path input_path;
+	fs::path output_path;
+};
+
+// Half the triangles per level, never moving the surface by more than a tenth of the mesh's size
+constexpr s_mesh_lod_options DEFAULT_LOD_OPTIONS = { MESH_FILE_MAXIMUM_LODS, 0.5f, 0.1f, 64 };
+
+static void print_usage()
+{
+	LOG_MESSAGE("usage: asset_compiler [options] <input> <output>");
+	LOG_MESSAGE("       asset_compiler -pack <directory> <output.pack>");
+	LOG_MESSAGE("  <input> is an .obj or .vbo file cooked to the <output> .mesh file, a .tga file cooked to the <output> .dds file,");
+	LOG_MESSAGE("  or a directory whose .obj & .tga files are all cooked in parallel to <output>, preserving the directory structure");
+	LOG_MESSAGE("  directories are cooked incrementally, only files changed since the last cook into <output> are cooked again");
+	LOG_MESSAGE("options:");
+	LOG_MESSAGE("  -pack        pack every file under <directory> into one archive, named by their relative path");
+	LOG_MESSAGE("  -force       cook or pack everything, even files which are up to date");
+	LOG_MESSAGE("  -flipu       invert u texture coordinates (u = 1 - u)");
+	LOG_MESSAGE("  -cw          clockwise winding, counter clockwise by default");
+	LOG_MESSAGE("  -compact     quantized 20 byte vertices, verified against their error bounds");
+	LOG_MESSAGE("  -hflip       flip textures horizontally, matches texconv");
+	LOG_MESSAGE("  -vflip       flip textures vertically, matches texconv");
+	LOG_MESSAGE("  -bc1         BC1 (BC3 with alpha) for albedo textures instead of BC7, half the size at lower quality");
+	LOG_MESSAGE("  -mipfilter <box|kaiser> texture mip filter, defaults to kaiser");
+	LOG_MESSAGE("  -lods <count> levels of detail per mesh including full detail, 1 disables simplification, defaults to %u", MESH_FILE_MAXIMUM_LODS);
+	LOG_MESSAGE("  -j <count>   worker thread count, defaults to one per hardware thread");
+}
+
+static bool parse_command_line(const int argc, char* argv[], s_command_line* const out_command_line)
+{
+	*out_command_line = {};
+	out_command_line->mesh_options.lod_options = DEFAULT_LOD_OPTIONS;
+	out_command_line->texture_options.mip_filter = _mip_filter_kaiser;
+	std::vector<const char*> positional_arguments;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-pack") == 0)
+		{
+			out_command_line->pack = true;
+		}
+		else if (strcmp(argv[i], "-force") == 0)
+		{
+			out_command_line->force = true;
+		}
+		else if (strcmp(argv[i], "-flipu") == 0)
+		{
+			out_command_line->mesh_options.flip_u = true;
+		}
+		else if (strcmp(argv[i], "-cw") == 0)
+		{
+			out_command_line->mesh_options.clockwise = true;
+		}
+		else if (strcmp(argv[i], "-compact") == 0)
+		{
+			out_command_line->mesh_options.compact_vertices = true;
+		}
+		else if (strcmp(argv[i], "-hflip") == 0)
+		{
+			out_command_line->texture_options.flip_horizontal = true;
+		}
+		else if (strcmp(argv[i], "-vflip") == 0)
+		{
+			out_command_line->texture_options.flip_vertical = true;
+		}
+		else if (strcmp(argv[i], "-bc1") == 0)
+		{
+			out_command_line->texture_options.albedo_bc1 = true;
+		}
+		else if (strcmp(argv[i], "-mipfilter") == 0 && i + 1 < argc)
+		{
+			i++;
+			if (strcmp(argv[i], "box") == 0 || strcmp(argv[i], "kaiser") == 0)
+			{
+				out_command_line->texture_options.mip_filter = strcmp(argv[i], "box") == 0 ? _mip_filter_box : _mip_filter_kaiser;
+			}
+			else
+			{
+				LOG_WARNING("unknown mip filter %s", argv[i]);
+				return K_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "-lods") == 0 && i + 1 < argc)
+		{
+			out_command_line->mesh_options.lod_options.maximum_lod_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+		{
+			out_command_line->thread_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (argv[i][0] == '-')
+		{
+			LOG_WARNING("unknown option %s", argv[i]);
+			return K_FAILURE;
+		}
+		else
+		{
+			positional_arguments.push_back(argv[i]);
+		}
+	}
+
+	if (positional_arguments.size() != 2)
+	{
+		return K_FAILURE;
+	}
+	out_command_line->input_path = positional_arguments[0];
+	out_command_line->output_path = positional_arguments[1];
+	return K_SUCCESS;
+}
+
+struct s_cook_job
+{
+	fs::path input_path;
+	fs::path output_path;
+	bool texture; // .tga to .dds, otherwise a mesh
+	std::string name; // output path relative to the output directory, empty when cooking a single file
+	std::string source_name; // input path relative to the input directory
+	s_cook_record record;
+	s_mesh_cook_result mesh_result;
+	s_texture_cook_result texture_result;
+	bool up_to_date; // skipped, the cooked file already matches its source & settings
+	bool succeeded;
+};
+
+static const char* texture_format_name(const e_texture_format format)
+{
+	switch (format)
+	{
+	case _texture_format_bc1: return "BC1";
+	case _texture_format_bc3: return "BC3";
+	case _texture_format_bc4: return "BC4";
+	case _texture_format_bc5: return "BC5";
+	case _texture_format_bc7: return "BC7";
+	}
+	return "unknown";
+}
+
+static std::vector<s_cook_job> gather_jobs(const fs::path& input_path, const fs::path& output_path)
+{
+	std::vector<s_cook_job> jobs;
+	if (!fs::is_directory(input_path))
+	{
+		s_cook_job job = {};
+		job.input_path = input_path;
+		job.output_path = output_path;
+		job.texture = input_path.extension() == ".tga";
+		jobs.push_back(std::move(job));
+		return jobs;
+	}
+
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input_path))
+	{
+		const bool texture = entry.path().extension() == ".tga";
+		if (entry.is_regular_file() && (texture || entry.path().extension() == ".obj"))
+		{
+			const fs::path relative_path = fs::relative(entry.path(), input_path);
+			s_cook_job job = {};
+			job.input_path = entry.path();
+			job.output_path = (output_path / relative_path).replace_extension(texture ? ".dds" : ".mesh");
+			job.texture = texture;
+			job.name = fs::path(relative_path).replace_extension(texture ? ".dds" : ".mesh").generic_string();
+			job.source_name = relative_path.generic_string();
+			jobs.push_back(std::move(job));
+		}
+	}
+
+	// Largest first so a big file doesn't start last and hold up the whole build
+	std::sort(jobs.begin(), jobs.end(), [](const s_cook_job& a, const s_cook_job& b)
+	{
+		const uintmax_t a_size = fs::file_size(a.input_path);
+		const uintmax_t b_size = fs::file_size(b.input_path);
+		return a_size != b_size ? a_size > b_size : a.input_path < b.input_path;
+	});
+	return jobs;
+}
+
+// Everything other than the source that changes a cooked file, a different hash cooks the file again
+static uint64_t get_settings_hash(const s_command_line& command_line, const bool texture)
+{
+	if (texture)
+	{
+		const s_texture_cook_options& options = command_line.texture_options;
+		const uint32_t settings[] = { TEXTURE_COOKER_VERSION, options.flip_horizontal, options.flip_vertical, options.albedo_bc1, static_cast<uint32_t>(options.mip_filter) };
+		return hash_cooked_content(settings, sizeof(settings));
+	}
+
+	const s_mesh_cook_options& options = command_line.mesh_options;
+	const s_mesh_lod_options& lod_options = options.lod_options;
+	const uint32_t settings[] =
+	{
+		MESH_COOKER_VERSION, MESH_FILE_VERSION, options.flip_u, options.clockwise, options.compact_vertices,
+		lod_options.maximum_lod_count, std::bit_cast<uint32_t>(lod_options.triangle_ratio), std::bit_cast<uint32_t>(lod_options.maximum_error), lod_options.minimum_triangle_count
+	};
+	return hash_cooked_content(settings, sizeof(settings));
+}
+
+// Cook a job unless its record in the manifest shows the cooked file is already up to date
+// Sources with the same size & write time as when they were cooked aren't read at all, others are hashed to catch files touched without changing
+static void run_cook_job(s_cook_job* const job, const c_cook_manifest* const manifest, const uint64_t settings_hash, const s_command_line& command_line, c_thread_pool* const thread_pool)
+{
+	s_cook_record* const record = &job->record;
+	record->name = job->name;
+	record->source_name = job->source_name;
+	record->settings_hash = settings_hash;
+	record->source_write_time = get_file_write_time(job->input_path);
+	std::error_code source_error;
+	record->source_size = fs::file_size(job->input_path, source_error);
+
+	const s_cook_record* const previous_record = manifest != nullptr ? manifest->find(job->name) : nullptr;
+	std::error_code output_error;
+	const uintmax_t output_size = fs::file_size(job->output_path, output_error);
+	const bool output_valid =
+		previous_record != nullptr && !output_error && output_size == previous_record->content_size &&
+		previous_record->settings_hash == settings_hash && previous_record->source_name == record->source_name;
+	if (output_valid && !source_error && previous_record->source_size == record->source_size && previous_record->source_write_time == record->source_write_time)
+	{
+		*record = *previous_record;
+		job->up_to_date = true;
+		job->succeeded = true;
+		return;
+	}
+
+	if (!hash_file(job->input_path, &record->source_hash, &record->source_size))
+	{
+		job->succeeded = false;
+		return;
+	}
+	if (output_valid && previous_record->source_hash == record->source_hash)
+	{
+		record->content_hash = previous_record->content_hash;
+		record->content_size = previous_record->content_size;
+		job->up_to_date = true;
+		job->succeeded = true;
+		return;
+	}
+
+	job->succeeded = job->texture
+		? cook_texture(job->input_path, job->output_path, command_line.texture_options, thread_pool, &job->texture_result)
+		: cook_mesh(job->input_path, job->output_path, command_line.mesh_options, thread_pool, &job->mesh_result);
+	job->succeeded = job->succeeded && hash_file(job->output_path, &record->content_hash, &record->content_size);
+}
+
+int main(int argc, char* argv[])
+{
+	s_command_line command_line;
+	if (!parse_command_line(argc, argv, &command_line))
+	{
+		print_usage();
+		return 1;
+	}
+	if (!fs::exists(command_line.input_path))
+	{
+		LOG_ERROR("%s does not exist!", command_line.input_path.string().c_str());
+		return 1;
+	}
+
+	const auto start_time = std::chrono::steady_clock::now();
+	if (command_line.pack)
+	{
+		if (!command_line.force && fs::is_directory(command_line.input_path) && is_archive_up_to_date(command_line.input_path, command_line.output_path))
+		{
+			LOG_MESSAGE("%s is up to date", command_line.output_path.string().c_str());
+			return 0;
+		}
+
+		s_archive_statistics statistics;
+		if (!fs::is_directory(command_line.input_path) || !write_archive(command_line.input_path, command_line.output_path, &statistics))
+		{
+			LOG_ERROR("failed to pack %s", command_line.input_path.string().c_str());
+			return 1;
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		LOG_MESSAGE("packed %u files (%.2f MB) into %s (%.2f MB) in %.2fms", statistics.entry_count, statistics.data_size / (1024.0 * 1024.0), command_line.output_path.string().c_str(), statistics.archive_size / (1024.0 * 1024.0), seconds * 1000.0);
+		if (statistics.duplicate_count > 0)
+		{
+			LOG_MESSAGE("%u duplicate files shared existing data, saving %.2f MB", statistics.duplicate_count, statistics.duplicate_size / (1024.0 * 1024.0));
+		}
+		return 0;
+	}
+
+	c_thread_pool thread_pool(command_line.thread_count);
+	std::vector<s_cook_job> jobs = gather_jobs(command_line.input_path, command_line.output_path);
+
+	// Only directories keep a manifest, a single file is always cooked
+	const bool incremental = fs::is_directory(command_line.input_path);
+	const fs::path manifest_path = command_line.output_path / COOK_MANIFEST_NAME;
+	c_cook_manifest manifest;
+	if (incremental && !command_line.force)
+	{
+		manifest.read(manifest_path);
+	}
+	const uint64_t mesh_settings_hash = get_settings_hash(command_line, false);
+	const uint64_t texture_settings_hash = get_settings_hash(command_line, true);
+
+	// Files are checked & cooked in parallel, large files additionally split their parsing across the same pool
+	c_job_group job_group(&thread_pool);
+	for (s_cook_job& job : jobs)
+	{
+		const uint64_t settings_hash = job.texture ? texture_settings_hash : mesh_settings_hash;
+		job_group.run([&job, &manifest, incremental, settings_hash, &command_line, &thread_pool]
+		{
+			run_cook_job(&job, incremental ? &manifest : nullptr, settings_hash, command_line, &thread_pool);
+		});
+	}
+	job_group.wait();
+
+	if (incremental)
+	{
+		// Cooked files whose source is gone are deleted so they aren't packed, failed files are left out so they're cooked next time
+		c_cook_manifest cooked_manifest;
+		std::unordered_set<std::string> cooked_names;
+		for (const s_cook_job& job : jobs)
+		{
+			cooked_names.insert(job.name);
+			if (job.succeeded)
+			{
+				cooked_manifest.set(job.record);
+			}
+		}
+		for (const auto& record : manifest.get_records())
+		{
+			if (!cooked_names.contains(record.first))
+			{
+				std::error_code error;
+				fs::remove(command_line.output_path / record.first, error);
+				LOG_MESSAGE("removed %s, %s no longer exists", record.first.c_str(), record.second.source_name.c_str());
+			}
+		}
+		cooked_manifest.write(manifest_path);
+	}
+
+	uint32_t up_to_date_count = 0;
+	uint32_t failed_count = 0;
+	uint64_t source_bytes = 0;
+	uint32_t generated_mip_count = 0;
+	double mip_milliseconds = 0.0;
+	for (const s_cook_job& job : jobs)
+	{
+		if (!job.succeeded)
+		{
+			LOG_WARNING("failed to cook %s", job.input_path.string().c_str());
+			failed_count++;
+			continue;
+		}
+		if (job.up_to_date)
+		{
+			up_to_date_count++;
+			continue;
+		}
+		if (job.texture)
+		{
+			const s_texture_cook_result& result = job.texture_result;
+			source_bytes += result.source_size;
+			generated_mip_count += result.mip_count - 1;
+			mip_milliseconds += result.mip_milliseconds;
+			LOG_MESSAGE("%s: %ux%u %s, %u mips in %.2fms, %.2f MB to %.2f MB, PSNR %.2fdB, %.2fms", job.output_path.string().c_str(), result.width, result.height, texture_format_name(result.format), result.mip_count, result.mip_milliseconds, result.source_size / (1024.0 * 1024.0), result.cooked_size / (1024.0 * 1024.0), result.peak_signal_to_noise, result.milliseconds);
+			continue;
+		}
+
+		const s_mesh_cook_result& result = job.mesh_result;
+		source_bytes += result.source_size;
+		LOG_MESSAGE("%s: %u vertices (%u welded), %u triangles in %u meshlets, %.2fms", job.output_path.string().c_str(), result.vertex_count, result.welded_count, result.triangle_count, result.meshlet_count, result.milliseconds);
+		LOG_MESSAGE("    vertex cache: ACMR %.3f to %.3f, ATVR %.3f to %.3f", result.source_cache.acmr, result.cooked_cache.acmr, result.source_cache.atvr, result.cooked_cache.atvr);
+		for (uint32_t lod = 1; lod < result.lod_count; lod++)
+		{
+			LOG_MESSAGE("    lod %u: %u triangles, error %.2e", lod, result.lod_triangle_counts[lod], result.lod_errors[lod]);
+		}
+		if (command_line.mesh_options.compact_vertices)
+		{
+			const s_compact_vertex_error& error = result.compact_error;
+			LOG_MESSAGE("    compact error: position %.2e, normal %.2e, tangent %.2e, uv %.2e", error.position, error.normal, error.tangent, error.tex_coord);
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	LOG_MESSAGE("cooked %zu of %zu assets (%u up to date) on %u threads in %.2fms (%.1f MB/s)", jobs.size() - failed_count - up_to_date_count, jobs.size(), up_to_date_count, thread_pool.get_thread_count(), seconds * 1000.0, seconds > 0.0 ? source_bytes / seconds / (1024.0 * 1024.0) : 0.0);
+
+	if (generated_mip_count > 0)
+	{
+		// Filtering time is summed over textures cooked at the same time, so this is the rate one texture at a time would see
+		LOG_MESSAGE("generated %u mips in %.2fms of filtering (%.0f mips/s)", generated_mip_count, mip_milliseconds, generated_mip_count / (mip_milliseconds / 1000.0));
+	}
+
+	return failed_count == 0 && !jobs.empty() ? 0 : 1;
+}
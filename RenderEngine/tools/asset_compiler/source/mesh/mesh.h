@@ -0,0 +1,45 @@
+#pragma once
+#include <common/types.h>
+#include <asset/mesh_format.h>
+#include <vector>
+#include <cmath>
+
+// Minimal 3 component vector for geometry processing, the engine's vector3d relies on DirectXMath
+struct s_vector3
+{
+	float x;
+	float y;
+	float z;
+};
+
+inline s_vector3 operator+(const s_vector3& a, const s_vector3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline s_vector3 operator-(const s_vector3& a, const s_vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline s_vector3 operator*(const s_vector3& a, const float b) { return { a.x * b, a.y * b, a.z * b }; }
+inline float dot(const s_vector3& a, const s_vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline s_vector3 cross(const s_vector3& a, const s_vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline float length(const s_vector3& a) { return sqrtf(dot(a, a)); }
+// Zero length vectors stay zero, matching XMVector3Normalize
+inline s_vector3 normalise(const s_vector3& a)
+{
+	const float vector_length = length(a);
+	return vector_length > 0.0f ? a * (1.0f / vector_length) : s_vector3{ 0.0f, 0.0f, 0.0f };
+}
+inline s_vector3 load_vector3(const float values[3]) { return { values[0], values[1], values[2] }; }
+inline void store_vector3(const s_vector3& a, float out_values[3]) { out_values[0] = a.x; out_values[1] = a.y; out_values[2] = a.z; }
+
+// Simplified triangle list indexing the same vertices as the full detail mesh
+struct s_mesh_lod
+{
+	std::vector<uint32_t> indices;
+	float error; // model space distance from the full detail surface
+};
+
+// Triangle list mesh in the engine's final vertex layout
+// Indices are always held as 32 bit while cooking, narrowed on write when the vertex count allows
+struct s_mesh
+{
+	std::vector<s_mesh_file_vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<s_mesh_lod> lods; // coarser levels after indices, most detailed first
+	std::vector<s_mesh_file_meshlet> meshlets; // ranges of indices, empty until build_meshlets
+};
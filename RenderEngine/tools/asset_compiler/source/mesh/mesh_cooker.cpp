@@ -0,0 +1,123 @@
+#include "mesh_cooker.h"
+#include <common/report.h>
+#include <mesh/obj_reader.h>
+#include <mesh/vbo_reader.h>
+#include <mesh/normals.h>
+#include <mesh/tangent_frame.h>
+#include <mesh/mesh_writer.h>
+#include <mesh/mesh_simplifier.h>
+#include <mesh/meshlet_builder.h>
+#include <chrono>
+
+// Overdraw ordering may cost this much more vertex cache misses than ordering for the cache alone
+constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+bool cook_mesh(const std::filesystem::path& input_path, const std::filesystem::path& output_path, const s_mesh_cook_options& options, c_thread_pool* const thread_pool, s_mesh_cook_result* const out_result)
+{
+	const auto start_time = std::chrono::steady_clock::now();
+	*out_result = {};
+
+	s_mesh mesh;
+	bool has_normals = true;
+	if (input_path.extension() == ".vbo")
+	{
+		// Already converted by meshconvert, flips & winding were applied then
+		if (!read_vbo(input_path, &mesh))
+		{
+			return K_FAILURE;
+		}
+		out_result->source_size = std::filesystem::file_size(input_path);
+	}
+	else
+	{
+		const s_obj_options obj_options = { options.clockwise };
+		s_obj_statistics obj_statistics;
+		if (!read_obj(input_path, obj_options, thread_pool, &mesh, &obj_statistics))
+		{
+			return K_FAILURE;
+		}
+		has_normals = obj_statistics.has_normals;
+		out_result->source_size = obj_statistics.file_size;
+		out_result->welded_count = obj_statistics.corner_count - static_cast<uint32_t>(mesh.vertices.size());
+
+		if (options.flip_u)
+		{
+			for (s_mesh_file_vertex& vertex : mesh.vertices)
+			{
+				vertex.tex_coord[0] = 1.0f - vertex.tex_coord[0];
+			}
+		}
+	}
+
+	if (!has_normals && !compute_normals(&mesh, options.clockwise))
+	{
+		LOG_WARNING("failed to compute normals for %s!", input_path.string().c_str());
+		return K_FAILURE;
+	}
+	if (!compute_tangent_frame(&mesh))
+	{
+		LOG_WARNING("failed to compute tangent frame for %s!", input_path.string().c_str());
+		return K_FAILURE;
+	}
+	s_mesh_file_bounds bounds;
+	compute_mesh_bounds(mesh, &bounds);
+	generate_mesh_lods(&mesh, bounds.radius, options.lod_options);
+
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	const uint32_t index_count = static_cast<uint32_t>(mesh.indices.size());
+	analyze_vertex_cache(mesh.indices.data(), index_count, vertex_count, &out_result->source_cache);
+	const std::vector<uint32_t> source_indices = mesh.indices;
+	optimize_vertex_cache(mesh.indices.data(), index_count, vertex_count);
+	optimize_overdraw(mesh, mesh.indices.data(), index_count, OVERDRAW_ACMR_THRESHOLD);
+	for (s_mesh_lod& lod : mesh.lods)
+	{
+		optimize_vertex_cache(lod.indices.data(), static_cast<uint32_t>(lod.indices.size()), vertex_count);
+	}
+	// Reorders the full detail indices, which the levels of detail were already built from
+	// Meshlets are seeded in index order so they follow the overdraw order, but grow in their own, so each is cache optimized again
+	build_meshlets(&mesh);
+	optimize_meshlet_vertex_caches(&mesh);
+
+	// The overdraw & meshlet passes trade away some cache hits, which can leave a mesh already written in a good order worse off
+	// Meshlets are grown from the source order as well, & whichever order transforms fewer vertices is kept
+	s_vertex_cache_statistics optimized_cache;
+	analyze_vertex_cache(mesh.indices.data(), index_count, vertex_count, &optimized_cache);
+	if (optimized_cache.acmr >= out_result->source_cache.acmr)
+	{
+		std::vector<uint32_t> optimized_indices = source_indices;
+		std::vector<s_mesh_file_meshlet> optimized_meshlets;
+		mesh.indices.swap(optimized_indices);
+		mesh.meshlets.swap(optimized_meshlets);
+		build_meshlets(&mesh);
+		optimize_meshlet_vertex_caches(&mesh);
+
+		s_vertex_cache_statistics source_order_cache;
+		analyze_vertex_cache(mesh.indices.data(), index_count, vertex_count, &source_order_cache);
+		if (source_order_cache.acmr >= optimized_cache.acmr)
+		{
+			mesh.indices.swap(optimized_indices);
+			mesh.meshlets.swap(optimized_meshlets);
+		}
+	}
+	optimize_vertex_fetch(&mesh);
+	analyze_vertex_cache(mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()), vertex_count, &out_result->cooked_cache);
+
+	const e_mesh_vertex_format vertex_format = options.compact_vertices ? _mesh_vertex_format_compact : _mesh_vertex_format_full;
+	if (!write_mesh(output_path, mesh, vertex_format, &out_result->compact_error))
+	{
+		return K_FAILURE;
+	}
+
+	out_result->vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	out_result->triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+	out_result->meshlet_count = static_cast<uint32_t>(mesh.meshlets.size());
+	out_result->lod_count = static_cast<uint32_t>(mesh.lods.size() + 1);
+	out_result->lod_triangle_counts[0] = out_result->triangle_count;
+	for (uint32_t lod = 1; lod < out_result->lod_count; lod++)
+	{
+		out_result->lod_triangle_counts[lod] = static_cast<uint32_t>(mesh.lods[lod - 1].indices.size() / 3);
+		out_result->lod_errors[lod] = mesh.lods[lod - 1].error;
+	}
+	out_result->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+	return K_SUCCESS;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <mesh/mesh.h>
+#include <mesh/vertex_compressor.h>
+#include <mesh/mesh_simplifier.h>
+#include <mesh/mesh_optimizer.h>
+#include <filesystem>
+
+class c_thread_pool;
+
+// Bump whenever a change to the cooker changes the .mesh files it writes, so incremental cooks redo every mesh
+constexpr uint32_t MESH_COOKER_VERSION = 3;
+
+struct s_mesh_cook_options
+{
+	bool flip_u; // u = 1 - u, matches meshconvert -flipu
+	bool clockwise; // clockwise winding, matches meshconvert -cw
+	bool compact_vertices; // quantized s_mesh_file_compact_vertex instead of full floats
+	s_mesh_lod_options lod_options;
+};
+
+struct s_mesh_cook_result
+{
+	uint64_t source_size;
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+	uint32_t welded_count; // face corners merged into an existing vertex
+	uint32_t meshlet_count;
+	uint32_t lod_count; // including full detail
+	uint32_t lod_triangle_counts[MESH_FILE_MAXIMUM_LODS];
+	float lod_errors[MESH_FILE_MAXIMUM_LODS]; // model space
+	s_compact_vertex_error compact_error; // only set for compact vertices
+	s_vertex_cache_statistics source_cache; // full detail, in the order the source was written
+	s_vertex_cache_statistics cooked_cache; // full detail, as written to the .mesh
+	double milliseconds;
+};
+
+// Cook an .OBJ (or legacy .VBO) into a .MESH: weld, generate missing normals, tangent frames, bounds, simplified levels of detail & meshlets
+// Triangles are then ordered for the vertex cache & overdraw, and vertices by first use
+bool cook_mesh(const std::filesystem::path& input_path, const std::filesystem::path& output_path, const s_mesh_cook_options& options, c_thread_pool* const thread_pool, s_mesh_cook_result* const out_result);
@@ -0,0 +1,364 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <numeric>
+
+// Forsyth's scoring constants, tuned for an LRU cache of VERTEX_CACHE_SCORING_SIZE
+constexpr uint32_t VERTEX_CACHE_SCORING_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+// Vertices used by the last triangle score the same, whichever order it was drawn in
+static float get_vertex_score(const int32_t cache_position, const uint32_t remaining_triangle_count)
+{
+	if (remaining_triangle_count == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+		{
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			const float scaler = 1.0f / static_cast<float>(VERTEX_CACHE_SCORING_SIZE - 3);
+			score = powf(1.0f - static_cast<float>(cache_position - 3) * scaler, CACHE_DECAY_POWER);
+		}
+	}
+
+	// Vertices with few triangles left are finished off first, so they don't linger as lone triangles later
+	score += VALENCE_BOOST_SCALE * powf(static_cast<float>(remaining_triangle_count), -VALENCE_BOOST_POWER);
+	return score;
+}
+
+void analyze_vertex_cache(const uint32_t* const indices, const uint32_t index_count, const uint32_t vertex_count, s_vertex_cache_statistics* const out_statistics)
+{
+	*out_statistics = {};
+	if (index_count < 3)
+	{
+		return;
+	}
+
+	// A vertex is still cached if fewer than the cache's size were loaded since it was, which is exactly a FIFO
+	std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+	std::vector<bool> vertex_used(vertex_count, false);
+	uint32_t timestamp = VERTEX_CACHE_ANALYSIS_SIZE + 1;
+	uint32_t transformed_count = 0;
+	uint32_t used_count = 0;
+	for (uint32_t i = 0; i < index_count; i++)
+	{
+		const uint32_t vertex = indices[i];
+		if (timestamp - cache_timestamps[vertex] > VERTEX_CACHE_ANALYSIS_SIZE)
+		{
+			cache_timestamps[vertex] = timestamp++;
+			transformed_count++;
+		}
+		if (!vertex_used[vertex])
+		{
+			vertex_used[vertex] = true;
+			used_count++;
+		}
+	}
+
+	out_statistics->acmr = static_cast<float>(transformed_count) / static_cast<float>(index_count / 3);
+	out_statistics->atvr = static_cast<float>(transformed_count) / static_cast<float>(used_count);
+}
+
+void optimize_vertex_cache(uint32_t* const indices, const uint32_t index_count, const uint32_t vertex_count)
+{
+	const uint32_t triangle_count = index_count / 3;
+	if (triangle_count < 2)
+	{
+		return;
+	}
+
+	// Triangles using each vertex, the first remaining_triangle_counts of each are those not yet drawn
+	std::vector<uint32_t> vertex_triangle_offsets(vertex_count + 1, 0);
+	for (uint32_t i = 0; i < triangle_count * 3; i++)
+	{
+		vertex_triangle_offsets[indices[i] + 1]++;
+	}
+	for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		vertex_triangle_offsets[vertex + 1] += vertex_triangle_offsets[vertex];
+	}
+	std::vector<uint32_t> vertex_triangles(triangle_count * 3);
+	std::vector<uint32_t> remaining_triangle_counts(vertex_count, 0);
+	for (uint32_t i = 0; i < triangle_count * 3; i++)
+	{
+		const uint32_t vertex = indices[i];
+		vertex_triangles[vertex_triangle_offsets[vertex] + remaining_triangle_counts[vertex]++] = i / 3;
+	}
+
+	std::vector<int32_t> cache_positions(vertex_count, -1);
+	std::vector<float> vertex_scores(vertex_count);
+	for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		vertex_scores[vertex] = get_vertex_score(-1, remaining_triangle_counts[vertex]);
+	}
+	std::vector<float> triangle_scores(triangle_count);
+	for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+	{
+		const uint32_t* const corners = &indices[triangle * 3];
+		triangle_scores[triangle] = vertex_scores[corners[0]] + vertex_scores[corners[1]] + vertex_scores[corners[2]];
+	}
+
+	std::vector<uint32_t> optimized_indices;
+	optimized_indices.reserve(triangle_count * 3);
+	std::vector<bool> triangle_drawn(triangle_count, false);
+	// Most recently used first, with room for the 3 vertices pushed in before the oldest fall out
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> next_cache;
+	cache.reserve(VERTEX_CACHE_SCORING_SIZE + 3);
+	next_cache.reserve(VERTEX_CACHE_SCORING_SIZE + 3);
+
+	uint32_t best_triangle = static_cast<uint32_t>(std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+	uint32_t next_undrawn_triangle = 0;
+	for (uint32_t drawn_count = 0; drawn_count < triangle_count; drawn_count++)
+	{
+		// Only triangles touching the cache are rescored, once none are left start again from the next undrawn one
+		if (best_triangle == UINT32_MAX)
+		{
+			while (triangle_drawn[next_undrawn_triangle])
+			{
+				next_undrawn_triangle++;
+			}
+			best_triangle = next_undrawn_triangle;
+		}
+
+		triangle_drawn[best_triangle] = true;
+		const uint32_t* const corners = &indices[best_triangle * 3];
+		next_cache.clear();
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t vertex = corners[corner];
+			optimized_indices.push_back(vertex);
+			next_cache.push_back(vertex);
+
+			// Swap the drawn triangle past the end of the vertex's remaining ones
+			uint32_t* const triangles = &vertex_triangles[vertex_triangle_offsets[vertex]];
+			const uint32_t remaining_count = remaining_triangle_counts[vertex];
+			for (uint32_t i = 0; i < remaining_count; i++)
+			{
+				if (triangles[i] == best_triangle)
+				{
+					std::swap(triangles[i], triangles[remaining_count - 1]);
+					break;
+				}
+			}
+			remaining_triangle_counts[vertex]--;
+		}
+		for (const uint32_t vertex : cache)
+		{
+			if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+			{
+				next_cache.push_back(vertex);
+			}
+		}
+		cache.swap(next_cache);
+
+		// Vertices pushed out of the cache are scored as uncached, then left out of it
+		for (uint32_t position = 0; position < static_cast<uint32_t>(cache.size()); position++)
+		{
+			const uint32_t vertex = cache[position];
+			cache_positions[vertex] = position < VERTEX_CACHE_SCORING_SIZE ? static_cast<int32_t>(position) : -1;
+			vertex_scores[vertex] = get_vertex_score(cache_positions[vertex], remaining_triangle_counts[vertex]);
+		}
+
+		best_triangle = UINT32_MAX;
+		float best_score = -1.0f;
+		for (const uint32_t vertex : cache)
+		{
+			const uint32_t* const triangles = &vertex_triangles[vertex_triangle_offsets[vertex]];
+			for (uint32_t i = 0; i < remaining_triangle_counts[vertex]; i++)
+			{
+				const uint32_t triangle = triangles[i];
+				const uint32_t* const triangle_corners = &indices[triangle * 3];
+				const float score = vertex_scores[triangle_corners[0]] + vertex_scores[triangle_corners[1]] + vertex_scores[triangle_corners[2]];
+				triangle_scores[triangle] = score;
+				if (score > best_score)
+				{
+					best_score = score;
+					best_triangle = triangle;
+				}
+			}
+		}
+		if (cache.size() > VERTEX_CACHE_SCORING_SIZE)
+		{
+			cache.resize(VERTEX_CACHE_SCORING_SIZE);
+		}
+	}
+
+	std::copy(optimized_indices.begin(), optimized_indices.end(), indices);
+}
+
+void optimize_meshlet_vertex_caches(s_mesh* const mesh)
+{
+	// Meshlets only use a handful of vertices, so each is optimized with its own small numbering rather than the whole mesh's
+	std::vector<uint32_t> local_vertices(mesh->vertices.size(), UINT32_MAX);
+	std::vector<uint32_t> global_vertices;
+	std::vector<uint32_t> local_indices;
+	for (const s_mesh_file_meshlet& meshlet : mesh->meshlets)
+	{
+		uint32_t* const indices = &mesh->indices[meshlet.index_offset];
+		global_vertices.clear();
+		local_indices.resize(meshlet.index_count);
+		for (uint32_t i = 0; i < meshlet.index_count; i++)
+		{
+			const uint32_t vertex = indices[i];
+			if (local_vertices[vertex] == UINT32_MAX)
+			{
+				local_vertices[vertex] = static_cast<uint32_t>(global_vertices.size());
+				global_vertices.push_back(vertex);
+			}
+			local_indices[i] = local_vertices[vertex];
+		}
+
+		optimize_vertex_cache(local_indices.data(), meshlet.index_count, static_cast<uint32_t>(global_vertices.size()));
+		for (uint32_t i = 0; i < meshlet.index_count; i++)
+		{
+			indices[i] = global_vertices[local_indices[i]];
+		}
+		for (const uint32_t vertex : global_vertices)
+		{
+			local_vertices[vertex] = UINT32_MAX;
+		}
+	}
+}
+
+void optimize_overdraw(const s_mesh& mesh, uint32_t* const indices, const uint32_t index_count, const float threshold)
+{
+	const uint32_t triangle_count = index_count / 3;
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	if (triangle_count < 2)
+	{
+		return;
+	}
+
+	s_vertex_cache_statistics statistics;
+	analyze_vertex_cache(indices, index_count, vertex_count, &statistics);
+
+	// Clusters start at every triangle whose vertices all miss the cache, reordering them costs little as nothing is lost across the boundary
+	std::vector<uint32_t> cluster_offsets; // in triangles
+	std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+	uint32_t timestamp = VERTEX_CACHE_ANALYSIS_SIZE + 1;
+	for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+	{
+		uint32_t miss_count = 0;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t vertex = indices[triangle * 3 + corner];
+			if (timestamp - cache_timestamps[vertex] > VERTEX_CACHE_ANALYSIS_SIZE)
+			{
+				cache_timestamps[vertex] = timestamp++;
+				miss_count++;
+			}
+		}
+		if (triangle == 0 || miss_count == 3)
+		{
+			cluster_offsets.push_back(triangle);
+		}
+	}
+	const uint32_t cluster_count = static_cast<uint32_t>(cluster_offsets.size());
+	if (cluster_count < 2)
+	{
+		return;
+	}
+	cluster_offsets.push_back(triangle_count);
+
+	// Area weighted centroids & normals, of each cluster & the whole mesh
+	std::vector<s_vector3> cluster_centroids(cluster_count);
+	std::vector<s_vector3> cluster_normals(cluster_count);
+	s_vector3 mesh_centroid = { 0.0f, 0.0f, 0.0f };
+	float mesh_area = 0.0f;
+	for (uint32_t cluster = 0; cluster < cluster_count; cluster++)
+	{
+		s_vector3 centroid = { 0.0f, 0.0f, 0.0f };
+		s_vector3 normal = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+		for (uint32_t triangle = cluster_offsets[cluster]; triangle < cluster_offsets[cluster + 1]; triangle++)
+		{
+			const s_vector3 p0 = load_vector3(mesh.vertices[indices[triangle * 3 + 0]].position);
+			const s_vector3 p1 = load_vector3(mesh.vertices[indices[triangle * 3 + 1]].position);
+			const s_vector3 p2 = load_vector3(mesh.vertices[indices[triangle * 3 + 2]].position);
+			const s_vector3 face_normal = cross(p1 - p0, p2 - p0);
+			const float triangle_area = length(face_normal);
+			centroid = centroid + (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal = normal + face_normal;
+			area += triangle_area;
+		}
+		mesh_centroid = mesh_centroid + centroid;
+		mesh_area += area;
+		cluster_centroids[cluster] = area > 0.0f ? centroid * (1.0f / area) : centroid;
+		cluster_normals[cluster] = normalise(normal);
+	}
+	mesh_centroid = mesh_area > 0.0f ? mesh_centroid * (1.0f / mesh_area) : mesh_centroid;
+
+	// Clusters facing away from the middle of the mesh are on its outside, drawing them first lets depth testing reject what's behind
+	std::vector<float> cluster_sort_keys(cluster_count);
+	for (uint32_t cluster = 0; cluster < cluster_count; cluster++)
+	{
+		cluster_sort_keys[cluster] = dot(cluster_centroids[cluster] - mesh_centroid, cluster_normals[cluster]);
+	}
+	std::vector<uint32_t> cluster_order(cluster_count);
+	std::iota(cluster_order.begin(), cluster_order.end(), 0);
+	std::stable_sort(cluster_order.begin(), cluster_order.end(), [&cluster_sort_keys](const uint32_t a, const uint32_t b) { return cluster_sort_keys[a] > cluster_sort_keys[b]; });
+
+	std::vector<uint32_t> sorted_indices;
+	sorted_indices.reserve(triangle_count * 3);
+	for (const uint32_t cluster : cluster_order)
+	{
+		sorted_indices.insert(sorted_indices.end(), indices + cluster_offsets[cluster] * 3, indices + cluster_offsets[cluster + 1] * 3);
+	}
+
+	s_vertex_cache_statistics sorted_statistics;
+	analyze_vertex_cache(sorted_indices.data(), triangle_count * 3, vertex_count, &sorted_statistics);
+	if (sorted_statistics.acmr <= statistics.acmr * threshold)
+	{
+		std::copy(sorted_indices.begin(), sorted_indices.end(), indices);
+	}
+}
+
+void optimize_vertex_fetch(s_mesh* const mesh)
+{
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh->vertices.size());
+	std::vector<uint32_t> vertex_remap(vertex_count, UINT32_MAX);
+	uint32_t next_vertex = 0;
+	const auto remap_indices = [&vertex_remap, &next_vertex](std::vector<uint32_t>* const indices)
+	{
+		for (uint32_t& index : *indices)
+		{
+			if (vertex_remap[index] == UINT32_MAX)
+			{
+				vertex_remap[index] = next_vertex++;
+			}
+			index = vertex_remap[index];
+		}
+	};
+	remap_indices(&mesh->indices);
+	for (s_mesh_lod& lod : mesh->lods)
+	{
+		remap_indices(&lod.indices);
+	}
+
+	// Vertices nothing draws are kept at the end, in their original order
+	for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		if (vertex_remap[vertex] == UINT32_MAX)
+		{
+			vertex_remap[vertex] = next_vertex++;
+		}
+	}
+
+	std::vector<s_mesh_file_vertex> vertices(vertex_count);
+	for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+	{
+		vertices[vertex_remap[vertex]] = mesh->vertices[vertex];
+	}
+	mesh->vertices.swap(vertices);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <mesh/mesh.h>
+
+// Post transform cache the statistics are measured against, a FIFO of about what current GPUs reuse from
+constexpr uint32_t VERTEX_CACHE_ANALYSIS_SIZE = 16;
+
+struct s_vertex_cache_statistics
+{
+	float acmr; // average cache miss ratio, vertices transformed per triangle, 0.5 at best & 3 at worst
+	float atvr; // average transform to vertex ratio, vertices transformed per vertex referenced, 1 at best
+};
+
+// Simulate drawing indices through a VERTEX_CACHE_ANALYSIS_SIZE FIFO cache
+void analyze_vertex_cache(const uint32_t* const indices, const uint32_t index_count, const uint32_t vertex_count, s_vertex_cache_statistics* const out_statistics);
+
+// Reorder triangles for post transform cache hits, using Forsyth's linear speed scoring against an LRU cache
+// Same approach as DirectXMesh's OptimizeFacesLRU, vertices are left where they are
+void optimize_vertex_cache(uint32_t* const indices, const uint32_t index_count, const uint32_t vertex_count);
+
+// Reorder each meshlet's triangles for the cache, keeping every meshlet's range & bounds as they are
+void optimize_meshlet_vertex_caches(s_mesh* const mesh);
+
+// Split cache optimized indices into clusters wherever the cache starts cold, then draw outward facing clusters first so they occlude the rest
+// The new order is only kept if its ACMR stays within threshold times the cache optimized ACMR
+void optimize_overdraw(const s_mesh& mesh, uint32_t* const indices, const uint32_t index_count, const float threshold);
+
+// Reorder vertices by their first use in mesh->indices, then the levels of detail, so vertex fetches walk the buffer forwards
+// Same as DirectXMesh's OptimizeVertices, every level is remapped to match & meshlets are untouched as they only hold index ranges
+void optimize_vertex_fetch(s_mesh* const mesh);
@@ -0,0 +1,458 @@
+#include "mesh_simplifier.h"
+#include <mesh/position_weld.h>
+#include <algorithm>
+
+// Area weighted sum of squared distances to a set of planes, as in Garland & Heckbert
+// Held in double as the constant term cancels out almost entirely near the surface
+struct s_quadric
+{
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double weight;
+};
+
+static s_quadric make_plane_quadric(const s_vector3& normal, const float distance, const float weight)
+{
+	const double x = normal.x;
+	const double y = normal.y;
+	const double z = normal.z;
+	const double d = distance;
+
+	s_quadric quadric;
+	quadric.a00 = weight * x * x;
+	quadric.a01 = weight * x * y;
+	quadric.a02 = weight * x * z;
+	quadric.a11 = weight * y * y;
+	quadric.a12 = weight * y * z;
+	quadric.a22 = weight * z * z;
+	quadric.b0 = weight * x * d;
+	quadric.b1 = weight * y * d;
+	quadric.b2 = weight * z * d;
+	quadric.c = weight * d * d;
+	quadric.weight = weight;
+	return quadric;
+}
+
+static s_quadric add_quadrics(const s_quadric& a, const s_quadric& b)
+{
+	return
+	{
+		a.a00 + b.a00, a.a01 + b.a01, a.a02 + b.a02, a.a11 + b.a11, a.a12 + b.a12, a.a22 + b.a22,
+		a.b0 + b.b0, a.b1 + b.b1, a.b2 + b.b2,
+		a.c + b.c,
+		a.weight + b.weight
+	};
+}
+
+// Mean squared distance from position to the quadric's planes
+static float get_quadric_error(const s_quadric& quadric, const s_vector3& position)
+{
+	if (quadric.weight <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	const double x = position.x;
+	const double y = position.y;
+	const double z = position.z;
+	const double error =
+		quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z +
+		2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z) +
+		2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) +
+		quadric.c;
+	return static_cast<float>(std::max(error, 0.0) / quadric.weight);
+}
+
+// Half edge collapses on a position welded view of the mesh, a collapsed position's triangles are moved onto a neighbouring vertex
+class c_mesh_simplifier
+{
+public:
+	c_mesh_simplifier(const s_mesh& mesh);
+
+	// Collapse edges until at most target_triangle_count remain, or every remaining collapse would move the surface more than maximum_error
+	void simplify(const uint32_t target_triangle_count, const float maximum_error);
+	void get_indices(std::vector<uint32_t>* const out_indices) const;
+
+	inline uint32_t get_triangle_count() const { return m_live_triangle_count; };
+	// Largest collapse error so far, in model space units
+	inline float get_error() const { return sqrtf(m_error_squared); };
+
+private:
+	struct s_collapse
+	{
+		uint32_t position;
+		uint32_t target_position;
+		float error_squared;
+	};
+
+	inline uint32_t get_corner_position(const uint32_t triangle, const uint32_t corner) const { return m_vertex_positions[m_triangles[triangle * 3 + corner]]; };
+	bool find_collapse(const uint32_t position, s_collapse* const out_collapse);
+	// Rejects collapses that would split a UV chart, make the surface non-manifold or flip a triangle
+	bool can_collapse(const uint32_t position, const uint32_t target_position, uint32_t* const out_target_vertex);
+	void collapse(const s_collapse& collapse, const uint32_t target_vertex);
+
+	std::vector<s_vector3> m_positions;
+	std::vector<uint32_t> m_vertex_positions; // vertex to welded position
+	std::vector<uint32_t> m_position_vertices; // the only vertex at a position, UINT32_MAX for seams
+	std::vector<bool> m_locked; // seam, border & non-manifold positions, never collapsed
+	std::vector<s_quadric> m_quadrics;
+	std::vector<uint32_t> m_triangles; // 3 vertex indices per triangle
+	std::vector<bool> m_triangle_alive;
+	std::vector<std::vector<uint32_t>> m_position_triangles; // may include dead triangles
+	uint32_t m_live_triangle_count;
+	float m_error_squared;
+
+	// Scratch for can_collapse
+	std::vector<uint32_t> m_neighbours;
+	std::vector<uint32_t> m_target_neighbours;
+};
+
+c_mesh_simplifier::c_mesh_simplifier(const s_mesh& mesh)
+	: m_positions()
+	, m_vertex_positions()
+	, m_position_vertices()
+	, m_locked()
+	, m_quadrics()
+	, m_triangles(mesh.indices)
+	, m_triangle_alive(mesh.indices.size() / 3, true)
+	, m_position_triangles()
+	, m_live_triangle_count(0)
+	, m_error_squared(0.0f)
+	, m_neighbours()
+	, m_target_neighbours()
+{
+	// Weld by position alone, vertices split by normals or texcoords share a position & become seams
+	const uint32_t position_count = weld_positions(mesh, &m_vertex_positions);
+	m_positions.resize(position_count);
+	m_position_vertices.assign(position_count, UINT32_MAX);
+	std::vector<uint32_t> position_vertex_counts(position_count, 0);
+	for (uint32_t vertex = 0; vertex < static_cast<uint32_t>(mesh.vertices.size()); vertex++)
+	{
+		const uint32_t position = m_vertex_positions[vertex];
+		m_positions[position] = load_vector3(mesh.vertices[vertex].position);
+		m_position_vertices[position] = vertex;
+		position_vertex_counts[position]++;
+	}
+
+	m_locked.assign(position_count, false);
+	m_quadrics.assign(position_count, s_quadric{});
+	m_position_triangles.resize(position_count);
+	for (uint32_t position = 0; position < position_count; position++)
+	{
+		m_locked[position] = position_vertex_counts[position] > 1;
+		m_position_vertices[position] = m_locked[position] ? UINT32_MAX : m_position_vertices[position];
+	}
+
+	std::vector<uint64_t> edges;
+	const uint32_t triangle_count = static_cast<uint32_t>(m_triangle_alive.size());
+	edges.reserve(triangle_count * 3);
+	for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+	{
+		const uint32_t positions[3] = { this->get_corner_position(triangle, 0), this->get_corner_position(triangle, 1), this->get_corner_position(triangle, 2) };
+		if (positions[0] == positions[1] || positions[1] == positions[2] || positions[2] == positions[0])
+		{
+			// Draws nothing already, drop it from every level
+			m_triangle_alive[triangle] = false;
+			continue;
+		}
+
+		m_live_triangle_count++;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			m_position_triangles[positions[corner]].push_back(triangle);
+			const uint32_t a = positions[corner];
+			const uint32_t b = positions[(corner + 1) % 3];
+			edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+		}
+
+		const s_vector3& p0 = m_positions[positions[0]];
+		const s_vector3 face_normal = cross(m_positions[positions[1]] - p0, m_positions[positions[2]] - p0);
+		const float double_area = length(face_normal);
+		if (double_area > 0.0f)
+		{
+			const s_vector3 normal = face_normal * (1.0f / double_area);
+			const s_quadric quadric = make_plane_quadric(normal, -dot(normal, p0), double_area * 0.5f);
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				m_quadrics[positions[corner]] = add_quadrics(m_quadrics[positions[corner]], quadric);
+			}
+		}
+	}
+
+	// Edges with one triangle are open borders, more than two is non-manifold, either way the ends stay put
+	std::sort(edges.begin(), edges.end());
+	for (size_t edge = 0; edge < edges.size();)
+	{
+		size_t edge_end = edge + 1;
+		while (edge_end < edges.size() && edges[edge_end] == edges[edge])
+		{
+			edge_end++;
+		}
+		if (edge_end - edge != 2)
+		{
+			m_locked[static_cast<uint32_t>(edges[edge] >> 32)] = true;
+			m_locked[static_cast<uint32_t>(edges[edge] & UINT32_MAX)] = true;
+		}
+		edge = edge_end;
+	}
+}
+
+void c_mesh_simplifier::simplify(const uint32_t target_triangle_count, const float maximum_error)
+{
+	const float maximum_error_squared = maximum_error * maximum_error;
+	const uint32_t position_count = static_cast<uint32_t>(m_positions.size());
+	std::vector<s_collapse> collapses;
+	std::vector<bool> collapsed_this_pass;
+
+	while (m_live_triangle_count > target_triangle_count)
+	{
+		collapses.clear();
+		for (uint32_t position = 0; position < position_count; position++)
+		{
+			s_collapse collapse;
+			if (!m_locked[position] && !m_position_triangles[position].empty() && this->find_collapse(position, &collapse) && collapse.error_squared <= maximum_error_squared)
+			{
+				collapses.push_back(collapse);
+			}
+		}
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		// Only the cheapest share each pass, so later collapses are chosen with the quadrics the earlier ones merged
+		std::sort(collapses.begin(), collapses.end(), [](const s_collapse& a, const s_collapse& b) { return a.error_squared < b.error_squared; });
+		const size_t pass_limit = std::max<size_t>(collapses.size() / 4, 1);
+		collapsed_this_pass.assign(position_count, false);
+		size_t collapse_count = 0;
+		for (const s_collapse& collapse : collapses)
+		{
+			if (collapse_count >= pass_limit || m_live_triangle_count <= target_triangle_count)
+			{
+				break;
+			}
+			// Either end may have changed this pass, leave them for the next one
+			if (collapsed_this_pass[collapse.position] || collapsed_this_pass[collapse.target_position])
+			{
+				continue;
+			}
+
+			uint32_t target_vertex = 0;
+			if (this->can_collapse(collapse.position, collapse.target_position, &target_vertex))
+			{
+				this->collapse(collapse, target_vertex);
+				collapsed_this_pass[collapse.position] = true;
+				collapsed_this_pass[collapse.target_position] = true;
+				collapse_count++;
+			}
+		}
+		if (collapse_count == 0)
+		{
+			break;
+		}
+	}
+}
+
+void c_mesh_simplifier::get_indices(std::vector<uint32_t>* const out_indices) const
+{
+	out_indices->clear();
+	out_indices->reserve(static_cast<size_t>(m_live_triangle_count) * 3);
+	for (uint32_t triangle = 0; triangle < static_cast<uint32_t>(m_triangle_alive.size()); triangle++)
+	{
+		if (m_triangle_alive[triangle])
+		{
+			out_indices->insert(out_indices->end(), m_triangles.begin() + triangle * 3, m_triangles.begin() + triangle * 3 + 3);
+		}
+	}
+}
+
+bool c_mesh_simplifier::find_collapse(const uint32_t position, s_collapse* const out_collapse)
+{
+	bool found = false;
+	for (const uint32_t triangle : m_position_triangles[position])
+	{
+		if (!m_triangle_alive[triangle])
+		{
+			continue;
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t target_position = this->get_corner_position(triangle, corner);
+			if (target_position == position)
+			{
+				continue;
+			}
+
+			const s_quadric quadric = add_quadrics(m_quadrics[position], m_quadrics[target_position]);
+			const float error_squared = get_quadric_error(quadric, m_positions[target_position]);
+			uint32_t target_vertex = 0;
+			if ((!found || error_squared < out_collapse->error_squared) && this->can_collapse(position, target_position, &target_vertex))
+			{
+				*out_collapse = { position, target_position, error_squared };
+				found = true;
+			}
+		}
+	}
+	return found;
+}
+
+bool c_mesh_simplifier::can_collapse(const uint32_t position, const uint32_t target_position, uint32_t* const out_target_vertex)
+{
+	uint32_t target_vertex = UINT32_MAX;
+	uint32_t shared_triangle_count = 0;
+	m_neighbours.clear();
+	for (const uint32_t triangle : m_position_triangles[position])
+	{
+		if (!m_triangle_alive[triangle])
+		{
+			continue;
+		}
+
+		uint32_t position_corner = 0;
+		uint32_t target_corner = UINT32_MAX;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t corner_position = this->get_corner_position(triangle, corner);
+			position_corner = corner_position == position ? corner : position_corner;
+			target_corner = corner_position == target_position ? corner : target_corner;
+			if (corner_position != position)
+			{
+				m_neighbours.push_back(corner_position);
+			}
+		}
+
+		if (target_corner != UINT32_MAX)
+		{
+			// The triangles either side of the edge must agree on the target's vertex, otherwise the edge is a seam at that end
+			const uint32_t corner_vertex = m_triangles[triangle * 3 + target_corner];
+			if (target_vertex != UINT32_MAX && target_vertex != corner_vertex)
+			{
+				return false;
+			}
+			target_vertex = corner_vertex;
+			shared_triangle_count++;
+			continue;
+		}
+
+		// Triangles that survive must keep facing the same way
+		const s_vector3& a = m_positions[this->get_corner_position(triangle, (position_corner + 1) % 3)];
+		const s_vector3& b = m_positions[this->get_corner_position(triangle, (position_corner + 2) % 3)];
+		const s_vector3 normal_before = cross(a - m_positions[position], b - m_positions[position]);
+		const s_vector3 normal_after = cross(a - m_positions[target_position], b - m_positions[target_position]);
+		if (dot(normal_before, normal_after) <= 1e-2f * length(normal_before) * length(normal_after))
+		{
+			return false;
+		}
+	}
+	if (shared_triangle_count != 2)
+	{
+		return false;
+	}
+
+	// Link condition, the two ends may only share the neighbours opposite the edge or the collapse pinches the surface
+	m_target_neighbours.clear();
+	for (const uint32_t triangle : m_position_triangles[target_position])
+	{
+		if (!m_triangle_alive[triangle])
+		{
+			continue;
+		}
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint32_t corner_position = this->get_corner_position(triangle, corner);
+			if (corner_position != target_position && corner_position != position)
+			{
+				m_target_neighbours.push_back(corner_position);
+			}
+		}
+	}
+	std::sort(m_neighbours.begin(), m_neighbours.end());
+	m_neighbours.erase(std::unique(m_neighbours.begin(), m_neighbours.end()), m_neighbours.end());
+	std::sort(m_target_neighbours.begin(), m_target_neighbours.end());
+	m_target_neighbours.erase(std::unique(m_target_neighbours.begin(), m_target_neighbours.end()), m_target_neighbours.end());
+	uint32_t shared_neighbour_count = 0;
+	for (const uint32_t neighbour : m_neighbours)
+	{
+		shared_neighbour_count += std::binary_search(m_target_neighbours.begin(), m_target_neighbours.end(), neighbour) ? 1 : 0;
+	}
+	if (shared_neighbour_count != 2)
+	{
+		return false;
+	}
+
+	*out_target_vertex = target_vertex;
+	return true;
+}
+
+void c_mesh_simplifier::collapse(const s_collapse& collapse, const uint32_t target_vertex)
+{
+	const uint32_t vertex = m_position_vertices[collapse.position];
+	std::vector<uint32_t>& target_triangles = m_position_triangles[collapse.target_position];
+	for (const uint32_t triangle : m_position_triangles[collapse.position])
+	{
+		if (!m_triangle_alive[triangle])
+		{
+			continue;
+		}
+
+		uint32_t* const corners = &m_triangles[triangle * 3];
+		const bool shares_edge = m_vertex_positions[corners[0]] == collapse.target_position || m_vertex_positions[corners[1]] == collapse.target_position || m_vertex_positions[corners[2]] == collapse.target_position;
+		if (shares_edge)
+		{
+			m_triangle_alive[triangle] = false;
+			m_live_triangle_count--;
+			continue;
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			corners[corner] = corners[corner] == vertex ? target_vertex : corners[corner];
+		}
+		target_triangles.push_back(triangle);
+	}
+
+	const std::vector<bool>& triangle_alive = m_triangle_alive;
+	target_triangles.erase(std::remove_if(target_triangles.begin(), target_triangles.end(), [&triangle_alive](const uint32_t triangle) { return !triangle_alive[triangle]; }), target_triangles.end());
+	m_position_triangles[collapse.position].clear();
+	m_quadrics[collapse.target_position] = add_quadrics(m_quadrics[collapse.position], m_quadrics[collapse.target_position]);
+	m_error_squared = std::max(m_error_squared, collapse.error_squared);
+}
+
+void generate_mesh_lods(s_mesh* const mesh, const float bounding_radius, const s_mesh_lod_options& options)
+{
+	mesh->lods.clear();
+	const uint32_t lod_count = std::min(options.maximum_lod_count, MESH_FILE_MAXIMUM_LODS);
+	if (lod_count <= 1)
+	{
+		return;
+	}
+
+	c_mesh_simplifier simplifier(*mesh);
+	const float maximum_error = options.maximum_error * bounding_radius;
+	uint32_t previous_triangle_count = static_cast<uint32_t>(mesh->indices.size() / 3);
+	for (uint32_t lod = 1; lod < lod_count; lod++)
+	{
+		const uint32_t target_triangle_count = static_cast<uint32_t>(previous_triangle_count * options.triangle_ratio);
+		if (target_triangle_count < options.minimum_triangle_count)
+		{
+			break;
+		}
+
+		simplifier.simplify(target_triangle_count, maximum_error);
+
+		// A level that barely reduced the triangle count isn't worth its index memory, and the ones after it would fare no better
+		const uint32_t triangle_count = simplifier.get_triangle_count();
+		if (triangle_count > previous_triangle_count - (previous_triangle_count - target_triangle_count) / 2)
+		{
+			break;
+		}
+
+		s_mesh_lod level;
+		simplifier.get_indices(&level.indices);
+		level.error = simplifier.get_error();
+		mesh->lods.push_back(std::move(level));
+		previous_triangle_count = triangle_count;
+	}
+}
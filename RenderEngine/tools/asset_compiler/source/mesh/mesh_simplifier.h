@@ -0,0 +1,15 @@
+#pragma once
+#include <mesh/mesh.h>
+
+struct s_mesh_lod_options
+{
+	uint32_t maximum_lod_count; // including the full detail mesh, at most MESH_FILE_MAXIMUM_LODS
+	float triangle_ratio; // each level aims for this fraction of the previous level's triangles
+	float maximum_error; // fraction of the bounding radius, simplification stops rather than exceeding it
+	uint32_t minimum_triangle_count; // no level is generated below this many triangles
+};
+
+// Build a chain of progressively simpler index lists into mesh->lods using quadric error edge collapses
+// Vertices are never moved or added, every level indexes the mesh's existing vertex buffer
+// Vertices on open borders or texture & normal seams are kept so silhouettes & UV charts don't tear
+void generate_mesh_lods(s_mesh* const mesh, const float bounding_radius, const s_mesh_lod_options& options);
@@ -0,0 +1,124 @@
+#include "mesh_writer.h"
+#include <common/report.h>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+static uint64_t align_offset(const uint64_t offset, const uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+void compute_mesh_bounds(const s_mesh& mesh, s_mesh_file_bounds* const out_bounds)
+{
+	*out_bounds = {};
+	if (mesh.vertices.empty())
+	{
+		return;
+	}
+
+	s_vector3 minimum = load_vector3(mesh.vertices[0].position);
+	s_vector3 maximum = minimum;
+	for (const s_mesh_file_vertex& vertex : mesh.vertices)
+	{
+		minimum = { std::min(minimum.x, vertex.position[0]), std::min(minimum.y, vertex.position[1]), std::min(minimum.z, vertex.position[2]) };
+		maximum = { std::max(maximum.x, vertex.position[0]), std::max(maximum.y, vertex.position[1]), std::max(maximum.z, vertex.position[2]) };
+	}
+
+	const s_vector3 center = (minimum + maximum) * 0.5f;
+	float radius_squared = 0.0f;
+	for (const s_mesh_file_vertex& vertex : mesh.vertices)
+	{
+		const s_vector3 delta = load_vector3(vertex.position) - center;
+		radius_squared = std::max(radius_squared, dot(delta, delta));
+	}
+
+	store_vector3(minimum, out_bounds->minimum);
+	store_vector3(maximum, out_bounds->maximum);
+	store_vector3(center, out_bounds->center);
+	out_bounds->radius = sqrtf(radius_squared);
+}
+
+bool write_mesh(const std::filesystem::path& file_path, const s_mesh& mesh, const e_mesh_vertex_format vertex_format, s_compact_vertex_error* const out_compact_error)
+{
+	if (mesh.vertices.empty() || mesh.indices.empty())
+	{
+		LOG_WARNING("refusing to write empty mesh %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	// 0xFFFF is left free so the strip cut value can never be hit
+	const bool use_16_bit_indices = mesh.vertices.size() < UINT16_MAX;
+	const uint32_t index_stride = use_16_bit_indices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	// Every level's indices are stored back to back, each level is a range of them
+	std::vector<s_mesh_file_lod> lods;
+	lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f, 0 });
+	std::vector<uint32_t> indices = mesh.indices;
+	for (const s_mesh_lod& level : mesh.lods)
+	{
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level.indices.size()), level.error, 0 });
+		indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+	}
+
+	s_mesh_file_header header = {};
+	header.signature = MESH_FILE_SIGNATURE;
+	header.version = MESH_FILE_VERSION;
+	header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	header.vertex_stride = vertex_format == _mesh_vertex_format_compact ? sizeof(s_mesh_file_compact_vertex) : sizeof(s_mesh_file_vertex);
+	header.index_count = static_cast<uint32_t>(indices.size());
+	header.index_format = use_16_bit_indices ? _mesh_index_format_16 : _mesh_index_format_32;
+	header.vertex_format = vertex_format;
+	header.lod_count = static_cast<uint32_t>(lods.size());
+	header.lod_data_offset = sizeof(s_mesh_file_header);
+	header.meshlet_count = static_cast<uint32_t>(mesh.meshlets.size());
+	header.meshlet_data_offset = header.lod_data_offset + header.lod_count * sizeof(s_mesh_file_lod);
+	header.vertex_data_offset = align_offset(header.meshlet_data_offset + header.meshlet_count * sizeof(s_mesh_file_meshlet), MESH_FILE_DATA_ALIGNMENT);
+	header.index_data_offset = align_offset(header.vertex_data_offset + static_cast<uint64_t>(header.vertex_count) * header.vertex_stride, MESH_FILE_DATA_ALIGNMENT);
+	compute_mesh_bounds(mesh, &header.bounds);
+
+	const void* vertex_data = mesh.vertices.data();
+	std::vector<s_mesh_file_compact_vertex> compact_vertices;
+	if (vertex_format == _mesh_vertex_format_compact)
+	{
+		compress_vertices(mesh, header.bounds, &compact_vertices, out_compact_error);
+		if (!is_compact_vertex_error_valid(*out_compact_error))
+		{
+			LOG_WARNING("%s exceeds the compact vertex error bounds! (position %g, normal %g, tangent %g, uv %g, %u flipped bitangents)", file_path.string().c_str(),
+				out_compact_error->position, out_compact_error->normal, out_compact_error->tangent, out_compact_error->tex_coord, out_compact_error->flipped_bitangent_count);
+			return K_FAILURE;
+		}
+		vertex_data = compact_vertices.data();
+	}
+
+	std::vector<uint8_t> file_data(header.index_data_offset + static_cast<uint64_t>(header.index_count) * index_stride, 0);
+	memcpy(file_data.data(), &header, sizeof(header));
+	memcpy(file_data.data() + header.lod_data_offset, lods.data(), lods.size() * sizeof(s_mesh_file_lod));
+	memcpy(file_data.data() + header.meshlet_data_offset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(s_mesh_file_meshlet));
+	memcpy(file_data.data() + header.vertex_data_offset, vertex_data, static_cast<size_t>(header.vertex_count) * header.vertex_stride);
+	if (use_16_bit_indices)
+	{
+		uint16_t* const file_indices = reinterpret_cast<uint16_t*>(file_data.data() + header.index_data_offset);
+		for (uint32_t i = 0; i < header.index_count; i++)
+		{
+			file_indices[i] = static_cast<uint16_t>(indices[i]);
+		}
+	}
+	else
+	{
+		memcpy(file_data.data() + header.index_data_offset, indices.data(), static_cast<size_t>(header.index_count) * index_stride);
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(file_path.parent_path(), error);
+
+	std::ofstream mesh_file(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	mesh_file.write(reinterpret_cast<const char*>(file_data.data()), file_data.size());
+	if (mesh_file.fail())
+	{
+		LOG_WARNING("failed to write %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	return K_SUCCESS;
+}
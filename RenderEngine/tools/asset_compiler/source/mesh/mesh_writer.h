@@ -0,0 +1,11 @@
+#pragma once
+#include <mesh/mesh.h>
+#include <mesh/vertex_compressor.h>
+#include <filesystem>
+
+// Compute a box around the vertex positions, and a sphere around the box centre
+void compute_mesh_bounds(const s_mesh& mesh, s_mesh_file_bounds* const out_bounds);
+
+// Write a cooked .MESH file with mesh.lods after the full detail level & mesh.meshlets, indices are narrowed to 16 bit when every index fits
+// Compact vertices are checked against their error bounds first, out_compact_error is only filled in for them
+bool write_mesh(const std::filesystem::path& file_path, const s_mesh& mesh, const e_mesh_vertex_format vertex_format, s_compact_vertex_error* const out_compact_error);
@@ -0,0 +1,209 @@
+#include "meshlet_builder.h"
+#include <mesh/position_weld.h>
+#include <algorithm>
+
+// Cones wider than this can't be culled from any useful number of view points, so are left uncullable
+constexpr float MINIMUM_CONE_DOT = 0.1f;
+// Unconnected triangles considered for a meshlet once its connected ones run out, looking ahead from the seed in index order
+constexpr uint32_t DISCONNECTED_TRIANGLE_WINDOW = 256;
+
+static void compute_meshlet_bounds(const s_mesh& mesh, const uint32_t* const indices, const uint32_t index_count, s_mesh_file_meshlet* const out_meshlet)
+{
+	s_vector3 minimum = load_vector3(mesh.vertices[indices[0]].position);
+	s_vector3 maximum = minimum;
+	for (uint32_t i = 1; i < index_count; i++)
+	{
+		const float* const position = mesh.vertices[indices[i]].position;
+		minimum = { std::min(minimum.x, position[0]), std::min(minimum.y, position[1]), std::min(minimum.z, position[2]) };
+		maximum = { std::max(maximum.x, position[0]), std::max(maximum.y, position[1]), std::max(maximum.z, position[2]) };
+	}
+
+	const s_vector3 center = (minimum + maximum) * 0.5f;
+	float radius_squared = 0.0f;
+	for (uint32_t i = 0; i < index_count; i++)
+	{
+		const s_vector3 delta = load_vector3(mesh.vertices[indices[i]].position) - center;
+		radius_squared = std::max(radius_squared, dot(delta, delta));
+	}
+	store_vector3(center, out_meshlet->center);
+	out_meshlet->radius = sqrtf(radius_squared);
+
+	// Face normals from the winding, which is what the rasterizer culls by, rather than the shading normals
+	std::vector<s_vector3> face_normals;
+	face_normals.reserve(index_count / 3);
+	s_vector3 normal_sum = { 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i + 2 < index_count; i += 3)
+	{
+		const s_vector3 p0 = load_vector3(mesh.vertices[indices[i + 0]].position);
+		const s_vector3 p1 = load_vector3(mesh.vertices[indices[i + 1]].position);
+		const s_vector3 p2 = load_vector3(mesh.vertices[indices[i + 2]].position);
+		const s_vector3 face_normal = cross(p1 - p0, p2 - p0);
+		if (dot(face_normal, face_normal) > 0.0f)
+		{
+			face_normals.push_back(normalise(face_normal));
+			normal_sum = normal_sum + face_normals.back();
+		}
+	}
+
+	const s_vector3 axis = normalise(normal_sum);
+	float minimum_dot = 1.0f;
+	for (const s_vector3& face_normal : face_normals)
+	{
+		minimum_dot = std::min(minimum_dot, dot(face_normal, axis));
+	}
+	store_vector3(axis, out_meshlet->cone_axis);
+	const bool cone_valid = !face_normals.empty() && dot(axis, axis) > 0.0f && minimum_dot >= MINIMUM_CONE_DOT;
+	out_meshlet->cone_cutoff = cone_valid ? sqrtf(1.0f - minimum_dot * minimum_dot) : 1.0f;
+}
+
+void build_meshlets(s_mesh* const mesh)
+{
+	mesh->meshlets.clear();
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh->vertices.size());
+	const uint32_t triangle_count = static_cast<uint32_t>(mesh->indices.size() / 3);
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Triangles touching each position, so meshlets grow across texture & normal seams as well
+	std::vector<uint32_t> vertex_positions;
+	const uint32_t position_count = weld_positions(*mesh, &vertex_positions);
+	std::vector<uint32_t> position_triangle_offsets(position_count + 1, 0);
+	for (const uint32_t index : mesh->indices)
+	{
+		position_triangle_offsets[vertex_positions[index] + 1]++;
+	}
+	for (uint32_t position = 0; position < position_count; position++)
+	{
+		position_triangle_offsets[position + 1] += position_triangle_offsets[position];
+	}
+	std::vector<uint32_t> position_triangles(mesh->indices.size());
+	std::vector<uint32_t> position_fill_counts(position_count, 0);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mesh->indices.size()); i++)
+	{
+		const uint32_t position = vertex_positions[mesh->indices[i]];
+		position_triangles[position_triangle_offsets[position] + position_fill_counts[position]++] = i / 3;
+	}
+
+	std::vector<bool> triangle_assigned(triangle_count, false);
+	std::vector<uint32_t> vertex_meshlets(vertex_count, UINT32_MAX); // last meshlet each vertex was added to
+	std::vector<uint32_t> meshlet_vertices;
+	std::vector<uint32_t> indices;
+	indices.reserve(mesh->indices.size());
+
+	// Grow each meshlet from a seed triangle, always taking the neighbouring triangle that adds the fewest vertices
+	// and on a tie the one closest to the meshlet, which keeps meshlets compact & their bounds tight
+	uint32_t seed_triangle = 0;
+	while (true)
+	{
+		while (seed_triangle < triangle_count && triangle_assigned[seed_triangle])
+		{
+			seed_triangle++;
+		}
+		if (seed_triangle == triangle_count)
+		{
+			break;
+		}
+
+		const uint32_t meshlet_index = static_cast<uint32_t>(mesh->meshlets.size());
+		const uint32_t index_offset = static_cast<uint32_t>(indices.size());
+		meshlet_vertices.clear();
+		s_vector3 position_sum = { 0.0f, 0.0f, 0.0f };
+		float radius_squared = 0.0f; // around the seed triangle, only used to judge disconnected triangles
+		uint32_t meshlet_triangle_count = 0;
+		const s_vector3 seed_position = load_vector3(mesh->vertices[mesh->indices[seed_triangle * 3]].position);
+
+		uint32_t triangle = seed_triangle;
+		while (true)
+		{
+			triangle_assigned[triangle] = true;
+			meshlet_triangle_count++;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t vertex = mesh->indices[triangle * 3 + corner];
+				indices.push_back(vertex);
+				if (vertex_meshlets[vertex] != meshlet_index)
+				{
+					vertex_meshlets[vertex] = meshlet_index;
+					meshlet_vertices.push_back(vertex);
+					const s_vector3 position = load_vector3(mesh->vertices[vertex].position);
+					position_sum = position_sum + position;
+					radius_squared = std::max(radius_squared, dot(position - seed_position, position - seed_position));
+				}
+			}
+			if (meshlet_triangle_count == MESH_FILE_MESHLET_MAXIMUM_TRIANGLES)
+			{
+				break;
+			}
+
+			const s_vector3 centroid = position_sum * (1.0f / static_cast<float>(meshlet_vertices.size()));
+			uint32_t best_triangle = UINT32_MAX;
+			uint32_t best_new_vertex_count = 0;
+			float best_distance_squared = 0.0f;
+			for (const uint32_t vertex : meshlet_vertices)
+			{
+				const uint32_t position = vertex_positions[vertex];
+				for (uint32_t i = position_triangle_offsets[position]; i < position_triangle_offsets[position + 1]; i++)
+				{
+					const uint32_t candidate = position_triangles[i];
+					if (triangle_assigned[candidate])
+					{
+						continue;
+					}
+
+					const uint32_t* const corners = &mesh->indices[candidate * 3];
+					const uint32_t new_vertex_count =
+						(vertex_meshlets[corners[0]] != meshlet_index ? 1 : 0) +
+						(vertex_meshlets[corners[1]] != meshlet_index ? 1 : 0) +
+						(vertex_meshlets[corners[2]] != meshlet_index ? 1 : 0);
+					if (meshlet_vertices.size() + new_vertex_count > MESH_FILE_MESHLET_MAXIMUM_VERTICES)
+					{
+						continue;
+					}
+
+					const s_vector3 triangle_center = (load_vector3(mesh->vertices[corners[0]].position) + load_vector3(mesh->vertices[corners[1]].position) + load_vector3(mesh->vertices[corners[2]].position)) * (1.0f / 3.0f);
+					const s_vector3 delta = triangle_center - centroid;
+					const float distance_squared = dot(delta, delta);
+					if (best_triangle == UINT32_MAX || new_vertex_count < best_new_vertex_count || (new_vertex_count == best_new_vertex_count && distance_squared < best_distance_squared))
+					{
+						best_triangle = candidate;
+						best_new_vertex_count = new_vertex_count;
+						best_distance_squared = distance_squared;
+					}
+				}
+			}
+
+			// Nothing connected fits, meshes made of many small pieces (leaves, chain links) would end up with tiny meshlets
+			// so take the first unassigned triangle that follows in index order, but only if it's close by compared to the meshlet's size
+			const float maximum_distance_squared = radius_squared * 4.0f;
+			const uint32_t window_end = std::min(seed_triangle + DISCONNECTED_TRIANGLE_WINDOW, triangle_count);
+			for (uint32_t candidate = seed_triangle; best_triangle == UINT32_MAX && candidate < window_end; candidate++)
+			{
+				const uint32_t* const corners = &mesh->indices[candidate * 3];
+				const uint32_t new_vertex_count =
+					(vertex_meshlets[corners[0]] != meshlet_index ? 1 : 0) +
+					(vertex_meshlets[corners[1]] != meshlet_index ? 1 : 0) +
+					(vertex_meshlets[corners[2]] != meshlet_index ? 1 : 0);
+				const s_vector3 delta = load_vector3(mesh->vertices[corners[0]].position) - centroid;
+				if (!triangle_assigned[candidate] && meshlet_vertices.size() + new_vertex_count <= MESH_FILE_MESHLET_MAXIMUM_VERTICES && dot(delta, delta) <= maximum_distance_squared)
+				{
+					best_triangle = candidate;
+				}
+			}
+			if (best_triangle == UINT32_MAX)
+			{
+				break;
+			}
+			triangle = best_triangle;
+		}
+
+		s_mesh_file_meshlet meshlet = {};
+		meshlet.index_offset = index_offset;
+		meshlet.index_count = meshlet_triangle_count * 3;
+		compute_meshlet_bounds(*mesh, &indices[index_offset], meshlet.index_count, &meshlet);
+		mesh->meshlets.push_back(meshlet);
+	}
+
+	mesh->indices.swap(indices);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <mesh/mesh.h>
+
+// Group the full detail triangles into meshlets of at most MESH_FILE_MESHLET_MAXIMUM_VERTICES & MESH_FILE_MESHLET_MAXIMUM_TRIANGLES
+// Triangles are reordered so each meshlet is a contiguous range of mesh->indices, then given a bounding sphere & normal cone
+void build_meshlets(s_mesh* const mesh);
@@ -0,0 +1,44 @@
+#include "normals.h"
+#include <common/report.h>
+#include <algorithm>
+
+static inline float corner_angle(const s_vector3& a, const s_vector3& b)
+{
+	return acosf(std::clamp(dot(normalise(a), normalise(b)), -1.0f, 1.0f));
+}
+
+bool compute_normals(s_mesh* const mesh, const bool clockwise)
+{
+	const size_t vertex_count = mesh->vertices.size();
+	const size_t face_count = mesh->indices.size() / 3;
+	std::vector<s_vector3> normals(vertex_count, s_vector3{ 0.0f, 0.0f, 0.0f });
+
+	for (size_t face = 0; face < face_count; face++)
+	{
+		const uint32_t i0 = mesh->indices[face * 3 + 0];
+		const uint32_t i1 = mesh->indices[face * 3 + 1];
+		const uint32_t i2 = mesh->indices[face * 3 + 2];
+		if (i0 >= vertex_count || i1 >= vertex_count || i2 >= vertex_count)
+		{
+			LOG_WARNING("face %zu references a vertex out of range!", face);
+			return K_FAILURE;
+		}
+
+		const s_vector3 p0 = load_vector3(mesh->vertices[i0].position);
+		const s_vector3 p1 = load_vector3(mesh->vertices[i1].position);
+		const s_vector3 p2 = load_vector3(mesh->vertices[i2].position);
+		const s_vector3 face_normal = normalise(cross(p1 - p0, p2 - p0));
+
+		normals[i0] = normals[i0] + face_normal * corner_angle(p1 - p0, p2 - p0);
+		normals[i1] = normals[i1] + face_normal * corner_angle(p2 - p1, p0 - p1);
+		normals[i2] = normals[i2] + face_normal * corner_angle(p0 - p2, p1 - p2);
+	}
+
+	for (size_t i = 0; i < vertex_count; i++)
+	{
+		const s_vector3 normal = normalise(normals[i]) * (clockwise ? -1.0f : 1.0f);
+		store_vector3(normal, mesh->vertices[i].normal);
+	}
+
+	return K_SUCCESS;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <mesh/mesh.h>
+
+// Replace vertex normals with face normals weighted by the angle each face makes at the vertex
+// Same weighting as DirectXMesh's ComputeNormals default, which meshconvert uses when an .OBJ has no normals
+bool compute_normals(s_mesh* const mesh, const bool clockwise);
@@ -0,0 +1,479 @@
+#include "obj_reader.h"
+#include <common/report.h>
+#include <common/thread_pool.h>
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+
+// Chunks are cut at the first line break after each multiple of this size
+constexpr size_t OBJ_CHUNK_SIZE = 64 * 1024;
+// Marks a face corner with no texcoord or normal reference
+constexpr int64_t OBJ_INDEX_NONE = INT64_MIN;
+
+enum e_obj_corner_flags : uint8_t
+{
+	// Index was negative, stored relative to the chunk's first element until resolved
+	_obj_corner_relative_position = 1 << 0,
+	_obj_corner_relative_tex_coord = 1 << 1,
+	_obj_corner_relative_normal = 1 << 2,
+};
+
+struct s_obj_corner
+{
+	int64_t position;
+	int64_t tex_coord;
+	int64_t normal;
+	uint8_t flags;
+};
+
+// Vertex data as referenced by faces, before tangents are known
+// Compared bitwise while welding, the same way WaveFrontReader's memcmp does
+struct s_obj_vertex
+{
+	float position[3];
+	float normal[3];
+	float tex_coord[2];
+};
+static_assert(sizeof(s_obj_vertex) == 0x20);
+
+struct s_obj_chunk
+{
+	std::string_view text;
+	uint32_t first_line;
+
+	std::vector<s_vector3> positions;
+	std::vector<s_vector3> normals;
+	std::vector<float> tex_coords; // u, v pairs
+	std::vector<s_obj_corner> corners;
+	std::vector<uint32_t> face_corner_counts;
+
+	// prefix sums of element counts in earlier chunks, used to resolve indices
+	uint64_t position_base;
+	uint64_t normal_base;
+	uint64_t tex_coord_base;
+
+	std::vector<s_obj_vertex> vertices; // one per corner once resolved
+	bool failed;
+};
+
+static inline bool is_space(const char character)
+{
+	return character == ' ' || character == '\t' || character == '\r';
+}
+
+static inline void skip_spaces(const char*& cursor, const char* const end)
+{
+	while (cursor < end && is_space(*cursor))
+	{
+		cursor++;
+	}
+}
+
+static bool parse_floats(const char*& cursor, const char* const end, float* const out_values, const uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		skip_spaces(cursor, end);
+		// from_chars doesn't accept a leading '+'
+		if (cursor < end && *cursor == '+')
+		{
+			cursor++;
+		}
+		const std::from_chars_result result = std::from_chars(cursor, end, out_values[i]);
+		if (result.ec != std::errc())
+		{
+			return K_FAILURE;
+		}
+		cursor = result.ptr;
+	}
+	return K_SUCCESS;
+}
+
+static bool parse_index(const char*& cursor, const char* const end, int64_t* const out_index)
+{
+	if (cursor < end && *cursor == '+')
+	{
+		cursor++;
+	}
+	const std::from_chars_result result = std::from_chars(cursor, end, *out_index);
+	if (result.ec != std::errc() || *out_index == 0)
+	{
+		// 0 is not allowed for an index
+		return K_FAILURE;
+	}
+	cursor = result.ptr;
+	return K_SUCCESS;
+}
+
+// OBJ indices are 1 based, negative indices count back from the most recently declared element
+static inline int64_t to_chunk_index(const int64_t obj_index, const size_t chunk_element_count, bool* const out_relative)
+{
+	*out_relative = obj_index < 0;
+	return obj_index < 0 ? static_cast<int64_t>(chunk_element_count) + obj_index : obj_index - 1;
+}
+
+static bool parse_face(const char* cursor, const char* const end, s_obj_chunk* const chunk)
+{
+	uint32_t corner_count = 0;
+	for (;;)
+	{
+		skip_spaces(cursor, end);
+		if (cursor >= end || *cursor == '#')
+		{
+			break;
+		}
+
+		s_obj_corner corner = { OBJ_INDEX_NONE, OBJ_INDEX_NONE, OBJ_INDEX_NONE, 0 };
+		bool relative = false;
+		int64_t index = 0;
+
+		if (!parse_index(cursor, end, &index))
+		{
+			return K_FAILURE;
+		}
+		corner.position = to_chunk_index(index, chunk->positions.size(), &relative);
+		corner.flags |= relative ? _obj_corner_relative_position : 0;
+
+		if (cursor < end && *cursor == '/')
+		{
+			cursor++;
+			// Optional texcoord, skipped for p//n
+			if (cursor < end && *cursor != '/')
+			{
+				if (!parse_index(cursor, end, &index))
+				{
+					return K_FAILURE;
+				}
+				corner.tex_coord = to_chunk_index(index, chunk->tex_coords.size() / 2, &relative);
+				corner.flags |= relative ? _obj_corner_relative_tex_coord : 0;
+			}
+			// Optional normal
+			if (cursor < end && *cursor == '/')
+			{
+				cursor++;
+				if (!parse_index(cursor, end, &index))
+				{
+					return K_FAILURE;
+				}
+				corner.normal = to_chunk_index(index, chunk->normals.size(), &relative);
+				corner.flags |= relative ? _obj_corner_relative_normal : 0;
+			}
+		}
+
+		if (cursor < end && !is_space(*cursor))
+		{
+			return K_FAILURE;
+		}
+
+		chunk->corners.push_back(corner);
+		corner_count++;
+	}
+
+	// Need at least 3 points to form a triangle
+	if (corner_count < 3)
+	{
+		return K_FAILURE;
+	}
+	chunk->face_corner_counts.push_back(corner_count);
+	return K_SUCCESS;
+}
+
+static void parse_chunk(const std::filesystem::path& file_path, s_obj_chunk* const chunk)
+{
+	const char* cursor = chunk->text.data();
+	const char* const end = cursor + chunk->text.size();
+	uint32_t line = chunk->first_line;
+
+	while (cursor < end)
+	{
+		const char* line_end = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		line_end = line_end != nullptr ? line_end : end;
+
+		skip_spaces(cursor, line_end);
+		const char* const command = cursor;
+		while (cursor < line_end && !is_space(*cursor))
+		{
+			cursor++;
+		}
+		const std::string_view command_name(command, cursor - command);
+
+		// Extra components (w, vertex colours) are ignored, as are groups, smoothing groups & materials
+		bool line_valid = true;
+		if (command_name == "v")
+		{
+			s_vector3 position;
+			line_valid = parse_floats(cursor, line_end, &position.x, 3);
+			chunk->positions.push_back(position);
+		}
+		else if (command_name == "vt")
+		{
+			float tex_coord[2];
+			line_valid = parse_floats(cursor, line_end, tex_coord, 2);
+			chunk->tex_coords.insert(chunk->tex_coords.end(), tex_coord, tex_coord + 2);
+		}
+		else if (command_name == "vn")
+		{
+			s_vector3 normal;
+			line_valid = parse_floats(cursor, line_end, &normal.x, 3);
+			chunk->normals.push_back(normal);
+		}
+		else if (command_name == "f")
+		{
+			line_valid = parse_face(cursor, line_end, chunk);
+		}
+
+		if (!line_valid)
+		{
+			LOG_WARNING("%s(%u): malformed '%.*s' statement", file_path.string().c_str(), line, static_cast<int>(command_name.size()), command_name.data());
+			chunk->failed = true;
+			return;
+		}
+
+		cursor = line_end + 1;
+		line++;
+	}
+}
+
+static inline bool resolve_index(int64_t index, const bool relative, const uint64_t base, const uint64_t total_count, uint64_t* const out_index)
+{
+	index += relative ? static_cast<int64_t>(base) : 0;
+	*out_index = static_cast<uint64_t>(index);
+	return index >= 0 && static_cast<uint64_t>(index) < total_count;
+}
+
+// Turns every corner into a full vertex, indices are resolved against every chunk's elements
+static void resolve_chunk(const std::filesystem::path& file_path, const std::vector<s_obj_chunk>& chunks, const uint64_t total_counts[3], s_obj_chunk* const chunk)
+{
+	// Find the chunk that owns a global element index, elements are looked up in place rather than concatenated
+	auto find_chunk = [&chunks](const uint64_t index, uint64_t s_obj_chunk::* const base) -> const s_obj_chunk*
+	{
+		size_t low = 0;
+		size_t high = chunks.size();
+		while (high - low > 1)
+		{
+			const size_t middle = (low + high) / 2;
+			if (chunks[middle].*base <= index)
+			{
+				low = middle;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		return &chunks[low];
+	};
+
+	chunk->vertices.resize(chunk->corners.size());
+	for (size_t i = 0; i < chunk->corners.size(); i++)
+	{
+		const s_obj_corner& corner = chunk->corners[i];
+		s_obj_vertex& vertex = chunk->vertices[i];
+		memset(&vertex, 0, sizeof(vertex));
+
+		uint64_t index = 0;
+		if (!resolve_index(corner.position, corner.flags & _obj_corner_relative_position, chunk->position_base, total_counts[0], &index))
+		{
+			LOG_WARNING("%s: face references position %lld which does not exist", file_path.string().c_str(), static_cast<long long>(index) + 1);
+			chunk->failed = true;
+			return;
+		}
+		const s_obj_chunk* owner = find_chunk(index, &s_obj_chunk::position_base);
+		store_vector3(owner->positions[index - owner->position_base], vertex.position);
+
+		if (corner.tex_coord != OBJ_INDEX_NONE)
+		{
+			if (!resolve_index(corner.tex_coord, corner.flags & _obj_corner_relative_tex_coord, chunk->tex_coord_base, total_counts[1], &index))
+			{
+				LOG_WARNING("%s: face references texcoord %lld which does not exist", file_path.string().c_str(), static_cast<long long>(index) + 1);
+				chunk->failed = true;
+				return;
+			}
+			owner = find_chunk(index, &s_obj_chunk::tex_coord_base);
+			vertex.tex_coord[0] = owner->tex_coords[(index - owner->tex_coord_base) * 2 + 0];
+			vertex.tex_coord[1] = owner->tex_coords[(index - owner->tex_coord_base) * 2 + 1];
+		}
+
+		if (corner.normal != OBJ_INDEX_NONE)
+		{
+			if (!resolve_index(corner.normal, corner.flags & _obj_corner_relative_normal, chunk->normal_base, total_counts[2], &index))
+			{
+				LOG_WARNING("%s: face references normal %lld which does not exist", file_path.string().c_str(), static_cast<long long>(index) + 1);
+				chunk->failed = true;
+				return;
+			}
+			owner = find_chunk(index, &s_obj_chunk::normal_base);
+			store_vector3(owner->normals[index - owner->normal_base], vertex.normal);
+		}
+	}
+}
+
+// Open addressing hash table from vertex contents to welded vertex index
+class c_vertex_welder
+{
+public:
+	explicit c_vertex_welder(const size_t maximum_vertex_count)
+	{
+		size_t capacity = 64;
+		while (capacity < maximum_vertex_count * 2)
+		{
+			capacity *= 2;
+		}
+		m_slots.assign(capacity, UINT32_MAX);
+	}
+
+	uint32_t add(const s_obj_vertex& vertex, std::vector<s_obj_vertex>* const vertices)
+	{
+		const size_t mask = m_slots.size() - 1;
+		for (size_t slot = hash(vertex) & mask;; slot = (slot + 1) & mask)
+		{
+			const uint32_t index = m_slots[slot];
+			if (index == UINT32_MAX)
+			{
+				m_slots[slot] = static_cast<uint32_t>(vertices->size());
+				vertices->push_back(vertex);
+				return m_slots[slot];
+			}
+			if (memcmp(&(*vertices)[index], &vertex, sizeof(s_obj_vertex)) == 0)
+			{
+				return index;
+			}
+		}
+	}
+
+private:
+	static uint64_t hash(const s_obj_vertex& vertex)
+	{
+		uint32_t words[sizeof(s_obj_vertex) / sizeof(uint32_t)];
+		memcpy(words, &vertex, sizeof(words));
+
+		// FNV-1a over whole words, then a finaliser to spread the low bits used for the slot
+		uint64_t value = 0xCBF29CE484222325ull;
+		for (const uint32_t word : words)
+		{
+			value = (value ^ word) * 0x100000001B3ull;
+		}
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	std::vector<uint32_t> m_slots;
+};
+
+bool read_obj(const std::filesystem::path& file_path, const s_obj_options& options, c_thread_pool* const thread_pool, s_mesh* const out_mesh, s_obj_statistics* const out_statistics)
+{
+	*out_statistics = {};
+
+	std::ifstream obj_file(file_path, std::ios::in | std::ios::binary | std::ios::ate);
+	if (obj_file.fail())
+	{
+		LOG_WARNING("failed to open %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	const size_t file_size = static_cast<size_t>(obj_file.tellg());
+	std::vector<char> file_data(file_size);
+	obj_file.seekg(0);
+	obj_file.read(file_data.data(), file_size);
+	if (obj_file.fail())
+	{
+		LOG_WARNING("failed to read %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	out_statistics->file_size = file_size;
+
+	// Split on line boundaries, counting lines as we go so warnings can point at the right place
+	std::vector<s_obj_chunk> chunks;
+	const char* const data = file_data.data();
+	size_t chunk_start = 0;
+	uint32_t line = 1;
+	while (chunk_start < file_size)
+	{
+		size_t chunk_end = std::min(chunk_start + OBJ_CHUNK_SIZE, file_size);
+		const void* const line_break = chunk_end < file_size ? memchr(data + chunk_end, '\n', file_size - chunk_end) : nullptr;
+		chunk_end = line_break != nullptr ? static_cast<const char*>(line_break) - data + 1 : file_size;
+
+		s_obj_chunk chunk = {};
+		chunk.text = std::string_view(data + chunk_start, chunk_end - chunk_start);
+		chunk.first_line = line;
+		chunks.push_back(std::move(chunk));
+
+		line += static_cast<uint32_t>(std::count(data + chunk_start, data + chunk_end, '\n'));
+		chunk_start = chunk_end;
+	}
+	out_statistics->chunk_count = static_cast<uint32_t>(chunks.size());
+
+	parallel_for(thread_pool, chunks.size(), [&](const size_t i) { parse_chunk(file_path, &chunks[i]); });
+
+	// Element bases for each chunk, relative indices & lookups resolve against these
+	uint64_t total_counts[3] = {};
+	size_t corner_count = 0;
+	for (s_obj_chunk& chunk : chunks)
+	{
+		if (chunk.failed)
+		{
+			return K_FAILURE;
+		}
+		chunk.position_base = total_counts[0];
+		chunk.tex_coord_base = total_counts[1];
+		chunk.normal_base = total_counts[2];
+		total_counts[0] += chunk.positions.size();
+		total_counts[1] += chunk.tex_coords.size() / 2;
+		total_counts[2] += chunk.normals.size();
+		corner_count += chunk.corners.size();
+	}
+	out_statistics->corner_count = static_cast<uint32_t>(corner_count);
+	out_statistics->has_tex_coords = total_counts[1] > 0;
+	out_statistics->has_normals = total_counts[2] > 0;
+
+	parallel_for(thread_pool, chunks.size(), [&](const size_t i) { resolve_chunk(file_path, chunks, total_counts, &chunks[i]); });
+
+	// Weld & triangulate serially so vertex order matches first use, exactly as meshconvert writes it
+	std::vector<s_obj_vertex> welded_vertices;
+	welded_vertices.reserve(corner_count);
+	c_vertex_welder welder(corner_count);
+	out_mesh->indices.clear();
+	for (const s_obj_chunk& chunk : chunks)
+	{
+		if (chunk.failed)
+		{
+			return K_FAILURE;
+		}
+
+		size_t corner = 0;
+		for (const uint32_t face_corner_count : chunk.face_corner_counts)
+		{
+			// Fan triangulate polygons around their first corner
+			const uint32_t i0 = welder.add(chunk.vertices[corner], &welded_vertices);
+			uint32_t i1 = welder.add(chunk.vertices[corner + 1], &welded_vertices);
+			for (uint32_t j = 2; j < face_corner_count; j++)
+			{
+				const uint32_t index = welder.add(chunk.vertices[corner + j], &welded_vertices);
+				out_mesh->indices.push_back(i0);
+				out_mesh->indices.push_back(options.clockwise ? index : i1);
+				out_mesh->indices.push_back(options.clockwise ? i1 : index);
+				i1 = index;
+			}
+			corner += face_corner_count;
+		}
+	}
+
+	if (out_mesh->indices.empty())
+	{
+		LOG_WARNING("%s contains no faces!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	out_mesh->vertices.assign(welded_vertices.size(), s_mesh_file_vertex{});
+	for (size_t i = 0; i < welded_vertices.size(); i++)
+	{
+		memcpy(out_mesh->vertices[i].position, welded_vertices[i].position, sizeof(float) * 3);
+		memcpy(out_mesh->vertices[i].normal, welded_vertices[i].normal, sizeof(float) * 3);
+		memcpy(out_mesh->vertices[i].tex_coord, welded_vertices[i].tex_coord, sizeof(float) * 2);
+	}
+
+	return K_SUCCESS;
+}
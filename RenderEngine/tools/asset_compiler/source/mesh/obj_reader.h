@@ -0,0 +1,24 @@
+#pragma once
+#include <mesh/mesh.h>
+#include <filesystem>
+
+class c_thread_pool;
+
+struct s_obj_options
+{
+	bool clockwise; // emit faces clockwise instead of meshconvert's default counter clockwise
+};
+
+struct s_obj_statistics
+{
+	uint64_t file_size;
+	uint32_t chunk_count;
+	uint32_t corner_count; // face corners before welding
+	bool has_normals;
+	bool has_tex_coords;
+};
+
+// Parse a Wavefront .OBJ into a welded, fan triangulated mesh, matching meshconvert's WaveFrontReader output
+// Files larger than one chunk are split on line boundaries and the chunks parsed in parallel on thread_pool
+// Vertices are welded on their exact position, normal & texcoord bits with a hash table, in order of first use
+bool read_obj(const std::filesystem::path& file_path, const s_obj_options& options, c_thread_pool* const thread_pool, s_mesh* const out_mesh, s_obj_statistics* const out_statistics);
@@ -0,0 +1,28 @@
+#include "position_weld.h"
+#include <algorithm>
+#include <numeric>
+
+uint32_t weld_positions(const s_mesh& mesh, std::vector<uint32_t>* const out_vertex_positions)
+{
+	const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	out_vertex_positions->assign(vertex_count, 0);
+
+	std::vector<uint32_t> sorted_vertices(vertex_count);
+	std::iota(sorted_vertices.begin(), sorted_vertices.end(), 0);
+	const auto position_less = [&mesh](const uint32_t a, const uint32_t b)
+	{
+		const float* const position_a = mesh.vertices[a].position;
+		const float* const position_b = mesh.vertices[b].position;
+		return std::lexicographical_compare(position_a, position_a + 3, position_b, position_b + 3);
+	};
+	std::sort(sorted_vertices.begin(), sorted_vertices.end(), position_less);
+
+	uint32_t position_count = 0;
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		const uint32_t vertex = sorted_vertices[i];
+		position_count += i == 0 || position_less(sorted_vertices[i - 1], vertex) ? 1 : 0;
+		(*out_vertex_positions)[vertex] = position_count - 1;
+	}
+	return position_count;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <mesh/mesh.h>
+
+// Map every vertex to a shared id for its position, vertices split only by normals or texcoords get the same id
+// Returns the number of distinct positions, ids are in sorted position order
+uint32_t weld_positions(const s_mesh& mesh, std::vector<uint32_t>* const out_vertex_positions);
@@ -0,0 +1,100 @@
+#include "tangent_frame.h"
+#include <common/report.h>
+
+bool compute_tangent_frame(s_mesh* const mesh)
+{
+	constexpr float EPSILON = 0.0001f;
+	const size_t vertex_count = mesh->vertices.size();
+	const size_t face_count = mesh->indices.size() / 3;
+
+	std::vector<s_vector3> tangents(vertex_count, s_vector3{ 0.0f, 0.0f, 0.0f });
+	std::vector<s_vector3> bitangents(vertex_count, s_vector3{ 0.0f, 0.0f, 0.0f });
+
+	// Accumulate each face's texture space basis onto its vertices
+	for (size_t face = 0; face < face_count; face++)
+	{
+		const uint32_t i0 = mesh->indices[face * 3 + 0];
+		const uint32_t i1 = mesh->indices[face * 3 + 1];
+		const uint32_t i2 = mesh->indices[face * 3 + 2];
+		if (i0 >= vertex_count || i1 >= vertex_count || i2 >= vertex_count)
+		{
+			LOG_WARNING("face %zu references a vertex out of range!", face);
+			return K_FAILURE;
+		}
+
+		const s_mesh_file_vertex& v0 = mesh->vertices[i0];
+		const s_mesh_file_vertex& v1 = mesh->vertices[i1];
+		const s_mesh_file_vertex& v2 = mesh->vertices[i2];
+
+		const float du1 = v1.tex_coord[0] - v0.tex_coord[0];
+		const float dv1 = v1.tex_coord[1] - v0.tex_coord[1];
+		const float du2 = v2.tex_coord[0] - v0.tex_coord[0];
+		const float dv2 = v2.tex_coord[1] - v0.tex_coord[1];
+
+		float determinant = du1 * dv2 - dv1 * du2;
+		determinant = fabsf(determinant) <= EPSILON ? 1.0f : 1.0f / determinant;
+
+		const s_vector3 edge1 = load_vector3(v1.position) - load_vector3(v0.position);
+		const s_vector3 edge2 = load_vector3(v2.position) - load_vector3(v0.position);
+		const s_vector3 face_tangent = (edge1 * dv2 - edge2 * dv1) * determinant;
+		const s_vector3 face_bitangent = (edge2 * du1 - edge1 * du2) * determinant;
+
+		for (const uint32_t index : { i0, i1, i2 })
+		{
+			tangents[index] = tangents[index] + face_tangent;
+			bitangents[index] = bitangents[index] + face_bitangent;
+		}
+	}
+
+	for (size_t i = 0; i < vertex_count; i++)
+	{
+		// Gram-Schmidt orthonormalisation
+		const s_vector3 normal = normalise(load_vector3(mesh->vertices[i].normal));
+		s_vector3 tangent = normalise(tangents[i] - normal * dot(normal, tangents[i]));
+		s_vector3 bitangent = normalise(bitangents[i] - normal * dot(normal, bitangents[i]) - tangent * dot(tangent, bitangents[i]));
+
+		// handle degenerate vectors
+		const float tangent_length = length(tangent);
+		const float bitangent_length = length(bitangent);
+		if (tangent_length <= EPSILON || bitangent_length <= EPSILON)
+		{
+			if (tangent_length > 0.5f)
+			{
+				// Reset bitangent from tangent and normal
+				bitangent = cross(normal, tangent);
+			}
+			else if (bitangent_length > 0.5f)
+			{
+				// Reset tangent from bitangent and normal
+				tangent = cross(bitangent, normal);
+			}
+			else
+			{
+				// Reset both from the normal and whichever axis it is least aligned with
+				const float d0 = fabsf(normal.x);
+				const float d1 = fabsf(normal.y);
+				const float d2 = fabsf(normal.z);
+				s_vector3 axis;
+				if (d0 < d1)
+				{
+					axis = d0 < d2 ? s_vector3{ 1.0f, 0.0f, 0.0f } : s_vector3{ 0.0f, 0.0f, 1.0f };
+				}
+				else if (d1 < d2)
+				{
+					axis = s_vector3{ 0.0f, 1.0f, 0.0f };
+				}
+				else
+				{
+					axis = s_vector3{ 0.0f, 0.0f, 1.0f };
+				}
+				tangent = cross(normal, axis);
+				bitangent = cross(normal, tangent);
+			}
+		}
+
+		store_vector3(tangent, mesh->vertices[i].tangent);
+		store_vector3(bitangent, mesh->vertices[i].bitangent);
+	}
+
+	return K_SUCCESS;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <mesh/mesh.h>
+
+// Fill in per vertex tangents & bitangents from positions, normals and texcoords
+// Same accumulation, Gram-Schmidt & degenerate handling as DirectXMesh's ComputeTangentFrame, which isn't available off Windows
+bool compute_tangent_frame(s_mesh* const mesh);
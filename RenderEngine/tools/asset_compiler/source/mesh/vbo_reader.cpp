@@ -0,0 +1,65 @@
+#include "vbo_reader.h"
+#include <common/report.h>
+#include <fstream>
+#include <cstring>
+
+// Matches vertex_part in the engine's types.h
+struct s_vbo_vertex
+{
+	float position[3];
+	float normal[3];
+	float tex_coord[2];
+};
+static_assert(sizeof(s_vbo_vertex) == 0x20);
+
+bool read_vbo(const std::filesystem::path& file_path, s_mesh* const out_mesh)
+{
+	std::ifstream vbo_file(file_path, std::ios::in | std::ios::binary);
+	if (vbo_file.fail())
+	{
+		LOG_WARNING("failed to open %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	uint32_t vertex_count = 0;
+	uint32_t index_count = 0;
+	vbo_file.read(reinterpret_cast<char*>(&vertex_count), sizeof(uint32_t));
+	vbo_file.read(reinterpret_cast<char*>(&index_count), sizeof(uint32_t));
+	if (vbo_file.fail() || vertex_count == 0 || index_count == 0 || index_count % 3 != 0)
+	{
+		LOG_WARNING("%s has an invalid header (%u vertices, %u indices)!", file_path.string().c_str(), vertex_count, index_count);
+		return K_FAILURE;
+	}
+
+	std::vector<s_vbo_vertex> vbo_vertices(vertex_count);
+	std::vector<uint16_t> vbo_indices(index_count);
+	vbo_file.read(reinterpret_cast<char*>(vbo_vertices.data()), sizeof(s_vbo_vertex) * vertex_count);
+	vbo_file.read(reinterpret_cast<char*>(vbo_indices.data()), sizeof(uint16_t) * index_count);
+	if (vbo_file.fail())
+	{
+		LOG_WARNING("%s is truncated!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	out_mesh->vertices.assign(vertex_count, s_mesh_file_vertex{});
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		s_mesh_file_vertex& mesh_vertex = out_mesh->vertices[i];
+		memcpy(mesh_vertex.position, vbo_vertices[i].position, sizeof(mesh_vertex.position));
+		memcpy(mesh_vertex.normal, vbo_vertices[i].normal, sizeof(mesh_vertex.normal));
+		memcpy(mesh_vertex.tex_coord, vbo_vertices[i].tex_coord, sizeof(mesh_vertex.tex_coord));
+	}
+
+	out_mesh->indices.resize(index_count);
+	for (uint32_t i = 0; i < index_count; i++)
+	{
+		if (vbo_indices[i] >= vertex_count)
+		{
+			LOG_WARNING("%s index %u is out of range (%u >= %u)!", file_path.string().c_str(), i, vbo_indices[i], vertex_count);
+			return K_FAILURE;
+		}
+		out_mesh->indices[i] = vbo_indices[i];
+	}
+
+	return K_SUCCESS;
+}
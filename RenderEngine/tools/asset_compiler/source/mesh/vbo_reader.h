@@ -0,0 +1,7 @@
+#pragma once
+#include <mesh/mesh.h>
+#include <filesystem>
+
+// Read a .VBO written by meshconvert (positions, normals & texcoords, 16 bit indices)
+// Tangents & bitangents are left zeroed
+bool read_vbo(const std::filesystem::path& file_path, s_mesh* const out_mesh);
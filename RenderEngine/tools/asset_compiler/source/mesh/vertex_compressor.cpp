@@ -0,0 +1,69 @@
+#include "vertex_compressor.h"
+#include <asset/vertex_compression.h>
+#include <algorithm>
+#include <cfloat>
+
+// Bitangents this close to the normal & tangent plane have no meaningful handedness to preserve
+constexpr float HANDEDNESS_EPSILON = 1e-3f;
+
+static float direction_error(const float original[3], const float decoded[3])
+{
+	// Degenerate frames encode to an arbitrary direction, nothing is lost
+	const s_vector3 original_direction = normalise(load_vector3(original));
+	if (dot(original_direction, original_direction) == 0.0f)
+	{
+		return 0.0f;
+	}
+	return length(original_direction - load_vector3(decoded));
+}
+
+void compress_vertices(const s_mesh& mesh, const s_mesh_file_bounds& bounds, std::vector<s_mesh_file_compact_vertex>* const out_vertices, s_compact_vertex_error* const out_error)
+{
+	*out_error = {};
+	out_vertices->resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const s_mesh_file_vertex& vertex = mesh.vertices[i];
+		encode_compact_vertex(vertex, bounds, &(*out_vertices)[i]);
+
+		s_mesh_file_vertex decoded = {};
+		decode_compact_vertex((*out_vertices)[i], bounds, &decoded);
+
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			// Float rounding in the decode scales with distance from the origin rather than the extent, so isn't counted against the quantization
+			const float extent = bounds.maximum[axis] - bounds.minimum[axis];
+			const float rounding_error = 2.0f * FLT_EPSILON * std::max(fabsf(bounds.minimum[axis]), fabsf(bounds.maximum[axis]));
+			if (extent > 0.0f)
+			{
+				const float error = std::max(fabsf(decoded.position[axis] - vertex.position[axis]) - rounding_error, 0.0f);
+				out_error->position = std::max(out_error->position, error / extent);
+			}
+		}
+		out_error->normal = std::max(out_error->normal, direction_error(vertex.normal, decoded.normal));
+		out_error->tangent = std::max(out_error->tangent, direction_error(vertex.tangent, decoded.tangent));
+		for (uint32_t component = 0; component < 2; component++)
+		{
+			const float scale = std::max(fabsf(vertex.tex_coord[component]), 1.0f);
+			out_error->tex_coord = std::max(out_error->tex_coord, fabsf(decoded.tex_coord[component] - vertex.tex_coord[component]) / scale);
+		}
+
+		const s_vector3 normal = normalise(load_vector3(vertex.normal));
+		const s_vector3 tangent = normalise(load_vector3(vertex.tangent));
+		const s_vector3 bitangent = normalise(load_vector3(vertex.bitangent));
+		const float handedness = dot(cross(normal, tangent), bitangent);
+		if (fabsf(handedness) > HANDEDNESS_EPSILON && dot(load_vector3(decoded.bitangent), bitangent) < 0.0f)
+		{
+			out_error->flipped_bitangent_count++;
+		}
+	}
+}
+
+bool is_compact_vertex_error_valid(const s_compact_vertex_error& error)
+{
+	return error.position <= COMPACT_POSITION_ERROR_BOUND &&
+		error.normal <= COMPACT_DIRECTION_ERROR_BOUND &&
+		error.tangent <= COMPACT_DIRECTION_ERROR_BOUND &&
+		error.tex_coord <= COMPACT_TEX_COORD_ERROR_BOUND &&
+		error.flipped_bitangent_count == 0;
+}
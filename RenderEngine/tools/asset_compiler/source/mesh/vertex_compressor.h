@@ -0,0 +1,18 @@
+#pragma once
+#include <mesh/mesh.h>
+#include <vector>
+
+// Largest difference between each original vertex & its decoded compact form
+struct s_compact_vertex_error
+{
+	float position; // fraction of the mesh extent on the worst axis
+	float normal; // distance between unit vectors
+	float tangent;
+	float tex_coord; // relative to the larger of |uv| and 1
+	uint32_t flipped_bitangent_count; // decoded bitangents pointing away from the original
+};
+
+// Encode every vertex to the compact layout, then decode it again with the shader's maths to measure the error
+void compress_vertices(const s_mesh& mesh, const s_mesh_file_bounds& bounds, std::vector<s_mesh_file_compact_vertex>* const out_vertices, s_compact_vertex_error* const out_error);
+// True if every error is within the bounds in vertex_compression.h
+bool is_compact_vertex_error_valid(const s_compact_vertex_error& error);
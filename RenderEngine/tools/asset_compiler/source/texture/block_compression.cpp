@@ -0,0 +1,614 @@
+#include "block_compression.h"
+#include <common/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr uint32_t BLOCK_PIXEL_COUNT = 16;
+// Least squares passes over the endpoints, each one refits indices to the new endpoints & is kept only if it lowers the error
+constexpr uint32_t ENDPOINT_REFINEMENT_COUNT = 2;
+constexpr uint32_t POWER_ITERATION_COUNT = 8;
+
+// BC7 interpolation weights out of 64 for 4 bit indices
+constexpr uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+constexpr uint32_t BC7_MODE_6 = 1 << 6;
+
+static uint32_t squared_difference(const int32_t a, const int32_t b)
+{
+	return static_cast<uint32_t>((a - b) * (a - b));
+}
+
+// Mean & principal axis of the block's first channel_count channels, found by power iteration on the covariance matrix
+template <uint32_t k_channel_count>
+static void compute_principal_axis(const uint8_t pixels[64], float out_mean[k_channel_count], float out_axis[k_channel_count])
+{
+	for (uint32_t channel = 0; channel < k_channel_count; channel++)
+	{
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			sum += pixels[i * 4 + channel];
+		}
+		out_mean[channel] = sum / BLOCK_PIXEL_COUNT;
+	}
+
+	float covariance[k_channel_count][k_channel_count] = {};
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		float delta[k_channel_count];
+		for (uint32_t channel = 0; channel < k_channel_count; channel++)
+		{
+			delta[channel] = pixels[i * 4 + channel] - out_mean[channel];
+		}
+		for (uint32_t row = 0; row < k_channel_count; row++)
+		{
+			for (uint32_t column = 0; column < k_channel_count; column++)
+			{
+				covariance[row][column] += delta[row] * delta[column];
+			}
+		}
+	}
+
+	// Start from the covariance of the channel with the most spread, a fixed start vector could be orthogonal to the axis
+	// A flat block has no spread at all & keeps a zero axis, so both endpoints land on the mean
+	uint32_t widest_channel = 0;
+	for (uint32_t channel = 1; channel < k_channel_count; channel++)
+	{
+		widest_channel = covariance[channel][channel] > covariance[widest_channel][widest_channel] ? channel : widest_channel;
+	}
+	for (uint32_t channel = 0; channel < k_channel_count; channel++)
+	{
+		out_axis[channel] = covariance[channel][widest_channel];
+	}
+	for (uint32_t iteration = 0; iteration < POWER_ITERATION_COUNT; iteration++)
+	{
+		float next_axis[k_channel_count] = {};
+		float length_squared = 0.0f;
+		for (uint32_t row = 0; row < k_channel_count; row++)
+		{
+			for (uint32_t column = 0; column < k_channel_count; column++)
+			{
+				next_axis[row] += covariance[row][column] * out_axis[column];
+			}
+			length_squared += next_axis[row] * next_axis[row];
+		}
+		if (length_squared <= 0.0f)
+		{
+			break;
+		}
+		const float inverse_length = 1.0f / sqrtf(length_squared);
+		for (uint32_t channel = 0; channel < k_channel_count; channel++)
+		{
+			out_axis[channel] = next_axis[channel] * inverse_length;
+		}
+	}
+}
+
+// Ends of the block's projection onto its principal axis, clamped to the representable range
+template <uint32_t k_channel_count>
+static void compute_axis_endpoints(const uint8_t pixels[64], float out_endpoint0[k_channel_count], float out_endpoint1[k_channel_count])
+{
+	float mean[k_channel_count];
+	float axis[k_channel_count];
+	compute_principal_axis<k_channel_count>(pixels, mean, axis);
+
+	float minimum_projection = 0.0f;
+	float maximum_projection = 0.0f;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		float projection = 0.0f;
+		for (uint32_t channel = 0; channel < k_channel_count; channel++)
+		{
+			projection += (pixels[i * 4 + channel] - mean[channel]) * axis[channel];
+		}
+		minimum_projection = std::min(minimum_projection, projection);
+		maximum_projection = std::max(maximum_projection, projection);
+	}
+	for (uint32_t channel = 0; channel < k_channel_count; channel++)
+	{
+		out_endpoint0[channel] = std::clamp(mean[channel] + axis[channel] * maximum_projection, 0.0f, 255.0f);
+		out_endpoint1[channel] = std::clamp(mean[channel] + axis[channel] * minimum_projection, 0.0f, 255.0f);
+	}
+}
+
+// Endpoints minimising the squared error for fixed indices, weights[i] is how much of endpoint1 pixel i gets
+// Returns false if every pixel uses the same weight, which leaves the endpoints undetermined
+template <uint32_t k_channel_count>
+static bool solve_endpoints(const uint8_t pixels[64], const float weights[16], float out_endpoint0[k_channel_count], float out_endpoint1[k_channel_count])
+{
+	float aa = 0.0f;
+	float ab = 0.0f;
+	float bb = 0.0f;
+	float ax[k_channel_count] = {};
+	float bx[k_channel_count] = {};
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const float b = weights[i];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (uint32_t channel = 0; channel < k_channel_count; channel++)
+		{
+			ax[channel] += a * pixels[i * 4 + channel];
+			bx[channel] += b * pixels[i * 4 + channel];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+	{
+		return false;
+	}
+	const float inverse_determinant = 1.0f / determinant;
+	for (uint32_t channel = 0; channel < k_channel_count; channel++)
+	{
+		out_endpoint0[channel] = std::clamp((ax[channel] * bb - bx[channel] * ab) * inverse_determinant, 0.0f, 255.0f);
+		out_endpoint1[channel] = std::clamp((bx[channel] * aa - ax[channel] * ab) * inverse_determinant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+static uint16_t quantise_565(const float colour[3])
+{
+	const uint32_t red = static_cast<uint32_t>(colour[0] * 31.0f / 255.0f + 0.5f);
+	const uint32_t green = static_cast<uint32_t>(colour[1] * 63.0f / 255.0f + 0.5f);
+	const uint32_t blue = static_cast<uint32_t>(colour[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<uint16_t>((red << 11) | (green << 5) | blue);
+}
+
+static void expand_565(const uint16_t colour, int32_t out_colour[3])
+{
+	const int32_t red = (colour >> 11) & 0x1F;
+	const int32_t green = (colour >> 5) & 0x3F;
+	const int32_t blue = colour & 0x1F;
+	out_colour[0] = (red << 3) | (red >> 2);
+	out_colour[1] = (green << 2) | (green >> 4);
+	out_colour[2] = (blue << 3) | (blue >> 2);
+}
+
+// Nearest of the 4 colour palette for each pixel, index 0 & 1 are the endpoints, 2 & 3 a third & two thirds of the way to endpoint 1
+static uint32_t fit_bc1_indices(const uint8_t pixels[64], const uint16_t colour0, const uint16_t colour1, uint32_t* const out_indices)
+{
+	int32_t palette[4][3];
+	expand_565(colour0, palette[0]);
+	expand_565(colour1, palette[1]);
+	for (uint32_t channel = 0; channel < 3; channel++)
+	{
+		palette[2][channel] = (2 * palette[0][channel] + palette[1][channel] + 1) / 3;
+		palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel] + 1) / 3;
+	}
+
+	uint32_t error = 0;
+	uint32_t indices = 0;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint32_t best_index = 0;
+		uint32_t best_error = UINT32_MAX;
+		for (uint32_t index = 0; index < 4; index++)
+		{
+			const uint32_t index_error =
+				squared_difference(pixels[i * 4 + 0], palette[index][0]) +
+				squared_difference(pixels[i * 4 + 1], palette[index][1]) +
+				squared_difference(pixels[i * 4 + 2], palette[index][2]);
+			if (index_error < best_error)
+			{
+				best_index = index;
+				best_error = index_error;
+			}
+		}
+		indices |= best_index << (i * 2);
+		error += best_error;
+	}
+	*out_indices = indices;
+	return error;
+}
+
+uint32_t encode_bc1_block(const uint8_t pixels[64], uint8_t out_block[8])
+{
+	constexpr float BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	float endpoint0[3];
+	float endpoint1[3];
+	compute_axis_endpoints<3>(pixels, endpoint0, endpoint1);
+	uint16_t colour0 = quantise_565(endpoint0);
+	uint16_t colour1 = quantise_565(endpoint1);
+	uint32_t indices = 0;
+	uint32_t error = fit_bc1_indices(pixels, colour0, colour1, &indices);
+
+	for (uint32_t refinement = 0; refinement < ENDPOINT_REFINEMENT_COUNT && error > 0; refinement++)
+	{
+		float weights[16];
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			weights[i] = BC1_WEIGHTS[(indices >> (i * 2)) & 3];
+		}
+		if (!solve_endpoints<3>(pixels, weights, endpoint0, endpoint1))
+		{
+			break;
+		}
+		const uint16_t refined_colour0 = quantise_565(endpoint0);
+		const uint16_t refined_colour1 = quantise_565(endpoint1);
+		uint32_t refined_indices = 0;
+		const uint32_t refined_error = fit_bc1_indices(pixels, refined_colour0, refined_colour1, &refined_indices);
+		if (refined_error >= error)
+		{
+			break;
+		}
+		colour0 = refined_colour0;
+		colour1 = refined_colour1;
+		indices = refined_indices;
+		error = refined_error;
+	}
+
+	// colour0 <= colour1 would switch the block to 3 colours & transparent black, swapping the endpoints swaps indices 0 & 1 and 2 & 3
+	if (colour0 < colour1)
+	{
+		std::swap(colour0, colour1);
+		indices ^= 0x55555555;
+	}
+	else if (colour0 == colour1)
+	{
+		indices = 0;
+		int32_t colour[3];
+		expand_565(colour0, colour);
+		error = 0;
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			error += squared_difference(pixels[i * 4 + 0], colour[0]) + squared_difference(pixels[i * 4 + 1], colour[1]) + squared_difference(pixels[i * 4 + 2], colour[2]);
+		}
+	}
+
+	memcpy(&out_block[0], &colour0, sizeof(uint16_t));
+	memcpy(&out_block[2], &colour1, sizeof(uint16_t));
+	memcpy(&out_block[4], &indices, sizeof(uint32_t));
+	return error;
+}
+
+// BC4 palette, 8 steps between the endpoints when value0 > value1, otherwise 6 steps plus exact 0 & 255
+static void build_bc4_palette(const uint32_t value0, const uint32_t value1, int32_t out_palette[8])
+{
+	out_palette[0] = value0;
+	out_palette[1] = value1;
+	if (value0 > value1)
+	{
+		for (uint32_t step = 1; step < 7; step++)
+		{
+			out_palette[step + 1] = ((7 - step) * value0 + step * value1 + 3) / 7;
+		}
+	}
+	else
+	{
+		for (uint32_t step = 1; step < 5; step++)
+		{
+			out_palette[step + 1] = ((5 - step) * value0 + step * value1 + 2) / 5;
+		}
+		out_palette[6] = 0;
+		out_palette[7] = 255;
+	}
+}
+
+static uint32_t fit_bc4_indices(const uint8_t pixels[64], const uint32_t channel, const uint32_t value0, const uint32_t value1, uint64_t* const out_indices)
+{
+	int32_t palette[8];
+	build_bc4_palette(value0, value1, palette);
+
+	uint32_t error = 0;
+	uint64_t indices = 0;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint32_t best_index = 0;
+		uint32_t best_error = UINT32_MAX;
+		for (uint32_t index = 0; index < 8; index++)
+		{
+			const uint32_t index_error = squared_difference(pixels[i * 4 + channel], palette[index]);
+			if (index_error < best_error)
+			{
+				best_index = index;
+				best_error = index_error;
+			}
+		}
+		indices |= static_cast<uint64_t>(best_index) << (i * 3);
+		error += best_error;
+	}
+	*out_indices = indices;
+	return error;
+}
+
+uint32_t encode_bc4_block(const uint8_t pixels[64], const uint32_t channel, uint8_t out_block[8])
+{
+	// The 8 step mode spans the whole block, the 6 step mode spans everything but exact 0s & 255s which it has its own entries for
+	uint32_t minimum = 255;
+	uint32_t maximum = 0;
+	uint32_t inner_minimum = 255;
+	uint32_t inner_maximum = 0;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const uint32_t value = pixels[i * 4 + channel];
+		minimum = std::min(minimum, value);
+		maximum = std::max(maximum, value);
+		if (value != 0 && value != 255)
+		{
+			inner_minimum = std::min(inner_minimum, value);
+			inner_maximum = std::max(inner_maximum, value);
+		}
+	}
+
+	uint32_t value0 = maximum;
+	uint32_t value1 = minimum;
+	uint64_t indices = 0;
+	uint32_t error = fit_bc4_indices(pixels, channel, value0, value1, &indices);
+	if (error > 0)
+	{
+		const uint32_t six_step_value0 = inner_minimum <= inner_maximum ? inner_minimum : minimum;
+		const uint32_t six_step_value1 = inner_minimum <= inner_maximum ? inner_maximum : minimum;
+		uint64_t six_step_indices = 0;
+		const uint32_t six_step_error = fit_bc4_indices(pixels, channel, six_step_value0, six_step_value1, &six_step_indices);
+		if (six_step_error < error)
+		{
+			value0 = six_step_value0;
+			value1 = six_step_value1;
+			indices = six_step_indices;
+			error = six_step_error;
+		}
+	}
+
+	out_block[0] = static_cast<uint8_t>(value0);
+	out_block[1] = static_cast<uint8_t>(value1);
+	for (uint32_t byte = 0; byte < 6; byte++)
+	{
+		out_block[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+	}
+	return error;
+}
+
+uint32_t encode_bc3_block(const uint8_t pixels[64], uint8_t out_block[16])
+{
+	const uint32_t alpha_error = encode_bc4_block(pixels, 3, &out_block[0]);
+	return alpha_error + encode_bc1_block(pixels, &out_block[8]);
+}
+
+uint32_t encode_bc5_block(const uint8_t pixels[64], uint8_t out_block[16])
+{
+	const uint32_t red_error = encode_bc4_block(pixels, 0, &out_block[0]);
+	return red_error + encode_bc4_block(pixels, 1, &out_block[8]);
+}
+
+struct s_bc7_endpoint
+{
+	uint32_t values[4]; // 7 bits
+	uint32_t p_bit;
+};
+
+// The shared low bit is picked per endpoint as whichever reproduces the endpoint more closely
+// Opaque blocks always take a set bit, the only way alpha can reach exactly 255
+static s_bc7_endpoint quantise_bc7_endpoint(const float endpoint[4], const bool opaque)
+{
+	s_bc7_endpoint best_endpoint = {};
+	float best_error = 0.0f;
+	for (uint32_t p_bit = opaque ? 1 : 0; p_bit < 2; p_bit++)
+	{
+		s_bc7_endpoint quantised_endpoint = {};
+		quantised_endpoint.p_bit = p_bit;
+		float error = 0.0f;
+		for (uint32_t channel = 0; channel < 4; channel++)
+		{
+			const float value = std::clamp(floorf((endpoint[channel] - p_bit) * 0.5f + 0.5f), 0.0f, 127.0f);
+			quantised_endpoint.values[channel] = static_cast<uint32_t>(value);
+			const float difference = value * 2.0f + p_bit - endpoint[channel];
+			error += difference * difference;
+		}
+		if (p_bit == 0 || opaque || error < best_error)
+		{
+			best_endpoint = quantised_endpoint;
+			best_error = error;
+		}
+	}
+	return best_endpoint;
+}
+
+static uint32_t fit_bc7_indices(const uint8_t pixels[64], const s_bc7_endpoint& endpoint0, const s_bc7_endpoint& endpoint1, uint8_t out_indices[16])
+{
+	int32_t palette[16][4];
+	for (uint32_t channel = 0; channel < 4; channel++)
+	{
+		const uint32_t value0 = (endpoint0.values[channel] << 1) | endpoint0.p_bit;
+		const uint32_t value1 = (endpoint1.values[channel] << 1) | endpoint1.p_bit;
+		for (uint32_t index = 0; index < 16; index++)
+		{
+			palette[index][channel] = ((64 - BC7_WEIGHTS[index]) * value0 + BC7_WEIGHTS[index] * value1 + 32) >> 6;
+		}
+	}
+
+	uint32_t error = 0;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		uint32_t best_index = 0;
+		uint32_t best_error = UINT32_MAX;
+		for (uint32_t index = 0; index < 16; index++)
+		{
+			const uint32_t index_error =
+				squared_difference(pixels[i * 4 + 0], palette[index][0]) +
+				squared_difference(pixels[i * 4 + 1], palette[index][1]) +
+				squared_difference(pixels[i * 4 + 2], palette[index][2]) +
+				squared_difference(pixels[i * 4 + 3], palette[index][3]);
+			if (index_error < best_error)
+			{
+				best_index = index;
+				best_error = index_error;
+			}
+		}
+		out_indices[i] = static_cast<uint8_t>(best_index);
+		error += best_error;
+	}
+	return error;
+}
+
+// Appends bits to a block least significant bit first
+class c_block_bit_writer
+{
+public:
+	explicit c_block_bit_writer(uint8_t* const block)
+		: m_block(block)
+		, m_bit_offset(0)
+	{
+	}
+
+	void write(const uint32_t value, const uint32_t bit_count)
+	{
+		for (uint32_t bit = 0; bit < bit_count; bit++, m_bit_offset++)
+		{
+			if ((value >> bit) & 1)
+			{
+				m_block[m_bit_offset / 8] |= static_cast<uint8_t>(1 << (m_bit_offset % 8));
+			}
+		}
+	}
+
+private:
+	uint8_t* const m_block;
+	uint32_t m_bit_offset;
+};
+
+uint32_t encode_bc7_block(const uint8_t pixels[64], uint8_t out_block[16])
+{
+	bool opaque = true;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		opaque = opaque && pixels[i * 4 + 3] == 0xFF;
+	}
+
+	float endpoint0[4];
+	float endpoint1[4];
+	compute_axis_endpoints<4>(pixels, endpoint0, endpoint1);
+	s_bc7_endpoint quantised_endpoint0 = quantise_bc7_endpoint(endpoint0, opaque);
+	s_bc7_endpoint quantised_endpoint1 = quantise_bc7_endpoint(endpoint1, opaque);
+	uint8_t indices[16];
+	uint32_t error = fit_bc7_indices(pixels, quantised_endpoint0, quantised_endpoint1, indices);
+
+	for (uint32_t refinement = 0; refinement < ENDPOINT_REFINEMENT_COUNT && error > 0; refinement++)
+	{
+		float weights[16];
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+		}
+		if (!solve_endpoints<4>(pixels, weights, endpoint0, endpoint1))
+		{
+			break;
+		}
+		const s_bc7_endpoint refined_endpoint0 = quantise_bc7_endpoint(endpoint0, opaque);
+		const s_bc7_endpoint refined_endpoint1 = quantise_bc7_endpoint(endpoint1, opaque);
+		uint8_t refined_indices[16];
+		const uint32_t refined_error = fit_bc7_indices(pixels, refined_endpoint0, refined_endpoint1, refined_indices);
+		if (refined_error >= error)
+		{
+			break;
+		}
+		quantised_endpoint0 = refined_endpoint0;
+		quantised_endpoint1 = refined_endpoint1;
+		memcpy(indices, refined_indices, sizeof(indices));
+		error = refined_error;
+	}
+
+	// The first index's top bit is implied zero, the weights are symmetric so swapping the endpoints mirrors every index exactly
+	if (indices[0] >= 8)
+	{
+		std::swap(quantised_endpoint0, quantised_endpoint1);
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			indices[i] = static_cast<uint8_t>(15 - indices[i]);
+		}
+	}
+
+	memset(out_block, 0, 16);
+	c_block_bit_writer writer(out_block);
+	writer.write(BC7_MODE_6, 7);
+	for (uint32_t channel = 0; channel < 4; channel++)
+	{
+		writer.write(quantised_endpoint0.values[channel], 7);
+		writer.write(quantised_endpoint1.values[channel], 7);
+	}
+	writer.write(quantised_endpoint0.p_bit, 1);
+	writer.write(quantised_endpoint1.p_bit, 1);
+	writer.write(indices[0], 3);
+	for (uint32_t i = 1; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		writer.write(indices[i], 4);
+	}
+	return error;
+}
+
+uint32_t get_texture_format_channel_count(const e_texture_format format)
+{
+	switch (format)
+	{
+	case _texture_format_bc1:
+		return 3;
+	case _texture_format_bc4:
+		return 1;
+	case _texture_format_bc5:
+		return 2;
+	case _texture_format_bc3:
+	case _texture_format_bc7:
+	default:
+		return 4;
+	}
+}
+
+uint64_t encode_image(const s_image& image, const e_texture_format format, c_thread_pool* const thread_pool, std::vector<uint8_t>* const out_blocks)
+{
+	const uint32_t block_columns = get_block_count(image.width);
+	const uint32_t block_rows = get_block_count(image.height);
+	const uint32_t block_size = get_texture_format_block_size(format);
+	out_blocks->assign(static_cast<size_t>(block_columns) * block_rows * block_size, 0);
+
+	// One job per row of blocks, rows are independent
+	std::vector<uint64_t> row_errors(block_rows, 0);
+	parallel_for(thread_pool, block_rows, [&image, format, out_blocks, &row_errors, block_columns, block_size](const size_t block_row)
+	{
+		uint64_t row_error = 0;
+		for (uint32_t block_column = 0; block_column < block_columns; block_column++)
+		{
+			uint8_t pixels[64];
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				const uint32_t image_y = std::min(static_cast<uint32_t>(block_row) * 4 + y, image.height - 1);
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					const uint32_t image_x = std::min(block_column * 4 + x, image.width - 1);
+					memcpy(&pixels[(y * 4 + x) * 4], &image.pixels[(static_cast<size_t>(image_y) * image.width + image_x) * 4], 4);
+				}
+			}
+
+			uint8_t* const block = &(*out_blocks)[(block_row * block_columns + block_column) * block_size];
+			switch (format)
+			{
+			case _texture_format_bc1:
+				row_error += encode_bc1_block(pixels, block);
+				break;
+			case _texture_format_bc3:
+				row_error += encode_bc3_block(pixels, block);
+				break;
+			case _texture_format_bc4:
+				row_error += encode_bc4_block(pixels, 0, block);
+				break;
+			case _texture_format_bc5:
+				row_error += encode_bc5_block(pixels, block);
+				break;
+			case _texture_format_bc7:
+				row_error += encode_bc7_block(pixels, block);
+				break;
+			}
+		}
+		row_errors[block_row] = row_error;
+	});
+
+	// Repeated edge texels are counted in the error, at most a few columns & rows on non multiple of 4 images
+	uint64_t error = 0;
+	for (const uint64_t row_error : row_errors)
+	{
+		error += row_error;
+	}
+	return error;
+}
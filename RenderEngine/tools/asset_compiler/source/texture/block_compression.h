@@ -0,0 +1,20 @@
+#pragma once
+#include <texture/texture.h>
+
+class c_thread_pool;
+
+// Block encoders take the 16 texels of a 4x4 block as RGBA in row order & return the squared error of the channels they keep
+// Endpoints come from the block's principal axis & are refined by least squares against the chosen indices
+uint32_t encode_bc1_block(const uint8_t pixels[64], uint8_t out_block[8]);
+uint32_t encode_bc3_block(const uint8_t pixels[64], uint8_t out_block[16]);
+uint32_t encode_bc4_block(const uint8_t pixels[64], const uint32_t channel, uint8_t out_block[8]);
+uint32_t encode_bc5_block(const uint8_t pixels[64], uint8_t out_block[16]);
+// BC7 mode 6 only, a single RGBA subset at 7 bits per endpoint channel plus a shared bit, with 16 interpolation steps
+uint32_t encode_bc7_block(const uint8_t pixels[64], uint8_t out_block[16]);
+
+// Number of channels a format keeps, the ones its squared error is measured over
+uint32_t get_texture_format_channel_count(const e_texture_format format);
+
+// Compress every block of an image across the pool, partial blocks at the right & bottom edges repeat the last column & row
+// Returns the squared error summed over every texel & kept channel
+uint64_t encode_image(const s_image& image, const e_texture_format format, c_thread_pool* const thread_pool, std::vector<uint8_t>* const out_blocks);
@@ -0,0 +1,109 @@
+#include "dds_writer.h"
+#include <common/report.h>
+#include <fstream>
+
+// Layouts match DDS_HEADER, DDS_PIXELFORMAT & DDS_HEADER_DXT10 from DDS.h, which the tool can't include
+constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+constexpr uint32_t DDS_FOURCC_DX10 = 0x30315844; // "DX10"
+
+constexpr uint32_t DDSD_CAPS = 0x1;
+constexpr uint32_t DDSD_HEIGHT = 0x2;
+constexpr uint32_t DDSD_WIDTH = 0x4;
+constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+struct s_dds_pixel_format
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t four_cc;
+	uint32_t rgb_bit_count;
+	uint32_t red_mask;
+	uint32_t green_mask;
+	uint32_t blue_mask;
+	uint32_t alpha_mask;
+};
+static_assert(sizeof(s_dds_pixel_format) == 0x20);
+
+struct s_dds_header
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitch_or_linear_size;
+	uint32_t depth;
+	uint32_t mip_map_count;
+	uint32_t reserved1[11];
+	s_dds_pixel_format pixel_format;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+static_assert(sizeof(s_dds_header) == 0x7C);
+
+struct s_dds_header_dx10
+{
+	uint32_t dxgi_format;
+	uint32_t resource_dimension;
+	uint32_t misc_flag;
+	uint32_t array_size;
+	uint32_t misc_flags2;
+};
+static_assert(sizeof(s_dds_header_dx10) == 0x14);
+
+bool write_dds(const std::filesystem::path& file_path, const e_texture_format format, const std::vector<s_dds_mip>& mips)
+{
+	if (mips.empty())
+	{
+		LOG_WARNING("refusing to write empty texture %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	s_dds_header header = {};
+	header.size = sizeof(s_dds_header);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | (mips.size() > 1 ? DDSD_MIPMAPCOUNT : 0);
+	header.height = mips[0].height;
+	header.width = mips[0].width;
+	header.pitch_or_linear_size = static_cast<uint32_t>(mips[0].blocks.size());
+	header.mip_map_count = static_cast<uint32_t>(mips.size());
+	header.pixel_format.size = sizeof(s_dds_pixel_format);
+	header.pixel_format.flags = DDPF_FOURCC;
+	header.pixel_format.four_cc = DDS_FOURCC_DX10;
+	header.caps = DDSCAPS_TEXTURE | (mips.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	s_dds_header_dx10 header_dx10 = {};
+	header_dx10.dxgi_format = format;
+	header_dx10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+	header_dx10.array_size = 1;
+
+	std::error_code error;
+	std::filesystem::create_directories(file_path.parent_path(), error);
+	std::ofstream dds_file(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (dds_file.fail())
+	{
+		LOG_WARNING("failed to open %s for writing!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	dds_file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+	dds_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	dds_file.write(reinterpret_cast<const char*>(&header_dx10), sizeof(header_dx10));
+	for (const s_dds_mip& mip : mips)
+	{
+		dds_file.write(reinterpret_cast<const char*>(mip.blocks.data()), mip.blocks.size());
+	}
+	if (dds_file.fail())
+	{
+		LOG_WARNING("failed to write %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	return K_SUCCESS;
+}
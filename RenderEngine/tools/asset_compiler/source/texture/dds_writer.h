@@ -0,0 +1,15 @@
+#pragma once
+#include <texture/texture.h>
+#include <filesystem>
+
+// Block compressed data for one mip level
+struct s_dds_mip
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> blocks;
+};
+
+// Write a 2D .DDS with a DX10 header, which DDSTextureLoader needs for BC7 & reads for every other format
+// mips are most detailed first
+bool write_dds(const std::filesystem::path& file_path, const e_texture_format format, const std::vector<s_dds_mip>& mips);
@@ -0,0 +1,304 @@
+#include "mip_generator.h"
+#include <common/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+
+// Shape & reach of the Kaiser window, in texels of the level being made, as used by NVTT's default mipmap filter
+constexpr float KAISER_ALPHA = 4.0f;
+constexpr float KAISER_RADIUS = 1.5f;
+constexpr float PI = 3.14159265358979f;
+
+// RGBA as floats, colour in linear light for albedo & in [-1, +1] for normal maps
+struct s_linear_image
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<float> values; // width * height * 4
+};
+
+// Taps for one texel of the smaller level along one axis
+struct s_filter_taps
+{
+	uint32_t count;
+	uint32_t offset; // into the kernel's weights & indices
+};
+
+struct s_filter_kernel
+{
+	std::vector<s_filter_taps> taps; // one per texel of the smaller level
+	std::vector<float> weights;
+	std::vector<uint32_t> indices; // texels of the larger level, already wrapped around its edges
+};
+
+static uint32_t wrap_index(const int32_t index, const uint32_t size)
+{
+	const int32_t wrapped = index % static_cast<int32_t>(size);
+	return static_cast<uint32_t>(wrapped < 0 ? wrapped + static_cast<int32_t>(size) : wrapped);
+}
+
+static float srgb_to_linear(const float value)
+{
+	return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(const float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static uint8_t to_unorm8(const float value)
+{
+	return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Zeroth order modified Bessel function of the first kind, by its power series
+static float bessel_i0(const float x)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	const float quarter_x_squared = x * x * 0.25f;
+	for (uint32_t k = 1; k < 32 && term > sum * 1e-8f; k++)
+	{
+		term *= quarter_x_squared / static_cast<float>(k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static float sinc(const float x)
+{
+	return fabsf(x) < 1e-5f ? 1.0f : sinf(PI * x) / (PI * x);
+}
+
+// x is in texels of the smaller level
+static float kaiser_weight(const float x)
+{
+	const float t = x / KAISER_RADIUS;
+	if (fabsf(t) >= 1.0f)
+	{
+		return 0.0f;
+	}
+	return sinc(x) * bessel_i0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / bessel_i0(KAISER_ALPHA);
+}
+
+// Weights are the same for every row or column, so they're worked out once per level & axis
+static void build_filter_kernel(const uint32_t source_size, const uint32_t destination_size, const e_mip_filter filter, s_filter_kernel* const out_kernel)
+{
+	out_kernel->taps.resize(destination_size);
+	out_kernel->weights.clear();
+	out_kernel->indices.clear();
+	const float scale = static_cast<float>(source_size) / static_cast<float>(destination_size);
+	for (uint32_t i = 0; i < destination_size; i++)
+	{
+		s_filter_taps& taps = out_kernel->taps[i];
+		taps.offset = static_cast<uint32_t>(out_kernel->weights.size());
+		if (filter == _mip_filter_box)
+		{
+			// Each source texel weighted by how much of it the destination texel covers, odd sizes split texels between neighbours
+			const float begin = i * scale;
+			const float end = (i + 1) * scale;
+			const int32_t first = static_cast<int32_t>(floorf(begin));
+			const int32_t last = static_cast<int32_t>(ceilf(end)) - 1;
+			for (int32_t j = first; j <= last; j++)
+			{
+				const float coverage = std::min(end, static_cast<float>(j + 1)) - std::max(begin, static_cast<float>(j));
+				out_kernel->weights.push_back(coverage / scale);
+				out_kernel->indices.push_back(wrap_index(j, source_size));
+			}
+		}
+		else
+		{
+			const float center = (i + 0.5f) * scale;
+			const float radius = KAISER_RADIUS * scale;
+			const int32_t first = static_cast<int32_t>(ceilf(center - radius - 0.5f));
+			const int32_t last = static_cast<int32_t>(floorf(center + radius - 0.5f));
+			float weight_sum = 0.0f;
+			for (int32_t j = first; j <= last; j++)
+			{
+				const float weight = kaiser_weight((j + 0.5f - center) / scale);
+				out_kernel->weights.push_back(weight);
+				out_kernel->indices.push_back(wrap_index(j, source_size));
+				weight_sum += weight;
+			}
+			for (size_t weight = taps.offset; weight < out_kernel->weights.size(); weight++)
+			{
+				out_kernel->weights[weight] /= weight_sum;
+			}
+		}
+		taps.count = static_cast<uint32_t>(out_kernel->weights.size()) - taps.offset;
+	}
+}
+
+// Separable filter, across each row into a half width image then down each column
+static void downsample(const s_linear_image& source, const e_mip_filter filter, c_thread_pool* const thread_pool, s_linear_image* const out_image)
+{
+	out_image->width = std::max(source.width / 2, 1u);
+	out_image->height = std::max(source.height / 2, 1u);
+	out_image->values.resize(static_cast<size_t>(out_image->width) * out_image->height * 4);
+
+	s_filter_kernel horizontal_kernel;
+	s_filter_kernel vertical_kernel;
+	build_filter_kernel(source.width, out_image->width, filter, &horizontal_kernel);
+	build_filter_kernel(source.height, out_image->height, filter, &vertical_kernel);
+
+	s_linear_image rows = { out_image->width, source.height, {} };
+	rows.values.resize(static_cast<size_t>(rows.width) * rows.height * 4);
+	parallel_for(thread_pool, rows.height, [&source, &rows, &horizontal_kernel](const size_t y)
+	{
+		const float* const source_row = &source.values[y * source.width * 4];
+		float* const row = &rows.values[y * rows.width * 4];
+		for (uint32_t x = 0; x < rows.width; x++)
+		{
+			const s_filter_taps& taps = horizontal_kernel.taps[x];
+			float sum[4] = {};
+			for (uint32_t tap = 0; tap < taps.count; tap++)
+			{
+				const float weight = horizontal_kernel.weights[taps.offset + tap];
+				const float* const texel = &source_row[horizontal_kernel.indices[taps.offset + tap] * 4];
+				for (uint32_t channel = 0; channel < 4; channel++)
+				{
+					sum[channel] += texel[channel] * weight;
+				}
+			}
+			std::copy(sum, sum + 4, &row[x * 4]);
+		}
+	});
+
+	parallel_for(thread_pool, out_image->height, [&rows, out_image, &vertical_kernel](const size_t y)
+	{
+		const s_filter_taps& taps = vertical_kernel.taps[y];
+		float* const row = &out_image->values[y * out_image->width * 4];
+		std::fill(row, row + out_image->width * 4, 0.0f);
+		for (uint32_t tap = 0; tap < taps.count; tap++)
+		{
+			const float weight = vertical_kernel.weights[taps.offset + tap];
+			const float* const source_row = &rows.values[static_cast<size_t>(vertical_kernel.indices[taps.offset + tap]) * rows.width * 4];
+			for (uint32_t value = 0; value < out_image->width * 4; value++)
+			{
+				row[value] += source_row[value] * weight;
+			}
+		}
+	});
+}
+
+static void normalise_xyz(float* const texel)
+{
+	const float length = sqrtf(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+	if (length > 1e-6f)
+	{
+		texel[0] /= length;
+		texel[1] /= length;
+		texel[2] /= length;
+	}
+	else
+	{
+		// Opposing normals averaged to nothing, point straight out of the surface
+		texel[0] = 0.0f;
+		texel[1] = 0.0f;
+		texel[2] = 1.0f;
+	}
+}
+
+static void to_linear_image(const s_image& image, const e_texture_usage usage, c_thread_pool* const thread_pool, s_linear_image* const out_image)
+{
+	float srgb_table[256];
+	for (uint32_t value = 0; value < 256; value++)
+	{
+		srgb_table[value] = srgb_to_linear(value / 255.0f);
+	}
+
+	out_image->width = image.width;
+	out_image->height = image.height;
+	out_image->values.resize(image.pixels.size());
+	parallel_for(thread_pool, image.height, [&image, usage, out_image, &srgb_table](const size_t y)
+	{
+		for (size_t i = y * image.width * 4; i < (y + 1) * image.width * 4; i += 4)
+		{
+			const uint8_t* const pixel = &image.pixels[i];
+			float* const texel = &out_image->values[i];
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				switch (usage)
+				{
+				case _texture_usage_albedo:
+					texel[channel] = srgb_table[pixel[channel]];
+					break;
+				case _texture_usage_normal:
+					texel[channel] = pixel[channel] / 255.0f * 2.0f - 1.0f;
+					break;
+				case _texture_usage_specular:
+				default:
+					texel[channel] = pixel[channel] / 255.0f;
+					break;
+				}
+			}
+			texel[3] = pixel[3] / 255.0f;
+			if (usage == _texture_usage_normal)
+			{
+				normalise_xyz(texel);
+			}
+		}
+	});
+}
+
+static void to_image(const s_linear_image& linear_image, const e_texture_usage usage, c_thread_pool* const thread_pool, s_image* const out_image)
+{
+	out_image->width = linear_image.width;
+	out_image->height = linear_image.height;
+	out_image->pixels.resize(linear_image.values.size());
+	parallel_for(thread_pool, linear_image.height, [&linear_image, usage, out_image](const size_t y)
+	{
+		for (size_t i = y * linear_image.width * 4; i < (y + 1) * linear_image.width * 4; i += 4)
+		{
+			float texel[4] = { linear_image.values[i + 0], linear_image.values[i + 1], linear_image.values[i + 2], linear_image.values[i + 3] };
+			uint8_t* const pixel = &out_image->pixels[i];
+			if (usage == _texture_usage_normal)
+			{
+				normalise_xyz(texel);
+			}
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				switch (usage)
+				{
+				case _texture_usage_albedo:
+					pixel[channel] = to_unorm8(linear_to_srgb(std::clamp(texel[channel], 0.0f, 1.0f)));
+					break;
+				case _texture_usage_normal:
+					pixel[channel] = to_unorm8(texel[channel] * 0.5f + 0.5f);
+					break;
+				case _texture_usage_specular:
+				default:
+					pixel[channel] = to_unorm8(texel[channel]);
+					break;
+				}
+			}
+			pixel[3] = to_unorm8(texel[3]);
+		}
+	});
+}
+
+void generate_mips(const s_image& source, const e_texture_usage usage, const e_mip_filter filter, c_thread_pool* const thread_pool, std::vector<s_image>* const out_levels)
+{
+	out_levels->clear();
+	s_linear_image level;
+	to_linear_image(source, usage, thread_pool, &level);
+
+	// Every level is filtered from the full precision one above, so rounding doesn't build up down the chain
+	if (usage == _texture_usage_normal)
+	{
+		out_levels->emplace_back();
+		to_image(level, usage, thread_pool, &out_levels->back());
+	}
+	else
+	{
+		out_levels->push_back(source);
+	}
+	while (level.width > 1 || level.height > 1)
+	{
+		s_linear_image next_level;
+		downsample(level, filter, thread_pool, &next_level);
+		out_levels->emplace_back();
+		to_image(next_level, usage, thread_pool, &out_levels->back());
+		level = std::move(next_level);
+	}
+}
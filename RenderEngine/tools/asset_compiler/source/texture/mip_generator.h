@@ -0,0 +1,18 @@
+#pragma once
+#include <texture/texture.h>
+
+class c_thread_pool;
+
+enum e_mip_filter
+{
+	_mip_filter_box, // 2x2 average, soft but never rings
+	_mip_filter_kaiser, // Kaiser windowed sinc over 6x6 texels, keeps more detail in the smaller levels
+
+	k_mip_filter_count
+};
+
+// Build a full mip chain down to 1x1 into out_levels, most detailed first with the source as level 0
+// Albedo is filtered in linear light & re-encoded as sRGB, so dark & bright texels average to the brightness they appear
+// Normal maps are filtered as unit vectors & renormalised at every level including the first, specular is filtered as plain data
+// Filtering wraps at the edges to match the engine's sampler, each level is spread across the pool by row
+void generate_mips(const s_image& source, const e_texture_usage usage, const e_mip_filter filter, c_thread_pool* const thread_pool, std::vector<s_image>* const out_levels);
@@ -0,0 +1,42 @@
+#pragma once
+#include <common/types.h>
+#include <vector>
+
+// 8 bit per channel RGBA image, rows top to bottom
+struct s_image
+{
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> pixels; // width * height * 4
+};
+
+// What a texture is sampled as, which decides how it's compressed
+enum e_texture_usage
+{
+	_texture_usage_albedo,
+	_texture_usage_normal, // tangent space, only x & y are kept, the shader rebuilds z
+	_texture_usage_specular, // single channel
+
+	k_texture_usage_count
+};
+
+// Block compressed formats the cooker writes, values match DXGI_FORMAT
+enum e_texture_format
+{
+	_texture_format_bc1 = 71, // DXGI_FORMAT_BC1_UNORM, opaque RGB at 4 bits per pixel
+	_texture_format_bc3 = 77, // DXGI_FORMAT_BC3_UNORM, RGB & alpha at 8 bits per pixel
+	_texture_format_bc4 = 80, // DXGI_FORMAT_BC4_UNORM, red only at 4 bits per pixel
+	_texture_format_bc5 = 83, // DXGI_FORMAT_BC5_UNORM, red & green at 8 bits per pixel
+	_texture_format_bc7 = 98, // DXGI_FORMAT_BC7_UNORM, RGBA at 8 bits per pixel
+};
+
+// Bytes per 4x4 block
+inline uint32_t get_texture_format_block_size(const e_texture_format format)
+{
+	return format == _texture_format_bc1 || format == _texture_format_bc4 ? 8 : 16;
+}
+
+inline uint32_t get_block_count(const uint32_t pixel_count)
+{
+	return (pixel_count + 3) / 4;
+}
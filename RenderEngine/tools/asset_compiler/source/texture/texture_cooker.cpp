@@ -0,0 +1,135 @@
+#include "texture_cooker.h"
+#include <common/report.h>
+#include <texture/tga_reader.h>
+#include <texture/block_compression.h>
+#include <texture/dds_writer.h>
+#include <texture/mip_generator.h>
+#include <common/thread_pool.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+e_texture_usage get_texture_usage(const std::filesystem::path& file_path)
+{
+	std::string name = file_path.stem().string();
+	std::transform(name.begin(), name.end(), name.begin(), [](const unsigned char character) { return static_cast<char>(tolower(character)); });
+	const auto has_suffix = [&name](const char* const suffix)
+	{
+		const size_t suffix_length = strlen(suffix);
+		return name.size() >= suffix_length && name.compare(name.size() - suffix_length, suffix_length, suffix) == 0;
+	};
+
+	if (has_suffix("_ddn") || has_suffix("_nrm") || has_suffix("_normal"))
+	{
+		return _texture_usage_normal;
+	}
+	if (has_suffix("_spec") || has_suffix("_specular"))
+	{
+		return _texture_usage_specular;
+	}
+	return _texture_usage_albedo;
+}
+
+static void flip_image(s_image* const image, const bool horizontal, const bool vertical)
+{
+	uint32_t* const pixels = reinterpret_cast<uint32_t*>(image->pixels.data());
+	if (horizontal)
+	{
+		for (uint32_t y = 0; y < image->height; y++)
+		{
+			std::reverse(pixels + static_cast<size_t>(y) * image->width, pixels + static_cast<size_t>(y + 1) * image->width);
+		}
+	}
+	if (vertical)
+	{
+		for (uint32_t y = 0; y < image->height / 2; y++)
+		{
+			std::swap_ranges(pixels + static_cast<size_t>(y) * image->width, pixels + static_cast<size_t>(y + 1) * image->width, pixels + static_cast<size_t>(image->height - 1 - y) * image->width);
+		}
+	}
+}
+
+static e_texture_format get_texture_format(const e_texture_usage usage, const s_image& image, const s_texture_cook_options& options)
+{
+	switch (usage)
+	{
+	case _texture_usage_normal:
+		return _texture_format_bc5;
+	case _texture_usage_specular:
+		return _texture_format_bc4;
+	case _texture_usage_albedo:
+	default:
+		if (!options.albedo_bc1)
+		{
+			return _texture_format_bc7;
+		}
+		for (size_t i = 3; i < image.pixels.size(); i += 4)
+		{
+			if (image.pixels[i] != 0xFF)
+			{
+				return _texture_format_bc3;
+			}
+		}
+		return _texture_format_bc1;
+	}
+}
+
+bool cook_texture(const std::filesystem::path& input_path, const std::filesystem::path& output_path, const s_texture_cook_options& options, c_thread_pool* const thread_pool, s_texture_cook_result* const out_result)
+{
+	const auto start_time = std::chrono::steady_clock::now();
+	*out_result = {};
+
+	s_image image;
+	if (!read_tga(input_path, &image))
+	{
+		return K_FAILURE;
+	}
+	// D3D12 only creates block compressed textures whose top level is made of whole blocks
+	if (image.width % 4 != 0 || image.height % 4 != 0)
+	{
+		LOG_WARNING("%s is %ux%u, block compressed textures must be a multiple of 4 in both dimensions!", input_path.string().c_str(), image.width, image.height);
+		return K_FAILURE;
+	}
+	flip_image(&image, options.flip_horizontal, options.flip_vertical);
+
+	const e_texture_usage usage = get_texture_usage(input_path);
+	const e_texture_format format = get_texture_format(usage, image, options);
+
+	const auto mip_start_time = std::chrono::steady_clock::now();
+	std::vector<s_image> levels;
+	generate_mips(image, usage, options.mip_filter, thread_pool, &levels);
+	out_result->mip_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mip_start_time).count();
+
+	// Levels are compressed side by side, each one also splitting its rows across the pool
+	std::vector<s_dds_mip> mips(levels.size());
+	std::vector<uint64_t> level_errors(levels.size(), 0);
+	c_job_group job_group(thread_pool);
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		job_group.run([&levels, &mips, &level_errors, level, format, thread_pool]
+		{
+			mips[level] = { levels[level].width, levels[level].height, {} };
+			level_errors[level] = encode_image(levels[level], format, thread_pool, &mips[level].blocks);
+		});
+	}
+	job_group.wait();
+
+	if (!write_dds(output_path, format, mips))
+	{
+		return K_FAILURE;
+	}
+
+	out_result->width = image.width;
+	out_result->height = image.height;
+	const double sample_count = static_cast<double>(image.width) * image.height * get_texture_format_channel_count(format);
+	const double mean_squared_error = level_errors[0] / sample_count;
+	out_result->peak_signal_to_noise = mean_squared_error > 0.0 ? static_cast<float>(10.0 * log10(255.0 * 255.0 / mean_squared_error)) : INFINITY;
+	out_result->source_size = std::filesystem::file_size(input_path);
+	out_result->cooked_size = std::filesystem::file_size(output_path);
+	out_result->mip_count = static_cast<uint32_t>(mips.size());
+	out_result->usage = usage;
+	out_result->format = format;
+	out_result->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+	return K_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <texture/texture.h>
+#include <texture/mip_generator.h>
+#include <filesystem>
+
+class c_thread_pool;
+
+// Bump whenever a change to the cooker changes the .dds files it writes, so incremental cooks redo every texture
+constexpr uint32_t TEXTURE_COOKER_VERSION = 1;
+
+struct s_texture_cook_options
+{
+	bool flip_horizontal; // matches texconv -hflip
+	bool flip_vertical; // matches texconv -vflip
+	bool albedo_bc1; // BC1, or BC3 with alpha, for albedo instead of BC7, half the size at lower quality
+	e_mip_filter mip_filter;
+};
+
+struct s_texture_cook_result
+{
+	uint64_t source_size;
+	uint64_t cooked_size;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mip_count; // including the source level
+	e_texture_usage usage;
+	e_texture_format format;
+	float peak_signal_to_noise; // dB over the kept channels of the top level
+	double mip_milliseconds; // filtering the chain, before any compression
+	double milliseconds;
+};
+
+// Usage from the file name's suffix, _ddn/_nrm/_normal are normal maps & _spec/_specular are specular, anything else is albedo
+e_texture_usage get_texture_usage(const std::filesystem::path& file_path);
+
+// Cook a .TGA into a block compressed .DDS with a full, gamma correct mip chain, the format is picked from the texture's usage
+bool cook_texture(const std::filesystem::path& input_path, const std::filesystem::path& output_path, const s_texture_cook_options& options, c_thread_pool* const thread_pool, s_texture_cook_result* const out_result);
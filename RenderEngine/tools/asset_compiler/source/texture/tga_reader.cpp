@@ -0,0 +1,128 @@
+#include "tga_reader.h"
+#include <common/report.h>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+enum e_tga_image_type
+{
+	_tga_image_truecolour = 2,
+	_tga_image_greyscale = 3,
+	_tga_image_truecolour_rle = 10,
+	_tga_image_greyscale_rle = 11,
+};
+
+constexpr uint32_t TGA_HEADER_SIZE = 18;
+constexpr uint8_t TGA_DESCRIPTOR_RIGHT_ORIGIN = 0x10;
+constexpr uint8_t TGA_DESCRIPTOR_TOP_ORIGIN = 0x20;
+
+static uint16_t read_uint16(const uint8_t* const data)
+{
+	return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+bool read_tga(const std::filesystem::path& file_path, s_image* const out_image)
+{
+	std::ifstream tga_file(file_path, std::ios::in | std::ios::binary);
+	if (tga_file.fail())
+	{
+		LOG_WARNING("failed to open %s!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(tga_file)), std::istreambuf_iterator<char>());
+	if (data.size() < TGA_HEADER_SIZE)
+	{
+		LOG_WARNING("%s is too small to be a tga!", file_path.string().c_str());
+		return K_FAILURE;
+	}
+
+	const uint8_t id_length = data[0];
+	const uint8_t colour_map_type = data[1];
+	const uint8_t image_type = data[2];
+	const uint32_t width = read_uint16(&data[12]);
+	const uint32_t height = read_uint16(&data[14]);
+	const uint8_t bits_per_pixel = data[16];
+	const uint8_t descriptor = data[17];
+
+	const bool greyscale = image_type == _tga_image_greyscale || image_type == _tga_image_greyscale_rle;
+	const bool run_length_encoded = image_type == _tga_image_truecolour_rle || image_type == _tga_image_greyscale_rle;
+	const bool type_valid = colour_map_type == 0 && (greyscale || image_type == _tga_image_truecolour || image_type == _tga_image_truecolour_rle);
+	const bool depth_valid = greyscale ? bits_per_pixel == 8 : (bits_per_pixel == 24 || bits_per_pixel == 32);
+	if (!type_valid || !depth_valid || width == 0 || height == 0)
+	{
+		LOG_WARNING("%s is an unsupported tga (type %u, %u bits per pixel, %ux%u)!", file_path.string().c_str(), image_type, bits_per_pixel, width, height);
+		return K_FAILURE;
+	}
+
+	// Decode into file order first, runs can cross row boundaries
+	const uint32_t bytes_per_pixel = bits_per_pixel / 8;
+	const size_t pixel_count = static_cast<size_t>(width) * height;
+	std::vector<uint8_t> file_pixels(pixel_count * bytes_per_pixel);
+	size_t offset = TGA_HEADER_SIZE + id_length;
+	if (!run_length_encoded)
+	{
+		if (data.size() - offset < file_pixels.size())
+		{
+			LOG_WARNING("%s is truncated!", file_path.string().c_str());
+			return K_FAILURE;
+		}
+		std::copy(data.begin() + offset, data.begin() + offset + file_pixels.size(), file_pixels.begin());
+	}
+	else
+	{
+		size_t pixel = 0;
+		while (pixel < pixel_count)
+		{
+			if (offset >= data.size())
+			{
+				LOG_WARNING("%s is truncated!", file_path.string().c_str());
+				return K_FAILURE;
+			}
+			const uint8_t packet = data[offset++];
+			const size_t run_length = std::min<size_t>((packet & 0x7F) + 1, pixel_count - pixel);
+			const bool repeated = (packet & 0x80) != 0;
+			const size_t packet_size = (repeated ? 1 : run_length) * bytes_per_pixel;
+			if (data.size() - offset < packet_size)
+			{
+				LOG_WARNING("%s is truncated!", file_path.string().c_str());
+				return K_FAILURE;
+			}
+			for (size_t i = 0; i < run_length; i++, pixel++)
+			{
+				const uint8_t* const source = &data[offset + (repeated ? 0 : i * bytes_per_pixel)];
+				std::copy(source, source + bytes_per_pixel, &file_pixels[pixel * bytes_per_pixel]);
+			}
+			offset += packet_size;
+		}
+	}
+
+	// BGR(A) or grey to RGBA, flipped to a top left origin
+	out_image->width = width;
+	out_image->height = height;
+	out_image->pixels.resize(pixel_count * 4);
+	const bool top_origin = (descriptor & TGA_DESCRIPTOR_TOP_ORIGIN) != 0;
+	const bool right_origin = (descriptor & TGA_DESCRIPTOR_RIGHT_ORIGIN) != 0;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint32_t source_y = top_origin ? y : height - 1 - y;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const uint32_t source_x = right_origin ? width - 1 - x : x;
+			const uint8_t* const source = &file_pixels[(static_cast<size_t>(source_y) * width + source_x) * bytes_per_pixel];
+			uint8_t* const destination = &out_image->pixels[(static_cast<size_t>(y) * width + x) * 4];
+			if (greyscale)
+			{
+				destination[0] = destination[1] = destination[2] = source[0];
+				destination[3] = 0xFF;
+			}
+			else
+			{
+				destination[0] = source[2];
+				destination[1] = source[1];
+				destination[2] = source[0];
+				destination[3] = bytes_per_pixel == 4 ? source[3] : 0xFF;
+			}
+		}
+	}
+	return K_SUCCESS;
+}
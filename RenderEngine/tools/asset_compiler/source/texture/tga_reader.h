@@ -0,0 +1,7 @@
+#pragma once
+#include <texture/texture.h>
+#include <filesystem>
+
+// Read a truecolour or greyscale .TGA, raw or run length encoded, into RGBA with the top row first whatever the file's origin
+// 24 bit & greyscale images are given an opaque alpha
+bool read_tga(const std::filesystem::path& file_path, s_image* const out_image);
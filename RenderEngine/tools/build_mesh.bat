@@ -10,17 +10,15 @@ set source_dir=%source_dir:"=%
 set destination_dir=%destination_dir:"=%
 set tool_dir=%tool_dir:"=%
 
-:: Compile each .obj to .vbo whilst preserving directories
-for /r %source_dir% %%f in (*.obj) do (
-    set "full_dir=%%~dpf"
-    set "relative_dir=!full_dir:%source_dir%=!"
-    set "compiled_dir=%destination_dir%!relative_dir!
-	
-	if not exist "!compiled_dir!" (
-        mkdir "!compiled_dir!"
-    )
-	
-	%tool_dir%\meshconvert "%%f" -vbo -nodds -y -flipu -o "!compiled_dir!%%~nf.vbo" >NUL
+:: Cook every .obj to .mesh whilst preserving directories, files are compiled in parallel
+:: Only meshes whose source or options changed since the last build are cooked again, see cook.manifest in the destination
+:: asset_compiler is built from tools\asset_compiler with CMake into its build directory
+set asset_compiler=%tool_dir%\asset_compiler\build\asset_compiler.exe
+if not exist "%asset_compiler%" (
+    echo error: asset_compiler not found at !asset_compiler!, compile_assets.bat builds it with CMake
+    exit /b 1
 )
+"%asset_compiler%" -flipu "%source_dir%" "%destination_dir%"
+if errorlevel 1 exit /b 1
 
 endlocal
\ No newline at end of file
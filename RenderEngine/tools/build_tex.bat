@@ -10,21 +10,16 @@ set source_dir=%source_dir:"=%
 set destination_dir=%destination_dir:"=%
 set tool_dir=%tool_dir:"=%
 
-:: TODO: convert different texture types to different DDS formats
-for /r "%source_dir%" %%f in (*.tga) do (
-    set "full_dir=%%~dpf"
-    set "relative_dir=!full_dir:%source_dir%=!"
-    set "compiled_dir=%destination_dir%!relative_dir!
-	
-	:: Remove trailing backslash from compiled_dir which texconv will not work with
-	if "!compiled_dir:~-1!"=="\" set "compiled_dir=!compiled_dir:~0,-1!"
-	
-    if not exist "!compiled_dir!" (
-        mkdir "!compiled_dir!"
-    )
-	
-	"%tool_dir%\texconv" "%%f" -o "!compiled_dir!" -hflip -vflip -y >NUL
+:: Block compress every .tga to .dds whilst preserving directories, the format is picked from each texture's usage
+:: _ddn normal maps to BC5, _spec specular maps to BC4, everything else to BC7, flipped to match what texconv used to output
+:: Only textures whose source or options changed since the last build are cooked again, see cook.manifest in the destination
+set asset_compiler=%tool_dir%\asset_compiler\build\asset_compiler.exe
+if not exist "%asset_compiler%" (
+    echo error: asset_compiler not found at !asset_compiler!, compile_assets.bat builds it with CMake
+    exit /b 1
 )
+"%asset_compiler%" -hflip -vflip "%source_dir%" "%destination_dir%"
+if errorlevel 1 exit /b 1
 
 :: Move existing DDS files to compiled assets
 for /r "%source_dir%" %%f in (*.dds) do (
@@ -37,7 +32,7 @@ for /r "%source_dir%" %%f in (*.dds) do (
         mkdir "!dest_folder!"
     )
 
-    :: Copy the file to the destination, >NUL suppresses output to build log
-    copy "%%f" "!dest_folder!" >NUL
+    :: Copy the file to the destination if it's newer, >NUL suppresses output to build log
+    xcopy /d /y "%%f" "!dest_folder!" >NUL
 )
 endlocal
\ No newline at end of file
@@ -6,8 +6,29 @@ set assets_dir=%1
 set compiled_dir=%2
 set tool_dir=%3
 
+:: Build asset_compiler into tools\asset_compiler\build, only sources changed since the last build are compiled again
+:: CMake comes with Visual Studio's C++ workload, which puts it on the path of the developer environment builds run in
+where cmake >NUL 2>&1
+if errorlevel 1 (
+    echo error: cmake not found, it's needed to build tools\asset_compiler
+    exit /b 1
+)
+set asset_compiler_dir=%tool_dir:"=%\asset_compiler
+cmake -S "%asset_compiler_dir%" -B "%asset_compiler_dir%\build"
+if errorlevel 1 exit /b 1
+cmake --build "%asset_compiler_dir%\build" --config Release --parallel
+if errorlevel 1 exit /b 1
+
 call "%tool_dir%\build_mesh.bat" "%assets_dir%\models" "%compiled_dir%\models" %tool_dir%
+if errorlevel 1 exit /b 1
 call "%tool_dir%\build_tex.bat" "%assets_dir%\textures" "%compiled_dir%\textures" %tool_dir%
+if errorlevel 1 exit /b 1
+
+:: Pack everything cooked into a single archive, loaded with one mapping at startup, skipped if nothing changed since the last pack
+:: Remove speech marks from directories
+set compiled_dir=%compiled_dir:"=%
+"%asset_compiler_dir%\build\asset_compiler.exe" -pack "%compiled_dir%" "%compiled_dir%\assets.pack"
+if errorlevel 1 exit /b 1
 
 :: TODO: compile shaders, for now we'll just copy all hlsl files to compiled_dir
 :: Moved this step to copy assets to build
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Linux counterpart to compile_assets.bat, builds asset_compiler if needed, cooks models and packs them
+# Cooking & packing are incremental, only assets changed since the last run are cooked again
+# usage: compile_assets.sh <assets_dir> <compiled_dir> [asset_compiler_build_dir]
+set -e
+
+assets_dir=$1
+compiled_dir=$2
+tool_dir=$(cd "$(dirname "$0")" && pwd)
+build_dir=${3:-$tool_dir/asset_compiler/build}
+
+if [ -z "$assets_dir" ] || [ -z "$compiled_dir" ]; then
+	echo "usage: $0 <assets_dir> <compiled_dir> [asset_compiler_build_dir]"
+	exit 1
+fi
+
+cmake -S "$tool_dir/asset_compiler" -B "$build_dir" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "$build_dir" --parallel >/dev/null
+
+"$build_dir/asset_compiler" -flipu "$assets_dir/models" "$compiled_dir/models"
+
+"$build_dir/asset_compiler" -hflip -vflip "$assets_dir/textures" "$compiled_dir/textures"
+# Textures already in .dds are copied as they are, when newer than the last copy
+compiled_textures_dir=$(cd "$compiled_dir/textures" && pwd)
+(cd "$assets_dir/textures" && find . -name '*.dds' -exec sh -c 'mkdir -p "$1/$(dirname "$0")" && cp -u "$0" "$1/$0"' {} "$compiled_textures_dir" \;)
+
+# Pack everything cooked into a single archive, loaded with one mapping at startup
+"$build_dir/asset_compiler" -pack "$compiled_dir" "$compiled_dir/assets.pack"
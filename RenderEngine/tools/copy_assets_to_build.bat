@@ -5,7 +5,10 @@ setlocal enabledelayedexpansion
 set compiled_dir=%1
 set build_dir=%2
 
-:: Copy compiled assets folder to build
-xcopy /s /e /y %compiled_dir%\ %build_dir%\ >NUL
+:: Copy compiled assets folder to build, files with the same size & time as the build's copy are skipped
+robocopy %compiled_dir% %build_dir% /e /njh /njs /nfl /ndl /np >NUL
 
-endlocal
\ No newline at end of file
+:: robocopy exit codes below 8 mean success, 1 is files copied
+if %errorlevel% geq 8 exit /b %errorlevel%
+endlocal
+exit /b 0
\ No newline at end of file